@@ -35,6 +35,7 @@ if sys.version_info < (3, 6):
 
 import autorx
 from autorx.scan import SondeScanner
+from autorx.scan_scheduler import ScanScheduler
 from autorx.decode import SondeDecoder, VALID_SONDE_TYPES, DRIFTY_SONDE_TYPES
 from autorx.logger import TelemetryLogger
 from autorx.email_notification import EmailNotification
@@ -97,6 +98,9 @@ gpsd_adaptor = None
 # This contains frequncies that should be blocked for a short amount of time.
 temporary_block_list = {}
 
+# Scan scheduler - per-frequency scan history, shared by all scanner instances.
+scan_scheduler = None
+
 
 def allocate_sdr(check_only=False, task_description=""):
     """Allocate an un-used SDR for a task.
@@ -184,6 +188,9 @@ def start_scanner():
             temporary_block_list=temporary_block_list,
             temporary_block_time=config["temporary_block_time"],
             max_async_scan_workers=config["max_async_scan_workers"],
+            scan_scheduler=scan_scheduler,
+            scan_budget=config["scan_budget"],
+            channelized_scan=config["channelized_scan"],
         )
 
         # Add a reference into the sdr_list entry
@@ -293,7 +300,13 @@ def start_decoder(freq, sonde_type, continuous=False):
             experimental_decoder=config["experimental_decoders"][_exp_sonde_type],
             save_raw_hex=config["save_raw_hex"],
             wideband_sondes=config["wideband_sondes"],
-            close_on_encrypted=config["close_on_encrypted"]
+            close_on_encrypted=config["close_on_encrypted"],
+            binary_output=config["decoder_binary_output"],
+            rs41_calibration_cache=config["rs41_calibration_cache"],
+            # Detection on the decoder IQ stream - new sondes go through handle_scan_results() like scan results.
+            tap_callback=autorx.scan_results.put if config["decode_tap_detect"] else None,
+            tap_quantization=config["quantization"],
+            tap_spacing_limit=config["decoder_spacing_limit"]
         )
         autorx.sdr_list[_device_idx]["task"] = autorx.task_list[freq]["task"]
 
@@ -759,7 +772,7 @@ def email_error(message="foo"):
 
 def main():
     """Main Loop"""
-    global config, exporter_objects, exporter_functions, logging_level, rs92_ephemeris, gpsd_adaptor, email_exporter
+    global config, exporter_objects, exporter_functions, logging_level, rs92_ephemeris, gpsd_adaptor, email_exporter, scan_scheduler
 
     # Command line arguments.
     parser = argparse.ArgumentParser()
@@ -892,6 +905,10 @@ def main():
         config = _temp_cfg
         autorx.sdr_list = config["sdr_settings"]
 
+    if config["scan_scheduler"]:
+        scan_scheduler = ScanScheduler()
+        autorx.scan_scheduler = scan_scheduler
+
 
     # Apply any logging changes based on configuration file settings.
     if config["save_system_log"]:
@@ -47,5 +47,8 @@ scan_inhibit = False
 # Rotator object
 rotator_object = None
 
+# Scan scheduler (scan_scheduler.py), None if disabled
+scan_scheduler = None
+
 # Logging Directory
 logging_path = "./log/"
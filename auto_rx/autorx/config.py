@@ -140,6 +140,10 @@ def read_auto_rx_config(filename, no_sdr_test=False):
         "rs41_drift_tweak": False,
         "decoder_stats": False,
         "max_async_scan_workers": 4,
+        "scan_scheduler": True,
+        "scan_budget": 0,
+        "channelized_scan": False,
+        "decode_tap_detect": False,
         "ngp_tweak": False,
         # Rotator Settings
         "enable_rotator": False,
@@ -174,6 +178,8 @@ def read_auto_rx_config(filename, no_sdr_test=False):
         # "sondehub_contact_email": "none@none.com" # Commented out to ensure a warning message is shown on startup
         "wideband_sondes": False, # Wideband sonde detection / decoding
         "close_on_encrypted": True,
+        "decoder_binary_output": False,
+        "rs41_calibration_cache": True,
     }
 
     try:
@@ -820,6 +826,63 @@ def read_auto_rx_config(filename, no_sdr_test=False):
             )
             auto_rx_config["close_on_encrypted"] = True
 
+        # Binary telemetry records from the decoders
+        try:
+            auto_rx_config["decoder_binary_output"] = config.getboolean(
+                "advanced", "decoder_binary_output"
+            )
+        except:
+            logging.warning(
+                "Config - Missing decoder_binary_output option, using default (False)"
+            )
+            auto_rx_config["decoder_binary_output"] = False
+
+        # RS41 calibration data cache
+        try:
+            auto_rx_config["rs41_calibration_cache"] = config.getboolean(
+                "advanced", "rs41_calibration_cache"
+            )
+        except:
+            logging.warning(
+                "Config - Missing rs41_calibration_cache option, using default (True)"
+            )
+            auto_rx_config["rs41_calibration_cache"] = True
+
+        # Adaptive scan scheduler
+        try:
+            auto_rx_config["scan_scheduler"] = config.getboolean(
+                "advanced", "scan_scheduler"
+            )
+            auto_rx_config["scan_budget"] = max(0, config.getint("advanced", "scan_budget"))
+        except:
+            logging.warning(
+                "Config - Missing scan_scheduler or scan_budget option, using default (enabled, no budget)"
+            )
+            auto_rx_config["scan_scheduler"] = True
+            auto_rx_config["scan_budget"] = 0
+
+        # Channelized detection on RTLSDRs
+        try:
+            auto_rx_config["channelized_scan"] = config.getboolean(
+                "advanced", "channelized_scan"
+            )
+        except:
+            logging.warning(
+                "Config - Missing channelized_scan option, using default (False)"
+            )
+            auto_rx_config["channelized_scan"] = False
+
+        # Sonde detection on the decoder IQ streams
+        try:
+            auto_rx_config["decode_tap_detect"] = config.getboolean(
+                "advanced", "decode_tap_detect"
+            )
+        except:
+            logging.warning(
+                "Config - Missing decode_tap_detect option, using default (False)"
+            )
+            auto_rx_config["decode_tap_detect"] = False
+
         # If we are being called as part of a unit test, just return the config now.
         if no_sdr_test:
             return auto_rx_config
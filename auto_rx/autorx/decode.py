@@ -16,14 +16,18 @@ import subprocess
 import time
 import traceback
 from dateutil.parser import parse
-from threading import Thread
+from threading import Event, Thread
 from types import FunctionType, MethodType
-from .utils import AsynchronousFileReader, rtlsdr_test, position_info, generate_aprs_id
+from .utils import rtlsdr_test, position_info, generate_aprs_id
 from .gps import get_ephemeris, get_almanac
 from .sonde_specific import fix_datetime, imet_unique_id
 from .fsk_demod import FSKDemodStats
 from .sdr_wrappers import test_sdr, get_sdr_iq_cmd, get_sdr_fm_cmd, get_sdr_name
 from .email_notification import EmailNotification
+from .sonde_tlm import split_lines, split_records, add_binary_option, add_rxtime_option
+from .reactor import get_reactor
+from .latency import record_latency
+from .tap_detect import TapDetector, get_tap_cmd, get_tap_shm_name, plan_tap_channels
 
 # Global valid sonde types list.
 VALID_SONDE_TYPES = [
@@ -155,7 +159,12 @@ class SondeDecoder(object):
         experimental_decoder=False,
         save_raw_hex=False,
         wideband_sondes=False,
-        close_on_encrypted=True
+        close_on_encrypted=True,
+        binary_output=False,
+        rs41_calibration_cache=False,
+        tap_callback=None,
+        tap_quantization=10000,
+        tap_spacing_limit=15000
     ):
         """ Initialise and start a Sonde Decoder.
 
@@ -197,6 +206,14 @@ class SondeDecoder(object):
             wideband_sondes (bool): If True, use a wider bandwidth for iMet sondes. Does not affect settings for any other radiosonde types.
             close_on_encrypted (bool): If True, close the decoder when an encrypted sonde is detected, resulting in the frequency being locked out.
                     If False, we continue to pass data through the processing chain, but with different behaviour (e.g. no sondehub upload)
+            binary_output (bool): If True, run the demod/mod decoders with --jsnbin, and read their telemetry as binary records
+                    instead of parsing JSON lines.
+            rs41_calibration_cache (bool): If True, the RS41 decoder keeps the sonde calibration data in a cache file
+                    (log/rs41_calcache.bin), which is re-used when the decoder is restarted.
+            tap_callback (function): If set, tap the decoder IQ stream and run sonde detection on the rest of its bandwidth
+                    (see tap_detect.py). Detections are passed to this function as a list of [frequency, type], like scan results.
+            tap_quantization (int): Round tap detection frequencies to this many Hz.
+            tap_spacing_limit (int): Ignore tap detections of the decoded sonde type within this many Hz of the decoder frequency.
         """
         # Thread running flag
         self.decoder_running = True
@@ -231,6 +248,14 @@ class SondeDecoder(object):
         self.raw_file = None
         self.wideband_sondes = wideband_sondes
         self.close_on_encrypted = close_on_encrypted
+        self.binary_output = binary_output
+        self.rs41_calibration_cache = rs41_calibration_cache
+        self.tap_callback = tap_callback
+        self.tap_quantization = tap_quantization
+        self.tap_spacing_limit = tap_spacing_limit
+
+        # Detection on the decoder IQ stream, created along with the decoder command (if the decoder uses IQ).
+        self.tap_detector = None
 
         # Last decoded position of this sonde
         self.last_positions = {}
@@ -246,6 +271,12 @@ class SondeDecoder(object):
         self.save_decode_iq_path = os.path.join(autorx.logging_path, f"decode_IQ_{self.sonde_freq}_{self.sonde_type}_{str(self.rtl_device_idx)}.raw")
         self.save_decode_audio_path = os.path.join(autorx.logging_path, f"decode_audio_{self.sonde_freq}_{self.sonde_type}_{str(self.rtl_device_idx)}.wav")
 
+        # RS41 calibration cache. The frequency lets rs41mod pre-load the last sonde seen on it.
+        if self.rs41_calibration_cache:
+            self.rs41_calcache_option = f"--calcache {os.path.join(autorx.logging_path, 'rs41_calcache.bin')} --jsn_cfq {int(self.sonde_freq)}"
+        else:
+            self.rs41_calcache_option = ""
+
         # iMet ID store. We latch in the first iMet ID we calculate, to avoid issues with iMet-1-RS units
         # which don't necessarily have a consistent packet count to time increment ratio.
         # This is a tradeoff between being able to handle multiple iMet sondes on a single frequency, and
@@ -268,6 +299,8 @@ class SondeDecoder(object):
 
         # This will become our decoder thread.
         self.decoder = None
+        # Set to wake up the decoder thread (decoder output closed, or decoder stopped).
+        self.decoder_wakeup = None
 
         self.exit_state = "OK"
 
@@ -354,6 +387,20 @@ class SondeDecoder(object):
             # 'Regular' decoder - just a single command.
             self.decoder_command = self.generate_decoder_command()
 
+        # Receive time of each frame, for latency tracing. The soft-input decoders take
+        # the sample time base from the fsk_demod --softblk blocks.
+        if self.decoder_command_2 is not None:
+            self.decoder_command_2 = add_rxtime_option(self.decoder_command_2)
+        elif self.decoder_command is not None:
+            self.decoder_command = add_rxtime_option(self.decoder_command)
+
+        # Binary telemetry records from the decoders which support them (see sonde_tlm.py)
+        if self.binary_output:
+            if self.decoder_command_2 is not None:
+                self.decoder_command_2 = add_binary_option(self.decoder_command_2)
+            elif self.decoder_command is not None:
+                self.decoder_command = add_binary_option(self.decoder_command)
+
         if self.decoder_command is None:
             self.log_error("Could not generate decoder command. Not starting decoder.")
             self.decoder_running = False
@@ -366,12 +413,42 @@ class SondeDecoder(object):
 
             # Start up the decoder thread.
             self.decode_process = None
-            self.async_reader = None
+            self.decoder_source = None
+            self.demod_source = None
+            self.decoder_wakeup = Event()
 
             self.decoder_running = True
             self.decoder = Thread(target=self.decoder_thread)
             self.decoder.start()
 
+    def get_sdr_iq_cmd(self, **kwargs):
+        """ get_sdr_iq_cmd, followed by the detection tap (iq_shmw --tee) if enabled. """
+        _cmd = get_sdr_iq_cmd(**kwargs)
+
+        if (self.tap_callback is None) or _cmd.startswith("false"):
+            return _cmd
+
+        _sample_rate = kwargs["sample_rate"]
+        _offsets = plan_tap_channels(_sample_rate, kwargs.get("channel_filter", None))
+        if len(_offsets) == 0:
+            self.log_debug("IQ bandwidth too narrow for tap detection.")
+            return _cmd
+
+        _shm_name = get_tap_shm_name(self.sonde_freq, self.rtl_device_idx)
+        self.tap_detector = TapDetector(
+            shm_name=_shm_name,
+            sonde_freq=self.sonde_freq,
+            sonde_type=self.sonde_type,
+            sample_rate=_sample_rate,
+            offsets=_offsets,
+            callback=self.tap_callback,
+            rs_path=self.rs_path,
+            quantization=self.tap_quantization,
+            spacing_limit=self.tap_spacing_limit,
+        )
+
+        return _cmd + get_tap_cmd(_shm_name, _sample_rate)
+
     def generate_decoder_command(self):
         """ Generate the shell command which runs the relevant radiosonde decoder - Standard decoders.
 
@@ -414,7 +491,7 @@ class SondeDecoder(object):
             if self.save_decode_audio:
                 decode_cmd += f" tee {self.save_decode_audio_path} |"
 
-            decode_cmd += "./rs41mod --ptu2 --json --jsnsubfrm1 2>/dev/null"
+            decode_cmd += f"./rs41mod --ptu2 --json --jsnsubfrm1 {self.rs41_calcache_option} 2>/dev/null"
 
         elif self.sonde_type == "RS92":
             # Decoding a RS92 requires either an ephemeris or an almanac file.
@@ -481,7 +558,7 @@ class SondeDecoder(object):
                 decode_cmd += f" tee {self.save_decode_audio_path} |"
 
             decode_cmd += (
-                "./rs92mod -vx -v --crc --ecc --vel --json %s %s 2>/dev/null"
+                "./rs92mod -vx -v --crc --ecc --vel --wls --json %s %s 2>/dev/null"
                 % (_rs92_gps_data, _ptu_opts)
             )
 
@@ -552,7 +629,7 @@ class SondeDecoder(object):
             else:
                 _sample_rate = 48000
 
-            decode_cmd = get_sdr_iq_cmd(
+            decode_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -585,7 +662,7 @@ class SondeDecoder(object):
 
             _sample_rate = 96000
 
-            decode_cmd = get_sdr_iq_cmd(
+            decode_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -610,7 +687,7 @@ class SondeDecoder(object):
 
             _sample_rate = 48000
 
-            decode_cmd = get_sdr_iq_cmd(
+            decode_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -637,7 +714,7 @@ class SondeDecoder(object):
 
             _sample_rate = 48000
 
-            decode_cmd = get_sdr_iq_cmd(
+            decode_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -673,7 +750,7 @@ class SondeDecoder(object):
             _baud_rate = 4800
             _sample_rate = 240000
 
-            demod_cmd = get_sdr_iq_cmd(
+            demod_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -735,7 +812,7 @@ class SondeDecoder(object):
 
             _sample_rate = 48000
 
-            decode_cmd = get_sdr_iq_cmd(
+            decode_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -760,7 +837,7 @@ class SondeDecoder(object):
             
             _sample_rate = 48000
 
-            decode_cmd = get_sdr_iq_cmd(
+            decode_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -787,7 +864,7 @@ class SondeDecoder(object):
             _sample_rate = 96000
             _if_bw = 64
 
-            decode_cmd = get_sdr_iq_cmd(
+            decode_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -804,8 +881,8 @@ class SondeDecoder(object):
             if self.save_decode_iq:
                 decode_cmd += f" tee {self.save_decode_iq_path} |"
 
-            # WXR301, via iq_dec as a FM Demod.
-            decode_cmd += f"./iq_dec --FM --IFbw {_if_bw} --lpFM --wav --iq 0.0 - {_sample_rate} 16 2>/dev/null | ./weathex301d -b --json"
+            # WXR301, IQ input, FM-demod in weathex301d.
+            decode_cmd += f"./weathex301d --json --IQ 0.0 --lpIQ --lpbw {_if_bw} - {_sample_rate} 16 2>/dev/null"
 
         elif self.sonde_type == "WXRPN9":
             # Weathex WxR-301D (PN9)
@@ -813,7 +890,7 @@ class SondeDecoder(object):
             _sample_rate = 96000
             _if_bw = 64
 
-            decode_cmd = get_sdr_iq_cmd(
+            decode_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -830,8 +907,8 @@ class SondeDecoder(object):
             if self.save_decode_iq:
                 decode_cmd += f" tee {self.save_decode_iq_path} |"
 
-            # WXR301, via iq_dec as a FM Demod.
-            decode_cmd += f"./iq_dec --FM --IFbw {_if_bw} --lpFM --wav --iq 0.0 - {_sample_rate} 16 2>/dev/null | ./weathex301d -b --json --pn9"
+            # WXR301, IQ input, FM-demod in weathex301d.
+            decode_cmd += f"./weathex301d --json --pn9 --IQ 0.0 --lpIQ --lpbw {_if_bw} - {_sample_rate} 16 2>/dev/null"
 
         elif self.sonde_type == "UDP":
             # UDP Input Mode.
@@ -877,7 +954,7 @@ class SondeDecoder(object):
             _upper = 5000
 
 
-            demod_cmd = get_sdr_iq_cmd(
+            demod_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -898,7 +975,7 @@ class SondeDecoder(object):
 
             # Updated 2025-08-26 to bump mask estimator to 5000 Hz, increase timing estimator duration, and change oversampling rate
             # From controlled testing this seems to improve weak signal performance.
-            demod_cmd += "./fsk_demod --cs16 -b %d -u %d -s --mask 5000 --nsym=300 -p 5 --stats=%d 2 %d %d - -" % (
+            demod_cmd += "./fsk_demod --cs16 -b %d -u %d -s --softblk --mask 5000 --nsym=300 -p 5 --stats=%d 2 %d %d - -" % (
                 _lower,
                 _upper,
                 _stats_rate,
@@ -906,7 +983,7 @@ class SondeDecoder(object):
                 _baud_rate,
             )
 
-            decode_cmd = f"./rs41mod --ptu2 --json --jsnsubfrm1 --softin -i {self.raw_file_option} 2>/dev/null"
+            decode_cmd = f"./rs41mod --ptu2 --json --jsnsubfrm1 --softin -i {self.raw_file_option} {self.rs41_calcache_option} 2>/dev/null"
 
             # RS41s transmit pulsed beacons - average over the last 2 frames, and use a peak-hold
             demod_stats = FSKDemodStats(averaging_time=2.0, peak_hold=True)
@@ -955,7 +1032,7 @@ class SondeDecoder(object):
                 _upper = 20000
 
 
-            demod_cmd = get_sdr_iq_cmd(
+            demod_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -973,7 +1050,7 @@ class SondeDecoder(object):
             if self.save_decode_iq:
                 demod_cmd += f" tee {self.save_decode_iq_path} |"
 
-            demod_cmd += "./fsk_demod --cs16 -b %d -u %d -s --stats=%d 2 %d %d - -" % (
+            demod_cmd += "./fsk_demod --cs16 -b %d -u %d -s --softblk --stats=%d 2 %d %d - -" % (
                 _lower,
                 _upper,
                 _stats_rate,
@@ -982,7 +1059,7 @@ class SondeDecoder(object):
             )
 
             decode_cmd = (
-                "./rs92mod -vx -v --crc --ecc --vel --json --softin -i %s %s 2>/dev/null"
+                "./rs92mod -vx -v --crc --ecc --vel --wls --json --softin -i %s %s 2>/dev/null"
                 % (_rs92_gps_data, _ptu_ops)
             )
 
@@ -999,7 +1076,7 @@ class SondeDecoder(object):
             _upper = 20000
 
 
-            demod_cmd = get_sdr_iq_cmd(
+            demod_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -1043,7 +1120,7 @@ class SondeDecoder(object):
             _lower = -5000
             _upper = 5000
 
-            demod_cmd = get_sdr_iq_cmd(
+            demod_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -1064,7 +1141,7 @@ class SondeDecoder(object):
 
             # NOTE - Using inverted soft decision outputs, so DFM type detection works correctly.
             # No mask estimator - DFMs seem to decode better without it!
-            demod_cmd += "./fsk_demod --cs16 -b %d -u %d -s -i --stats=%d 2 %d %d - -" % (
+            demod_cmd += "./fsk_demod --cs16 -b %d -u %d -s --softblk -i --stats=%d 2 %d %d - -" % (
                 _lower,
                 _upper,
                 _stats_rate,
@@ -1098,7 +1175,7 @@ class SondeDecoder(object):
             _lower = -10000
             _upper = 10000
 
-            demod_cmd = get_sdr_iq_cmd(
+            demod_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -1117,7 +1194,7 @@ class SondeDecoder(object):
                 demod_cmd += f" tee {self.save_decode_iq_path} |"
 
             demod_cmd += (
-                "./fsk_demod --cs16 -b %d -u %d -s -p %d --stats=%d 2 %d %d - -"
+                "./fsk_demod --cs16 -b %d -u %d -s --softblk -p %d --stats=%d 2 %d %d - -"
                 % (_lower, _upper, _p, _stats_rate, _sample_rate, _baud_rate)
             )
 
@@ -1140,7 +1217,7 @@ class SondeDecoder(object):
             _lower = -10000
             _upper = 10000
 
-            demod_cmd = get_sdr_iq_cmd(
+            demod_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -1159,7 +1236,7 @@ class SondeDecoder(object):
                 demod_cmd += f" tee {self.save_decode_iq_path} |"
 
             demod_cmd += (
-                "./fsk_demod --cs16 -b %d -u %d -s -p %d --stats=%d 2 %d %d - -"
+                "./fsk_demod --cs16 -b %d -u %d -s --softblk -p %d --stats=%d 2 %d %d - -"
                 % (_lower, _upper, _p, _stats_rate, _sample_rate, _baud_rate)
             )
 
@@ -1180,7 +1257,7 @@ class SondeDecoder(object):
             _lower = -10000
             _upper = 10000
 
-            demod_cmd = get_sdr_iq_cmd(
+            demod_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -1198,7 +1275,7 @@ class SondeDecoder(object):
             if self.save_decode_iq:
                 demod_cmd += f" tee {self.save_decode_iq_path} |"
 
-            demod_cmd += "./fsk_demod --cs16 -b %d -u %d -s --stats=%d 2 %d %d - -" % (
+            demod_cmd += "./fsk_demod --cs16 -b %d -u %d -s --softblk --stats=%d 2 %d %d - -" % (
                 _lower,
                 _upper,
                 _stats_rate,
@@ -1222,7 +1299,7 @@ class SondeDecoder(object):
             _lower = -10000
             _upper = 10000
 
-            demod_cmd = get_sdr_iq_cmd(
+            demod_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -1239,7 +1316,7 @@ class SondeDecoder(object):
             if self.save_decode_iq:
                 demod_cmd += f" tee {self.save_decode_iq_path} |"
 
-            demod_cmd += "./fsk_demod --cs16 -b %d -u %d -s --stats=%d 2 %d %d - -" % (
+            demod_cmd += "./fsk_demod --cs16 -b %d -u %d -s --softblk --stats=%d 2 %d %d - -" % (
                 _lower,
                 _upper,
                 _stats_rate,
@@ -1263,7 +1340,7 @@ class SondeDecoder(object):
             _lower = -10000
             _upper = 10000
 
-            demod_cmd = get_sdr_iq_cmd(
+            demod_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -1281,7 +1358,7 @@ class SondeDecoder(object):
             if self.save_decode_iq:
                 demod_cmd += f" tee {self.save_decode_iq_path} |"
 
-            demod_cmd += "./fsk_demod --cs16 -s -b %d -u %d --stats=%d 2 %d %d - -" % (
+            demod_cmd += "./fsk_demod --cs16 -s --softblk -b %d -u %d --stats=%d 2 %d %d - -" % (
                 _lower,
                 _upper,
                 _stats_rate,
@@ -1309,7 +1386,7 @@ class SondeDecoder(object):
             _baud_rate = 4800
             _sample_rate = 220000
 
-            demod_cmd = get_sdr_iq_cmd(
+            demod_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -1350,7 +1427,7 @@ class SondeDecoder(object):
             _lower = -15000
             _upper = 15000
 
-            demod_cmd = get_sdr_iq_cmd(
+            demod_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -1368,7 +1445,7 @@ class SondeDecoder(object):
             if self.save_decode_iq:
                 demod_cmd += f" tee {self.save_decode_iq_path} |"
 
-            demod_cmd += "./fsk_demod --cs16 -s -b %d -u %d --stats=%d 2 %d %d - -" % (
+            demod_cmd += "./fsk_demod --cs16 -s --softblk -b %d -u %d --stats=%d 2 %d %d - -" % (
                 _lower,
                 _upper,
                 _stats_rate,
@@ -1392,7 +1469,7 @@ class SondeDecoder(object):
             _lower = -40000
             _upper = 40000
 
-            demod_cmd = get_sdr_iq_cmd(
+            demod_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -1436,7 +1513,7 @@ class SondeDecoder(object):
             _lower = -40000
             _upper = 40000
 
-            demod_cmd = get_sdr_iq_cmd(
+            demod_cmd = self.get_sdr_iq_cmd(
                 sdr_type = self.sdr_type,
                 frequency = self.sonde_freq,
                 sample_rate = _sample_rate,
@@ -1475,22 +1552,34 @@ class SondeDecoder(object):
 
         return (demod_cmd, decode_cmd, demod_stats)
 
-    def stats_thread(self, asyncreader):
-        """ Process demodulator statistics from a supplied AsynchronousFileReader object (which will be hooked into stderr from fsk_demod) """
-        while (not asyncreader.eof()) and self.decoder_running:
-            for _line in asyncreader.readlines():
-                self.demod_stats.update(_line)
-            # Avoid spinlocking..
-            # Probably about time we looked at using async for this stuff...
-            time.sleep(0.2)
+    def decoder_output(self, data):
+        """ Handle a line / record of decoder output. Called from the reactor thread. """
+        if not self.decoder_running:
+            return
+
+        # Pass the line into the handler, and see if it is OK.
+        if (data != None) and (data != b""):
+            _ok = self.handle_decoder_line(data)
+
+            # If we decoded a valid JSON blob, update our last-packet time.
+            if _ok:
+                self.last_packet_time = time.time()
 
-        asyncreader.stop()
+        # The handler may have closed the decoder (version mismatch, encrypted sonde).
+        if not self.decoder_running:
+            self.decoder_wakeup.set()
+
+    def decoder_eof(self):
+        """ The decoder subprocess has closed its output. Called from the reactor thread. """
+        self.decoder_output_eof = True
+        self.decoder_wakeup.set()
 
     def decoder_thread(self):
         """ Runs the supplied decoder command(s) as a subprocess, and passes returned lines to handle_decoder_line. """
 
         # Timeout Counter.
-        _last_packet = time.time()
+        self.last_packet_time = time.time()
+        self.decoder_output_eof = False
 
         if self.decoder_command_2 is None:
             # No second decoder command, so we only need to process stdout from the one process.
@@ -1528,52 +1617,44 @@ class SondeDecoder(object):
                 preexec_fn=os.setsid,
             )
 
-            self.demod_reader = AsynchronousFileReader(
-                self.demod_process.stderr, autostart=True
+            # Demodulator statistics, from stderr.
+            self.demod_source = get_reactor().register(
+                self.demod_process.stderr, self.demod_stats.update
             )
 
-            # Start thread to process demodulator stats.
-            self.demod_stats_thread = Thread(
-                target=self.stats_thread, args=(self.demod_reader,)
-            )
-            self.demod_stats_thread.start()
-
-        self.async_reader = AsynchronousFileReader(
-            self.decode_process.stdout, autostart=True
+        # Decoder output (lines, or lines and binary telemetry records), read by the reactor thread.
+        self.decoder_source = get_reactor().register(
+            self.decode_process.stdout,
+            self.decoder_output,
+            eof_handler=self.decoder_eof,
+            parser=split_records if self.binary_output else split_lines,
         )
 
         self.log_info("Starting decoder subprocess.")
 
-        while (not self.async_reader.eof()) and self.decoder_running:
-            # Read in any lines available in the async reader queue.
-            for _line in self.async_reader.readlines():
-                if (_line != None) and (_line != ""):
-                    # Pass the line into the handler, and see if it is OK.
-                    _ok = self.handle_decoder_line(_line)
-
-                    # If we decoded a valid JSON blob, update our last-packet time.
-                    if _ok:
-                        _last_packet = time.time()
-
-            # Check timeout counter.
-            if (
-                (self.timeout > 0)
-                and (time.time() > (_last_packet + self.timeout))
-                and (not self.udp_mode)
-            ):
-                # If we have not seen data for a while, break.
-                self.log_error("RX Timed out.")
-                self.exit_state = "Timeout"
-                break
+        if self.tap_detector is not None:
+            self.tap_detector.start()
+
+        # Wait until the decoder exits, times out, or is stopped. The output is handled by the reactor.
+        while (not self.decoder_output_eof) and self.decoder_running:
+            if (self.timeout > 0) and (not self.udp_mode):
+                _wait = self.last_packet_time + self.timeout - time.time()
+                if _wait <= 0:
+                    # If we have not seen data for a while, break.
+                    self.log_error("RX Timed out.")
+                    self.exit_state = "Timeout"
+                    break
             else:
-                # Otherwise, sleep for a short time.
-                time.sleep(0.1)
+                _wait = None
+
+            self.decoder_wakeup.wait(_wait)
 
         # Either our subprocess has exited, or the user has asked to close the process.
         # Try many things to kill off the subprocess.
         try:
-            # Stop the async reader
-            self.async_reader.stop()
+            # Stop reading the decoder output.
+            get_reactor().unregister(self.decoder_source)
+            get_reactor().unregister(self.demod_source)
             # Send a SIGKILL to the subprocess PID via OS.
             try:
                 os.killpg(os.getpgid(self.decode_process.pid), signal.SIGKILL)
@@ -1589,13 +1670,13 @@ class SondeDecoder(object):
                     self.demod_process.kill()
             except Exception as e:
                 self.log_debug("SIGKILL via subprocess.kill failed - %s" % str(e))
-            # Finally, join the async reader.
-            self.async_reader.join()
-
         except Exception as e:
             traceback.print_exc()
             self.log_error("Error while killing subprocess - %s" % str(e))
 
+        if self.tap_detector is not None:
+            self.tap_detector.stop()
+
         self.log_info("Closed decoder subprocess.")
         self.decoder_running = False
 
@@ -1604,22 +1685,29 @@ class SondeDecoder(object):
             exporters.
 
         Args:
-            data (str, bytearray): One line of text output from the decoder subprocess.
+            data (str, bytearray, dict): One line of text output from the decoder subprocess,
+                or a telemetry record already parsed by sonde_tlm.split_records().
 
         Returns:
             bool:   True if the line was decoded to a JSON object correctly, False otherwise.
         """
 
+        # Arrival time, for latency tracing.
+        _line_time = time.time()
+
+        # Binary telemetry records arrive as dictionaries.
+        _record = type(data) is dict
+
         # Catch 'bad' first characters.
         try:
-            _first_char = data.decode("ascii")[0]
+            _first_char = "{" if _record else data.decode("ascii")[0]
         except UnicodeDecodeError:
             return
 
         # Don't even try and decode lines which don't start with a '{'
         # These may be other output from the decoder, which we shouldn't try to parse.
         # If we have raw logging enabled, log these lines to disk.
-        if data.decode("ascii")[0] != "{":
+        if _first_char != "{":
 
             # Save the line verbatim to the raw data file, if we have that enabled
             if self.raw_file:
@@ -1629,11 +1717,14 @@ class SondeDecoder(object):
 
         else:
 
-            try:
-                _telemetry = json.loads(data.decode("ascii"))
-            except Exception as e:
-                self.log_debug("Line could not be parsed as JSON - %s" % str(e))
-                return False
+            if _record:
+                _telemetry = data
+            else:
+                try:
+                    _telemetry = json.loads(data.decode("ascii"))
+                except Exception as e:
+                    self.log_debug("Line could not be parsed as JSON - %s" % str(e))
+                    return False
 
             # Check the JSON blob has been parsed as a dictionary
             if type(_telemetry) is not dict:
@@ -1667,6 +1758,11 @@ class SondeDecoder(object):
                 if _field not in _telemetry:
                     _telemetry[_field] = self.DECODER_OPTIONAL_FIELDS[_field]
 
+            # Receive time of the frame (decoder, --rxtime). All later stages record their latency
+            # against this time. Frames without it (decoders without a sample time base) are not traced.
+            if "rx_time" in _telemetry:
+                record_latency("decoder", _telemetry["rx_time"], _line_time)
+
             # Check for an encrypted flag, and check if it is set.
             # Currently encrypted == true indicates an encrypted RS41-SGM. 
             data_not_encrypted = True
@@ -1993,11 +2089,14 @@ class SondeDecoder(object):
                 return
             else:
                 if _telem_ok == "OK":
+                    _export_time = time.time()
+                    record_latency("handle", _line_time, _export_time)
                     for _exporter in self.exporters:
                         try:
                             _exporter(_telemetry)
                         except Exception as e:
                             self.log_error("Exporter Error %s" % str(e))
+                    record_latency("exporters", _export_time)
 
             return _telem_ok
 
@@ -2068,6 +2167,8 @@ class SondeDecoder(object):
             self.exit_state = "TempBlock"
         
         self.decoder_running = False
+        if self.decoder_wakeup is not None:
+            self.decoder_wakeup.set()
 
         if self.decoder is not None and (not nowait):
             self.decoder.join()
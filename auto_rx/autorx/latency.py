@@ -0,0 +1,124 @@
+#!/usr/bin/env python
+#
+#   radiosonde_auto_rx - Telemetry Latency Tracing
+#
+#   Telemetry frames carry 'rx_time', the time their header was received (from the
+#   decoder, with --rxtime). Frames from decoders without a sample time base have no
+#   'rx_time' and only appear in the 'handle' and 'exporters' histograms. Each stage
+#   a frame passes through records the time since then into a histogram:
+#
+#       decoder         - rx_time -> line handled in decode.py (decoding, pipe, reader queue)
+#       handle          - line handled -> passed to the exporters (parsing, filtering)
+#       exporters       - time spent in the exporter add() calls
+#       logger          - rx_time -> written to the log file
+#       web             - rx_time -> sent to the web clients
+#       sondehub_queue  - rx_time -> SondeHub batch upload started
+#       sondehub        - rx_time -> SondeHub upload completed
+#
+#   The histograms are available from the web interface (/get_latency_stats).
+#
+#   Released under GNU GPL v3 or later
+#
+import threading
+import time
+
+
+# Histogram bucket upper limits, in milliseconds. The last bucket takes everything above.
+LATENCY_BUCKETS_MS = [1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 60000]
+
+# Stages, in the order a frame passes through them.
+LATENCY_STAGES = [
+    "decoder",
+    "handle",
+    "exporters",
+    "logger",
+    "web",
+    "sondehub_queue",
+    "sondehub",
+]
+
+
+class LatencyHistogram(object):
+    """ Histogram of the latencies of one stage. """
+
+    def __init__(self):
+        self.reset()
+
+    def reset(self):
+        self.counts = [0] * (len(LATENCY_BUCKETS_MS) + 1)
+        self.count = 0
+        self.sum = 0.0
+        self.max = 0.0
+        self.last = 0.0
+
+    def add(self, latency_ms):
+        _i = 0
+        while _i < len(LATENCY_BUCKETS_MS) and latency_ms > LATENCY_BUCKETS_MS[_i]:
+            _i += 1
+        self.counts[_i] += 1
+        self.count += 1
+        self.sum += latency_ms
+        self.max = max(self.max, latency_ms)
+        self.last = latency_ms
+
+    def percentile(self, p):
+        """ Upper limit of the bucket containing the p-th percentile (the maximum for the last bucket) """
+        if self.count == 0:
+            return 0.0
+        _n = p / 100.0 * self.count
+        _acc = 0
+        for _i, _c in enumerate(self.counts):
+            _acc += _c
+            if _acc >= _n and _c > 0:
+                if _i < len(LATENCY_BUCKETS_MS):
+                    return min(float(LATENCY_BUCKETS_MS[_i]), self.max)
+                break
+        return self.max
+
+    def to_dict(self):
+        return {
+            "count": self.count,
+            "mean_ms": round(self.sum / self.count, 1) if self.count else 0.0,
+            "p50_ms": self.percentile(50),
+            "p90_ms": self.percentile(90),
+            "p99_ms": self.percentile(99),
+            "max_ms": round(self.max, 1),
+            "last_ms": round(self.last, 1),
+            "counts": list(self.counts),
+        }
+
+
+_lock = threading.Lock()
+_histograms = {_stage: LatencyHistogram() for _stage in LATENCY_STAGES}
+
+
+def record_latency(stage, start_time, end_time=None):
+    """ Record the latency of a stage.
+
+    Args:
+        stage (str): Stage name (see LATENCY_STAGES; other names get their own histogram).
+        start_time (float): Start time (unix time), usually the frame's rx_time.
+        end_time (float): End time (unix time). Defaults to now.
+    """
+    if end_time is None:
+        end_time = time.time()
+
+    try:
+        # Clock steps / recordings with a given start time can give negative values.
+        _latency_ms = max(0.0, (end_time - float(start_time)) * 1000.0)
+    except (TypeError, ValueError):
+        return
+
+    with _lock:
+        if stage not in _histograms:
+            _histograms[stage] = LatencyHistogram()
+        _histograms[stage].add(_latency_ms)
+
+
+def get_latency_stats():
+    """ Return the latency histograms as a dictionary (JSON-serialisable) """
+    with _lock:
+        _stages = {_stage: _hist.to_dict() for _stage, _hist in _histograms.items()}
+
+    return {"buckets_ms": LATENCY_BUCKETS_MS, "stages": _stages}
+
@@ -11,8 +11,9 @@ import glob
 import logging
 import os
 import time
-from queue import Queue
+from queue import Queue, Empty
 from threading import Thread
+from .latency import record_latency
 
 
 class TelemetryLogger(object):
@@ -105,20 +106,29 @@ class TelemetryLogger(object):
 
         while self.input_processing_running:
 
-            # Process everything in the queue.
-            while self.input_queue.qsize() > 0:
+            # Wait for new data (up to 0.5 s, to close old logs and check for shutdown),
+            # then process everything in the queue.
+            try:
+                _telem = self.input_queue.get(timeout=0.5)
+            except Empty:
+                _telem = None
+
+            while _telem is not None:
                 try:
-                    _telem = self.input_queue.get_nowait()
                     self.write_telemetry(_telem)
+                    if "rx_time" in _telem:
+                        record_latency("logger", _telem["rx_time"])
                 except Exception as e:
                     self.log_error("Error processing telemetry dict - %s" % str(e))
 
+                try:
+                    _telem = self.input_queue.get_nowait()
+                except Empty:
+                    _telem = None
+
             # Close any un-needed log handlers.
             self.cleanup_logs()
 
-            # Sleep while waiting for some new data.
-            time.sleep(0.5)
-
         self.log_info("Stopped Telemetry Logger Thread.")
 
     def telemetry_to_string(self, telemetry):
@@ -0,0 +1,191 @@
+#!/usr/bin/env python
+#
+#   radiosonde_auto_rx - Decoder Output Reactor
+#
+#   One thread reads the stdout/stderr pipes of all running decoders (selectors, i.e. epoll on Linux),
+#   splits the output into lines or binary telemetry records straight from a per-pipe buffer,
+#   and passes them to the handler registered for the pipe. Handlers run on the reactor thread,
+#   so they should not block (the telemetry exporters only queue the data).
+#
+#   Released under GNU GPL v3 or later
+#
+import logging
+import os
+import selectors
+import threading
+import traceback
+from .sonde_tlm import split_lines
+
+
+class PipeSource(object):
+    """ A pipe registered with the reactor. """
+
+    def __init__(self, fd, handler, eof_handler, parser, buffer_size):
+        self.fd = fd
+        self.handler = handler
+        self.eof_handler = eof_handler
+        self.parser = parser
+        self.buf = bytearray(buffer_size)
+        self.view = memoryview(self.buf)
+        self.fill = 0
+        self.active = True
+
+    def dispatch(self, item):
+        """ Pass a line / record to the handler, unless the source has been unregistered meanwhile. """
+        if not self.active:
+            return
+        try:
+            self.handler(item)
+        except Exception as e:
+            traceback.print_exc()
+            logging.error("Reactor - Error in output handler - %s" % str(e))
+
+    def grow(self):
+        """ Double the buffer (a line or record longer than the buffer). """
+        self.view.release()
+        self.buf = self.buf + bytearray(len(self.buf))
+        self.view = memoryview(self.buf)
+
+
+class PipeReactor(object):
+    """ Multiplexes decoder output pipes onto one thread. """
+
+    # Initial read buffer size per pipe. Binary records are < 64 kB.
+    BUFFER_SIZE = 65536
+
+    def __init__(self):
+        self.selector = selectors.DefaultSelector()
+
+        # Register/unregister requests from other threads, applied by the reactor thread.
+        self.lock = threading.Lock()
+        self.pending = []
+
+        # Wakes up the reactor thread for pending requests.
+        self.wakeup_r, self.wakeup_w = os.pipe()
+        os.set_blocking(self.wakeup_r, False)
+        os.set_blocking(self.wakeup_w, False)
+        self.selector.register(self.wakeup_r, selectors.EVENT_READ, None)
+
+        self.thread = threading.Thread(target=self.run, daemon=True)
+        self.thread.start()
+
+    def register(self, fileobj, handler, eof_handler=None, parser=split_lines):
+        """ Start reading a pipe.
+
+        Args:
+            fileobj: Pipe to read (e.g. Popen.stdout). It must not be read from elsewhere.
+            handler (function): Called with each line (bytes), or record (dict, see parser).
+            eof_handler (function): Called when the pipe is closed, after the last line.
+            parser (function): Splits the output, see sonde_tlm.split_lines() / split_records().
+
+        Returns:
+            PipeSource: Handle to unregister the pipe.
+        """
+        _source = PipeSource(
+            fileobj.fileno(), handler, eof_handler, parser, self.BUFFER_SIZE
+        )
+        os.set_blocking(_source.fd, False)
+        self.request("add", _source)
+        return _source
+
+    def unregister(self, source):
+        """ Stop reading a pipe. No further lines / records are passed on once this returns. """
+        if source is None:
+            return
+        source.active = False
+        self.request("remove", source)
+
+    def request(self, op, source):
+        with self.lock:
+            self.pending.append((op, source))
+        try:
+            os.write(self.wakeup_w, b"\x00")
+        except BlockingIOError:
+            # Wakeup pipe full - the reactor has a wakeup pending anyway.
+            pass
+
+    def apply_pending(self):
+        with self.lock:
+            _pending = self.pending
+            self.pending = []
+
+        for _op, _source in _pending:
+            try:
+                _key = self.selector.get_key(_source.fd)
+            except (KeyError, ValueError):
+                _key = None
+
+            try:
+                if _op == "add":
+                    if not _source.active:
+                        continue
+                    if _key is not None:
+                        # Stale entry of a closed pipe with the same descriptor number.
+                        self.selector.unregister(_source.fd)
+                    self.selector.register(_source.fd, selectors.EVENT_READ, _source)
+                elif _key is not None and _key.data is _source:
+                    self.selector.unregister(_source.fd)
+            except (KeyError, ValueError, OSError) as e:
+                logging.error("Reactor - Could not %s pipe - %s" % (_op, str(e)))
+
+    def read(self, source):
+        """ Read from a pipe and pass on all complete lines / records. """
+        try:
+            _n = os.readv(source.fd, [source.view[source.fill :]])
+        except BlockingIOError:
+            return
+        except OSError:
+            _n = 0
+
+        if _n == 0:
+            # EOF - pass on what is left, and drop the pipe.
+            source.parser(source.buf, 0, source.fill, source.dispatch, final=True)
+            source.fill = 0
+            try:
+                self.selector.unregister(source.fd)
+            except (KeyError, ValueError):
+                pass
+            if source.active and source.eof_handler:
+                source.eof_handler()
+            source.active = False
+            return
+
+        source.fill += _n
+        _used = source.parser(source.buf, 0, source.fill, source.dispatch)
+
+        # Move the partial line / record to the start of the buffer.
+        _rest = source.fill - _used
+        if _used > 0 and _rest > 0:
+            source.buf[0:_rest] = source.buf[_used : source.fill]
+        source.fill = _rest
+
+        if source.fill == len(source.buf):
+            source.grow()
+
+    def run(self):
+        while True:
+            self.apply_pending()
+
+            for _key, _events in self.selector.select():
+                if _key.data is None:
+                    # Wakeup - drain the pipe, the requests are applied at the top of the loop.
+                    try:
+                        while os.read(self.wakeup_r, 4096):
+                            pass
+                    except BlockingIOError:
+                        pass
+                else:
+                    self.read(_key.data)
+
+
+_reactor = None
+_reactor_lock = threading.Lock()
+
+
+def get_reactor():
+    """ Return the reactor, starting it on first use. """
+    global _reactor
+    with _reactor_lock:
+        if _reactor is None:
+            _reactor = PipeReactor()
+        return _reactor
@@ -8,22 +8,21 @@
 import autorx
 import datetime
 import logging
-import math
 import numpy as np
 import os
 import sys
 import platform
+import shutil
+import signal
 import subprocess
+import tempfile
 import time
 import traceback
 from io import StringIO
 from threading import Thread, Lock
 from types import FunctionType, MethodType
-from .utils import (
-    detect_peaks,
-    timeout_cmd
-)
-from .sdr_wrappers import test_sdr, reset_sdr, get_sdr_name, get_sdr_iq_cmd, get_sdr_fm_cmd, get_power_spectrum, shutdown_sdr
+from .utils import timeout_cmd
+from .sdr_wrappers import test_sdr, reset_sdr, get_sdr_name, get_sdr_iq_cmd, get_sdr_fm_cmd, get_sdr_wideband_iq_cmd, get_power_peaks, shutdown_sdr
 
 # Import async scanning for concurrent peak detection
 try:
@@ -236,11 +235,11 @@ def parse_dft_detect_output(ret_output, sdr_name):
         sdr_name (str): SDR name for logging
 
     Returns:
-        tuple: (sonde_type, offset_est) or (None, 0.0) if no sonde detected
+        tuple: (sonde_type, offset_est, score) or (None, 0.0, 0.0) if no sonde detected
     """
     # Check for no output from dft_detect.
     if ret_output is None or ret_output == "":
-        return (None, 0.0)
+        return (None, 0.0, 0.0)
 
     # Split the line into sonde type and correlation score.
     _fields = ret_output.split(":")
@@ -249,7 +248,7 @@ def parse_dft_detect_output(ret_output, sdr_name):
         logging.error(
             "Scanner - malformed output from dft_detect: %s" % ret_output.strip()
         )
-        return (None, 0.0)
+        return (None, 0.0, 0.0)
 
     _type = _fields[0]
     _score = _fields[1]
@@ -266,7 +265,7 @@ def parse_dft_detect_output(ret_output, sdr_name):
         logging.error(
             "Scanner - Error parsing dft_detect output: %s" % ret_output.strip()
         )
-        return (None, 0.0)
+        return (None, 0.0, 0.0)
 
     _sonde_type = None
 
@@ -407,7 +406,7 @@ def parse_dft_detect_output(ret_output, sdr_name):
     else:
         _sonde_type = None
 
-    return (_sonde_type, _offset_est)
+    return (_sonde_type, _offset_est, _score)
 
 
 def detect_sonde(
@@ -443,7 +442,8 @@ def detect_sonde(
         wideband_sondes (bool): Use a wider detection filter to allow detection of Weathex and wideband iMet sondes.
 
     Returns:
-        str/None: Returns None if no sonde found, otherwise returns a sonde type, from the following:
+        tuple: (sonde_type, offset_est, score), see parse_dft_detect_output().
+        sonde_type is None if no sonde found, otherwise a sonde type, from the following:
             'RS41' - Vaisala RS41
             'RS92' - Vaisala RS92
             'DFM' - Graw DFM06 / DFM09 (similar telemetry formats)
@@ -636,13 +636,13 @@ def detect_sonde(
             logging.debug(
                 f"Scanner ({_sdr_name}) - dft_detect exited in {_runtime:.1f} seconds with return code {e.returncode}."
             )
-            return (None, 0.0)
+            return (None, 0.0, 0.0)
     except Exception as e:
         # Something broke when running the detection function.
         logging.error(
             f"Scanner ({_sdr_name}) - Error when running dft_detect - {str(e)}"
         )
-        return (None, 0.0)
+        return (None, 0.0, 0.0)
     finally:
         # Always release the SDR channel, even on failure
         shutdown_sdr(sdr_type, rtl_device_idx, sdr_hostname, frequency, scan=True)
@@ -655,6 +655,195 @@ def detect_sonde(
     # Use shared parsing function to ensure consistency with async scanning
     return parse_dft_detect_output(ret_output, _sdr_name)
 
+# Channelized detection on a RTLSDR: capture sample rates (multiples of 96 kHz, so the
+# channels decimate exactly to 48 / 96 kHz), and the usable fraction of the capture bandwidth.
+CHANNELIZER_SAMPLE_RATES = [960000, 1152000, 1536000, 1920000, 2400000]
+CHANNELIZER_USABLE_BW = 0.8
+# Keep channels this far away from the centre frequency (DC spike of the RTLSDR).
+CHANNELIZER_DC_GUARD = 20000
+# Maximum number of channels per capture (iq_dec --chan limit).
+CHANNELIZER_MAX_CHANNELS = 32
+
+
+def plan_channelized_captures(frequencies, channel_bw):
+    """Group peak frequencies into wideband captures.
+
+    Args:
+        frequencies (list): Peak frequencies, in Hz.
+        channel_bw (int): Channel (IF) sample rate, in Hz.
+
+    Returns:
+        list: [(centre frequency, sample rate, [frequencies]), ...]
+    """
+    _max_rate = CHANNELIZER_SAMPLE_RATES[-1]
+    # Room for the channel bandwidth and for moving the centre off a channel: the shift below
+    # moves it by up to 4 guards, which widens the capture by up to 8 guards.
+    _max_span = _max_rate * CHANNELIZER_USABLE_BW - channel_bw - 8 * CHANNELIZER_DC_GUARD
+
+    # Greedy grouping, in frequency order.
+    _groups = []
+    for _freq in sorted(frequencies):
+        if len(_groups) > 0 and (_freq - _groups[-1][0]) <= _max_span and len(_groups[-1]) < CHANNELIZER_MAX_CHANNELS:
+            _groups[-1].append(_freq)
+        else:
+            _groups.append([_freq])
+
+    _captures = []
+    for _group in _groups:
+        _mid = (_group[0] + _group[-1]) / 2.0
+        # Centre between the outer channels, moved if a channel would be on the DC spike.
+        for _shift in [0, 2, -2, 4, -4]:
+            _centre = round(_mid + _shift * CHANNELIZER_DC_GUARD)
+            if all(abs(_f - _centre) >= CHANNELIZER_DC_GUARD for _f in _group):
+                break
+
+        _half_bw = max(abs(_f - _centre) for _f in _group) + channel_bw / 2.0
+        _rate = _max_rate
+        for _r in CHANNELIZER_SAMPLE_RATES:
+            if 2 * _half_bw <= _r * CHANNELIZER_USABLE_BW:
+                _rate = _r
+                break
+
+        _captures.append((_centre, _rate, _group))
+
+    return _captures
+
+
+def detect_sondes_channelized(
+    frequencies,
+    rs_path="./",
+    dwell_time=10,
+    sdr_type="RTLSDR",
+    rtl_sdr_path="rtl_sdr",
+    rtl_device_idx=0,
+    ppm=0,
+    gain=-1,
+    bias=False,
+    wideband_sondes=False
+):
+    """Attempt to detect radiosondes on several frequencies at once, from one wideband capture.
+
+    The SDR captures a block of IQ covering the frequencies, iq_dec --chan splits it into one IF channel per
+    frequency (written into named pipes), and a dft_detect per channel runs on each of them concurrently.
+    Frequencies spread further than one capture can cover are handled in several captures.
+
+    Args:
+        frequencies (list): Frequencies to perform the detection on, in Hz. 400-406 MHz sondes only (IQ detection).
+        Other arguments: see detect_sonde(). Only RTLSDRs are supported.
+
+    Returns:
+        list: [(frequency, sonde_type, offset_est, score), ...] for each frequency tested,
+            sonde_type is None if no sonde was detected.
+
+    Raises:
+        IOError: If a capture timed out (possible SDR lockup).
+    """
+
+    if wideband_sondes:
+        _iq_bw = 96000
+        _if_bw = 64
+    else:
+        _iq_bw = 48000
+        _if_bw = 15
+
+    _sdr_name = get_sdr_name(sdr_type, rtl_device_idx = rtl_device_idx)
+
+    _results = []
+
+    for (_centre, _rate, _group) in plan_channelized_captures(frequencies, _iq_bw):
+
+        _capture_cmd = get_sdr_wideband_iq_cmd(
+            sdr_type,
+            _centre,
+            _rate,
+            _rate * (dwell_time + 1),
+            rtl_device_idx = rtl_device_idx,
+            rtl_sdr_path = rtl_sdr_path,
+            ppm = ppm,
+            gain = gain,
+            bias = bias
+        )
+        if _capture_cmd is None:
+            raise ValueError(f"Channelized detection not supported on SDR type {sdr_type}")
+
+        _tempdir = tempfile.mkdtemp(prefix="autorx_scan_")
+        _detectors = []
+        _capture = None
+
+        try:
+            # One dft_detect per channel, reading from a named pipe.
+            _chan_args = ""
+            for _i, _freq in enumerate(_group):
+                _fifo = os.path.join(_tempdir, f"ch{_i}")
+                os.mkfifo(_fifo)
+                _chan_args += f"--chan {(_freq - _centre) / _rate:.8f} {_fifo} "
+
+                _detectors.append(
+                    subprocess.Popen(
+                        [
+                            os.path.join(rs_path, "dft_detect"),
+                            "-t", str(dwell_time),
+                            "--iq", "--bw", str(_if_bw), "--dc",
+                            "-", str(_iq_bw), "16",
+                            _fifo
+                        ],
+                        stdout=subprocess.PIPE,
+                        stderr=subprocess.DEVNULL
+                    )
+                )
+
+            _cmd = (
+                _capture_cmd
+                + os.path.join(rs_path, "iq_dec")
+                + f" --bo 16 {f'--IFbw {_iq_bw // 1000} ' if _iq_bw > 80000 else ''}"
+                + _chan_args
+                + f"- {int(_rate)} 8 2>/dev/null"
+            )
+
+            logging.debug(f"Scanner ({_sdr_name}) - Using channelized detection command: {_cmd}")
+            logging.debug(
+                f"Scanner ({_sdr_name}) - Attempting sonde detection on {len(_group)} frequencies (MHz): "
+                f"{[_f / 1e6 for _f in _group]}, capture at {_centre / 1e6:.3f} MHz, {_rate / 1e6:.3f} MS/s"
+            )
+
+            _start = time.time()
+            _capture = subprocess.Popen(_cmd, shell=True, start_new_session=True)
+            try:
+                _capture.wait(timeout=dwell_time * 2 + 10)
+            except subprocess.TimeoutExpired:
+                logging.error(f"Scanner ({_sdr_name}) - Channelized detection timed out.")
+                raise IOError("Possible SDR lockup.")
+
+            for _freq, _detector in zip(_group, _detectors):
+                try:
+                    (_output, _) = _detector.communicate(timeout=dwell_time + 5)
+                    _output = _output.decode("utf8")
+                except subprocess.TimeoutExpired:
+                    _output = ""
+
+                (_type, _offset_est, _score) = parse_dft_detect_output(_output, _sdr_name)
+                _results.append((_freq, _type, _offset_est, _score))
+
+            logging.debug(
+                f"Scanner ({_sdr_name}) - Channelized detection on {len(_group)} frequencies took {time.time() - _start:.1f} seconds."
+            )
+
+        finally:
+            # Clean up anything still running (timeout / error), and the named pipes.
+            if _capture is not None and _capture.poll() is None:
+                try:
+                    os.killpg(_capture.pid, signal.SIGKILL)
+                except OSError:
+                    pass
+                _capture.wait()
+            for _detector in _detectors:
+                if _detector.poll() is None:
+                    _detector.kill()
+                    _detector.wait()
+            shutil.rmtree(_tempdir, ignore_errors=True)
+
+    return _results
+
 
 #
 # Radiosonde Scanner Class
@@ -705,7 +894,10 @@ class SondeScanner(object):
         temporary_block_time=60,
         ngp_tweak=False,
         wideband_sondes=False,
-        max_async_scan_workers=4
+        max_async_scan_workers=4,
+        scan_scheduler=None,
+        scan_budget=0,
+        channelized_scan=False
     ):
         """Initialise a Sonde Scanner Object.
 
@@ -756,6 +948,12 @@ class SondeScanner(object):
             temporary_block_time (int): How long (minutes) frequencies in the temporary block list should remain blocked for.
             ngp_tweak (bool): Narrow the detection filter when searching for 1680 MHz sondes, to enhance detection of RS92-NGPs.
             wideband_sondes (bool): Use a wider detection filter to allow detection of Weathex and wideband iMet sondes.
+            max_async_scan_workers (int): Maximum number of concurrent detections (KA9Q only).
+            scan_scheduler (ScanScheduler): If provided, order and skip the peaks based on their history (see scan_scheduler.py).
+                The same object should be passed to every scanner instance, so the history is kept across scans.
+            scan_budget (int): With a scan_scheduler, limit the detection time per scan to this many seconds (0 = no limit).
+            channelized_scan (bool): RTLSDR only - detect on all peaks at once, from one wideband capture
+                (see detect_sondes_channelized()), instead of one peak after the other.
         """
 
         # Thread flag. This is set to True when a scan is running.
@@ -796,6 +994,9 @@ class SondeScanner(object):
         self.save_detection_audio = save_detection_audio
         self.wideband_sondes = wideband_sondes
         self.max_async_scan_workers = max_async_scan_workers
+        self.scan_scheduler = scan_scheduler
+        self.scan_budget = scan_budget
+        self.channelized_scan = channelized_scan
 
         # Temporary block list.
         self.temporary_block_list = temporary_block_list.copy()
@@ -967,12 +1168,37 @@ class SondeScanner(object):
         global scan_result
 
         _search_results = []
+        # Set if the peaks have been planned by the scan scheduler, which then gets the detection results.
+        _scheduled = False
 
         if len(self.only_scan) == 0:
             # No only_scan frequencies provided - perform a scan.
 
-            (freq, power, step) = get_power_spectrum(
+            # Capture the spectrum, and search it for peaks (power_peaks utility).
+            # Peaks are sorted by power, quantized and de-duplicated, limited to the
+            # min_freq/max_freq range, never_scan frequencies removed, truncated to max_peaks,
+            # and the always_scan frequencies are put in front.
+            # With the scan scheduler, max_peaks is applied to the planned peaks instead.
+            #
+            # Never scan list & Temporary block list behaviour change as of v1.2.3
+            # Was: peak_frequencies==_frequency   (This only matched an exact frequency in the never_scan list)
+            # Now (1.2.3): Block if the peak frequency is within +/-quantization/2.0 of a never_scan or blocklist frequency.
+            _peaks = get_power_peaks(
                 sdr_type=self.sdr_type,
+                peak_options={
+                    "power_peaks_path": os.path.join(self.rs_path, "power_peaks"),
+                    "snr_threshold": self.snr_threshold,
+                    "min_distance": self.min_distance,
+                    "quantization": self.quantization,
+                    "min_freq": self.min_freq * 1e6,
+                    "max_freq": self.max_freq * 1e6,
+                    "max_peaks": self.max_peaks
+                    if self.scan_scheduler is None
+                    else max(self.max_peaks, self.scan_scheduler.SWEEP_MAX_PEAKS),
+                    "never_scan": [_f * 1e6 for _f in self.never_scan],
+                    "always_scan": [_f * 1e6 for _f in self.always_scan],
+                    "search_step": self.search_step,
+                },
                 frequency_start=self.min_freq * 1e6,
                 frequency_stop=self.max_freq * 1e6,
                 step=self.search_step,
@@ -992,82 +1218,33 @@ class SondeScanner(object):
                 return []
 
             # Sanity check results.
-            if step == None or len(freq) == 0 or len(power) == 0:
+            if _peaks is None or len(_peaks["freq"]) == 0 or len(_peaks["power"]) == 0:
                 # Otherwise, if a file has been written but contains no data, it can indicate
                 # an issue with the RTLSDR. Sometimes these issues can be resolved by issuing a usb reset to the RTLSDR.
                 raise ValueError("Error getting PSD")
 
             # Update the global scan result
-            scan_result["freq"] = [round(x,6) for x in list(freq/1e6)]
-            scan_result["power"] = [round(x,2) for x in list(power)]
+            scan_result["freq"] = np.round(_peaks["freq"] / 1e6, 6).tolist()
+            scan_result["power"] = np.round(_peaks["power"], 2).tolist()
             scan_result["timestamp"] = datetime.datetime.now(datetime.timezone.utc).isoformat()
             scan_result["peak_freq"] = []
             scan_result["peak_lvl"] = []
 
-            # Rough approximation of the noise floor of the received power spectrum.
-            # Switched to use a Median instead of a Mean 2022-04-02. Should remove outliers better.
-            power_nf = np.median(power)
+            # Rough approximation of the noise floor of the received power spectrum (median).
+            power_nf = _peaks["noise_floor"]
             logging.debug(f"Noise Floor Estimate: {power_nf:.1f} dB uncal")
             # Pass the threshold data to the web client for plotting
             scan_result["threshold"] = power_nf
 
-            # Detect peaks.
-            peak_indices = detect_peaks(
-                power,
-                mph=(power_nf + self.snr_threshold),
-                mpd=(self.min_distance / step),
-                show=False,
-            )
-
             # If we have found no peaks, and no always_scan list has been provided, re-scan.
-            if (len(peak_indices) == 0) and (len(self.always_scan) == 0):
+            if len(_peaks["peak_freq"]) == 0:
                 self.log_debug("No peaks found.")
                 # Emit a notification to the client that a scan is complete.
                 flask_emit_event("scan_event")
                 return []
 
-            # Sort peaks by power.
-            peak_powers = power[peak_indices]
-            peak_freqs = freq[peak_indices]
-            peak_frequencies = peak_freqs[np.argsort(peak_powers)][::-1]
-
-            # Quantize to nearest x Hz
-            peak_frequencies = (
-                np.round(peak_frequencies / self.quantization) * self.quantization
-            )
-
-            # Remove any duplicate entries after quantization, but preserve order.
-            _, peak_idx = np.unique(peak_frequencies, return_index=True)
-            peak_frequencies = peak_frequencies[np.sort(peak_idx)]
-
-            # Remove outside min_freq and max_freq.
-            _index = np.argwhere(
-                (peak_frequencies < (self.min_freq * 1e6 - (self.quantization / 2.0))) |
-                (peak_frequencies > (self.max_freq * 1e6 + (self.quantization / 2.0)))
-            )
-            peak_frequencies = np.delete(peak_frequencies, _index)
-
-            # Never scan list & Temporary block list behaviour change as of v1.2.3
-            # Was: peak_frequencies==_frequency   (This only matched an exact frequency in the never_scan list)
-            # Now (1.2.3): Block if the peak frequency is within +/-quantization/2.0 of a never_scan or blocklist frequency.
-
-            # Remove any frequencies in the never_scan list.
-            for _frequency in np.array(self.never_scan) * 1e6:
-                _index = np.argwhere(
-                    np.abs(peak_frequencies - _frequency) < (self.quantization / 2.0)
-                )
-                peak_frequencies = np.delete(peak_frequencies, _index)
-
-            # Limit to the user-defined number of peaks to search over.
-            if len(peak_frequencies) > self.max_peaks:
-                peak_frequencies = peak_frequencies[: self.max_peaks]
-
-            # Append on any frequencies in the supplied always_scan list
-            peak_frequencies = np.append(
-                np.array(self.always_scan) * 1e6, peak_frequencies
-            )
-
             # Remove any frequencies in the temporary block list
+            _keep = np.ones(len(_peaks["peak_freq"]), dtype=bool)
             self.temporary_block_list_lock.acquire()
             for _frequency in self.temporary_block_list.copy().keys():
                 # Check the time the block was added.
@@ -1075,12 +1252,12 @@ class SondeScanner(object):
                     time.time() - self.temporary_block_time * 60
                 ):
                     # We should still be blocking this frequency, so remove any peaks with this frequency.
-                    _index = np.argwhere(
-                        np.abs(peak_frequencies - _frequency)
+                    _blocked = _keep & (
+                        np.abs(_peaks["peak_freq"] - _frequency)
                         < (self.quantization / 2.0)
                     )
-                    peak_frequencies = np.delete(peak_frequencies, _index)
-                    if len(_index) > 0:
+                    _keep &= ~_blocked
+                    if np.any(_blocked):
                         self.log_debug(
                             "Peak on %.3f MHz was removed due to temporary block."
                             % (_frequency / 1e6)
@@ -1096,40 +1273,43 @@ class SondeScanner(object):
 
             self.temporary_block_list_lock.release()
 
-            # Get the level of our peak search results, to send to the web client.
-            # This is actually a bit of a pain to do...
-            _peak_freq = []
-            _peak_lvl = []
-            _search_radius = math.ceil((self.quantization / 2) / self.search_step)
-            for _peak in peak_frequencies:
-                try:
-                    # Find the index of the peak within our decimated frequency array.
-                    _peak_power_idx = np.argmin(
-                        np.abs(scan_result["freq"] - _peak / 1e6)
-                    )
-                    # Because we've decimated the freq & power data, the peak location may
-                    # not be exactly at this frequency, so we take the maximum of an area
-                    # around this location.
-                    _peak_search_min = max(0, _peak_power_idx - _search_radius)
-                    _peak_search_max = min(
-                        len(scan_result["freq"]) - 1, _peak_power_idx + _search_radius
-                    )
-                    # Grab the maximum value, and append it and the frequency to the output arrays
-                    _peak_lvl.append(
-                        max(scan_result["power"][_peak_search_min:_peak_search_max + 1])
-                    )
-                    _peak_freq.append(_peak / 1e6)
-                except:
-                    pass
-            # Add the peak results to our global scan result dictionary.
-            scan_result["peak_freq"] = _peak_freq
-            scan_result["peak_lvl"] = _peak_lvl
+            peak_frequencies = _peaks["peak_freq"][_keep]
+
+            # Add the peak results (and their level, from power_peaks) to our global scan result dictionary.
+            scan_result["peak_freq"] = (peak_frequencies / 1e6).tolist()
+            scan_result["peak_lvl"] = np.round(_peaks["peak_lvl"][_keep], 2).tolist()
             # Tell the web client we have new data.
             flask_emit_event("scan_event")
 
             if len(peak_frequencies) == 0:
                 self.log_debug("No peaks found after never_scan frequencies removed.")
                 return []
+
+            if self.scan_scheduler is not None:
+                # Order the peaks by their history, and skip persistent carriers / peaks over the budget.
+                (_planned, _skipped, _deferred) = self.scan_scheduler.plan(
+                    peak_frequencies.tolist(),
+                    _peaks["peak_lvl"][_keep].tolist(),
+                    always_scan=[_f * 1e6 for _f in self.always_scan],
+                    max_tests=self.get_max_tests(),
+                    max_peaks=self.max_peaks,
+                )
+                _scheduled = True
+                if len(_skipped) > 0:
+                    self.log_debug(
+                        "Skipping persistent carriers (MHz): %s"
+                        % str([_f / 1e6 for _f in _skipped])
+                    )
+                if len(_deferred) > 0:
+                    self.log_debug(
+                        "Peak limit / scan budget exceeded, deferring peaks (MHz): %s"
+                        % str([_f / 1e6 for _f in _deferred])
+                    )
+                peak_frequencies = np.array(_planned)
+
+                if len(peak_frequencies) == 0:
+                    self.log_debug("No peaks left to test after scheduling.")
+                    return []
             else:
                 self.log_info(
                     "Detected peaks on %d frequencies (MHz): %s"
@@ -1149,7 +1329,6 @@ class SondeScanner(object):
         _use_async_scanning = False
         if ASYNC_SCAN_AVAILABLE and self.sdr_type == "KA9Q" and len(peak_frequencies) > 1:
             try:
-                import os
                 cpu_count = os.cpu_count() or 1
 
                 # With KA9Q, we can use multiple virtual channels concurrently
@@ -1182,10 +1361,16 @@ class SondeScanner(object):
                 )
 
                 # Process results
-                for _freq, detected in detections:
+                for _peak_freq, _freq, detected, _score in detections:
                     if self.sonde_scanner_running == False:
                         return []
 
+                    if _scheduled:
+                        self.scan_scheduler.update(_peak_freq, detected, _score)
+
+                    if detected is None:
+                        continue
+
                     _search_results.append([_freq, detected])
                     self.send_to_callback([[_freq, detected]])
 
@@ -1201,8 +1386,61 @@ class SondeScanner(object):
                 self.log_debug(f"Async scan traceback: {traceback.format_exc()}")
                 # Fall through to sequential scanning below
 
-        # Standard sequential scanning (for RTLSDR, SpyServer, single peaks, or async fallback)
-        if not _use_async_scanning:
+        # Channelized scanning on a RTLSDR: all peaks from one wideband capture.
+        # Only 400-406 MHz sondes (IQ detection), 1680 MHz detection uses a FM demodulator.
+        _use_channelized_scanning = False
+        if (
+            self.channelized_scan
+            and self.sdr_type == "RTLSDR"
+            and len(peak_frequencies) > 1
+            and max(peak_frequencies) < 1000e6
+        ):
+            try:
+                detections = detect_sondes_channelized(
+                    [float(_f) for _f in peak_frequencies],
+                    rs_path=self.rs_path,
+                    dwell_time=self.detect_dwell_time,
+                    sdr_type=self.sdr_type,
+                    rtl_sdr_path=os.path.join(os.path.dirname(self.rtl_fm_path), "rtl_sdr"),
+                    rtl_device_idx=self.rtl_device_idx,
+                    ppm=self.ppm,
+                    gain=self.gain,
+                    bias=self.bias,
+                    wideband_sondes=self.wideband_sondes
+                )
+
+                # Process results, in the order of the peaks.
+                _use_channelized_scanning = True
+                for _peak_freq, detected, offset_est, _score in sorted(
+                    detections, key=lambda x: list(peak_frequencies).index(x[0])
+                ):
+                    if self.sonde_scanner_running == False:
+                        return []
+
+                    if _scheduled:
+                        self.scan_scheduler.update(_peak_freq, detected, _score)
+
+                    if detected is None:
+                        continue
+
+                    # Quantize the detected frequency (with offset) to 1 kHz
+                    _freq = round((_peak_freq + offset_est) / 1000.0) * 1000.0
+                    _search_results.append([_freq, detected])
+                    self.send_to_callback([[_freq, detected]])
+
+                    if first_only:
+                        return _search_results
+
+            except IOError:
+                # Possible SDR lockup - handled by the scan loop.
+                raise
+            except Exception as e:
+                self.log_error(f"Channelized scanning failed: {e}, falling back to sequential")
+                self.log_debug(f"Channelized scan traceback: {traceback.format_exc()}")
+                _use_channelized_scanning = False
+
+        # Standard sequential scanning (for SpyServer, single peaks, or async/channelized fallback)
+        if not _use_async_scanning and not _use_channelized_scanning:
             for freq in peak_frequencies:
 
                 _freq = float(freq)
@@ -1211,7 +1449,7 @@ class SondeScanner(object):
                 if self.sonde_scanner_running == False:
                     return []
 
-                (detected, offset_est) = detect_sonde(
+                (detected, offset_est, _score) = detect_sonde(
                     _freq,
                     sdr_type=self.sdr_type,
                     sdr_hostname=self.sdr_hostname,
@@ -1227,6 +1465,9 @@ class SondeScanner(object):
                     wideband_sondes=self.wideband_sondes
                 )
 
+                if _scheduled:
+                    self.scan_scheduler.update(float(freq), detected, _score)
+
                 if detected != None:
                     # Quantize the detected frequency (with offset) to 1 kHz
                     _freq = round((_freq + offset_est) / 1000.0) * 1000.0
@@ -1249,6 +1490,21 @@ class SondeScanner(object):
 
         return _search_results
 
+    def get_max_tests(self):
+        """Number of detection attempts that fit into the scan budget (None if there is no budget)."""
+        if self.scan_budget <= 0:
+            return None
+
+        _workers = 1
+        if ASYNC_SCAN_AVAILABLE and self.sdr_type == "KA9Q":
+            # Detections run concurrently with KA9Q.
+            _workers = min(self.max_async_scan_workers, os.cpu_count() or 1)
+        elif self.channelized_scan and self.sdr_type == "RTLSDR":
+            # Up to this many peaks are detected from one capture.
+            _workers = CHANNELIZER_MAX_CHANNELS
+
+        return max(1, int(self.scan_budget // max(self.detect_dwell_time, 1)) * _workers)
+
     def oneshot(self, first_only=False):
         """Perform a once-off scan attempt
 
@@ -8,8 +8,9 @@
 #   KA9Q-radio creates multiple virtual SDR channels from one physical SDR,
 #   allowing true concurrent scanning across multiple frequencies.
 #
-#   NOTE: This is ONLY beneficial with KA9Q-radio. For standard RTLSDRs,
-#   scanning must be sequential due to hardware limitations.
+#   NOTE: This is ONLY beneficial with KA9Q-radio. A RTLSDR can only be tuned to one
+#   frequency at a time; concurrent detection on a RTLSDR splits one wideband capture
+#   into channels instead (scan.detect_sondes_channelized(), channelized_scan option).
 #
 import asyncio
 import logging
@@ -61,7 +62,7 @@ async def detect_sonde_async(
     dramatically reducing scan time when using KA9Q-radio.
 
     Returns:
-        Tuple[Optional[str], float]: (sonde_type, frequency_offset) or (None, 0.0)
+        Tuple[Optional[str], float, float]: (sonde_type, frequency_offset, score) or (None, 0.0, 0.0)
     """
 
     # Lazy import to avoid module-level dependency issues
@@ -226,7 +227,7 @@ async def detect_sonde_async(
             except asyncio.TimeoutError:
                 logging.warning(f"Scanner ({_sdr_name}) - Process did not exit within {PROCESS_WAIT_TIMEOUT}s after kill")
             logging.error(f"Scanner ({_sdr_name}) - dft_detect timed out on {frequency/1e6:.3f} MHz.")
-            return (None, 0.0)
+            return (None, 0.0, 0.0)
 
         _runtime = time.time() - _start
 
@@ -249,13 +250,13 @@ async def detect_sonde_async(
             )
             if stderr_output:
                 logging.debug(f"Scanner ({_sdr_name}) - dft_detect stderr: {stderr_output.strip()}")
-            return (None, 0.0)
+            return (None, 0.0, 0.0)
 
     except Exception as e:
         logging.error(
             f"Scanner ({_sdr_name}) - Error when running dft_detect - {str(e)}"
         )
-        return (None, 0.0)
+        return (None, 0.0, 0.0)
     finally:
         # Always clean up: kill subprocess if still running and release SDR
         if process is not None:
@@ -313,7 +314,8 @@ async def scan_peaks_concurrent(
         **detect_kwargs: Arguments passed to detect_sonde_async
 
     Returns:
-        List of tuples: [(frequency, sonde_type), ...]
+        List of tuples, one per completed detection attempt:
+            [(peak_frequency, corrected_frequency, sonde_type or None, score), ...]
     """
 
     # Create a semaphore to limit concurrent operations
@@ -326,17 +328,15 @@ async def scan_peaks_concurrent(
         async with semaphore:
             try:
                 _task_start = time.time()
-                detected, offset_est = await detect_sonde_async(
+                detected, offset_est, score = await detect_sonde_async(
                     frequency=freq,
                     **detect_kwargs
                 )
                 _task_time = time.time() - _task_start
                 logging.debug(f"Detection task for {freq/1e6:.3f} MHz completed in {_task_time:.1f}s")
-                if detected:
-                    # Quantize the detected frequency with offset to 1 kHz
-                    freq_corrected = round((freq + offset_est) / 1000.0) * 1000.0
-                    return (freq_corrected, detected)
-                return None
+                # Quantize the detected frequency with offset to 1 kHz
+                freq_corrected = round((freq + offset_est) / 1000.0) * 1000.0
+                return (freq, freq_corrected, detected, score)
             except asyncio.CancelledError:
                 # Task was cancelled - clean exit
                 logging.debug(f"Detection task for {freq/1e6:.3f} MHz cancelled")
@@ -358,7 +358,7 @@ async def scan_peaks_concurrent(
         await asyncio.gather(*tasks, return_exceptions=True)
         raise
 
-    # Filter out None results and exceptions
+    # Filter out exceptions
     detections = []
     for result in results:
         if isinstance(result, asyncio.CancelledError):
@@ -370,7 +370,8 @@ async def scan_peaks_concurrent(
             detections.append(result)
 
     _scan_time = time.time() - _scan_start
-    logging.info(f"Async scan completed: {len(detections)} detections from {len(peak_frequencies)} frequencies in {_scan_time:.1f}s")
+    _detected = len([_d for _d in detections if _d[2] is not None])
+    logging.info(f"Async scan completed: {_detected} detections from {len(peak_frequencies)} frequencies in {_scan_time:.1f}s")
 
     return detections
 
@@ -0,0 +1,225 @@
+#!/usr/bin/env python
+#
+#   radiosonde_auto_rx - Adaptive Scan Scheduler
+#
+#   Keeps statistics for each peak frequency across scan cycles (how often the peak is seen in
+#   the spectrum, detection results, detected type and dft_detect score), and uses them to decide
+#   which peaks get a detection dwell in a cycle, and in which order:
+#
+#   - Peaks are ordered by an estimate of the probability of a detection, (detections + 1) / (tests + 2),
+#     with older results fading out. A new peak starts at 0.5, a frequency that had a sonde on it
+#     before (e.g. a launch site frequency) ranks above it, a frequency that was tested a few times
+#     without result ranks below it. Peaks that have been waiting for a while move up.
+#   - A persistent carrier (seen in most of the recent sweeps, and not detected a few times in a row)
+#     is only re-tested after a back-off of 2, 4, ... up to MAX_BACKOFF_CYCLES cycles, so local
+#     interferers stop taking a dwell every cycle, but a sonde that appears on their frequency is
+#     still found eventually.
+#   - With a budget, only as many peaks are tested as fit into it. always_scan frequencies are
+#     always tested, first.
+#
+#   Released under GNU GPL v3 or later
+#
+import logging
+import threading
+import time
+
+
+class FrequencyStats(object):
+    """ Scan history of one (quantized) peak frequency. """
+
+    def __init__(self, frequency, cycle):
+        self.frequency = frequency
+        self.first_cycle = cycle
+        # Bit n set: peak seen in the spectrum n sweeps ago.
+        self.seen_history = 0
+        self.last_seen = 0.0
+        self.level = None
+
+        # Detection history. tests / detections fade out by HISTORY_DECAY per test.
+        self.tests = 0.0
+        self.detections = 0.0
+        self.negatives = 0
+        self.last_tested = 0.0
+        self.last_tested_cycle = None
+        self.last_detected = 0.0
+        self.last_type = None
+        self.last_score = None
+        # Set while the frequency is backed off as a persistent carrier.
+        self.backed_off = False
+
+    def to_dict(self):
+        return {
+            "frequency": self.frequency,
+            "seen": bin(self.seen_history).count("1"),
+            "last_seen": self.last_seen,
+            "level": self.level,
+            "tests": round(self.tests, 2),
+            "detections": round(self.detections, 2),
+            "negatives": self.negatives,
+            "last_tested": self.last_tested,
+            "last_detected": self.last_detected,
+            "last_type": self.last_type,
+            "last_score": self.last_score,
+            "backed_off": self.backed_off,
+        }
+
+
+class ScanScheduler(object):
+    """ Orders and skips scan peaks based on their history. Shared between scanner instances (thread-safe). """
+
+    # Sweeps of seen/not seen history kept per frequency.
+    HISTORY_SWEEPS = 8
+    # A peak seen in at least this many of the last HISTORY_SWEEPS sweeps is a persistent carrier...
+    PERSISTENT_SWEEPS = 6
+    # ... and is backed off after this many consecutive negative detections.
+    PERSISTENT_NEGATIVES = 3
+    # Maximum back-off, in scan cycles.
+    MAX_BACKOFF_CYCLES = 32
+    # Weight of the previous detection results per new test.
+    HISTORY_DECAY = 0.9
+    # Priority increase per cycle a peak has been waiting (untested), up to AGE_MAX_CYCLES.
+    AGE_WEIGHT = 0.25
+    AGE_MAX_CYCLES = 8
+    # Drop frequencies not seen (or tested) for this long, in seconds.
+    STATS_EXPIRY = 12 * 3600
+    # Peaks taken from the spectrum sweep (power_peaks --max) when scheduling. The max_peaks
+    # limit is applied after plan(), so that backed-off carriers don't use up its slots.
+    SWEEP_MAX_PEAKS = 100
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.stats = {}
+        self.cycle = 0
+
+    def get(self, frequency):
+        """ Stats of a frequency, created if new. Call with the lock held. """
+        _key = round(frequency)
+        if _key not in self.stats:
+            self.stats[_key] = FrequencyStats(_key, self.cycle)
+        return self.stats[_key]
+
+    def is_persistent(self, stats):
+        return (
+            bin(stats.seen_history).count("1") >= self.PERSISTENT_SWEEPS
+            and stats.negatives >= self.PERSISTENT_NEGATIVES
+        )
+
+    def backoff(self, stats):
+        """ Number of cycles between tests of a persistent carrier. """
+        return min(
+            2 ** (stats.negatives - self.PERSISTENT_NEGATIVES + 1),
+            self.MAX_BACKOFF_CYCLES,
+        )
+
+    def priority(self, stats):
+        """ Estimated detection probability, raised while the peak is waiting. """
+        _p = (stats.detections + 1.0) / (stats.tests + 2.0)
+
+        if stats.last_tested_cycle is None:
+            _waiting = self.cycle - stats.first_cycle
+        else:
+            _waiting = self.cycle - stats.last_tested_cycle - 1
+
+        return _p * (1.0 + self.AGE_WEIGHT * min(max(_waiting, 0), self.AGE_MAX_CYCLES))
+
+    def plan(self, peak_frequencies, peak_levels=None, always_scan=[], max_tests=None, max_peaks=None):
+        """ Start a new scan cycle, and select the peaks to test.
+
+        Args:
+            peak_frequencies (list): Peaks found in this sweep (Hz), including the always_scan frequencies.
+            peak_levels (list): Level of each peak (used to order peaks of equal priority).
+            always_scan (list): always_scan frequencies (Hz). These are always tested, first.
+            max_tests (int): Maximum number of peaks to test in this cycle (None: no limit).
+            max_peaks (int): Maximum number of peaks to test besides the always_scan frequencies (None: no limit).
+
+        Returns:
+            tuple: (peaks to test in this order, skipped persistent carriers, peaks deferred by max_peaks / the budget)
+        """
+        _now = time.time()
+
+        with self.lock:
+            self.cycle += 1
+            _mask = (1 << self.HISTORY_SWEEPS) - 1
+
+            # Shift the seen history of all known frequencies, and expire old ones.
+            for _key in list(self.stats.keys()):
+                _stats = self.stats[_key]
+                _stats.seen_history = (_stats.seen_history << 1) & _mask
+                if max(_stats.last_seen, _stats.last_tested) < _now - self.STATS_EXPIRY:
+                    self.stats.pop(_key)
+
+            _always = []
+            _candidates = []
+            _skipped = []
+
+            for _i, _freq in enumerate(peak_frequencies):
+                _stats = self.get(_freq)
+                _stats.seen_history |= 1
+                _stats.last_seen = _now
+                if peak_levels is not None and _i < len(peak_levels):
+                    _stats.level = float(peak_levels[_i])
+
+                if any(abs(_freq - _a) < 1.0 for _a in always_scan):
+                    _always.append(_freq)
+                elif self.is_persistent(_stats) and (
+                    _stats.last_tested_cycle is not None
+                    and (self.cycle - _stats.last_tested_cycle) < self.backoff(_stats)
+                ):
+                    _skipped.append(_freq)
+                    if not _stats.backed_off:
+                        _stats.backed_off = True
+                        logging.info(
+                            "Scan Scheduler - %.3f MHz looks like a persistent carrier, backing off."
+                            % (_freq / 1e6)
+                        )
+                else:
+                    _candidates.append(
+                        (self.priority(_stats), _stats.level or 0.0, _freq)
+                    )
+
+            # Highest detection probability first; stronger peak first if equal.
+            _candidates.sort(key=lambda x: (x[0], x[1]), reverse=True)
+            _ordered = [_c[2] for _c in _candidates]
+
+        _n = len(_ordered)
+        if max_peaks is not None:
+            _n = min(_n, max(0, max_peaks))
+        if max_tests is not None:
+            _n = min(_n, max(0, max_tests - len(_always)))
+        _deferred = _ordered[_n:]
+        _ordered = _ordered[:_n]
+
+        return (_always + _ordered, _skipped, _deferred)
+
+    def update(self, frequency, sonde_type, score=None):
+        """ Record the result of a detection attempt on a peak frequency.
+
+        Args:
+            frequency (float): Peak frequency that was tested (Hz, as passed to plan()).
+            sonde_type (str): Detected sonde type, or None.
+            score (float): dft_detect correlation score, if available.
+        """
+        with self.lock:
+            _stats = self.get(frequency)
+            _stats.tests = _stats.tests * self.HISTORY_DECAY + 1.0
+            _stats.detections = _stats.detections * self.HISTORY_DECAY
+            _stats.last_tested = time.time()
+            _stats.last_tested_cycle = self.cycle
+            _stats.last_score = score
+
+            if sonde_type is None:
+                _stats.negatives += 1
+            else:
+                _stats.detections += 1.0
+                _stats.negatives = 0
+                _stats.backed_off = False
+                _stats.last_detected = _stats.last_tested
+                _stats.last_type = sonde_type
+
+    def get_stats(self):
+        """ Return the frequency statistics as a list of dictionaries (JSON-serialisable) """
+        with self.lock:
+            return [
+                _stats.to_dict()
+                for _key, _stats in sorted(self.stats.items())
+            ]
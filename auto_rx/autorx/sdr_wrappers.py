@@ -9,6 +9,7 @@ import autorx
 import logging
 import os.path
 import platform
+import struct
 import subprocess
 import numpy as np
 
@@ -16,6 +17,10 @@ from .utils import rtlsdr_test, reset_rtlsdr_by_serial, reset_all_rtlsdrs, timeo
 from .ka9q import *
 
 
+# power_peaks binary output header magic ("PSPP"), see scan/power_peaks.c
+POWER_PEAKS_MAGIC = 0x50505350
+
+
 def test_sdr(
     sdr_type: str,
     rtl_device_idx = "0",
@@ -375,6 +380,97 @@ def get_sdr_iq_cmd(
         return "false |"
 
 
+def get_sdr_iq_shm_cmd(
+    shm_name: str,
+    sample_rate: int,
+    iq_shmw_path = "./iq_shmw",
+    ring_log2len = None,
+    **kwargs
+):
+    """
+    Get a command-line to run an SDR IQ source into a shared-memory ring buffer,
+    so that several consumers can attach to the same IQ stream.
+
+    shm_name (str): Name of the shared memory segment (/dev/shm/<shm_name>)
+    sample_rate (int): Sample rate in Hz
+    iq_shmw_path (str): Path to the iq_shmw utility.
+    ring_log2len (int): Optional ring length, as log2(bytes).
+
+    All other keyword arguments are passed through to get_sdr_iq_cmd.
+
+    Consumers attach using the --shm <shm_name> argument, available on the
+    demod/mod decoders and dft_detect, e.g. "./rs41mod --IQ 0.0 --shm <shm_name>".
+    Unlike a pipe, a slow consumer does not stall the SDR - it will instead skip
+    ahead and report overruns on exit.
+    """
+
+    _cmd = get_sdr_iq_cmd(sample_rate=sample_rate, **kwargs)
+
+    if _cmd.startswith("false"):
+        return _cmd
+
+    _cmd += (
+        f"{iq_shmw_path} "
+        f"{f'--len {int(ring_log2len)} ' if ring_log2len else ''}"
+        f"{shm_name} - {int(sample_rate)} 16"
+    )
+
+    return _cmd
+
+
+def get_sdr_wideband_iq_cmd(
+    sdr_type: str,
+    frequency: int,
+    sample_rate: int,
+    num_samples: int,
+    rtl_device_idx = "0",
+    rtl_sdr_path = "rtl_sdr",
+    ppm = 0,
+    gain = None,
+    bias = False
+):
+    """
+    Get a command-line to capture a block of wideband IQ (unsigned 8-bit) from a SDR,
+    e.g. to be split into channels by iq_dec --chan.
+
+    sdr_type (str): 'RTLSDR' (the only type supported)
+    frequency (int): Centre frequency in Hz
+    sample_rate (int): Sample rate in Hz
+    num_samples (int): Number of IQ samples to capture
+
+    Arguments for RTLSDRs:
+    rtl_device_idx (str) - Device ID for a RTLSDR
+    rtl_sdr_path (str) - Path to rtl_sdr. Defaults to just "rtl_sdr"
+    ppm (int): SDR Frequency accuracy correction, in ppm.
+    gain (int): SDR Gain setting, in dB. A gain setting of -1 (or -2) enables the RTLSDR AGC.
+    bias (bool): If True, enable the bias tee on the SDR.
+
+    Returns None if the SDR type is not supported.
+    """
+
+    if sdr_type == "RTLSDR":
+        _gain = ""
+        if gain and gain >= 0:
+            _gain = f"-g {gain:.1f} "
+
+        _cmd = (
+            f"{rtl_sdr_path} "
+            f"{'-T ' if bias else ''}"
+            f"-p {int(ppm)} "
+            f"-d {str(rtl_device_idx)} "
+            f"{_gain}"
+            f"-s {int(sample_rate)} "
+            f"-f {int(frequency)} "
+            f"-n {int(num_samples)} "
+            f"- 2>/dev/null | "
+        )
+
+        return _cmd
+
+    else:
+        return None
+
+
 
 def get_sdr_fm_cmd(
     sdr_type: str,
@@ -568,7 +664,7 @@ def read_ka9q_power_log(log_filename, sdr_name):
     return (freq, power, freq_step)
 
 
-def get_power_spectrum(
+def run_power_scan(
     sdr_type: str,
     frequency_start: int = 400050000,
     frequency_stop: int = 403000000,
@@ -585,7 +681,7 @@ def get_power_spectrum(
     ka9q_powers_path = "powers"
 ):
     """
-    Get power spectral density data from a SDR.
+    Capture power spectral density data from a SDR into a log file.
 
     Arguments:
 
@@ -615,11 +711,12 @@ def get_power_spectrum(
     ka9q_powers_path (str): Path to KA9Q Radio powers utility.
 
     Returns:
-    (freq, power, step) Tuple
+    (log_filename, log_format, sdr_name) Tuple
 
-    freq (np.array): Array of frequencies, in Hz
-    power (np.array): Array of uncalibrated power estimates, in Hz
-    step (float): Frequency step of the output data, in Hz.
+    log_filename (str): Power log file
+    log_format (str): 'rtl_power' (rtl_power / ss_power csv), 'ka9q' (ka9q-radio powers),
+        or 'dummy' if the SDR type has no spectrum support.
+    sdr_name (str): SDR name used for logging.
 
     Returns (None, None, None) if an error occurs.
 
@@ -701,7 +798,7 @@ def get_power_spectrum(
 
             return (None, None, None)
 
-        return read_rtl_power_log(_log_filename, _sdr_name)
+        return (_log_filename, "rtl_power", _sdr_name)
 
     elif sdr_type == "SpyServer":
         # Use a spyserver to obtain power spectral density data
@@ -763,7 +860,7 @@ def get_power_spectrum(
 
             return (None, None, None)
 
-        return read_rtl_power_log(_log_filename, _sdr_name)
+        return (_log_filename, "rtl_power", _sdr_name)
 
     elif sdr_type == "KA9Q":
         # Use powers to obtain power spectral density data
@@ -822,13 +919,159 @@ def get_power_spectrum(
 
             return (None, None, None)
 
-        return read_ka9q_power_log(_log_filename, _sdr_name)
+        return (_log_filename, "ka9q", _sdr_name)
 
     else:
         # Unsupported SDR Type
         logging.debug(f"Get PSD - Unsupported SDR Type: {sdr_type}")
+        return (None, "dummy", None)
+
+
+def get_power_spectrum(sdr_type: str, **kwargs):
+    """
+    Get power spectral density data from a SDR.
+
+    Arguments: see run_power_scan()
+
+    Returns:
+    (freq, power, step) Tuple
+
+    freq (np.array): Array of frequencies, in Hz
+    power (np.array): Array of uncalibrated power estimates, in Hz
+    step (float): Frequency step of the output data, in Hz.
+
+    Returns (None, None, None) if an error occurs.
+    """
+
+    (_log_filename, _log_format, _sdr_name) = run_power_scan(sdr_type, **kwargs)
+
+    if _log_format == "rtl_power":
+        return read_rtl_power_log(_log_filename, _sdr_name)
+    elif _log_format == "ka9q":
+        return read_ka9q_power_log(_log_filename, _sdr_name)
+    elif _log_format == "dummy":
         return (np.array([0,1,2]),np.array([0,1,2]),1)
-        #return (None, None, None)
+    else:
+        return (None, None, None)
+
+
+def read_power_peaks(
+    log_filename,
+    log_format,
+    sdr_name,
+    power_peaks_path = "./power_peaks",
+    snr_threshold = 10,
+    min_distance = 1000,
+    quantization = 10000,
+    min_freq = None,
+    max_freq = None,
+    max_peaks = 10,
+    never_scan = [],
+    always_scan = [],
+    search_step = None
+):
+    """
+    Read a power log file and search it for peaks, using the power_peaks utility.
+
+    Arguments:
+    log_filename (str): Power log file
+    log_format (str): 'rtl_power' or 'ka9q', see run_power_scan()
+    sdr_name (str): SDR name used for logging errors.
+    power_peaks_path (str): Path to the power_peaks utility.
+    snr_threshold (float): Peak threshold above the noise floor (median), dB.
+    min_distance (float): Minimum distance between peaks, Hz.
+    quantization (float): Peak frequencies are rounded to multiples of this, Hz.
+    min_freq, max_freq (float): Frequency range of the peaks, Hz.
+    max_peaks (int): Maximum number of peaks.
+    never_scan (list): Peaks within +/- quantization/2 of these frequencies (Hz) are removed.
+    always_scan (list): Frequencies (Hz) added in front of the peaks.
+    search_step (float): Requested frequency step, Hz (peak level search radius).
+
+    Returns:
+    A dictionary with the fields:
+        freq (np.array), power (np.array): Spectrum, Hz and uncalibrated power
+        step (float): Frequency step, Hz
+        noise_floor (float): Noise floor estimate
+        peak_freq (np.array), peak_lvl (np.array): always_scan frequencies and peaks, and their level
+
+    Returns None if an error occurs.
+    """
+
+    _cmd = [power_peaks_path, "--bin"]
+    if log_format == "ka9q":
+        _cmd.append("--ka9q")
+    _cmd += ["--snr", str(snr_threshold), "--dist", str(min_distance), "--quant", str(quantization)]
+    if min_freq is not None:
+        _cmd += ["--fmin", str(min_freq)]
+    if max_freq is not None:
+        _cmd += ["--fmax", str(max_freq)]
+    if search_step:
+        _cmd += ["--step", str(search_step)]
+    _cmd += ["--max", str(int(max_peaks))]
+    if len(never_scan) > 0:
+        _cmd += ["--never", ",".join(str(x) for x in never_scan)]
+    if len(always_scan) > 0:
+        _cmd += ["--always", ",".join(str(x) for x in always_scan)]
+    _cmd.append(log_filename)
+
+    try:
+        _output = subprocess.check_output(_cmd, stderr=subprocess.PIPE)
+    except (subprocess.CalledProcessError, OSError) as e:
+        logging.error(f"Scanner ({sdr_name}) - power_peaks failed - {str(e)}")
+        return None
+
+    # Header: magic, bins, peaks, reserved (uint32), step, noise floor (double), see scan/power_peaks.c
+    _hdr = struct.Struct("<4I2d")
+    if len(_output) < _hdr.size:
+        logging.error(f"Scanner ({sdr_name}) - power_peaks output truncated.")
+        return None
+
+    (_magic, _bins, _peaks, _, _step, _nf) = _hdr.unpack_from(_output, 0)
+    if (_magic != POWER_PEAKS_MAGIC) or (len(_output) != _hdr.size + 8 * (2 * _bins + 2 * _peaks)):
+        logging.error(f"Scanner ({sdr_name}) - power_peaks output malformed.")
+        return None
+
+    _data = np.frombuffer(_output, dtype="<f8", offset=_hdr.size)
+
+    return {
+        "freq": _data[:_bins],
+        "power": _data[_bins : 2 * _bins],
+        "step": _step,
+        "noise_floor": _nf,
+        "peak_freq": _data[2 * _bins : 2 * _bins + _peaks],
+        "peak_lvl": _data[2 * _bins + _peaks :],
+    }
+
+
+def get_power_peaks(sdr_type: str, peak_options = {}, **kwargs):
+    """
+    Get power spectral density data from a SDR, and search it for peaks.
+
+    Arguments:
+    sdr_type (str): 'RTLSDR', 'Spyserver' or 'KA9Q'
+    peak_options (dict): Peak search options, see read_power_peaks()
+    Other arguments: see run_power_scan()
+
+    Returns:
+    A dictionary, see read_power_peaks(), or None if an error occurs.
+    """
+
+    (_log_filename, _log_format, _sdr_name) = run_power_scan(sdr_type, **kwargs)
+
+    if _log_format == "dummy":
+        _always_scan = np.array(peak_options.get("always_scan", []), dtype=float)
+        return {
+            "freq": np.array([0.0, 1.0, 2.0]),
+            "power": np.array([0.0, 1.0, 2.0]),
+            "step": 1.0,
+            "noise_floor": 1.0,
+            "peak_freq": _always_scan,
+            "peak_lvl": np.zeros(len(_always_scan)),
+        }
+    elif _log_format is None:
+        return None
+
+    return read_power_peaks(_log_filename, _log_format, _sdr_name, **peak_options)
 
 if __name__ == "__main__":
 
@@ -0,0 +1,258 @@
+#!/usr/bin/env python
+#
+#   radiosonde_auto_rx - Binary Telemetry Records
+#
+#   Reads the binary telemetry records written by the demod/mod decoders
+#   when run with '--json --jsnbin' (see demod/mod/sonde_tlm.h), and turns
+#   them into the same dictionaries json.loads() gives for the JSON lines.
+#
+#   Released under GNU GPL v3 or later
+#
+import re
+import struct
+
+
+# Record magic, as it appears in the stream ("\xFFTLM"). 0xFF never occurs in the text output.
+TLM_MAGIC = b"\xffTLM"
+TLM_VERSION = 1
+
+# Key table - must match tlm_key[] in sonde_tlm.h (append only).
+TLM_KEYS = [
+    "type",
+    "frame",
+    "id",
+    "datetime",
+    "lat",
+    "lon",
+    "alt",
+    "vel_h",
+    "heading",
+    "vel_v",
+    "sats",
+    "bt",
+    "batt",
+    "temp",
+    "humidity",
+    "pressure",
+    "aux",
+    "subtype",
+    "encrypted",
+    "freq",
+    "tx_frequency",
+    "ref_datetime",
+    "ref_position",
+    "diff_GPS_MSL",
+    "gpsutc_leapsec",
+    "gpstow",
+    "aprsid",
+    "rawid",
+    "rs41_mainboard",
+    "rs41_mainboard_fw",
+    "rs41_calconf51x16",
+    "rs41_conf0x32",
+    "rs41_subfrm",
+    "version",
+    "rx_time",
+]
+
+# Field types
+TLM_INT = 1
+TLM_FLT = 2
+TLM_STR = 3
+TLM_HEX = 4
+TLM_BOOL = 5
+TLM_DT = 6
+
+_HDR = struct.Struct("<IHBB")
+_I64 = struct.Struct("<q")
+_F64 = struct.Struct("<d")
+_U16 = struct.Struct("<H")
+_DT = struct.Struct("<5hd")
+
+# Decoders which support --jsnbin (and --rxtime)
+TLM_DECODERS = [
+    "rs41mod",
+    "rs92mod",
+    "dfm09mod",
+    "m10mod",
+    "m20mod",
+    "lms6Xmod",
+    "imet54mod",
+    "mp3h1mod",
+    "mts01mod",
+    "meisei100mod",
+    "weathex301d",
+]
+
+_JSON_OPTION = re.compile(
+    r"(\./(?:%s)\s[^|]*?--json)(?=\s|$)" % "|".join(TLM_DECODERS)
+)
+
+
+def add_binary_option(command):
+    """ Add --jsnbin to the supported decoders within a decoder shell command.
+
+    Args:
+        command (str): Decoder command, as generated in decode.py
+
+    Returns:
+        str: The command, with '--json' replaced by '--json --jsnbin' for the supported decoders.
+    """
+    return _JSON_OPTION.sub(r"\1 --jsnbin", command)
+
+
+def add_rxtime_option(command):
+    """ Add --rxtime to the supported decoders within a decoder shell command.
+        The decoders then give the receive time of each frame ('rx_time', see latency.py).
+
+    Args:
+        command (str): Decoder command, as generated in decode.py
+
+    Returns:
+        str: The command, with '--json' replaced by '--json --rxtime' for the supported decoders.
+    """
+    return _JSON_OPTION.sub(r"\1 --rxtime", command)
+
+
+def parse_record(buf, offset=0):
+    """ Parse a single binary telemetry record.
+
+    Args:
+        buf (bytes, bytearray, memoryview): Buffer containing the record.
+        offset (int): Position of the record header within buf.
+
+    Returns:
+        dict: The telemetry fields, with the same values json.loads() gives for the JSON output.
+
+    Raises:
+        ValueError: If the record is malformed.
+    """
+    _magic, _len, _version, _nfld = _HDR.unpack_from(buf, offset)
+
+    if _version != TLM_VERSION:
+        raise ValueError("Unsupported record version %d" % _version)
+
+    _pos = offset + _HDR.size
+    _end = offset + _len
+    _telemetry = {}
+
+    for _i in range(_nfld):
+        if _pos + 2 > _end:
+            raise ValueError("Truncated record")
+
+        _key = buf[_pos]
+        _typ = buf[_pos + 1] & 0xF
+        _prec = buf[_pos + 1] >> 4
+        _pos += 2
+
+        if _typ == TLM_INT:
+            _value = _I64.unpack_from(buf, _pos)[0]
+            _pos += 8
+        elif _typ == TLM_FLT:
+            _value = _F64.unpack_from(buf, _pos)[0]
+            _pos += 8
+            # Same rounding as the printf("%.*f") of the JSON output.
+            _value = round(_value, _prec) if _prec > 0 else int(round(_value))
+        elif _typ == TLM_BOOL:
+            _value = buf[_pos] != 0
+            _pos += 1
+        elif _typ in (TLM_STR, TLM_HEX):
+            _n = _U16.unpack_from(buf, _pos)[0]
+            _raw = bytes(buf[_pos + 2 : _pos + 2 + _n])
+            _pos += 2 + _n
+            if _typ == TLM_STR:
+                _value = _raw.decode("ascii", errors="replace")
+            else:
+                _value = _raw.hex().upper()
+        elif _typ == TLM_DT:
+            (_yr, _mon, _day, _hr, _min, _sec) = _DT.unpack_from(buf, _pos)
+            _pos += _DT.size
+            _width = _prec + 3 if _prec > 0 else 2
+            _value = f"{_hr:02d}:{_min:02d}:{_sec:0{_width}.{_prec}f}Z"
+            if _yr > 0:
+                _value = f"{_yr:04d}-{_mon:02d}-{_day:02d}T" + _value
+        else:
+            raise ValueError("Unknown field type %d" % _typ)
+
+        if _pos > _end:
+            raise ValueError("Truncated record")
+
+        # Unknown keys (newer decoder) are skipped.
+        if _key < len(TLM_KEYS):
+            _telemetry[TLM_KEYS[_key]] = _value
+
+    return _telemetry
+
+
+def split_lines(buf, start, end, emit, final=False):
+    """ Pass the complete text lines in buf[start:end] to emit(), as bytes.
+
+    Args:
+        buf (bytearray): Buffer containing decoder output.
+        start, end (int): Range of buf to process.
+        emit (function): Called with each line (including the newline).
+        final (bool): Also pass on a trailing partial line (end of stream).
+
+    Returns:
+        int: The position after the last line passed on.
+    """
+    while start < end:
+        _nl = buf.find(b"\n", start, end)
+        if _nl < 0:
+            if final:
+                emit(bytes(buf[start:end]))
+                return end
+            return start
+        emit(bytes(buf[start : _nl + 1]))
+        start = _nl + 1
+    return start
+
+
+def split_records(buf, start, end, emit, final=False):
+    """ Pass the complete text lines (bytes) and binary telemetry records (dicts) in buf[start:end]
+        to emit(), in the order they appear. Malformed records are skipped.
+
+    Args:
+        buf (bytearray): Buffer containing decoder output.
+        start, end (int): Range of buf to process.
+        emit (function): Called with each line or record.
+        final (bool): End of stream - pass on the trailing text, drop a partial record.
+
+    Returns:
+        int: The position after the last line or record passed on.
+    """
+    _pos = start
+
+    while _pos < end:
+        _rec = buf.find(TLM_MAGIC, _pos, end)
+
+        if _rec < 0:
+            # No record in the buffer - hand over the complete text lines,
+            # keeping a partial line (which may hold the start of a magic).
+            return split_lines(buf, _pos, end, emit, final)
+
+        # Text output before the record.
+        split_lines(buf, _pos, _rec, emit, final=True)
+        _pos = _rec
+
+        if end - _pos < _HDR.size:
+            return end if final else _pos
+
+        _rec_len = _U16.unpack_from(buf, _pos + 4)[0]
+        if _rec_len < _HDR.size:
+            # Not a record header - skip the magic byte.
+            _pos += 1
+            continue
+
+        if end - _pos < _rec_len:
+            return end if final else _pos
+
+        try:
+            with memoryview(buf) as _view:
+                _telemetry = parse_record(_view, _pos)
+            emit(_telemetry)
+        except (ValueError, struct.error):
+            pass
+        _pos += _rec_len
+
+    return _pos
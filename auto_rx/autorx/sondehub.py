@@ -21,8 +21,9 @@ import os
 import requests
 import time
 from queue import Queue
-from threading import Thread
+from threading import Event, Thread
 from email.utils import formatdate
+from .latency import record_latency
 
 
 class SondehubUploader(object):
@@ -81,6 +82,7 @@ class SondehubUploader(object):
 
         # Start queue processing thread.
         self.input_processing_running = True
+        self.input_processing_wakeup = Event()
         self.input_process_thread = Thread(target=self.process_queue)
         self.input_process_thread.start()
 
@@ -104,9 +106,9 @@ class SondehubUploader(object):
         _telem = self.reformat_data(telemetry)
         # self.log_debug("Telem: %s" % str(_telem))
 
-        # Add it to the queue if we are running.
+        # Add it to the queue if we are running, along with the receive time for latency tracing.
         if self.input_processing_running and _telem:
-            self.input_queue.put(_telem)
+            self.input_queue.put((_telem, telemetry.get("rx_time")))
         else:
             self.log_debug("Processing not running, discarding.")
 
@@ -120,9 +122,10 @@ class SondehubUploader(object):
             "uploader_callsign": self.user_callsign,
             "uploader_position": self.user_position,
             "uploader_antenna": self.user_antenna,
-            "time_received": datetime.datetime.now(datetime.timezone.utc).strftime(
-                "%Y-%m-%dT%H:%M:%S.%fZ"
-            ),
+            # Receive time of the frame (decoder, see decode.py), if available, else now.
+            "time_received": datetime.datetime.fromtimestamp(
+                telemetry.get("rx_time", time.time()), datetime.timezone.utc
+            ).strftime("%Y-%m-%dT%H:%M:%S.%fZ"),
         }
 
         # Discard encrypted sonde data silently
@@ -364,20 +367,34 @@ class SondehubUploader(object):
         """
         self.log_info("Started Sondehub Uploader Thread.")
 
+        _next_upload = time.time()
+
         while self.input_processing_running:
 
             # Process everything in the queue.
             _to_upload = []
+            _rx_times = []
 
             while self.input_queue.qsize() > 0:
                 try:
-                    _to_upload.append(self.input_queue.get_nowait())
+                    _telem, _rx_time = self.input_queue.get_nowait()
+                    _to_upload.append(_telem)
+                    _rx_times.append(_rx_time)
                 except Exception as e:
                     self.log_error("Error grabbing telemetry from queue - %s" % str(e))
 
             # Upload data!
             if len(_to_upload) > 0:
-                self.upload_telemetry(_to_upload)
+                _upload_start = time.time()
+                # Only frames with a decoder receive time are traced.
+                _rx_times = [_t for _t in _rx_times if _t is not None]
+                for _rx_time in _rx_times:
+                    record_latency("sondehub_queue", _rx_time, _upload_start)
+
+                if self.upload_telemetry(_to_upload):
+                    _upload_end = time.time()
+                    for _rx_time in _rx_times:
+                        record_latency("sondehub", _rx_time, _upload_end)
 
             # If we haven't uploaded our station position recently, re-upload it.
             if (
@@ -390,16 +407,21 @@ class SondehubUploader(object):
             if self.slower_uploads:
                 self.actual_upload_rate = min(30,int(self.upload_rate*1.5))
             
-            # Sleep while waiting for some new data.
-            for i in range(self.actual_upload_rate):
-                time.sleep(1)
-                if self.input_processing_running == False:
-                    break
+            # Wait for the next upload. Uploads start every actual_upload_rate seconds, independent of
+            # how long an upload takes; close() ends the wait.
+            _next_upload += self.actual_upload_rate
+            if _next_upload < time.time():
+                _next_upload = time.time()
+            self.input_processing_wakeup.wait(_next_upload - time.time())
 
         self.log_info("Stopped Sondehub Uploader Thread.")
 
     def upload_telemetry(self, telem_list):
-        """ Upload an list of telemetry data to Sondehub """
+        """ Upload an list of telemetry data to Sondehub
+
+        Returns:
+            bool: True if the upload was accepted by Sondehub.
+        """
 
         _data_len = len(telem_list)
 
@@ -412,7 +434,7 @@ class SondehubUploader(object):
                 "Error serialising and compressing telemetry list for upload - %s"
                 % str(e)
             )
-            return
+            return False
 
         _compression_time = time.time() - _start_time
         self.log_debug(
@@ -448,7 +470,7 @@ class SondehubUploader(object):
                 )
             except Exception as e:
                 self.log_error("Upload Failed: %s" % str(e))
-                return
+                return False
 
             if _req.status_code == 200:
                 # 200 is the only status code that we accept.
@@ -501,6 +523,8 @@ class SondehubUploader(object):
         if not _upload_success:
             self.log_error("Upload failed after %d retries" % (_retries))
 
+        return _upload_success
+
     def station_position_upload(self):
         """ 
         Upload a station position packet to SondeHub.
@@ -579,6 +603,7 @@ class SondehubUploader(object):
     def close(self):
         """ Close input processing thread. """
         self.input_processing_running = False
+        self.input_processing_wakeup.set()
 
     def running(self):
         """ Check if the uploader thread is running. 
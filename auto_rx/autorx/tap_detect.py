@@ -0,0 +1,236 @@
+#!/usr/bin/env python
+#
+#   radiosonde_auto_rx - Decoder IQ Tap Detection
+#
+#   A decoder pulls IQ at a sample rate wider than one sonde channel (48 or 96 kHz, or a KA9Q channel).
+#   With the tap enabled, iq_shmw --tee sits in the decoder IQ chain and copies the stream into a
+#   shared-memory ring, and one dft_detect (continuous mode) per off-centre channel reads from that ring.
+#   New sondes within the captured bandwidth are reported like scan results, with no extra SDR and no scan pause.
+#
+#   The ring never blocks the decoder: a detector which falls behind skips ahead.
+#
+#   Released under GNU GPL v3 or later
+#
+import logging
+import os
+import re
+import signal
+import subprocess
+import time
+from threading import Lock, Thread
+from .reactor import get_reactor
+from .scan import parse_dft_detect_output
+from .sonde_tlm import split_lines
+
+
+# Spacing of the tap detection channels, and the number of channels (closest to the centre first).
+TAP_CHANNEL_SPACING = 10000
+TAP_MAX_CHANNELS = 6
+# Seconds to wait for the decoder chain to create the ring.
+TAP_START_TIMEOUT = 15
+# Report a sonde at most once in this many seconds.
+TAP_REPORT_HOLDOFF = 120
+# Detections needed in a channel (within TAP_REPORT_HOLDOFF) before a sonde is reported. Filters out the odd
+# false header match, which the continuous detectors would otherwise turn into decoders on empty channels.
+TAP_MIN_DETECTIONS = 2
+
+
+def get_tap_shm_name(sonde_freq, device_idx):
+    """ Shared memory segment name of a decoder tap (/dev/shm/<name>) """
+    return re.sub(r"[^A-Za-z0-9_]", "_", f"autorx_tap_{device_idx}_{int(sonde_freq)}")
+
+
+def get_tap_cmd(shm_name, sample_rate, iq_shmw_path="./iq_shmw"):
+    """ Command to insert into a decoder IQ chain (signed 16-bit IQ), after the SDR command. """
+    return f" {iq_shmw_path} --tee {shm_name} - {int(sample_rate)} 16 2>/dev/null |"
+
+
+def plan_tap_channels(sample_rate, channel_filter=None, spacing=TAP_CHANNEL_SPACING, max_channels=TAP_MAX_CHANNELS):
+    """ Channel offsets (Hz, relative to the decoder frequency) covered by the tap detectors.
+
+    The decoder's own channel (offset 0) is left out. Channels must lie within the captured bandwidth,
+    which is the sample rate, or the KA9Q channel filter if one is set.
+    """
+    _half_bw = sample_rate / 2.0
+    if channel_filter:
+        _half_bw = min(_half_bw, float(channel_filter))
+
+    _offsets = []
+    _n = 1
+    while (_n * spacing + spacing / 2.0 <= _half_bw) and (len(_offsets) < max_channels):
+        _offsets += [_n * spacing, -_n * spacing]
+        _n += 1
+
+    return _offsets[:max_channels]
+
+
+class TapDetector(object):
+    """ Runs dft_detect on the off-centre channels of a decoder IQ tap. """
+
+    def __init__(
+        self,
+        shm_name,
+        sonde_freq,
+        sonde_type,
+        sample_rate,
+        offsets,
+        callback,
+        rs_path="./",
+        quantization=10000,
+        spacing_limit=15000,
+    ):
+        """ Initialise a tap detector. Call start() once the decoder chain is running.
+
+        Args:
+            shm_name (str): Shared memory segment written by iq_shmw --tee.
+            sonde_freq (float): Decoder (tap centre) frequency, in Hz.
+            sonde_type (str): Sonde type being decoded.
+            sample_rate (int): Sample rate of the tapped IQ stream, in Hz.
+            offsets (list): Channel offsets to run a detector on (Hz), from plan_tap_channels().
+            callback (function): Called with a list of [frequency, type] detections, like the scanner callback.
+            rs_path (str): Path to the RS binaries (dft_detect).
+            quantization (int): Detections within quantization/2 of sonde_freq are the sonde being decoded (Hz).
+            spacing_limit (int): Ignore detections of the decoded sonde type within this many Hz of the
+                decoder frequency (most likely the decoded sonde itself, seen through a neighbouring channel).
+        """
+        self.shm_name = shm_name
+        self.sonde_freq = sonde_freq
+        self.sonde_type = sonde_type.lstrip("-")
+        self.sample_rate = sample_rate
+        self.offsets = offsets
+        self.callback = callback
+        self.rs_path = rs_path
+        self.quantization = quantization
+        self.spacing_limit = spacing_limit
+
+        self.name = "Tap %.3f MHz" % (sonde_freq / 1e6)
+        self.running = False
+        self.lock = Lock()
+        self.processes = []
+        self.sources = []
+        self.last_report = {}
+        self.detections = {}
+
+    def start(self):
+        self.running = True
+        Thread(target=self.start_detectors).start()
+
+    def start_detectors(self):
+        """ Wait for the decoder chain to create the ring, then start one dft_detect per channel. """
+        _shm_path = os.path.join("/dev/shm", self.shm_name)
+        _start = time.time()
+        while not os.path.exists(_shm_path):
+            if (not self.running) or (time.time() - _start > TAP_START_TIMEOUT):
+                if self.running:
+                    logging.error("%s - IQ tap did not start, no detection on this decoder." % self.name)
+                return
+            time.sleep(0.5)
+
+        with self.lock:
+            if not self.running:
+                return
+
+            for _offset in self.offsets:
+                _cmd = (
+                    f"{os.path.join(self.rs_path, 'dft_detect')} -c --IQ {_offset / self.sample_rate:.6f} "
+                    f"--dc --shm {self.shm_name} 2>/dev/null"
+                )
+                logging.debug("%s - Detector Command: %s" % (self.name, _cmd))
+
+                _process = subprocess.Popen(
+                    _cmd,
+                    shell=True,
+                    stdin=None,
+                    stdout=subprocess.PIPE,
+                    preexec_fn=os.setsid,
+                )
+                self.processes.append(_process)
+                self.sources.append(
+                    get_reactor().register(
+                        _process.stdout,
+                        lambda line, offset=_offset: self.handle_line(line, offset),
+                        parser=split_lines,
+                    )
+                )
+
+        logging.info(
+            "%s - Detecting sondes at offsets %s kHz."
+            % (self.name, ", ".join("%+d" % (_o / 1e3) for _o in sorted(self.offsets)))
+        )
+
+    def handle_line(self, line, offset):
+        """ Handle a line of dft_detect output. Called from the reactor thread. """
+        if not self.running:
+            return
+
+        _line = line.decode("ascii", errors="ignore").strip()
+        if ":" not in _line:
+            return
+
+        (_type, _offset_est, _score) = parse_dft_detect_output(_line, self.name)
+        if _type is None:
+            return
+
+        # Rounded to 1 kHz like the scanner results, so that the decoder starts on frequency and
+        # handle_scan_results() matches it against the scanner's detections of the same sonde.
+        _freq = round((self.sonde_freq + offset + _offset_est) / 1000.0) * 1000.0
+
+        if abs(_freq - self.sonde_freq) < self.quantization / 2.0:
+            # The sonde being decoded.
+            return
+
+        if (_type.lstrip("-") == self.sonde_type) and (abs(_freq - self.sonde_freq) < self.spacing_limit):
+            return
+
+        _now = time.time()
+        _key = (offset, _type)
+        self.detections[_key] = [_t for _t in self.detections.get(_key, []) if _t > _now - TAP_REPORT_HOLDOFF] + [_now]
+        if len(self.detections[_key]) < TAP_MIN_DETECTIONS:
+            return
+
+        # A sonde is usually detected in more than one channel. Like handle_scan_results(), treat detections of
+        # the same type within spacing_limit as the same sonde.
+        for _report_freq, (_report_time, _report_type) in list(self.last_report.items()):
+            if _report_time < _now - TAP_REPORT_HOLDOFF:
+                self.last_report.pop(_report_freq)
+            elif (_report_type == _type) and (abs(_report_freq - _freq) < self.spacing_limit):
+                return
+        self.last_report[_freq] = (_now, _type)
+
+        logging.info(
+            "%s - Detected %s sonde on %.3f MHz (Score: %.2f)"
+            % (self.name, _type, _freq / 1e6, _score)
+        )
+
+        try:
+            self.callback([[_freq, _type]])
+        except Exception as e:
+            logging.error("%s - Error passing detection to callback - %s" % (self.name, str(e)))
+
+    def stop(self):
+        """ Stop the detectors, and remove the ring if the decoder chain left it behind. """
+        with self.lock:
+            self.running = False
+
+            for _source in self.sources:
+                get_reactor().unregister(_source)
+            self.sources = []
+
+            for _process in self.processes:
+                try:
+                    os.killpg(os.getpgid(_process.pid), signal.SIGKILL)
+                except Exception as e:
+                    logging.debug("%s - SIGKILL via os.killpg failed - %s" % (self.name, str(e)))
+                try:
+                    _process.wait(timeout=2)
+                except Exception:
+                    pass
+            self.processes = []
+
+        # The decoder chain is stopped with SIGKILL, so iq_shmw does not get to unlink the ring.
+        try:
+            os.remove(os.path.join("/dev/shm", self.shm_name))
+        except FileNotFoundError:
+            pass
+        except Exception as e:
+            logging.debug("%s - Could not remove IQ tap ring - %s" % (self.name, str(e)))
@@ -34,7 +34,8 @@ from autorx.log_files import (
     path_to_kml_placemark
 )
 from autorx.decode import SondeDecoder
-from queue import Queue
+from autorx.latency import record_latency, get_latency_stats
+from queue import Queue, Empty
 from threading import Thread
 import flask
 from flask import request, abort, make_response, send_file
@@ -292,6 +293,21 @@ def flask_get_scan_data():
     return json.dumps(autorx.scan.scan_result)
 
 
+@app.route("/get_latency_stats")
+def flask_get_latency_stats():
+    """ Return the telemetry latency histograms (see latency.py) """
+    return json.dumps(get_latency_stats())
+
+
+@app.route("/get_scan_scheduler_stats")
+def flask_get_scan_scheduler_stats():
+    """ Return the per-frequency scan history of the scan scheduler (persistent carriers: 'backed_off') """
+    if autorx.scan_scheduler is None:
+        return json.dumps([])
+
+    return json.dumps(autorx.scan_scheduler.get_stats())
+
+
 @app.route("/get_telemetry_archive")
 def flask_get_telemetry_archive():
     """ Return a copy of the telemetry archive """
@@ -773,16 +789,18 @@ class WebExporter(object):
         """ Process data from the input queue.
         """
         while self.input_processing_running:
-            # Read in all queue items and handle them.
-            while not self.input_queue.empty():
-                self.handle_telemetry(self.input_queue.get())
+            # Wait for new data (up to a second, to check the store and for shutdown),
+            # then read in all queue items and handle them.
+            try:
+                self.handle_telemetry(self.input_queue.get(timeout=1.0))
+                while not self.input_queue.empty():
+                    self.handle_telemetry(self.input_queue.get())
+            except Empty:
+                pass
 
             # Check the telemetry store for old data.
             self.clean_telemetry_store()
 
-            # Wait a short time before processing new data
-            time.sleep(0.1)
-
         logging.debug("WebExporter - Closed Processing thread.")
 
     def handle_telemetry(self, telemetry):
@@ -849,6 +867,9 @@ class WebExporter(object):
         # Pass it on to the client.
         socketio.emit("telemetry_event", _telem, namespace="/update_status")
 
+        if "rx_time" in _telem:
+            record_latency("web", _telem["rx_time"])
+
     def clean_telemetry_store(self):
         """ Remove any old data from the telemetry store """
         global flask_telemetry_store
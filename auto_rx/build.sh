@@ -26,6 +26,7 @@ make -C .. clean all
 echo "Copying files into auto_rx directory."
 cd ../auto_rx/
 mv ../scan/dft_detect .
+mv ../scan/power_peaks .
 mv ../utils/fsk_demod .
 mv ../imet/imet4iq .
 mv ../mk2a/mk2a1680mod .
@@ -40,6 +41,7 @@ mv ../demod/mod/imet54mod .
 mv ../demod/mod/mp3h1mod .
 mv ../demod/mod/mts01mod .
 mv ../demod/mod/iq_dec .
+mv ../demod/mod/iq_shmw .
 mv ../weathex/weathex301d .
 mv ../dropsonde/rd94rd41drop .
 
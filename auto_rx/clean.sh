@@ -11,6 +11,7 @@ make -C .. clean
 echo "Removing binaries in the auto_rx directory."
 cd ../auto_rx/
 rm dft_detect
+rm power_peaks
 rm fsk_demod
 rm imet4iq
 rm mk2a1680mod
@@ -25,6 +26,7 @@ rm mp3h1mod
 rm imet54mod
 rm mts01mod
 rm iq_dec
+rm iq_shmw
 
 
 echo "Done!"
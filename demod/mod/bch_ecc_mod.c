@@ -635,11 +635,152 @@ static int era_sigma(RS_t *RS, int n, ui8_t era_pos[], ui8_t *sigma) {
     return 0;
 }
 
+/*
+ *  syndromes S_i = c((alpha^p)^(b+i)), i=0..2t-1, all in one pass over the codeword
+ *
+ *  multiplication by a constant a with split-nibble tables (PSHUFB/TBL):
+ *    x*a = tab[x & 0xF] ^ tab[16 + (x >> 4)]
+ *  SIMD: 16 lanes r=0..15, Horner over the 16-byte blocks m with a^16,
+ *    T_r = sum_m c[16m+r] (a^16)^m ,  S = sum_r T_r a^r  (Horner over the lanes)
+ *  kernel selected at runtime (syn_init): SSSE3 (x86), NEON (aarch64), else scalar
+ */
+
+typedef int (*syn_f)(RS_t *RS, ui8_t cw[], ui8_t *S);
+static syn_f syn_kernel = 0;
+
+#define SYN_BLKS ((MAX_DEG+1+15)/16)
+
+static ui8_t syn_mul(ui8_t tab[], ui8_t x) {
+    return tab[x & 0xF] ^ tab[16 + (x >> 4)];
+}
+
+static int syn_scalar(RS_t *RS, ui8_t cw[], ui8_t *S) {
+    int i, j, nsyn = 2*RS->t;
+    ui8_t s[MAX_SYN], c, e = 0;
+
+    for (i = 0; i < nsyn; i++) s[i] = 0;
+    for (j = RS->N-1; j >= 0; j--) {
+        c = cw[j];
+        for (i = 0; i < nsyn; i++) s[i] = syn_mul(RS->syn_a[i], s[i]) ^ c;
+    }
+    for (i = 0; i < nsyn; i++) { S[i] = s[i]; e |= s[i]; }
+
+    return e != 0;
+}
+
+// lanes T[16] -> S_i
+static ui8_t syn_lanes(ui8_t tab[], ui8_t T[]) {
+    int r;
+    ui8_t s = 0;
+    for (r = 15; r >= 0; r--) s = syn_mul(tab, s) ^ T[r];
+    return s;
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SYN_SSSE3
+#include <tmmintrin.h>
+
+__attribute__((target("ssse3")))
+static int syn_ssse3(RS_t *RS, ui8_t cw[], ui8_t *S) {
+    const __m128i m4 = _mm_set1_epi8(0x0F);
+    __m128i v[MAX_SYN], c, lo, hi;
+    ui8_t buf[SYN_BLKS*16];
+    ui8_t T[16], e = 0;
+    int i, j, m, nsyn = 2*RS->t, nblk = (RS->N+15)/16;
+
+    for (j = 0; j < RS->N; j++) buf[j] = cw[j];
+    for (j = RS->N; j < nblk*16; j++) buf[j] = 0;
+
+    for (i = 0; i < nsyn; i++) v[i] = _mm_setzero_si128();
+    for (m = nblk-1; m >= 0; m--) {
+        c = _mm_loadu_si128((__m128i *)(buf+16*m));
+        for (i = 0; i < nsyn; i++) {
+            lo = _mm_shuffle_epi8(_mm_loadu_si128((__m128i *)RS->syn_a16[i]), _mm_and_si128(v[i], m4));
+            hi = _mm_shuffle_epi8(_mm_loadu_si128((__m128i *)(RS->syn_a16[i]+16)), _mm_and_si128(_mm_srli_epi16(v[i], 4), m4));
+            v[i] = _mm_xor_si128(_mm_xor_si128(lo, hi), c);
+        }
+    }
+    for (i = 0; i < nsyn; i++) {
+        _mm_storeu_si128((__m128i *)T, v[i]);
+        S[i] = syn_lanes(RS->syn_a[i], T);
+        e |= S[i];
+    }
+
+    return e != 0;
+}
+#endif
+
+#if defined(__aarch64__)
+#define SYN_NEON
+#include <arm_neon.h>
+
+static int syn_neon(RS_t *RS, ui8_t cw[], ui8_t *S) {
+    const uint8x16_t m4 = vdupq_n_u8(0x0F);
+    uint8x16_t v[MAX_SYN], c, lo, hi;
+    ui8_t buf[SYN_BLKS*16];
+    ui8_t T[16], e = 0;
+    int i, j, m, nsyn = 2*RS->t, nblk = (RS->N+15)/16;
+
+    for (j = 0; j < RS->N; j++) buf[j] = cw[j];
+    for (j = RS->N; j < nblk*16; j++) buf[j] = 0;
+
+    for (i = 0; i < nsyn; i++) v[i] = vdupq_n_u8(0);
+    for (m = nblk-1; m >= 0; m--) {
+        c = vld1q_u8(buf+16*m);
+        for (i = 0; i < nsyn; i++) {
+            lo = vqtbl1q_u8(vld1q_u8(RS->syn_a16[i]), vandq_u8(v[i], m4));
+            hi = vqtbl1q_u8(vld1q_u8(RS->syn_a16[i]+16), vshrq_n_u8(v[i], 4));
+            v[i] = veorq_u8(veorq_u8(lo, hi), c);
+        }
+    }
+    for (i = 0; i < nsyn; i++) {
+        vst1q_u8(T, v[i]);
+        S[i] = syn_lanes(RS->syn_a[i], T);
+        e |= S[i];
+    }
+
+    return e != 0;
+}
+#endif
+
+static void syn_tab(GF_t *gf, ui8_t a, ui8_t tab[]) {
+    int x;
+    for (x = 0; x < 16; x++) {
+        tab[x]    = GF_mul(gf, x, a);
+        tab[16+x] = (x << 4) < gf->ord ? GF_mul(gf, x << 4, a) : 0;
+    }
+}
+
+static void syn_init(RS_t *RS) {
+    GF_t *gf = &RS->GF;
+    int i;
+    ui8_t a_i;
+
+    for (i = 0; i < 2*RS->t && i < MAX_SYN; i++) {
+        a_i = gf->exp_a[(RS->p*(RS->b+i)) % (gf->ord-1)];       // (alpha^p)^(b+i)
+        syn_tab(gf, a_i, RS->syn_a[i]);
+        syn_tab(gf, gf->exp_a[(16*gf->log_a[a_i]) % (gf->ord-1)], RS->syn_a16[i]);
+    }
+
+    if (syn_kernel == 0) {
+        syn_kernel = syn_scalar;
+    #ifdef SYN_SSSE3
+        if (__builtin_cpu_supports("ssse3")) syn_kernel = syn_ssse3;
+    #endif
+    #ifdef SYN_NEON
+        syn_kernel = syn_neon;
+    #endif
+    }
+}
+
+// S[0..2t-1]; return: 1 if S != 0
 static int syndromes(RS_t *RS, ui8_t cw[], ui8_t *S) {
     GF_t *gf = &RS->GF;
     int i, errors = 0;
     ui8_t a_i;
 
+    if (syn_kernel && 2*RS->t <= MAX_SYN) return syn_kernel(RS, cw, S);
+
     // syndromes: e_j=S((alpha^p)^(b+i))  (wie in g(X))
     for (i = 0; i < 2*RS->t; i++) {
         a_i = gf->exp_a[(RS->p*(RS->b+i)) % (gf->ord-1)];  // (alpha^p)^(b+i)
@@ -707,6 +848,52 @@ static void prn_table(void) {
 */
 
 
+/* --------------------------------------------------------------------------------------------- */
+/*
+ *  bin. BCH(63, 51), t=2 (Meisei), codeword packed in 64 bit: bit k = cw[k]
+ *
+ *  syndromes S1 = c(alpha), S3 = c(alpha^3) byte-wise (S2 = S1^2, S4 = S2^2):
+ *    S = bch63_s[0][c & 0xFF] ^ bch63_s[1][(c>>8) & 0xFF] ^ ... ^ bch63_s[7][c>>56]
+ *  error locators X1, X2 = alpha^pos are the roots of z^2 + S1 z + (S1^2 + S3/S1);
+ *    z = S1 y :  y^2 + y = c ,  c = 1 + S3/S1^3
+ *    c = 0: 1 error, X1 = S1
+ *    else y^2 + y = c has the solutions y0, y0+1 (Tr(c) = 0) or none: bch63_quad[c] = y0 (0: none)
+ *  no polynomial arithmetic and no Chien search
+ */
+
+static GF_t  bch63_gf;
+static ui8_t bch63_s1[8][256];
+static ui8_t bch63_s3[8][256];
+static ui8_t bch63_quad[64];
+
+static void bch63_init(GF_t *gf) {
+    int i, j, k, n;
+    ui8_t s1, s3, c;
+
+    bch63_gf = *gf;
+
+    for (k = 0; k < 8; k++) {
+        for (i = 0; i < 256; i++) {
+            s1 = s3 = 0;
+            for (j = 0; j < 8; j++) {
+                n = 8*k + j;
+                if (n < 63 && ((i >> j) & 1)) {
+                    s1 ^= gf->exp_a[n];
+                    s3 ^= gf->exp_a[(3*n) % 63];
+                }
+            }
+            bch63_s1[k][i] = s1;
+            bch63_s3[k][i] = s3;
+        }
+    }
+
+    for (i = 0; i < 64; i++) bch63_quad[i] = 0;
+    for (i = 2; i < 64; i++) { // y=1: c=0
+        c = GF_mul(gf, i, i) ^ i;
+        if (bch63_quad[c] == 0) bch63_quad[c] = i;
+    }
+}
+
 INCSTAT
 int rs_init_RS(RS_t *RS) {
     GF_t *gf = &RS->GF;
@@ -735,6 +922,8 @@ int rs_init_RS(RS_t *RS) {
         poly_mul(gf, RS->g, Xalp, RS->g);
     }
 
+    syn_init(RS);
+
     return check_gen;
 }
 
@@ -759,6 +948,8 @@ int rs_init_RS255(RS_t *RS) { // RS(255, 231)
         poly_mul(gf, RS->g, Xalp, RS->g);
     }
 
+    syn_init(RS);
+
     return check_gen;
 }
 
@@ -810,6 +1001,8 @@ int rs_init_RS255ccsds(RS_t *RS) { // RS(255, 223)
     RS.g[15] = RS.g[17] = exp_a[5];
     RS.g[16] = exp_a[24];
 */
+    syn_init(RS);
+
     return check_gen;
 }
 
@@ -828,6 +1021,9 @@ int rs_init_BCH64(RS_t *RS) {
     //     =(X^6+X+1)(X^6+X^4+X^2+X+1)
     RS->g[0] = RS->g[3] = RS->g[4] = RS->g[5] = RS->g[8] = RS->g[10] = RS->g[12] = 1;
 
+    syn_init(RS);
+    bch63_init(gf);
+
     return check_gen;
 }
 
@@ -853,6 +1049,8 @@ int rs_init_RS15ccsds(RS_t *RS) {
         poly_mul(gf, RS->g, Xalp, RS->g);
     }
 
+    syn_init(RS);
+
     return check_gen;
 }
 
@@ -872,32 +1070,17 @@ int rs_encode(RS_t *RS, ui8_t cw[]) {
     return 0;
 }
 
-// 2*Errors + Erasure <= 2*t
-INCSTAT
-int rs_decode_ErrEra(RS_t *RS, ui8_t cw[], int nera, ui8_t era_pos[],
-                               ui8_t *err_pos, ui8_t *err_val) {
+// decoder, syndromes S[0..2t-1] given (S[2t..MAX_DEG]=0), errera: S != 0
+static int decode_S(RS_t *RS, ui8_t cw[], ui8_t S[], int errera, int nera, ui8_t era_pos[],
+                    ui8_t *err_pos, ui8_t *err_val) {
     GF_t *gf = &RS->GF;
     ui8_t x, gamma;
-    ui8_t S[MAX_DEG+1],
-          Lambda[MAX_DEG+1],
+    ui8_t Lambda[MAX_DEG+1],
           Omega[MAX_DEG+1],
           sigma[MAX_DEG+1],
           sigLam[MAX_DEG+1];
     int deg_sigLam, deg_Lambda, deg_Omega;
-    int i, nerr, errera = 0;
-
-    if (nera > 2*RS->t) { return -4; }
-
-    for (i = 0; i < 2*RS->t; i++) { err_pos[i] = 0; }
-    for (i = 0; i < 2*RS->t; i++) { err_val[i] = 0; }
-
-    // IF: erasures set 0
-    //    for (i = 0; i < nera; i++) cw[era_pos[i]] = 0x00; // erasures
-    // THEN: restore cw[era_pos[i]], if errera < 0
-
-    for (i = 0; i <= MAX_DEG; i++) { S[i] = 0; }
-    errera = syndromes(RS, cw, S);
-    // wenn  S(x)=0 ,  dann poly_divmod(cw, RS.g, d, rem): rem=0
+    int i, nerr;
 
     for (i = 0; i <= MAX_DEG; i++) { sigma[i] = 0; }
     sigma[0] = 1;
@@ -957,6 +1140,65 @@ int rs_decode_ErrEra(RS_t *RS, ui8_t cw[], int nera, ui8_t era_pos[],
     return errera;
 }
 
+// 2*Errors + Erasure <= 2*t
+INCSTAT
+int rs_decode_ErrEra(RS_t *RS, ui8_t cw[], int nera, ui8_t era_pos[],
+                               ui8_t *err_pos, ui8_t *err_val) {
+    ui8_t S[MAX_DEG+1];
+    int i, errera = 0;
+
+    if (nera > 2*RS->t) { return -4; }
+
+    for (i = 0; i < 2*RS->t; i++) { err_pos[i] = 0; }
+    for (i = 0; i < 2*RS->t; i++) { err_val[i] = 0; }
+
+    // IF: erasures set 0
+    //    for (i = 0; i < nera; i++) cw[era_pos[i]] = 0x00; // erasures
+    // THEN: restore cw[era_pos[i]], if errera < 0
+
+    errera = syndromes(RS, cw, S);
+    // wenn  S(x)=0 ,  dann poly_divmod(cw, RS.g, d, rem): rem=0
+    if (errera == 0) return 0;
+
+    for (i = 2*RS->t; i <= MAX_DEG; i++) { S[i] = 0; }
+
+    return decode_S(RS, cw, S, errera, nera, era_pos, err_pos, err_val);
+}
+
+/*
+ *  batch decoding (errors only)
+ *    Most codewords are error-free (S=0) and need nothing but the syndromes;
+ *    the others continue with decode_S().
+ */
+
+// errors[k]: as rs_decode(); err_pos[], err_val[] may be NULL
+// return: number of uncorrectable codewords
+INCSTAT
+int rs_decode_batch(RS_t *RS, int n, ui8_t *cw[], int errors[], ui8_t *err_pos[], ui8_t *err_val[]) {
+    ui8_t S[MAX_DEG+1];
+    ui8_t pos[MAX_DEG+1], val[MAX_DEG+1];
+    ui8_t tmp[1] = {0};
+    int nsyn = 2*RS->t;
+    int i, k, errs, nerr = 0;
+
+    for (k = 0; k < n; k++) {
+        ui8_t *ep = err_pos ? err_pos[k] : pos;
+        ui8_t *ev = err_val ? err_val[k] : val;
+
+        for (i = 0; i < nsyn; i++) { ep[i] = 0; ev[i] = 0; }
+
+        errs = syndromes(RS, cw[k], S);
+        if (errs) {
+            for (i = nsyn; i <= MAX_DEG; i++) { S[i] = 0; }
+            errs = decode_S(RS, cw[k], S, errs, 0, tmp, ep, ev);
+        }
+        errors[k] = errs;
+        if (errs < 0) nerr++;
+    }
+
+    return nerr;
+}
+
 // Errors <= t
 INCSTAT
 int rs_decode(RS_t *RS, ui8_t cw[], ui8_t *err_pos, ui8_t *err_val) {
@@ -979,11 +1221,11 @@ int rs_decode_bch_gf2t2(RS_t *RS, ui8_t cw[], ui8_t *err_pos, ui8_t *err_val) {
     for (i = 0; i < RS->t; i++) { err_pos[i] = 0; }
     for (i = 0; i < RS->t; i++) { err_val[i] = 0; }
 
-    for (i = 0; i <= MAX_DEG; i++) { S[i] = 0; }
     errors = syndromes(RS, cw, S);
     // wenn  S(x)=0 ,  dann poly_divmod(cw, RS.g, d, rem): rem=0
 
     if (errors) {
+        for (i = 2*RS->t; i <= MAX_DEG; i++) { S[i] = 0; }
         polyGF_lfsr(gf, RS->t, 2*RS->t, S, Lambda, Omega);
         gamma = Lambda[0];
         if (gamma) {
@@ -1042,3 +1284,39 @@ int rs_decode_bch_gf2t2(RS_t *RS, ui8_t cw[], ui8_t *err_pos, ui8_t *err_val) {
     return errors;
 }
 
+// cw: bit k = cw[k], k=0..62; return: errors (0,1,2), -1: uncorrectable
+INCSTAT
+int rs_decode_bch63(ui64_t *cw, ui8_t *err_pos) {
+    GF_t *gf = &bch63_gf;
+    ui64_t w = *cw;
+    ui8_t S1 = 0, S3 = 0, b, c, y;
+    int k, l1;
+
+    for (k = 0; k < 8; k++) {
+        b = (w >> (8*k)) & 0xFF;
+        S1 ^= bch63_s1[k][b];
+        S3 ^= bch63_s3[k][b];
+    }
+
+    if (S1 == 0) return S3 ? -1 : 0;
+
+    l1 = gf->log_a[S1];
+    c = 1;
+    if (S3) c ^= gf->exp_a[(gf->log_a[S3] + 3*(63-l1)) % 63];  // 1 + S3/S1^3
+
+    if (c == 0) {
+        err_pos[0] = l1;
+        *cw = w ^ (1ULL << l1);
+        return 1;
+    }
+
+    y = bch63_quad[c];
+    if (y == 0) return -1;
+
+    err_pos[0] = (l1 + gf->log_a[y])   % 63;
+    err_pos[1] = (l1 + gf->log_a[y^1]) % 63;
+    *cw = w ^ (1ULL << err_pos[0]) ^ (1ULL << err_pos[1]);
+
+    return 2;
+}
+
@@ -18,6 +18,7 @@
     typedef unsigned char  ui8_t;
     typedef unsigned short ui16_t;
     typedef unsigned int   ui32_t;
+    typedef unsigned long long ui64_t;
     typedef char  i8_t;
     typedef short i16_t;
     typedef int   i32_t;
@@ -29,6 +30,7 @@
 
 
 #define MAX_DEG 254  // max N-1
+#define MAX_SYN  32  // max 2t (syndrome tables)
 
 
 typedef struct {
@@ -48,6 +50,8 @@ typedef struct {
     ui8_t p; ui8_t ip; // p*ip = 1 mod N
     ui8_t g[MAX_DEG+1];  // ohne g[] eventuell als init_return
     GF_t GF;
+    ui8_t syn_a[MAX_SYN][32];    // x*a_i = syn_a[i][x&0xF] ^ syn_a[i][16+(x>>4)], a_i=(alpha^p)^(b+i)
+    ui8_t syn_a16[MAX_SYN][32];  // x*a_i^16
 } RS_t;
 
 
@@ -82,12 +86,13 @@ static GF_t GF256AES = { .f     = 0x11B,  // AES-GF(2^8): X^8 + X^4 + X^3 + X +
                          .log_a = {0} };
 
 
-static RS_t RS256 = { 255, 12, 24, 231, 0, 1, 1, {0}, {0} };
-static RS_t RS256ccsds = { 255, 16, 32, 223, 112, 11, 116, {0}, {0} };
-static RS_t BCH64 = {  63,  2, 12,  51, 1, 1, 1, {0}, {0} };
+// g[], GF and the syndrome tables syn_a[], syn_a16[] are set by rs_init_*()
+static RS_t RS256      = { .N = 255, .t = 12, .R = 24, .K = 231, .b =   0, .p =  1, .ip =   1 };
+static RS_t RS256ccsds = { .N = 255, .t = 16, .R = 32, .K = 223, .b = 112, .p = 11, .ip = 116 };
+static RS_t BCH64      = { .N =  63, .t =  2, .R = 12, .K =  51, .b =   1, .p =  1, .ip =   1 };
 
-// static RS_t RS16_0 = { 15, 3, 6,  9, 0, 1, 1, {0}, {0} };
-static RS_t RS16ccsds = { 15, 2, 4, 11, 6, 1, 1, {0}, {0} };
+// static RS_t RS16_0  = { .N =  15, .t =  3, .R =  6, .K =   9, .b =   0, .p =  1, .ip =   1 };
+static RS_t RS16ccsds  = { .N =  15, .t =  2, .R =  4, .K =  11, .b =   6, .p =  1, .ip =   1 };
 
 
 #ifndef INCLUDESTATIC
@@ -102,6 +107,8 @@ int rs_encode(RS_t *RS, ui8_t cw[]);
 int rs_decode(RS_t *RS, ui8_t cw[], ui8_t *err_pos, ui8_t *err_val);
 int rs_decode_ErrEra(RS_t *RS, ui8_t cw[], int nera, ui8_t era_pos[], ui8_t *err_pos, ui8_t *err_val);
 int rs_decode_bch_gf2t2(RS_t *RS, ui8_t cw[], ui8_t *err_pos, ui8_t *err_val);
+int rs_decode_bch63(ui64_t *cw, ui8_t *err_pos); // BCH(63,51) packed, after rs_init_BCH64()
+int rs_decode_batch(RS_t *RS, int n, ui8_t *cw[], int errors[], ui8_t *err_pos[], ui8_t *err_val[]);
 
 #endif
 
@@ -18,140 +18,24 @@
 #include <string.h>
 
 #include "demod_mod.h"
+#include "iq_shm.h"
 
 #define FM_GAIN (0.8)
 
+// IQ: f1/f2 tone filters, else FM-demod
+#define IQ_TONES(dsp)  ((dsp)->opt_iq >= 2 && !(dsp)->opt_fm)
+
 /* ------------------------------------------------------------------------------------ */
 
 
 #ifndef EXT_FSK
 
-static void raw_dft(dft_t *dft, float complex *Z) {
-    int s, l, l2, i, j, k;
-    float complex  w1, w2, T;
-
-    j = 1;
-    for (i = 1; i < dft->N; i++) {
-        if (i < j) {
-            T = Z[j-1];
-            Z[j-1] = Z[i-1];
-            Z[i-1] = T;
-        }
-        k = dft->N/2;
-        while (k < j) {
-            j = j - k;
-            k = k/2;
-        }
-        j = j + k;
-    }
-
-    for (s = 0; s < dft->LOG2N; s++) {
-        l2 = 1 << s;
-        l  = l2 << 1;
-        w1 = (float complex)1.0;
-        w2 = dft->ew[s]; // cexp(-I*M_PI/(float)l2)
-        for (j = 1; j <= l2; j++) {
-            for (i = j; i <= dft->N; i += l) {
-                k = i + l2;
-                T = Z[k-1] * w1;
-                Z[k-1] = Z[i-1] - T;
-                Z[i-1] = Z[i-1] + T;
-            }
-            w1 = w1 * w2;
-        }
-    }
-}
-
-static void cdft(dft_t *dft, float complex *z, float complex *Z) {
-    int i;
-    for (i = 0; i < dft->N; i++)  Z[i] = z[i];
-    raw_dft(dft, Z);
-}
-
-static void rdft(dft_t *dft, float *x, float complex *Z) {
-    int i;
-    for (i = 0; i < dft->N; i++)  Z[i] = (float complex)x[i];
-    raw_dft(dft, Z);
-}
-
-static void Nidft(dft_t *dft, float complex *Z, float complex *z) {
-    int i;
-    for (i = 0; i < dft->N; i++)  z[i] = conj(Z[i]);
-    raw_dft(dft, z);
-    // idft():
-    // for (i = 0; i < dft->N; i++)  z[i] = conj(z[i])/(float)dft->N; // hier: z reell
-}
-
-static float bin2freq0(dft_t *dft, int k) {
-    float fq = dft->sr * k / /*(float)*/dft->N;
-    if (fq >= dft->sr/2.0) fq -= dft->sr;
-    return fq;
-}
-static float bin2freq(dft_t *dft, int k) {
-    float fq = k / (float)dft->N;
-    if ( fq >= 0.5) fq -= 1.0;
-    return fq*dft->sr;
-}
-static float bin2fq(dft_t *dft, int k) {
-    float fq = k / (float)dft->N;
-    if ( fq >= 0.5) fq -= 1.0;
-    return fq;
-}
-
-static int max_bin(dft_t *dft, float complex *Z) {
-    int k, kmax;
-    double max;
-
-    max = 0; kmax = 0;
-    for (k = 0; k < dft->N; k++) {
-        if (cabs(Z[k]) > max) {
-            max = cabs(Z[k]);
-            kmax = k;
-        }
-    }
-
-    return kmax;
-}
-
-static int dft_window(dft_t *dft, int w) {
-    int n;
-
-    if (w < 0 || w > 3) return -1;
-
-    for (n = 0; n < dft->N2; n++) {
-        switch (w)
-        {
-            case 0: // (boxcar)
-                    dft->win[n] = 1.0;
-                    break;
-            case 1: // Hann
-                    dft->win[n] = 0.5 * ( 1.0 - cos(_2PI*n/(float)(dft->N2-1)) );
-                    break ;
-            case 2: // Hamming
-                    dft->win[n] = 25/46.0 - (1.0 - 25/46.0)*cos(_2PI*n / (float)(dft->N2-1));
-                    break ;
-            case 3: // Blackmann
-                    dft->win[n] =  7938/18608.0
-                                 - 9240/18608.0*cos(_2PI*n / (float)(dft->N2-1))
-                                 + 1430/18608.0*cos(4*M_PI*n / (float)(dft->N2-1));
-                    break ;
-        }
-    }
-    while (n < dft->N) dft->win[n++] = 0.0;
-
-    return 0;
-}
-
-
 /* ------------------------------------------------------------------------------------ */
 
 static int getCorrDFT(dsp_t *dsp, float thres) {
     int i;
     int mp = -1;
     float mx = 0.0;
-    float mx2 = 0.0;
-    float re_cx = 0.0;
-    float xnorm = 1;
     ui32_t mpos = 0;
     ui32_t pos = dsp->sample_out;
 
@@ -164,59 +48,8 @@ static int getCorrDFT(dsp_t *dsp, float thres) {
     if (dsp->K + dsp->L > dsp->DFT.N) return -1;
     if (dsp->sample_out < dsp->L) return -2;
 
-
-    for (i = 0; i < dsp->K + dsp->L; i++) dsp->DFT.xn[i] = sbuf[(pos+dsp->M -(dsp->K + dsp->L-1) + i) % dsp->M];
-    while (i < dsp->DFT.N) dsp->DFT.xn[i++] = 0.0;
-
-
-    rdft(&dsp->DFT, dsp->DFT.xn, dsp->DFT.X);
-
-
-    if (dsp->opt_dc) {
-        /*
-        //X[0] = 0; // nicht ueber gesamte Laenge ... M10
-        //
-        // L < K ?  // only last 2L samples (avoid M10 carrier offset)
-        double dc = 0.0;
-        for (i = dsp->K - dsp->L; i < dsp->K + dsp->L; i++) dc += dsp->DFT.xn[i];
-        dc /= 2.0*(float)dsp->L;
-        dsp->DFT.X[0] -= dsp->DFT.N * dc  ;//* 0.95;
-        */
-        dsp->DFT.X[0] = 0;
-        Nidft(&dsp->DFT, dsp->DFT.X, dsp->DFT.cx);
-        for (i = 0; i < dsp->DFT.N; i++) dsp->DFT.xn[i] = creal(dsp->DFT.cx[i])/(float)dsp->DFT.N;
-    }
-
-    for (i = 0; i < dsp->DFT.N; i++) dsp->DFT.Z[i] = dsp->DFT.X[i]*dsp->DFT.Fm[i];
-
-    Nidft(&dsp->DFT, dsp->DFT.Z, dsp->DFT.cx);
-
-
-    // relativ Peak - Normierung erst zum Schluss;
-    // dann jedoch nicht zwingend corr-Max wenn FM-Amplitude bzw. norm(x) nicht konstant
-    // (z.B. rs41 Signal-Pausen). Moeglicherweise wird dann wahres corr-Max in dem
-    //  K-Fenster nicht erkannt, deshalb K nicht zu gross waehlen.
-    //
-    mx2 = 0.0;                                      // t = L-1
-    for (i = dsp->L-1; i < dsp->K + dsp->L; i++) {  // i=t .. i=t+K < t+1+K
-        re_cx = creal(dsp->DFT.cx[i]);  // imag(cx)=0
-        if (re_cx*re_cx > mx2) {
-            mx = re_cx;
-            mx2 = mx*mx;
-            mp = i;
-        }
-    }
-    if (mp == dsp->L-1 || mp == dsp->K + dsp->L-1) return -4; // Randwert
-    //  mp == t           mp == K+t
-
-    mpos = pos - (dsp->K + dsp->L-1) + mp; // t = L-1
-
-    //xnorm = sqrt(dsp->qs[(mpos + 2*dsp->M) % dsp->M]); // Nvar = L
-    xnorm = 0.0;
-    for (i = 0; i < dsp->L; i++) xnorm += dsp->DFT.xn[mp-i]*dsp->DFT.xn[mp-i];
-    xnorm = sqrt(xnorm);
-
-    mx /= xnorm*dsp->DFT.N;
+    mp = dft_corr(&dsp->DFT, sbuf, dsp->M, pos, dsp->K, dsp->L, dsp->opt_dc, &mx, &mpos);
+    if (mp < 0) return mp;
 
     dsp->mv = mx;
     dsp->mv_pos = mpos;
@@ -227,42 +60,12 @@ static int getCorrDFT(dsp_t *dsp, float thres) {
     dsp->mv2 = 0.0f;
     dsp->mv2_pos = 0;
     if (dsp->opt_dc) {
-        if (dsp->opt_iq >= 2 && fabs(mx) < thres) { /*&& !dsp->locked*/
+        if (IQ_TONES(dsp) && fabs(mx) < thres) { /*&& !dsp->locked*/
             mx = 0.0f;
             mpos = 0;
 
-            for (i = 0; i < dsp->K + dsp->L; i++) dsp->DFT.xn[i] = dcbuf[(pos+dsp->M -(dsp->K + dsp->L-1) + i) % dsp->M];
-            while (i < dsp->DFT.N) dsp->DFT.xn[i++] = 0.0;
-            rdft(&dsp->DFT, dsp->DFT.xn, dsp->DFT.X);
-
-            dsp->DFT.X[0] = 0;
-            Nidft(&dsp->DFT, dsp->DFT.X, dsp->DFT.cx);
-            for (i = 0; i < dsp->DFT.N; i++) dsp->DFT.xn[i] = creal(dsp->DFT.cx[i])/(float)dsp->DFT.N;
-
-            for (i = 0; i < dsp->DFT.N; i++) dsp->DFT.Z[i] = dsp->DFT.X[i]*dsp->DFT.Fm[i];
-
-            Nidft(&dsp->DFT, dsp->DFT.Z, dsp->DFT.cx);
-
-            mx2 = 0.0;                                      // t = L-1
-            for (i = dsp->L-1; i < dsp->K + dsp->L; i++) {  // i=t .. i=t+K < t+1+K
-                re_cx = creal(dsp->DFT.cx[i]);  // imag(cx)=0
-                if (re_cx*re_cx > mx2) {
-                    mx = re_cx;
-                    mx2 = mx*mx;
-                    mp = i;
-                }
-            }
-            if (mp == dsp->L-1 || mp == dsp->K + dsp->L-1) return -4; // Randwert
-            //  mp == t           mp == K+t
-
-            mpos = pos - (dsp->K + dsp->L-1) + mp; // t = L-1
-
-            xnorm = 0.0;
-            for (i = 0; i < dsp->L; i++) xnorm += dsp->DFT.xn[mp-i]*dsp->DFT.xn[mp-i];
-            xnorm = sqrt(xnorm);
-
-            mx /= xnorm*dsp->DFT.N;
-
+            mp = dft_corr(&dsp->DFT, dcbuf, dsp->M, pos, dsp->K, dsp->L, 1, &mx, &mpos);
+            if (mp < 0) return mp;
 
             dsp->mv2 = mx;
             dsp->mv2_pos = mpos - (dsp->lpFMtaps - (dsp->sps-1))/2;
@@ -281,7 +84,7 @@ static int getCorrDFT(dsp_t *dsp, float thres) {
     {
         double dc = 0.0;
         int mp_ofs = 0;
-        if (dsp->opt_iq >= 2  &&  dsp->mv2_pos == 0) {
+        if (IQ_TONES(dsp)  &&  dsp->mv2_pos == 0) {
             mp_ofs = (dsp->lpFMtaps - (dsp->sps-1))/2;
         }
         dc = 0.0;  // rs41 without preamble?
@@ -376,6 +179,35 @@ int read_wav_header(pcm_t *pcm, FILE *fp) {
 }
 
 
+int attach_shm(dsp_t *dsp, pcm_t *pcm, char *name) {
+    iqshm_t *q = iqshm_open(name);
+    if (q == NULL) return -1;
+
+    fprintf(stderr, "shm        : %s\n", q->name);
+    fprintf(stderr, "sample_rate: %d\n", q->hdr->sr);
+    fprintf(stderr, "bits       : %d\n", q->hdr->bps);
+    fprintf(stderr, "channels   : %d\n", q->hdr->nch);
+
+    pcm->sr  = q->hdr->sr;
+    pcm->bps = q->hdr->bps;
+    pcm->nch = q->hdr->nch;
+    if (pcm->sel_ch < 0  ||  pcm->sel_ch >= pcm->nch) pcm->sel_ch = 0;
+
+    dsp->shm = q;
+    return 0;
+}
+
+static size_t dsp_fread(void *ptr, size_t size, size_t n, dsp_t *dsp) {
+    size_t len;
+    if (dsp->shm) return iqshm_read(dsp->shm, ptr, size, n);
+    len = fread(ptr, size, n, dsp->fp);
+    if (dsp->opt_rxtime) {
+        dsp->in_bytes += len*size;
+        if (dsp->rx_t0 <= 0) rxt_update(&dsp->rxt, dsp->in_bytes / (dsp->nch*dsp->bps/8), rxt_now());
+    }
+    return len;
+}
+
 static int f32read_sample(dsp_t *dsp, float *s) {
     int i;
     unsigned int word = 0;
@@ -384,7 +216,7 @@ static int f32read_sample(dsp_t *dsp, float *s) {
 
     for (i = 0; i < dsp->nch; i++) {
 
-        if (fread( &word, dsp->bps/8, 1, dsp->fp) != 1) return EOF;
+        if (dsp_fread( &word, dsp->bps/8, 1, dsp) != 1) return EOF;
 
         if (i == dsp->ch) {  // i = 0: links bzw. mono
             //if (bits_sample ==  8)  sint = b-128;   // 8bit: 00..FF, centerpoint 0x80=128
@@ -422,19 +254,19 @@ static int f32read_csample(dsp_t *dsp, float complex *z) {
 
     if (dsp->bps == 32) { //float32
         float f[2];
-        if (fread( f, dsp->bps/8, 2, dsp->fp) != 2) return EOF;
+        if (dsp_fread( f, dsp->bps/8, 2, dsp) != 2) return EOF;
         x = f[0];
         y = f[1];
     }
     else if (dsp->bps == 16) { //int16
         short b[2];
-        if (fread( b, dsp->bps/8, 2, dsp->fp) != 2) return EOF;
+        if (dsp_fread( b, dsp->bps/8, 2, dsp) != 2) return EOF;
         x = b[0]/32768.0;
         y = b[1]/32768.0;
     }
     else {  // dsp->bps == 8   //uint8
         ui8_t u[2];
-        if (fread( u, dsp->bps/8, 2, dsp->fp) != 2) return EOF;
+        if (dsp_fread( u, dsp->bps/8, 2, dsp) != 2) return EOF;
         x = (u[0]-128)/128.0;
         y = (u[1]-128)/128.0;
     }
@@ -471,7 +303,7 @@ static int f32read_cblock(dsp_t *dsp) {
     float *f = (float*)s;
 
 
-    len = fread( s, dsp->bps/8, 2*dsp->decM, dsp->fp) / 2;
+    len = dsp_fread( s, dsp->bps/8, 2*dsp->decM, dsp) / 2;
 
     //for (n = 0; n < len; n++) dsp->decMbuf[n] = (u[2*n]-128)/128.0 + I*(u[2*n+1]-128)/128.0;
     // u8: 0..255, 128 -> 0V
@@ -545,180 +377,6 @@ static int get_SNR_rs41(dsp_t *dsp) {
 // decimate lowpass
 static float *ws_dec;
 
-static double sinc(double x) {
-    double y;
-    if (x == 0) y = 1;
-    else y = sin(M_PI*x)/(M_PI*x);
-    return y;
-}
-
-static int lowpass_init(float f, int taps, float **pws) {
-    double *h, *w;
-    double norm = 0;
-    int n;
-    float *ws = NULL;
-
-    if (taps % 2 == 0) taps++; // odd/symmetric
-
-    if ( taps < 1 ) taps = 1;
-
-    h = (double*)calloc( taps+1, sizeof(double)); if (h == NULL) return -1;
-    w = (double*)calloc( taps+1, sizeof(double)); if (w == NULL) return -1;
-    ws = (float*)calloc( 2*taps+1, sizeof(float)); if (ws == NULL) return -1;
-
-    for (n = 0; n < taps; n++) {
-        w[n] = 7938/18608.0 - 9240/18608.0*cos(_2PI*n/(taps-1)) + 1430/18608.0*cos(4*M_PI*n/(taps-1)); // Blackmann
-        h[n] = 2*f*sinc(2*f*(n-(taps-1)/2));
-        ws[n] = w[n]*h[n];
-        norm += ws[n]; // 1-norm
-    }
-    for (n = 0; n < taps; n++) {
-        ws[n] /= norm; // 1-norm
-    }
-
-    for (n = 0; n < taps; n++) ws[taps+n] = ws[n]; // duplicate/unwrap
-
-    *pws = ws;
-
-    free(h); h = NULL;
-    free(w); w = NULL;
-
-    return taps;
-}
-
-
-static int lowpass_update(float f, int taps, float *ws) {
-    double *h, *w;
-    double norm = 0;
-    int n;
-
-    if (taps % 2 == 0) taps++; // odd/symmetric
-
-    if ( taps < 1 ) taps = 1;
-
-    h = (double*)calloc( taps+1, sizeof(double)); if (h == NULL) return -1;
-    w = (double*)calloc( taps+1, sizeof(double)); if (w == NULL) return -1;
-
-    for (n = 0; n < taps; n++) {
-        w[n] = 7938/18608.0 - 9240/18608.0*cos(_2PI*n/(taps-1)) + 1430/18608.0*cos(4*M_PI*n/(taps-1)); // Blackmann
-        h[n] = 2*f*sinc(2*f*(n-(taps-1)/2));
-        ws[n] = w[n]*h[n];
-        norm += ws[n]; // 1-norm
-    }
-    for (n = 0; n < taps; n++) {
-        ws[n] /= norm; // 1-norm
-    }
-
-    for (n = 0; n < taps; n++) ws[taps+n] = ws[n];
-
-    free(h); h = NULL;
-    free(w); w = NULL;
-
-    return taps;
-}
-
-static float complex lowpass0(float complex buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    ui32_t n;            // sample: oldest_sample
-    double complex w = 0;
-    for (n = 0; n < taps; n++) {
-        w += buffer[(sample+n)%taps]*ws[taps-1-n];
-    }
-    return (float complex)w;
-}
-static float complex lowpass1a(float complex buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    double complex w = 0;
-    ui32_t n;
-    ui32_t S = taps-1 + (sample % taps);
-    for (n = 0; n < taps; n++) {
-        w += buffer[n]*ws[S-n]; // ws[taps+s-n] = ws[(taps+sample-n)%taps]
-    }
-    return (float complex)w;
-// symmetry: ws[n] == ws[taps-1-n]
-}
-//static __attribute__((optimize("-ffast-math"))) float complex lowpass()
-static float complex lowpass(float complex buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    float complex w = 0;
-    int n; // -Ofast
-    int S = taps - (sample % taps);
-    for (n = 0; n < taps; n++) {
-        w += buffer[n]*ws[S+n]; // ws[taps+s-n] = ws[(taps+sample-n)%taps]
-    }
-    return w;
-// symmetry: ws[n] == ws[taps-1-n]
-}
-static float complex lowpass2(float complex buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    float complex w = 0;
-    int n; // -Ofast
-    int s = sample % taps;
-    int S1 = s;
-    int S1N = S1-taps;
-    int n0 = taps-s;
-    for (n = 0; n < n0; n++) {
-        w += buffer[S1+n]*ws[n];
-    }
-    for (n = n0; n < taps; n++) {
-        w += buffer[S1N+n]*ws[n];
-    }
-    return w;
-// symmetry: ws[n] == ws[taps-1-n]
-}
-static float complex lowpass0_sym(float complex buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    ui32_t n;
-    double complex w = buffer[(sample+(taps-1)/2) % taps]*ws[(taps-1)/2]; // (N+1)/2 = (N-1)/2 + 1
-    for (n = 0; n < (taps-1)/2; n++) {
-        w += (buffer[(sample+n)%taps]+buffer[(sample+taps-n-1)%taps])*ws[n];
-    }
-    return (float complex)w;
-}
-static float complex lowpass2_sym(float complex buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    float complex w = 0;
-    int n;
-    int s = sample % taps; // lpIQ
-    int SW = (taps-1)/2;
-    int B1 = s + SW;
-    int n1 = SW - s;
-    int n0 = 0;
-
-    if (s > SW) {
-        B1 -= taps;
-        n1 = -n1 - 1;
-        n0 = B1+n1+1;
-    }
-
-    w = buffer[B1]*ws[SW];
-
-    for (n = 1; n < n1+1; n++) {
-        w += (buffer[B1 + n] + buffer[B1 - n]) * ws[SW+n];
-    }
-
-    for (n = 0; n < SW-n1; n++) {
-        w += (buffer[s + n] + buffer[s-1 - n]) * ws[SW+SW-n];
-    }
-
-    return w;
-// symmetry: ws[n] == ws[taps-1-n]
-}
-
-
-static float re_lowpass0(float buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    ui32_t n;
-    double w = 0;
-    for (n = 0; n < taps; n++) {
-        w += buffer[(sample+n)%taps]*ws[taps-1-n];
-    }
-    return (float)w;
-}
-static float re_lowpass(float buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    float w = 0;
-    int n;
-    int S = taps - (sample % taps);
-    for (n = 0; n < taps; n++) {
-        w += buffer[n]*ws[S+n]; // ws[taps+s-n] = ws[(taps+sample-n)%taps]
-    }
-    return w;
-}
-
-
 int f32buf_sample(dsp_t *dsp, int inv) {
     float s = 0.0;
     float s_fm = s;
@@ -775,7 +433,7 @@ int f32buf_sample(dsp_t *dsp, int inv) {
         dsp->rot_iqbuf[dsp->sample_in % dsp->N_IQBUF] = z;  // sample_in & (N-1) , N = (1<<LOG2N)
 
 
-        if (dsp->opt_iq >= 2)
+        if (IQ_TONES(dsp))
         {
             if (dsp->opt_iq >= 2) {
                 double xbit = 0.0;
@@ -843,7 +501,7 @@ int f32buf_sample(dsp_t *dsp, int inv) {
     if (dsp->opt_lp & LP_FM) {
         dsp->lpFM_buf[dsp->sample_in % dsp->lpFMtaps] = s_fm;
         s_fm = re_lowpass(dsp->lpFM_buf, dsp->sample_in+1, dsp->lpFMtaps, dsp->ws_lpFM);
-        if (dsp->opt_iq < 2) s = s_fm;
+        if (!IQ_TONES(dsp)) s = s_fm;
     }
 
     dsp->fm_buffer[dsp->sample_in % dsp->M] = s_fm;
@@ -876,7 +534,7 @@ static int read_bufbit(dsp_t *dsp, int symlen, char *bits, ui32_t mvp, int pos)
     double sum = 0.0;
     double dc = 0.0;
 
-    if (dsp->opt_dc && dsp->opt_iq < 2) dc = dsp->dc;
+    if (dsp->opt_dc && !IQ_TONES(dsp)) dc = dsp->dc;
 
     // bei symlen=2 (Manchester) kein dc noetig: -dc+dc=0 ;
     // allerdings M10-header mit symlen=1
@@ -954,7 +612,7 @@ int read_slbit(dsp_t *dsp, int *bit, int inv, int ofs, int pos, float l, int spi
 
     double dc = 0.0;
 
-    if (dsp->opt_dc && dsp->opt_iq < 2) dc = dsp->dc;
+    if (dsp->opt_dc && !IQ_TONES(dsp)) dc = dsp->dc;
 
     if (pos == 0) {
         bg = 0;
@@ -1026,7 +684,7 @@ int read_softbit(dsp_t *dsp, hsbit_t *shb, int inv, int ofs, int pos, float l, i
     ui8_t bit = 0;
 
 
-    if (dsp->opt_dc && dsp->opt_iq < 2) dc = dsp->dc;
+    if (dsp->opt_dc && !IQ_TONES(dsp)) dc = dsp->dc;
 
     if (pos == 0) {
         bg = 0;
@@ -1102,7 +760,7 @@ int read_softbit2p(dsp_t *dsp, hsbit_t *shb, int inv, int ofs, int pos, float l,
     ui8_t bit = 0, bit1 = 0;
 
 
-    if (dsp->opt_dc && dsp->opt_iq < 2) dc = dsp->dc;
+    if (dsp->opt_dc && !IQ_TONES(dsp)) dc = dsp->dc;
 
     if (pos == 0) {
         bg = 0;
@@ -1218,6 +876,8 @@ int init_buffers(dsp_t *dsp) {
     float *m = NULL;
 
 
+    rxt_init(&dsp->rxt, dsp->sr); // input sample rate
+
     // decimate
     if (dsp->opt_iq == 5)
     {
@@ -1228,6 +888,7 @@ int init_buffers(dsp_t *dsp) {
         float t_bw; // dec_lowpass: transition_bandwidth
         int taps; // dec_lowpass: taps
 
+        if (dsp->IF_sr > 0) IF_sr = dsp->IF_sr;
         if (dsp->opt_IFmin) IF_sr = IF_SAMPLE_RATE_MIN;
         if (IF_sr > sr_base) IF_sr = sr_base;
         if (IF_sr < sr_base) {
@@ -1524,6 +1185,13 @@ int free_buffers(dsp_t *dsp) {
 
     if (dsp->fm_buffer) { free(dsp->fm_buffer); dsp->fm_buffer = NULL; }
 
+    if (dsp->shm) {
+        if (dsp->shm->overruns) {
+            fprintf(stderr, "shm overruns: %llu (%llu bytes lost)\n", dsp->shm->overruns, dsp->shm->lost);
+        }
+        iqshm_close(dsp->shm); dsp->shm = NULL;
+    }
+
     return 0;
 }
 
@@ -1607,7 +1275,10 @@ int find_header(dsp_t *dsp, float thres, int hdmax, int bitofs, int opt_dc) {
                 herrs = headcmp(dsp, opt_dc);
                 if (herrs <= hdmax) header_found = 1; // max bitfehler in header
 
-                if (header_found) return 1;
+                if (header_found) {
+                    if (dsp->opt_rxtime) dsp->rx_time = rx_time(dsp, dsp->mv_pos+1 - dsp->L);
+                    return 1;
+                }
             }
         }
 
@@ -1616,6 +1287,38 @@ int find_header(dsp_t *dsp, float thres, int hdmax, int bitofs, int opt_dc) {
     return EOF;
 }
 
+/*
+ *  wall clock (unix time) of sample pos (sample_in, after decimation); 0: unknown
+ *  the last sample_in-1 belongs to the last input sample read;
+ *  the FIR lowpass filters delay by (taps-1)/2 samples
+ */
+double rx_time(dsp_t *dsp, ui32_t pos) {
+    double t0, k, sr_in;
+    ui64_t n_in;  // input samples read (shm: ring position)
+    int decM = dsp->decM > 1 ? dsp->decM : 1;
+    int d = 0;
+
+    if (dsp->shm) {
+        t0 = iqshm_t0(dsp->shm);
+        n_in = dsp->shm->rseq / dsp->shm->frame;
+    }
+    else {
+        t0 = dsp->rx_t0 > 0 ? dsp->rx_t0 : dsp->rxt.t0;
+        n_in = dsp->in_bytes / (dsp->nch*dsp->bps/8);
+    }
+    if (t0 <= 0) return 0.0;
+
+    if (dsp->opt_iq && (dsp->opt_lp & LP_IQ)) d += (dsp->lpIQtaps-1)/2;
+    if ((dsp->opt_lp & LP_FM) && !IQ_TONES(dsp)) d += (dsp->lpFMtaps-1)/2;
+
+    k = (double)n_in-1 - (double)(ui32_t)(dsp->sample_in-1 - pos + d) * decM;
+    if (decM > 1) k -= (dsp->dectaps-1)/2;
+
+    sr_in = decM > 1 ? dsp->sr_base : dsp->sr;
+
+    return t0 + k/sr_in;
+}
+
 /* ------------------------------------------------------------------------------------ */
 
 
@@ -1623,6 +1326,7 @@ int find_header(dsp_t *dsp, float thres, int hdmax, int bitofs, int opt_dc) {
 // external FSK demod: read float32 soft symbols
 
 int read_wav_header(pcm_t *pcm, FILE *fp) {}
+int attach_shm(dsp_t *dsp, pcm_t *pcm, char *name) {}
 int f32buf_sample(dsp_t *dsp, int inv) {}
 int read_slbit(dsp_t *dsp, int *bit, int inv, int ofs, int pos, float l, int spike) {}
 int read_softbit(dsp_t *dsp, hsbit_t *shb, int inv, int ofs, int pos, float l, int spike) {}
@@ -1632,131 +1336,7 @@ int init_buffers(dsp_t *dsp) {}
 int free_buffers(dsp_t *dsp) {}
 
 int find_header(dsp_t *dsp, float thres, int hdmax, int bitofs, int opt_dc) {}
+double rx_time(dsp_t *dsp, ui32_t pos) {}
 
 #endif
 
-
-static float cmp_hdb(hdb_t *hdb) { // bit-errors?
-    int i, j;
-    int headlen = hdb->len;
-    int berrs1 = 0, berrs2 = 0;
-
-    i = 0;
-    j = hdb->bufpos;
-    while (i < headlen) {
-        if (j < 0) j = headlen-1;
-        if (hdb->buf[j] != hdb->hdr[headlen-1-i]) berrs1 += 1;
-        j--;
-        i++;
-    }
-
-    i = 0;
-    j = hdb->bufpos;
-    while (i < headlen) {
-        if (j < 0) j = headlen-1;
-        if ((hdb->buf[j]^0x01) != hdb->hdr[headlen-1-i]) berrs2 += 1;
-        j--;
-        i++;
-    }
-
-    if (berrs2 < berrs1) return (-headlen+berrs2)/(float)headlen;
-    else                 return ( headlen-berrs1)/(float)headlen;
-
-    return 0;
-}
-
-int find_binhead(FILE *fp, hdb_t *hdb, float *score) {
-    int bit;
-    int headlen = hdb->len;
-    float mv;
-
-    //*score = 0.0;
-
-    while ( (bit = fgetc(fp)) != EOF )
-    {
-        bit &= 1;
-
-        hdb->bufpos = (hdb->bufpos+1) % headlen;
-        hdb->buf[hdb->bufpos] = 0x30 | bit;  // Ascii
-
-        mv = cmp_hdb(hdb);
-        if ( fabs(mv) > hdb->thb ) {
-            *score = mv;
-            return 1;
-        }
-    }
-
-    return EOF;
-}
-
-static float corr_softhdb(hdb_t *hdb) { // max score in window probably not needed
-    int i, j;
-    int headlen = hdb->len;
-    double sum = 0.0;
-    double normx = 0.0,
-           normy = 0.0;
-    float x, y;
-
-    i = 0;
-    j = hdb->bufpos + 1;
-
-    while (i < headlen) {
-        if (j >= headlen) j = 0;
-        x = hdb->sbuf[j];
-        y = 2.0*(hdb->hdr[i]&0x1) - 1.0;
-        sum += y * hdb->sbuf[j];
-        normx += x*x;
-        normy += y*y;
-        j++;
-        i++;
-    }
-    sum /= sqrt(normx*normy);
-
-    return sum;
-}
-
-int f32soft_read(FILE *fp, float *s, int inv) {
-    unsigned int word = 0;
-    short *b = (short*)&word;
-    float *f = (float*)&word;
-    int bps = 32;
-
-    if (fread( &word, bps/8, 1, fp) != 1) return EOF;
-
-    if (bps == 32) {
-        *s = *f;
-    }
-    else {
-        if (bps ==  8) { *b -= 128; }
-        *s = *b/128.0;
-        if (bps == 16) { *s /= 256.0; }
-    }
-
-    if (inv) *s = -*s;
-
-    return 0;
-}
-
-int find_softbinhead(FILE *fp, hdb_t *hdb, float *score, int inv) {
-    int headlen = hdb->len;
-    float sbit;
-    float mv;
-
-    //*score = 0.0;
-
-    while ( f32soft_read(fp, &sbit, inv) != EOF )
-    {
-        hdb->bufpos = (hdb->bufpos+1) % headlen;
-        hdb->sbuf[hdb->bufpos] = sbit;
-
-        mv = corr_softhdb(hdb);
-
-        if ( fabs(mv) > hdb->ths ) {
-            *score = mv;
-            return 1;
-        }
-    }
-
-    return EOF;
-}
-
@@ -1,12 +1,5 @@
-
-
-#include <math.h>
-#include <complex.h>
-
-#ifndef M_PI
-    #define M_PI  (3.1415926535897932384626433832795)
-#endif
-#define _2PI  (6.2831853071795864769252867665590)
+#include "dsp_core.h"
+#include "rx_time.h"
 
 
 #define LP_IQ    1
@@ -14,35 +7,9 @@
 #define LP_IQFM  4
 
 
-#ifndef INTTYPES
-#define INTTYPES
-typedef unsigned char  ui8_t;
-typedef unsigned short ui16_t;
-typedef unsigned int   ui32_t;
-typedef unsigned long long ui64_t;
-typedef char  i8_t;
-typedef short i16_t;
-typedef int   i32_t;
-#endif
-
-
-typedef struct {
-    int sr;       // sample_rate
-    int LOG2N;
-    int N;
-    int N2;
-    float *xn;
-    float complex  *ew;
-    float complex  *Fm;
-    float complex  *X;
-    float complex  *Z;
-    float complex  *cx;
-    float complex  *win; // float real
-} dft_t;
-
-
 typedef struct {
     FILE *fp;
+    struct iqshm *shm;  // optional: IQ from shared-memory ring instead of fp
     //
     int sr;       // sample_rate
     int bps;      // bits/sample
@@ -81,6 +48,7 @@ typedef struct {
     // IQ-data
     int opt_iq;
     int opt_iqdc;
+    int opt_fm;    // IQ: FM-demod (discriminator) instead of f1/f2 tone filters (wide FSK)
     int N_IQBUF;
     float complex *rot_iqbuf;
     float complex F1sum;
@@ -120,6 +88,7 @@ typedef struct {
     // decimate
     int opt_nolut; // default: LUT
     int opt_IFmin;
+    int IF_sr;     // IF sample rate after decimation (0: IF_SAMPLE_RATE)
     int decM;
     ui32_t sr_base;
     ui32_t dectaps;
@@ -148,6 +117,13 @@ typedef struct {
     float *lpFM_buf;
     float *fm_buffer;
 
+    // time base (--rxtime): wall clock of the frame headers
+    int opt_rxtime;
+    double rx_t0;      // wall clock of input sample 0 (--rxt0); 0: shm producer / read times
+    ui64_t in_bytes;   // input bytes read (fp)
+    rxtime_t rxt;      // t0 estimate from the read times (real-time pipe)
+    double rx_time;    // start of the last header (find_header); 0: unknown
+
 } dsp_t;
 
 
@@ -159,24 +135,8 @@ typedef struct {
 } pcm_t;
 
 
-typedef struct {
-    ui8_t hb;
-    float sb;
-} hsbit_t;
-
-
-typedef struct {
-    char *hdr;
-    char *buf;
-    float *sbuf;
-    int len;
-    int bufpos;
-    float thb;
-    float ths;
-} hdb_t;
-
-
 int read_wav_header(pcm_t *, FILE *);
+int attach_shm(dsp_t *, pcm_t *, char *);
 int f32buf_sample(dsp_t *, int);
 int read_slbit(dsp_t *, int*, int, int, int, float, int);
 int read_softbit(dsp_t *, hsbit_t *, int, int, int, float, int);
@@ -186,9 +146,6 @@ int init_buffers(dsp_t *);
 int free_buffers(dsp_t *);
 
 int find_header(dsp_t *, float, int, int, int);
-
-int f32soft_read(FILE *fp, float *s, int inv);
-int find_binhead(FILE *fp, hdb_t *hdb, float *score);
-int find_softbinhead(FILE *fp, hdb_t *hdb, float *score, int inv);
+double rx_time(dsp_t *, ui32_t);
 
 
@@ -32,6 +32,7 @@
 
 
 #include "demod_mod.h"
+#include "sonde_tlm.h"
 
 
 enum dfmtyp_keys_t {
@@ -69,6 +70,7 @@ typedef struct {
     i8_t inv;
     i8_t aut;
     i8_t jsn;  // JSON output (auto_rx)
+    i8_t jsb;  // --jsnbin: JSON as binary record (sonde_tlm.h)
     i8_t dst;  // continuous pcks 0..8
     i8_t dbg;
 } option_t;
@@ -133,6 +135,7 @@ typedef struct {
     gpsdat_t gps;
     int prev_cntsec_diff;
     int prev_manpol;
+    tlm_t tlm;
 } gpx_t;
 
 
@@ -187,12 +190,7 @@ static ui8_t G[8][4] =  // Generator
                       { 1, 0, 1, 1},
                       { 1, 1, 0, 1},
                       { 1, 1, 1, 0}};
-static ui8_t H[4][8] =  // Parity-Check
-                     {{ 0, 1, 1, 1, 1, 0, 0, 0},
-                      { 1, 0, 1, 1, 0, 1, 0, 0},
-                      { 1, 1, 0, 1, 0, 0, 1, 0},
-                      { 1, 1, 1, 0, 0, 0, 0, 1}};
-static ui8_t He[8] = { 0x7, 0xB, 0xD, 0xE, 0x8, 0x4, 0x2, 0x1}; // Spalten von H:
+static ui8_t He[8] = { 0x7, 0xB, 0xD, 0xE, 0x8, 0x4, 0x2, 0x1}; // Spalten der Parity-Check-Matrix H:
                                                                 // 1-bit-error-Syndrome
 static ui8_t codewords[16][8]; // (valid) Hamming codewords
 
@@ -237,73 +235,101 @@ static void deinterleave(hsbit_t *str, int L, hsbit_t *block) {
     }
 }
 
-static int check(int opt_ecc, hsbit_t code[8]) {
-    int i, j;               // Bei Demodulierung durch Nulldurchgaenge, wenn durch Fehler ausser Takt,
-    ui32_t synval = 0;      // verschieben sich die bits. Fuer Hamming-Decode waere es besser,
-    ui8_t syndrom[4];       // sync zu Beginn mit Header und dann Takt beibehalten fuer decision.
-    int ret=0;
+/*
+ *  Hamming(8,4)
+ *  256 words:
+ *    16 codewords
+ *    16*8=128 1-error words (dist=1)
+ *    16*7=112 2-error words (dist=2), each 2-error word has 4 codewords w/ dist=2
+ *
+ *  hard decision: ham_lut[w], w = bits code[0..7] (bit j = code[j])
+ *    0: codeword, 1..8: 1-bit-error at pos-1, 0xFF: 2-bit-error
+ *  soft decision (ecc2, ecc3): maximum likelihood, correlation of the soft bits
+ *    with all 16 codewords, corr[n] = sum_i (2*codewords[n][i]-1) * code[i].sb
+ *    (cw_sgn[i][] = 16 lanes, vectorized)
+ */
+static ui8_t ham_lut[256];
+static float cw_sgn[8][16];
 
-    for (i = 0; i < 4; i++) { // S = 4
-        syndrom[i] = 0;
-        for (j = 0; j < 8; j++) { // B = 8
-            syndrom[i] ^= H[i][j] & code[j].hb;
-        }
+#define ML_MARGIN 1.5f  // ecc3: min corr[best]-corr[2nd best], relative to mean |sb|
+
+static void ham_init(void) {
+    int i, j, n;
+    ui8_t nib, msg[4], code[8];
+    ui8_t synval;
+
+    for (nib = 0; nib < 16; nib++) {
+        nib4bits(nib, msg);
+        gencode(msg, code);
+        for (i = 0; i < 8; i++) codewords[nib][i] = code[i];
     }
-    synval = bits2val(syndrom, 4);
-    if (synval) {
-        ret = -1;
-        for (j = 0; j < 8; j++) {   // 1-bit-error
-            if (synval == He[j]) {  // reicht auf databits zu pruefen, d.h.
-                ret = j+1;          // (systematischer Code) He[0..3]
-                break;
-            }
-        }
+    for (i = 0; i < 8; i++) {
+        for (n = 0; n < 16; n++) cw_sgn[i][n] = 2*codewords[n][i]-1;
     }
-    else ret = 0;
 
-    if (ret > 0) code[ret-1].hb ^= 0x1; // d=1: 1-bit-error
-    else if (ret < 0 && opt_ecc == 2) { // d=2: 2-bit-error: soft decision
-        // Hamming(8,4)
-        // 256 words:
-        //   16 codewords
-        //   16*8=128 1-error words (dist=1)
-        //   16*7=112 2-error words (dist=2)
-        //     each 2-error word has 4 codewords w/ dist=2,
-        //     choose best match/correlation
-        int n;
-        int maxn = -1;
-        int d = 0;
-        float sum = 0.0;
-        float maxsum = 0.0;
-        /*
-        sum = 0.0;                 // s<0: h=0 , s>0: h=1
-        for (i = 0; i < 8; i++) {  // h\in{0,1} -> 2h-1\in{-1,+1}
-            sum += (2*code[i].hb-1)*code[i].sb;  // i.e. sum_i |s_i|
-        } // original score
-        */
-        for (n = 0; n < 16; n++) {
-            d = 0;
-            for (i = 0; i < 8; i++) { // d(a,b) = sum_i a[i]^b[i]
-                if (code[i].hb != codewords[n][i]) d++;
-            }
-            if (d == 2) { // check dist=2 codewords - in principle, all codewords could be tested
-                // softbits correlation:
-                //      - interleaving
-                //      + no pulse-shaping -> sum
-                sum = 0.0;
-                for (i = 0; i < 8; i++) {
-                    sum += (2*codewords[n][i]-1) * code[i].sb;
-                }
-                if (sum >= maxsum) { // best match
-                    maxsum = sum;
-                    maxn = n;
+    for (n = 0; n < 256; n++) {
+        synval = 0;
+        for (j = 0; j < 8; j++) {
+            if ((n>>j) & 1) synval ^= He[j]; // Spalten von H
+        }
+        ham_lut[n] = 0xFF;
+        if (synval == 0) ham_lut[n] = 0;
+        else {
+            for (j = 0; j < 8; j++) {   // 1-bit-error
+                if (synval == He[j]) {
+                    ham_lut[n] = j+1;
+                    break;
                 }
             }
         }
-        if (maxn >= 0) {
-            for (i = 0; i < 8; i++) {
-                if (code[i].hb = codewords[maxn][i]);
-            }
+    }
+}
+
+// maximum likelihood codeword; *margin: corr[best]-corr[2nd best]
+static int ham_ml(hsbit_t code[8], float *margin) {
+    float corr[16];
+    float max1, max2;
+    int i, n, maxn = 0;
+
+    for (n = 0; n < 16; n++) corr[n] = 0.0f;
+    for (i = 0; i < 8; i++) {
+        float sb = code[i].sb;
+        for (n = 0; n < 16; n++) corr[n] += cw_sgn[i][n] * sb;
+    }
+
+    max1 = corr[0]; max2 = -1e30f;
+    for (n = 1; n < 16; n++) {
+        if (corr[n] > max1) { max2 = max1; max1 = corr[n]; maxn = n; }
+        else if (corr[n] > max2) max2 = corr[n];
+    }
+    *margin = max1 - max2;
+
+    return maxn;
+}
+
+static int check(int opt_ecc, hsbit_t code[8]) {
+    int i;                  // Bei Demodulierung durch Nulldurchgaenge, wenn durch Fehler ausser Takt,
+    ui8_t w = 0;            // verschieben sich die bits. Fuer Hamming-Decode waere es besser,
+    int ret = 0;            // sync zu Beginn mit Header und dann Takt beibehalten fuer decision.
+
+    for (i = 0; i < 8; i++) w |= (code[i].hb & 1) << i;
+    ret = ham_lut[w];
+    if (ret == 0xFF) ret = -1;
+
+    if (ret > 0) code[ret-1].hb ^= 0x1; // d=1: 1-bit-error
+    else if (ret < 0 && opt_ecc >= 2) { // d=2: 2-bit-error: soft decision
+        // ecc2: best match/correlation
+        // ecc3: only if clearly better than the 2nd best codeword, then ret=9
+        float margin = 0.0f;
+        float mean_sb = 0.0f;
+        int maxn = ham_ml(code, &margin);
+
+        for (i = 0; i < 8; i++) mean_sb += fabs(code[i].sb);
+        mean_sb /= 8.0f;
+
+        if (opt_ecc == 2 || margin > ML_MARGIN*mean_sb) {
+            for (i = 0; i < 8; i++) code[i].hb = codewords[maxn][i];
+            if (opt_ecc == 3) ret = 9;
         }
     }
 
@@ -1100,16 +1126,24 @@ static void print_gpx(gpx_t *gpx) {
             int _sats = gpx->gps.nSV;
             if (_sats == 0 /*&& sonde_type == 6*/) _sats = gpx->gps.nPRN;
             // Print JSON blob     // valid sonde_ID?
-            printf("{ \"type\": \"%s\"", "DFM");
-            printf(", \"frame\": %u, ", gpx->sec_gps); // gpx->frnr
-            printf("\"id\": \"%s\", \"datetime\": \"%04d-%02d-%02dT%02d:%02d:%06.3fZ\", \"lat\": %.5f, \"lon\": %.5f, \"alt\": %.5f, \"vel_h\": %.5f, \"heading\": %.5f, \"vel_v\": %.5f, \"sats\": %d",
-                   json_sonde_id, gpx->jahr, gpx->monat, gpx->tag, gpx->std, gpx->min, gpx->sek, gpx->lat, gpx->lon, gpx->alt, gpx->horiV, gpx->dir, gpx->vertV, _sats);
+            tlm_t *t = &gpx->tlm;
+            tlm_begin(t, "DFM");
+            tlm_int(t, TLM_FRAME, gpx->sec_gps); // gpx->frnr
+            tlm_str(t, TLM_ID, json_sonde_id);
+            tlm_datetime(t, gpx->jahr, gpx->monat, gpx->tag, gpx->std, gpx->min, gpx->sek, 3);
+            tlm_flt(t, TLM_LAT, gpx->lat, 5);
+            tlm_flt(t, TLM_LON, gpx->lon, 5);
+            tlm_flt(t, TLM_ALT, gpx->alt, 5);
+            tlm_flt(t, TLM_VEL_H, gpx->horiV, 5);
+            tlm_flt(t, TLM_HEADING, gpx->dir, 5);
+            tlm_flt(t, TLM_VEL_V, gpx->vertV, 5);
+            tlm_int(t, TLM_SATS, _sats);
             if (gpx->ptu_out >= 0xA && gpx->status[0] > 0) { // DFM>=09(P): Battery (STM32)
-                printf(", \"batt\": %.2f", gpx->status[0]);
+                tlm_flt(t, TLM_BATT, gpx->status[0], 2);
             }
             if (gpx->ptu_out) { // get temperature
                 //float t = get_Temp(gpx); // ecc-valid temperature?
-                if (gpx->T > -270.0f) printf(", \"temp\": %.1f", gpx->T);
+                if (gpx->T > -270.0f) tlm_flt(t, TLM_TEMP, gpx->T, 1);
             }
             if (gpx->posmode == 4 && contaux && gpx->xdata[0]) {
                 char xdata_str[2*XDATA_LEN+1];
@@ -1117,31 +1151,30 @@ static void print_gpx(gpx_t *gpx) {
                 for (j = 0; j < XDATA_LEN; j++) {
                     sprintf(xdata_str+2*j, "%02X", gpx->xdata[j]);
                 }
-                printf(", \"aux\": \"%s\"", xdata_str);
+                tlm_str(t, TLM_AUX, xdata_str);
             }
-            //if (dfmXtyp > 0) printf(", \"subtype\": \"0x%1X\"", dfmXtyp);
+            //if (dfmXtyp > 0) tlm_strf(t, TLM_SUBTYPE, "0x%1X", dfmXtyp);
             if (dfmXtyp > 0) {
-                printf(", \"subtype\": \"0x%1X", dfmXtyp);
-                if (*gpx->dfmtyp) printf(":%s", gpx->dfmtyp);
-                printf("\"");
+                if (*gpx->dfmtyp) tlm_strf(t, TLM_SUBTYPE, "0x%1X:%s", dfmXtyp, gpx->dfmtyp);
+                else              tlm_strf(t, TLM_SUBTYPE, "0x%1X", dfmXtyp);
             }
             if (gpx->jsn_freq > 0) {
-                printf(", \"freq\": %d", gpx->jsn_freq);
+                tlm_int(t, TLM_FREQ, gpx->jsn_freq);
             }
 
             // Reference time/position
-            printf(", \"ref_datetime\": \"%s\"", "UTC" ); // {"GPS", "UTC"} GPS-UTC=leap_sec
+            tlm_str(t, TLM_REF_DATETIME, "UTC"); // {"GPS", "UTC"} GPS-UTC=leap_sec
             if (gpx->posmode <= 2) { // mode 2
-                printf(", \"ref_position\": \"%s\"", "GPS" ); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid
-                printf(", \"diff_GPS_MSL\": %.2f", -gpx->gps.dMSL ); // MSL = GPS + gps.dMSL
+                tlm_str(t, TLM_REF_POSITION, "GPS"); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid
+                tlm_flt(t, TLM_DIFF_GPS_MSL, -gpx->gps.dMSL, 2); // MSL = GPS + gps.dMSL
             }
-            else printf(", \"ref_position\": \"%s\"", "MSL" ); // mode 3,4
+            else tlm_str(t, TLM_REF_POSITION, "MSL"); // mode 3,4
 
             #ifdef VER_JSN_STR
                 ver_jsn = VER_JSN_STR;
             #endif
-            if (ver_jsn && *ver_jsn != '\0') printf(", \"version\": \"%s\"", ver_jsn);
-            printf(" }\n");
+            if (ver_jsn && *ver_jsn != '\0') tlm_str(t, TLM_VERSION_STR, ver_jsn);
+            tlm_out(t, stdout, gpx->option.jsb);
             printf("\n");
         }
 
@@ -1275,6 +1308,7 @@ int main(int argc, char **argv) {
     int option_raw = 0;      // rohe Frames
     int option_inv = 0;      // invertiert Signal
     int option_ecc = 0;
+    int option_ecc3 = 0;
     int option_ptu = 0;
     int option_dist = 0;     // continuous pcks 0..8
     int option_auto = 0;
@@ -1287,6 +1321,7 @@ int main(int argc, char **argv) {
     int option_bin = 0;
     int option_softin = 0;
     int option_json = 0;     // JSON blob output (for auto_rx)
+    int option_jsnbin = 0;   // JSON blob as binary record
     int option_pcmraw = 0;
     int wavloaded = 0;
     int sel_wavch = 0;       // audio channel: left
@@ -1298,6 +1333,7 @@ int main(int argc, char **argv) {
 
     FILE *fp = NULL;
     char *fpname = NULL;
+    char *shm_name = NULL;
 
     int ret = 0;
     int k;
@@ -1370,6 +1406,7 @@ int main(int argc, char **argv) {
         }
         else if ( (strcmp(*argv, "--ecc" ) == 0) ) { option_ecc = 1; }
         else if ( (strcmp(*argv, "--ecc2") == 0) ) { option_ecc = 2; }
+        else if ( (strcmp(*argv, "--ecc3") == 0) ) { option_ecc = 3; option_ecc3 = 1; }
         else if ( (strcmp(*argv, "--ptu") == 0) ) {  option_ptu = 1; }  //gpx.ptu_out = 1; // force ptu (non PS-15)
         else if ( (strcmp(*argv, "--spike") == 0) ) {
             spike = 1;
@@ -1380,6 +1417,7 @@ int main(int argc, char **argv) {
         else if   (strcmp(*argv, "--softinv") == 0) { option_softin = 2; }  // float32 inverted soft input
         else if   (strcmp(*argv, "--dist") == 0) { option_dist = 1; option_ecc = 1; }
         else if   (strcmp(*argv, "--json") == 0) { option_json = 1; option_ecc = 1; }
+        else if   (strcmp(*argv, "--jsnbin") == 0) { option_jsnbin = 1; }  // json as binary records
         else if   (strcmp(*argv, "--jsn_cfq") == 0) {
             int frq = -1;  // center frequency / Hz
             ++argv;
@@ -1444,6 +1482,16 @@ int main(int argc, char **argv) {
         else if   (strcmp(*argv, "--dbg") == 0) { gpx.option.dbg = 1; }
         else if   (strcmp(*argv, "--sat") == 0) { gpx.option.sat = 1; }
         else if (strcmp(*argv, "--rawhex") == 0) { rawhex = 1; }  // raw hex input
+        else if   (strcmp(*argv, "--shm") == 0) {  // IQ from shared-memory ring (iq_shmw)
+            ++argv;
+            if (*argv) shm_name = *argv; else return -1;
+        }
+        else if   (strcmp(*argv, "--rxtime") == 0) { dsp.opt_rxtime = 1; }  // JSON: wall clock of the header
+        else if   (strcmp(*argv, "--rxt0") == 0) {  // wall clock of the first sample (unix time)
+            ++argv;
+            if (*argv) dsp.rx_t0 = atof(*argv); else return -1;
+            dsp.opt_rxtime = 1;
+        }
         else if (strcmp(*argv, "-") == 0) {
             int sample_rate = 0, bits_sample = 0, channels = 0;
             ++argv;
@@ -1472,6 +1520,14 @@ int main(int argc, char **argv) {
     }
     if (!wavloaded) fp = stdin;
 
+    if (shm_name) {
+        if (attach_shm(&dsp, &pcm, shm_name) < 0) {
+            fprintf(stderr, "error: open shm %s\n", shm_name);
+            return -1;
+        }
+        option_pcmraw = 1;
+    }
+
     if (option_iq == 5 && option_dc) option_lp |= LP_FM;
 
     // LUT faster for decM, however frequency correction after decimation
@@ -1485,18 +1541,12 @@ int main(int argc, char **argv) {
     // produce wrong codewords. hence ecc2 is not recommended
     // for reliable frame decoding.
     //
-    if ( option_dist || option_json ) option_ecc = 1;
+    // ecc3: soft decision only for 2-error words with a clear best codeword
+    //
+    if ( option_dist || option_json ) option_ecc = (option_ecc3 ? 3 : 1);
 
 
-    if (option_ecc)
-    {
-        ui8_t nib, msg[4], code[8];
-        for (nib = 0; nib < 16; nib++) {
-            nib4bits(nib, msg);
-            gencode(msg, code);
-            for (k = 0; k < 8; k++) codewords[nib][k] = code[k];
-        }
-    }
+    if (option_ecc) ham_init();
 
     // init gpx
     //strcpy(gpx.frame_bits, dfm_header); //, sizeof(dfm_header);
@@ -1514,6 +1564,7 @@ int main(int argc, char **argv) {
     gpx.option.aut = option_auto;
     gpx.option.dst = option_dist;
     gpx.option.jsn = option_json;
+    gpx.option.jsb = option_jsnbin;
 
     if (gpx.option.aux && gpx.option.vbs < 1) gpx.option.vbs = 1;
 
@@ -1630,11 +1681,13 @@ int main(int argc, char **argv) {
             }
             else if (option_softin) {
                 header_found = find_softbinhead(fp, &hdb, &_mv, option_softin == 2);
+                if (dsp.opt_rxtime) gpx.tlm.rx_time = softin_rx_time(dsp.rx_t0);
                 hdrcnt += nfrms;
             }
             else {                                    //2 (false positive)      // FM-audio:
                 header_found = find_header(&dsp, thres, 2, bitofs, dsp.opt_dc); // optional 2nd pass: dc=0
                 _mv = dsp.mv;
+                gpx.tlm.rx_time = dsp.rx_time;
             }
             if (header_found == EOF) break;
 
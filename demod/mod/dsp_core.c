@@ -0,0 +1,695 @@
+
+/*
+ *  DSP kernels shared by the decoders (libsondedsp.a):
+ *    radix-2 DFT, windowed-sinc FIR lowpass, soft-symbol input and header search.
+ *  no dsp_t state; demod_mod.c builds the sample pipeline on top,
+ *  tools with their own pipeline (iq_dec, dft_detect, imet4iq, mk2a1680mod)
+ *  use the kernels directly.
+ *
+ *  compile:
+ *      gcc -Ofast -c dsp_core.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dsp_core.h"
+#include "soft_blk.h"
+#include "rx_time.h"
+
+/* ------------------------------------------------------------------------------------ */
+
+void raw_dft(dft_t *dft, float complex *Z) {
+    int s, l, l2, i, j, k;
+    float complex  w1, w2, T;
+
+    j = 1;
+    for (i = 1; i < dft->N; i++) {
+        if (i < j) {
+            T = Z[j-1];
+            Z[j-1] = Z[i-1];
+            Z[i-1] = T;
+        }
+        k = dft->N/2;
+        while (k < j) {
+            j = j - k;
+            k = k/2;
+        }
+        j = j + k;
+    }
+
+    for (s = 0; s < dft->LOG2N; s++) {
+        l2 = 1 << s;
+        l  = l2 << 1;
+        w1 = (float complex)1.0;
+        w2 = dft->ew[s]; // cexp(-I*M_PI/(float)l2)
+        for (j = 1; j <= l2; j++) {
+            for (i = j; i <= dft->N; i += l) {
+                k = i + l2;
+                T = Z[k-1] * w1;
+                Z[k-1] = Z[i-1] - T;
+                Z[i-1] = Z[i-1] + T;
+            }
+            w1 = w1 * w2;
+        }
+    }
+}
+
+void cdft(dft_t *dft, float complex *z, float complex *Z) {
+    int i;
+    for (i = 0; i < dft->N; i++)  Z[i] = z[i];
+    raw_dft(dft, Z);
+}
+
+void rdft(dft_t *dft, float *x, float complex *Z) {
+    int i;
+    for (i = 0; i < dft->N; i++)  Z[i] = (float complex)x[i];
+    raw_dft(dft, Z);
+}
+
+void Nidft(dft_t *dft, float complex *Z, float complex *z) {
+    int i;
+    for (i = 0; i < dft->N; i++)  z[i] = conj(Z[i]);
+    raw_dft(dft, z);
+    // idft():
+    // for (i = 0; i < dft->N; i++)  z[i] = conj(z[i])/(float)dft->N; // hier: z reell
+}
+
+float bin2freq0(dft_t *dft, int k) {
+    float fq = dft->sr * k / /*(float)*/dft->N;
+    if (fq >= dft->sr/2.0) fq -= dft->sr;
+    return fq;
+}
+float bin2freq(dft_t *dft, int k) {
+    float fq = k / (float)dft->N;
+    if ( fq >= 0.5) fq -= 1.0;
+    return fq*dft->sr;
+}
+float bin2fq(dft_t *dft, int k) {
+    float fq = k / (float)dft->N;
+    if ( fq >= 0.5) fq -= 1.0;
+    return fq;
+}
+
+int max_bin(dft_t *dft, float complex *Z) {
+    int k, kmax;
+    double max;
+
+    max = 0; kmax = 0;
+    for (k = 0; k < dft->N; k++) {
+        if (cabs(Z[k]) > max) {
+            max = cabs(Z[k]);
+            kmax = k;
+        }
+    }
+
+    return kmax;
+}
+
+int dft_window(dft_t *dft, int w) {
+    int n;
+
+    if (w < 0 || w > 3) return -1;
+
+    for (n = 0; n < dft->N2; n++) {
+        switch (w)
+        {
+            case 0: // (boxcar)
+                    dft->win[n] = 1.0;
+                    break;
+            case 1: // Hann
+                    dft->win[n] = 0.5 * ( 1.0 - cos(_2PI*n/(float)(dft->N2-1)) );
+                    break ;
+            case 2: // Hamming
+                    dft->win[n] = 25/46.0 - (1.0 - 25/46.0)*cos(_2PI*n / (float)(dft->N2-1));
+                    break ;
+            case 3: // Blackmann
+                    dft->win[n] =  7938/18608.0
+                                 - 9240/18608.0*cos(_2PI*n / (float)(dft->N2-1))
+                                 + 1430/18608.0*cos(4*M_PI*n / (float)(dft->N2-1));
+                    break ;
+        }
+    }
+    while (n < dft->N) dft->win[n++] = 0.0;
+
+    return 0;
+}
+
+/*
+ * header correlation (matched filter dft->Fm) over the last K+L samples of the ring buf[M],
+ * newest sample at pos; rm_dc: remove the mean (X[0]) first.
+ * score normalized by the window norm -> *mv, sample of the correlation peak -> *mv_pos.
+ * returns the peak index in the window, -4 if the peak is at the window edge (*mv, *mv_pos not set).
+ */
+int dft_corr(dft_t *dft, float *buf, ui32_t M, ui32_t pos, int K, int L, int rm_dc, float *mv, ui32_t *mv_pos) {
+    int i;
+    int mp = -1;
+    float mx = 0.0;
+    float mx2 = 0.0;
+    float re_cx = 0.0;
+    float xnorm = 1;
+
+    for (i = 0; i < K + L; i++) dft->xn[i] = buf[(pos+M -(K + L-1) + i) % M];
+    while (i < dft->N) dft->xn[i++] = 0.0;
+
+    rdft(dft, dft->xn, dft->X);
+
+    if (rm_dc) {
+        dft->X[0] = 0;
+        Nidft(dft, dft->X, dft->cx);
+        for (i = 0; i < dft->N; i++) dft->xn[i] = creal(dft->cx[i])/(float)dft->N;
+    }
+
+    for (i = 0; i < dft->N; i++) dft->Z[i] = dft->X[i]*dft->Fm[i];
+
+    Nidft(dft, dft->Z, dft->cx);
+
+
+    // relativ Peak - Normierung erst zum Schluss;
+    // dann jedoch nicht zwingend corr-Max wenn FM-Amplitude bzw. norm(x) nicht konstant
+    // (z.B. rs41 Signal-Pausen). Moeglicherweise wird dann wahres corr-Max in dem
+    //  K-Fenster nicht erkannt, deshalb K nicht zu gross waehlen.
+    //
+    mx2 = 0.0;                      // t = L-1
+    for (i = L-1; i < K + L; i++) {  // i=t .. i=t+K < t+1+K
+        re_cx = creal(dft->cx[i]);  // imag(cx)=0
+        if (re_cx*re_cx > mx2) {
+            mx = re_cx;
+            mx2 = mx*mx;
+            mp = i;
+        }
+    }
+    if (mp == L-1 || mp == K + L-1) return -4; // Randwert
+    //  mp == t           mp == K+t
+
+    xnorm = 0.0;
+    for (i = 0; i < L; i++) xnorm += dft->xn[mp-i]*dft->xn[mp-i];
+    xnorm = sqrt(xnorm);
+
+    mx /= xnorm*dft->N;
+
+    *mv = mx;
+    *mv_pos = pos - (K + L-1) + mp; // t = L-1
+
+    return mp;
+}
+
+/* ------------------------------------------------------------------------------------ */
+
+double sinc(double x) {
+    double y;
+    if (x == 0) y = 1;
+    else y = sin(M_PI*x)/(M_PI*x);
+    return y;
+}
+
+int lowpass_init(float f, int taps, float **pws) {
+    double *h, *w;
+    double norm = 0;
+    int n;
+    float *ws = NULL;
+
+    if (taps % 2 == 0) taps++; // odd/symmetric
+
+    if ( taps < 1 ) taps = 1;
+
+    h = (double*)calloc( taps+1, sizeof(double)); if (h == NULL) return -1;
+    w = (double*)calloc( taps+1, sizeof(double)); if (w == NULL) return -1;
+    ws = (float*)calloc( 2*taps+1, sizeof(float)); if (ws == NULL) return -1;
+
+    for (n = 0; n < taps; n++) {
+        w[n] = 7938/18608.0 - 9240/18608.0*cos(_2PI*n/(taps-1)) + 1430/18608.0*cos(4*M_PI*n/(taps-1)); // Blackmann
+        h[n] = 2*f*sinc(2*f*(n-(taps-1)/2));
+        ws[n] = w[n]*h[n];
+        norm += ws[n]; // 1-norm
+    }
+    for (n = 0; n < taps; n++) {
+        ws[n] /= norm; // 1-norm
+    }
+
+    for (n = 0; n < taps; n++) ws[taps+n] = ws[n]; // duplicate/unwrap
+
+    *pws = ws;
+
+    free(h); h = NULL;
+    free(w); w = NULL;
+
+    return taps;
+}
+
+
+int lowpass_update(float f, int taps, float *ws) {
+    double *h, *w;
+    double norm = 0;
+    int n;
+
+    if (taps % 2 == 0) taps++; // odd/symmetric
+
+    if ( taps < 1 ) taps = 1;
+
+    h = (double*)calloc( taps+1, sizeof(double)); if (h == NULL) return -1;
+    w = (double*)calloc( taps+1, sizeof(double)); if (w == NULL) return -1;
+
+    for (n = 0; n < taps; n++) {
+        w[n] = 7938/18608.0 - 9240/18608.0*cos(_2PI*n/(taps-1)) + 1430/18608.0*cos(4*M_PI*n/(taps-1)); // Blackmann
+        h[n] = 2*f*sinc(2*f*(n-(taps-1)/2));
+        ws[n] = w[n]*h[n];
+        norm += ws[n]; // 1-norm
+    }
+    for (n = 0; n < taps; n++) {
+        ws[n] /= norm; // 1-norm
+    }
+
+    for (n = 0; n < taps; n++) ws[taps+n] = ws[n];
+
+    free(h); h = NULL;
+    free(w); w = NULL;
+
+    return taps;
+}
+
+float complex lowpass0(float complex buffer[], ui32_t sample, ui32_t taps, float *ws) {
+    ui32_t n;            // sample: oldest_sample
+    double complex w = 0;
+    for (n = 0; n < taps; n++) {
+        w += buffer[(sample+n)%taps]*ws[taps-1-n];
+    }
+    return (float complex)w;
+}
+//static __attribute__((optimize("-ffast-math"))) float complex lowpass()
+float complex lowpass(float complex buffer[], ui32_t sample, ui32_t taps, float *ws) {
+    float complex w = 0;
+    int n; // -Ofast
+    int S = taps - (sample % taps);
+    for (n = 0; n < taps; n++) {
+        w += buffer[n]*ws[S+n]; // ws[taps+s-n] = ws[(taps+sample-n)%taps]
+    }
+    return w;
+// symmetry: ws[n] == ws[taps-1-n]
+}
+float complex lowpass2(float complex buffer[], ui32_t sample, ui32_t taps, float *ws) {
+    float complex w = 0;
+    int n; // -Ofast
+    int s = sample % taps;
+    int S1 = s;
+    int S1N = S1-taps;
+    int n0 = taps-s;
+    for (n = 0; n < n0; n++) {
+        w += buffer[S1+n]*ws[n];
+    }
+    for (n = n0; n < taps; n++) {
+        w += buffer[S1N+n]*ws[n];
+    }
+    return w;
+// symmetry: ws[n] == ws[taps-1-n]
+}
+
+
+float re_lowpass0(float buffer[], ui32_t sample, ui32_t taps, float *ws) {
+    ui32_t n;
+    double w = 0;
+    for (n = 0; n < taps; n++) {
+        w += buffer[(sample+n)%taps]*ws[taps-1-n];
+    }
+    return (float)w;
+}
+float re_lowpass(float buffer[], ui32_t sample, ui32_t taps, float *ws) {
+    float w = 0;
+    int n;
+    int S = taps - (sample % taps);
+    for (n = 0; n < taps; n++) {
+        w += buffer[n]*ws[S+n]; // ws[taps+s-n] = ws[(taps+sample-n)%taps]
+    }
+    return w;
+}
+
+/* ------------------------------------------------------------------------------------ */
+
+static float cmp_hdb(hdb_t *hdb) { // bit-errors?
+    int i, j;
+    int headlen = hdb->len;
+    int berrs1 = 0, berrs2 = 0;
+
+    i = 0;
+    j = hdb->bufpos;
+    while (i < headlen) {
+        if (j < 0) j = headlen-1;
+        if (hdb->buf[j] != hdb->hdr[headlen-1-i]) berrs1 += 1;
+        j--;
+        i++;
+    }
+
+    i = 0;
+    j = hdb->bufpos;
+    while (i < headlen) {
+        if (j < 0) j = headlen-1;
+        if ((hdb->buf[j]^0x01) != hdb->hdr[headlen-1-i]) berrs2 += 1;
+        j--;
+        i++;
+    }
+
+    if (berrs2 < berrs1) return (-headlen+berrs2)/(float)headlen;
+    else                 return ( headlen-berrs1)/(float)headlen;
+
+    return 0;
+}
+
+/*
+ * bit-parallel header search, headlen <= 64:
+ * the last headlen (hard) bits are kept in a 64-bit shift register, newest bit
+ * in bit 0, header bit hdr[headlen-1-k] in bit k. the register is rebuilt from
+ * hdb->buf/sbuf on entry, since decoders may reset the buffers between calls.
+ */
+#define HDB_WMAX 64
+
+static ui64_t hdb_mask(int headlen) {
+    return headlen < 64 ? ((ui64_t)1 << headlen) - 1 : ~(ui64_t)0;
+}
+
+static ui64_t hdb_hdrbits(hdb_t *hdb) {
+    ui64_t h = 0;
+    int i;
+    for (i = 0; i < hdb->len; i++) h = (h << 1) | (hdb->hdr[i] & 0x1);
+    return h;
+}
+
+static float cmp_hdbw(int headlen, ui64_t w, ui64_t v, ui64_t h) {
+    int nv = headlen - __builtin_popcountll(v);  // not yet filled: error in both polarities
+    int berrs1 = __builtin_popcountll((w ^ h) & v) + nv;
+    int berrs2 = __builtin_popcountll(~(w ^ h) & v) + nv;
+
+    if (berrs2 < berrs1) return (-headlen+berrs2)/(float)headlen;
+    else                 return ( headlen-berrs1)/(float)headlen;
+}
+
+int find_binhead(FILE *fp, hdb_t *hdb, float *score) {
+    int bit;
+    int headlen = hdb->len;
+    float mv;
+    ui64_t m, h, w = 0, v = 0;
+    int i, j;
+
+    //*score = 0.0;
+
+    if (headlen > HDB_WMAX) {
+        while ( (bit = fgetc(fp)) != EOF )
+        {
+            bit &= 1;
+
+            hdb->bufpos = (hdb->bufpos+1) % headlen;
+            hdb->buf[hdb->bufpos] = 0x30 | bit;  // Ascii
+
+            mv = cmp_hdb(hdb);
+            if ( fabs(mv) > hdb->thb ) {
+                *score = mv;
+                return 1;
+            }
+        }
+        return EOF;
+    }
+
+    m = hdb_mask(headlen);
+    h = hdb_hdrbits(hdb);
+    j = hdb->bufpos;
+    for (i = 0; i < headlen; i++) {  // oldest .. newest
+        j = (j+1) % headlen;
+        w = (w << 1) | (hdb->buf[j] & 0x1);
+        v = (v << 1) | ((hdb->buf[j] & 0xFE) == 0x30);
+    }
+
+    while ( (bit = fgetc(fp)) != EOF )
+    {
+        bit &= 1;
+
+        hdb->bufpos = (hdb->bufpos+1) % headlen;
+        hdb->buf[hdb->bufpos] = 0x30 | bit;  // Ascii
+
+        w = ((w << 1) | bit) & m;
+        v = ((v << 1) | 1) & m;
+
+        mv = cmp_hdbw(headlen, w, v, h);
+        if ( fabs(mv) > hdb->thb ) {
+            *score = mv;
+            return 1;
+        }
+    }
+
+    return EOF;
+}
+
+static float corr_softhdb(hdb_t *hdb) { // max score in window probably not needed
+    int i, j;
+    int headlen = hdb->len;
+    double sum = 0.0;
+    double normx = 0.0,
+           normy = 0.0;
+    float x, y;
+
+    i = 0;
+    j = hdb->bufpos + 1;
+
+    while (i < headlen) {
+        if (j >= headlen) j = 0;
+        x = hdb->sbuf[j];
+        y = 2.0*(hdb->hdr[i]&0x1) - 1.0;
+        sum += y * hdb->sbuf[j];
+        normx += x*x;
+        normy += y*y;
+        j++;
+        i++;
+    }
+    sum /= sqrt(normx*normy);
+
+    return sum;
+}
+
+/* ------------------------------------------------------------------------------------ */
+// soft input: raw float32 symbols, or framed blocks (soft_blk.h)
+
+static struct {
+    FILE *fp;
+    int framed;
+    softblk_hdr_t hdr;
+    float *buf;
+    ui32_t cap;
+    ui32_t len;
+    ui32_t pos;
+    // time base of the blocks: input sample t0 of the demodulator was received at rxt.t0 + t0/sr
+    rxtime_t rxt;
+    double hdr_k;      // input sample of the start of the last header (find_softbinhead); <0: unknown
+} softin = { NULL };
+
+static int softblk_read(FILE *fp, ui32_t word) {
+    softblk_hdr_t *hdr = &softin.hdr;
+
+    // resync (e.g. after a partial block)
+    hdr->magic = word;
+    while (hdr->magic != SOFTBLK_MAGIC) {
+        int c = fgetc(fp);
+        if (c == EOF) return EOF;
+        hdr->magic = (hdr->magic >> 8) | ((ui32_t)c << 24);
+    }
+    if (fread((ui8_t*)hdr + 4, sizeof(softblk_hdr_t) - 4, 1, fp) != 1) return EOF;
+    if (hdr->version != SOFTBLK_VERSION || hdr->len > SOFTBLK_MAXLEN) return EOF;
+
+    if (hdr->len > softin.cap) {
+        float *buf = realloc(softin.buf, hdr->len * sizeof(float));
+        if (buf == NULL) return EOF;
+        softin.buf = buf;
+        softin.cap = hdr->len;
+    }
+    if (fread(softin.buf, sizeof(float), hdr->len, fp) != hdr->len) return EOF;
+
+    softin.len = hdr->len;
+    softin.pos = 0;
+
+    // the demodulator has read its input up to the end of this block: anchor (cf. dsp_fread())
+    if (hdr->sr > 0 && hdr->sym_rate > 0) {
+        if (softin.rxt.sr != hdr->sr) rxt_init(&softin.rxt, hdr->sr);
+        rxt_update(&softin.rxt, hdr->t0 + (ui64_t)((double)hdr->len * hdr->sr / hdr->sym_rate), rxt_now());
+    }
+
+    return 0;
+}
+
+// refill softin.buf: one block, or one raw symbol
+static int softin_fill(FILE *fp) {
+    ui32_t word = 0;
+
+    if (softin.fp != fp) {  // start of stream: raw or framed?
+        softin.fp = fp;
+        softin.len = softin.pos = 0;
+        softin.framed = -1;
+        softin.hdr_k = -1.0;
+        rxt_init(&softin.rxt, 0);
+        if (softin.cap == 0) {
+            softin.buf = malloc(sizeof(float));
+            if (softin.buf == NULL) return EOF;
+            softin.cap = 1;
+        }
+    }
+
+    do {
+        if (fread(&word, 4, 1, fp) != 1) return EOF;
+
+        if (softin.framed < 0) softin.framed = (word == SOFTBLK_MAGIC);
+
+        if (softin.framed) {
+            if (softblk_read(fp, word) == EOF) return EOF;
+        }
+        else {
+            memcpy(softin.buf, &word, 4);
+            softin.len = 1;
+            softin.pos = 0;
+        }
+    } while (softin.len == 0);
+
+    return 0;
+}
+
+// header found: its first symbol is headlen symbols back (possibly in the previous block, same rate)
+static void softin_mark_header(int headlen) {
+    softblk_hdr_t *hdr = &softin.hdr;
+
+    if (softin.framed > 0 && hdr->sr > 0 && hdr->sym_rate > 0) {
+        softin.hdr_k = (double)hdr->t0 + ((double)softin.pos - headlen) * hdr->sr / hdr->sym_rate;
+    }
+    else softin.hdr_k = -1.0;
+}
+
+/*
+ *  wall clock (unix time) of the start of the last header found by find_softbinhead(); 0: unknown
+ *  (raw float32 input has no sample time base)
+ *  rx_t0 > 0: wall clock of the first demodulator input sample (--rxt0), else estimated from the block reads
+ */
+double softin_rx_time(double rx_t0) {
+    double t0 = rx_t0 > 0 ? rx_t0 : softin.rxt.t0;
+
+    if (softin.hdr_k < 0 || t0 <= 0 || softin.hdr.sr == 0) return 0.0;
+
+    return t0 + softin.hdr_k / softin.hdr.sr;
+}
+
+int f32soft_read(FILE *fp, float *s, int inv) {
+
+    if (softin.fp != fp || softin.pos >= softin.len) {
+        if (softin_fill(fp) == EOF) return EOF;
+    }
+
+    *s = softin.buf[softin.pos++];
+
+    if (inv) *s = -*s;
+
+    return 0;
+}
+
+/*
+ * soft header search, headlen <= 64:
+ * corr = sum(y*x)/(sqrt(N)|x|), y=+-1. with n_a hard bits agreeing with the header,
+ * sum(y*x) = 2*A - L1 <= 2*sqrt(n_a)*|x| - L1, A = sum_agree |x|, L1 = sum |x|, i.e.
+ *     corr <= 2*sqrt(n_a/N) - L1/(sqrt(N)|x|) ,  -corr likewise with n_d = N-n_a.
+ * n_a comes from the packed sign bits (popcount), |x|^2 and L1 are sliding sums;
+ * the exact correlation is only computed where the bound can reach ths.
+ */
+int find_softbinhead(FILE *fp, hdb_t *hdb, float *score, int inv) {
+    int headlen = hdb->len;
+    float sbit, x0;
+    float mv;
+    ui64_t m, h, w = 0;
+    double sx2 = 0.0, sx1 = 0.0;
+    double sqn[HDB_WMAX+1];
+    double rn, b, ths;
+    int i, j, na, nupd = 0;
+
+    //*score = 0.0;
+
+    if (headlen > HDB_WMAX) {
+        for (;;)
+        {
+            if (softin.fp != fp || softin.pos >= softin.len) {
+                if (softin_fill(fp) == EOF) break;
+            }
+            while (softin.pos < softin.len)
+            {
+                sbit = softin.buf[softin.pos++];
+                if (inv) sbit = -sbit;
+
+                hdb->bufpos = (hdb->bufpos+1) % headlen;
+                hdb->sbuf[hdb->bufpos] = sbit;
+
+                mv = corr_softhdb(hdb);
+
+                if ( fabs(mv) > hdb->ths ) {
+                    *score = mv;
+                    softin_mark_header(headlen);
+                    return 1;
+                }
+            }
+        }
+        return EOF;
+    }
+
+    m = hdb_mask(headlen);
+    h = hdb_hdrbits(hdb);
+    rn = 1.0/sqrt(headlen);
+    for (i = 0; i <= headlen; i++) sqn[i] = 2.0*sqrt(i/(double)headlen);
+    ths = hdb->ths - 1e-3;  // margin for the sliding sums
+
+    j = hdb->bufpos;
+    for (i = 0; i < headlen; i++) {  // oldest .. newest
+        j = (j+1) % headlen;
+        x0 = hdb->sbuf[j];
+        w = (w << 1) | (x0 > 0);
+        sx2 += x0*x0;
+        sx1 += fabs(x0);
+    }
+
+    for (;;)
+    {
+        if (softin.fp != fp || softin.pos >= softin.len) {
+            if (softin_fill(fp) == EOF) break;
+        }
+
+        // whole block
+        while (softin.pos < softin.len)
+        {
+            sbit = softin.buf[softin.pos++];
+            if (inv) sbit = -sbit;
+
+            hdb->bufpos = (hdb->bufpos+1) % headlen;
+            x0 = hdb->sbuf[hdb->bufpos];
+            hdb->sbuf[hdb->bufpos] = sbit;
+
+            w = ((w << 1) | (sbit > 0)) & m;
+            if (++nupd < headlen) {
+                sx2 += (double)sbit*sbit - (double)x0*x0;
+                sx1 += fabs(sbit) - fabs(x0);
+            }
+            else {  // no drift of the sliding sums
+                sx2 = sx1 = 0.0;
+                for (i = 0; i < headlen; i++) {
+                    sx2 += hdb->sbuf[i]*hdb->sbuf[i];
+                    sx1 += fabs(hdb->sbuf[i]);
+                }
+                nupd = 0;
+            }
+            if ( !(sx2 > 0.0) ) continue;
+
+            na = headlen - __builtin_popcountll(w ^ h);
+            b = sx1 * rn / sqrt(sx2);
+            if (sqn[na] - b < ths && sqn[headlen-na] - b < ths) continue;
+
+            mv = corr_softhdb(hdb);
+
+            if ( fabs(mv) > hdb->ths ) {
+                *score = mv;
+                softin_mark_header(headlen);
+                return 1;
+            }
+        }
+    }
+
+    return EOF;
+}
+
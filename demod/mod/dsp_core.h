@@ -0,0 +1,95 @@
+
+/*
+ *  dsp_core.c: DFT, FIR lowpass, soft-symbol input
+ *  (no dsp_t; included by demod_mod.h)
+ */
+
+#ifndef DSP_CORE_H
+#define DSP_CORE_H
+
+#include <stdio.h>
+#include <math.h>
+#include <complex.h>
+
+#ifndef M_PI
+    #define M_PI  (3.1415926535897932384626433832795)
+#endif
+#ifndef _2PI
+    #define _2PI  (6.2831853071795864769252867665590)
+#endif
+
+
+#ifndef INTTYPES
+#define INTTYPES
+typedef unsigned char  ui8_t;
+typedef unsigned short ui16_t;
+typedef unsigned int   ui32_t;
+typedef unsigned long long ui64_t;
+typedef char  i8_t;
+typedef short i16_t;
+typedef int   i32_t;
+#endif
+
+
+typedef struct {
+    int sr;       // sample_rate
+    int LOG2N;
+    int N;
+    int N2;
+    float *xn;
+    float complex  *ew;
+    float complex  *Fm;
+    float complex  *X;
+    float complex  *Z;
+    float complex  *cx;
+    float complex  *win; // float real
+} dft_t;
+
+
+typedef struct {
+    ui8_t hb;
+    float sb;
+} hsbit_t;
+
+
+typedef struct {
+    char *hdr;
+    char *buf;
+    float *sbuf;
+    int len;
+    int bufpos;
+    float thb;
+    float ths;
+} hdb_t;
+
+
+// DFT, N = 2^LOG2N; ew[s] = exp(-I*PI/2^s)
+void raw_dft(dft_t *, float complex *);
+void cdft(dft_t *, float complex *, float complex *);
+void rdft(dft_t *, float *, float complex *);
+void Nidft(dft_t *, float complex *, float complex *);
+float bin2freq0(dft_t *, int);
+float bin2freq(dft_t *, int);
+float bin2fq(dft_t *, int);
+int max_bin(dft_t *, float complex *);
+int dft_window(dft_t *, int);
+int dft_corr(dft_t *dft, float *buf, ui32_t M, ui32_t pos, int K, int L, int rm_dc, float *mv, ui32_t *mv_pos);
+
+// FIR lowpass (Blackman-windowed sinc), ws[0..2*taps-1]: taps duplicated;
+// buffer[sample % taps] = newest sample, then lowpass(buffer, sample+1, taps, ws)
+double sinc(double);
+int lowpass_init(float f, int taps, float **pws);
+int lowpass_update(float f, int taps, float *ws);
+float complex lowpass0(float complex buffer[], ui32_t sample, ui32_t taps, float *ws);
+float complex lowpass(float complex buffer[], ui32_t sample, ui32_t taps, float *ws);
+float complex lowpass2(float complex buffer[], ui32_t sample, ui32_t taps, float *ws);
+float re_lowpass0(float buffer[], ui32_t sample, ui32_t taps, float *ws);
+float re_lowpass(float buffer[], ui32_t sample, ui32_t taps, float *ws);
+
+// soft input: float32 symbols (or soft_blk.h blocks)
+int f32soft_read(FILE *fp, float *s, int inv);
+int find_binhead(FILE *fp, hdb_t *hdb, float *score);
+int find_softbinhead(FILE *fp, hdb_t *hdb, float *score, int inv);
+double softin_rx_time(double rx_t0);
+
+#endif
@@ -0,0 +1,108 @@
+
+/*
+ *  frame queue
+ *    single producer (demodulator), single consumer (ECC, parsing, output)
+ *
+ *  fixed-size slots, 2^log2n slots; wr/rd are slot sequence numbers.
+ *  the producer fills the slot frmq_wslot() returns and publishes it with
+ *  frmq_push() (release store of wr); the consumer reads frmq_rslot() and
+ *  hands the slot back with frmq_pop() (release store of rd).
+ *  no locks: an empty queue is polled by the consumer (1ms);
+ *  the producer only waits if all slots are taken (counted in q->full).
+ *
+ */
+
+#ifndef FRM_QUEUE_H
+#define FRM_QUEUE_H
+
+#include <stdlib.h>
+#include <time.h>
+
+#ifndef INTTYPES
+#define INTTYPES
+typedef unsigned char  ui8_t;
+typedef unsigned short ui16_t;
+typedef unsigned int   ui32_t;
+typedef unsigned long long ui64_t;
+typedef char  i8_t;
+typedef short i16_t;
+typedef int   i32_t;
+#endif
+
+
+#define FRMQ_LOG2N_DEF  6        // 64 frames
+#define FRMQ_WAIT_NS    1000000  // 1ms poll
+
+#define FRMQ_LOAD_ACQ(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define FRMQ_STORE_REL(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+
+typedef struct {
+    ui8_t  *buf;
+    ui32_t  n;       // number of slots
+    ui32_t  size;    // slot size (64 byte aligned)
+    ui32_t  wr;      // slots written (producer)
+    ui32_t  rd;      // slots read (consumer)
+    ui32_t  eof;     // producer closed
+    ui32_t  full;    // producer waits
+} frmq_t;
+
+
+static void frmq_sleep(void) {
+    struct timespec ts;
+    ts.tv_sec = 0;
+    ts.tv_nsec = FRMQ_WAIT_NS;
+    nanosleep(&ts, NULL);
+}
+
+static int frmq_init(frmq_t *q, int log2n, int size) {
+    q->n = 1u << log2n;
+    q->size = (size + 63) & ~63;
+    q->wr = 0;
+    q->rd = 0;
+    q->eof = 0;
+    q->full = 0;
+    q->buf = calloc(q->n, q->size);
+    if (q->buf == NULL) return -1;
+    return 0;
+}
+
+static void frmq_free(frmq_t *q) {
+    if (q->buf) { free(q->buf); q->buf = NULL; }
+}
+
+// producer
+static void *frmq_wslot(frmq_t *q) {
+    if (q->wr - FRMQ_LOAD_ACQ(&q->rd) >= q->n) {
+        q->full += 1;
+        while (q->wr - FRMQ_LOAD_ACQ(&q->rd) >= q->n) frmq_sleep();
+    }
+    return q->buf + (size_t)(q->wr & (q->n-1)) * q->size;
+}
+
+static void frmq_push(frmq_t *q) {
+    FRMQ_STORE_REL(&q->wr, q->wr+1);
+}
+
+static void frmq_close(frmq_t *q) {
+    FRMQ_STORE_REL(&q->eof, 1);
+}
+
+// consumer; NULL: closed and empty
+static void *frmq_rslot(frmq_t *q) {
+    for (;;) {
+        ui32_t eof = FRMQ_LOAD_ACQ(&q->eof);
+        if (FRMQ_LOAD_ACQ(&q->wr) != q->rd) {
+            return q->buf + (size_t)(q->rd & (q->n-1)) * q->size;
+        }
+        if (eof) return NULL;
+        frmq_sleep();
+    }
+}
+
+static void frmq_pop(frmq_t *q) {
+    FRMQ_STORE_REL(&q->rd, q->rd+1);
+}
+
+#endif
+
@@ -38,6 +38,7 @@
 //typedef int   i32_t;
 
 #include "demod_mod.h"
+#include "sonde_tlm.h"
 
 
 typedef struct {
@@ -50,6 +51,7 @@ typedef struct {
     i8_t inv;
     i8_t aut;
     i8_t jsn;  // JSON output (auto_rx)
+    i8_t jsb;  // --jsnbin: JSON as binary record (sonde_tlm.h)
     i8_t slt;  // silent
 } option_t;
 
@@ -77,6 +79,7 @@ typedef struct {
     ui8_t frame_bits[BITFRAME_LEN+8];
     int jsn_freq;   // freq/kHz (SDR)
     option_t option;
+    tlm_t tlm;
 } gpx_t;
 
 
@@ -583,32 +586,36 @@ static int print_position(gpx_t *gpx, int len, int ecc_frm, int ecc_tlm, int ecc
         char *ver_jsn = NULL;
         char *subtype = (rs_type == 54) ? "iMet-54" : "iMet-50";
         unsigned long count_day = (unsigned long)(gpx->std*3600 + gpx->min*60 + gpx->sek+0.5);  // (gpx->timems/1e3+0.5) has gaps
-        fprintf(stdout, "{ \"type\": \"%s\"", "IMET5");
-        fprintf(stdout, ", \"frame\": %lu", count_day);
-        fprintf(stdout, ", \"id\": \"IMET5-%u\", \"datetime\": \"%02d:%02d:%06.3fZ\", \"lat\": %.5f, \"lon\": %.5f, \"alt\": %.5f",
-                gpx->SNu32, gpx->std, gpx->min, gpx->sek, gpx->lat, gpx->lon, gpx->alt);
+        tlm_t *t = &gpx->tlm;
+        tlm_begin(t, "IMET5");
+        tlm_int(t, TLM_FRAME, count_day);
+        tlm_strf(t, TLM_ID, "IMET5-%u", gpx->SNu32);
+        tlm_datetime(t, 0, 0, 0, gpx->std, gpx->min, gpx->sek, 3);
+        tlm_flt(t, TLM_LAT, gpx->lat, 5);
+        tlm_flt(t, TLM_LON, gpx->lon, 5);
+        tlm_flt(t, TLM_ALT, gpx->alt, 5);
         if (gpx->option.ptu) {
             if (gpx->T > -273.0f) {
-                fprintf(stdout, ", \"temp\": %.1f",  gpx->T );
+                tlm_flt(t, TLM_TEMP, gpx->T, 1);
             }
             if (gpx->RH > -0.5f) {
-                fprintf(stdout, ", \"humidity\": %.1f",  gpx->RH );
+                tlm_flt(t, TLM_HUMIDITY, gpx->RH, 1);
             }
         }
-        fprintf(stdout, ", \"subtype\": \"%s\"", subtype);  // "IMET54"/"IMET50"
+        tlm_str(t, TLM_SUBTYPE, subtype);  // "IMET54"/"IMET50"
         if (gpx->jsn_freq > 0) {
-            fprintf(stdout, ", \"freq\": %d", gpx->jsn_freq );
+            tlm_int(t, TLM_FREQ, gpx->jsn_freq);
         }
 
         // Reference time/position
-        fprintf(stdout, ", \"ref_datetime\": \"%s\"", "UTC" ); // {"GPS", "UTC"} GPS-UTC=leap_sec
-        fprintf(stdout, ", \"ref_position\": \"%s\"", "MSL" ); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid
+        tlm_str(t, TLM_REF_DATETIME, "UTC"); // {"GPS", "UTC"} GPS-UTC=leap_sec
+        tlm_str(t, TLM_REF_POSITION, "MSL"); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid
 
         #ifdef VER_JSN_STR
             ver_jsn = VER_JSN_STR;
         #endif
-        if (ver_jsn && *ver_jsn != '\0') fprintf(stdout, ", \"version\": \"%s\"", ver_jsn);
-        fprintf(stdout, " }\n");
+        if (ver_jsn && *ver_jsn != '\0') tlm_str(t, TLM_VERSION_STR, ver_jsn);
+        tlm_out(t, stdout, gpx->option.jsb);
         fprintf(stdout, "\n");
     }
 
@@ -728,6 +735,7 @@ int main(int argc, char *argv[]) {
 
     FILE *fp;
     char *fpname = NULL;
+    char *shm_name = NULL;
 
     int k;
 
@@ -853,6 +861,7 @@ int main(int argc, char *argv[]) {
             gpx.option.jsn = 1;
             gpx.option.ecc = 1;
         }
+        else if   (strcmp(*argv, "--jsnbin") == 0) { gpx.option.jsb = 1; }  // json as binary records
         else if   (strcmp(*argv, "--jsn_cfq") == 0) {
             int frq = -1;  // center frequency / Hz
             ++argv;
@@ -861,6 +870,16 @@ int main(int argc, char *argv[]) {
             cfreq = frq;
         }
         else if   (strcmp(*argv, "--rawhex") == 0) { rawhex = 2; }  // raw hex input
+        else if   (strcmp(*argv, "--shm") == 0) {  // IQ from shared-memory ring (iq_shmw)
+            ++argv;
+            if (*argv) shm_name = *argv; else return -1;
+        }
+        else if   (strcmp(*argv, "--rxtime") == 0) { dsp.opt_rxtime = 1; }  // JSON: wall clock of the header
+        else if   (strcmp(*argv, "--rxt0") == 0) {  // wall clock of the first sample (unix time)
+            ++argv;
+            if (*argv) dsp.rx_t0 = atof(*argv); else return -1;
+            dsp.opt_rxtime = 1;
+        }
         else if (strcmp(*argv, "-") == 0) {
             int sample_rate = 0, bits_sample = 0, channels = 0;
             ++argv;
@@ -889,6 +908,14 @@ int main(int argc, char *argv[]) {
     }
     if (!wavloaded) fp = stdin;
 
+    if (shm_name) {
+        if (attach_shm(&dsp, &pcm, shm_name) < 0) {
+            fprintf(stderr, "error: open shm %s\n", shm_name);
+            return -1;
+        }
+        option_pcmraw = 1;
+    }
+
     if (option_iq == 5 && option_dc) option_lp |= LP_FM;
 
     // LUT faster for decM, however frequency correction after decimation
@@ -1008,10 +1035,12 @@ int main(int argc, char *argv[]) {
         {
             if (option_softin) {
                 header_found = find_softbinhead(fp, &hdb, &_mv, option_softin == 2);
+                if (dsp.opt_rxtime) gpx.tlm.rx_time = softin_rx_time(dsp.rx_t0);
             }
             else {                                                              // FM-audio:
                 header_found = find_header(&dsp, thres, 4, bitofs, dsp.opt_dc); // optional 2nd pass: dc=0
                 _mv = dsp.mv;
+                gpx.tlm.rx_time = dsp.rx_time;
             }
             if (header_found == EOF) break;
 
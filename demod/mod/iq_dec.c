@@ -2,7 +2,7 @@
 /*
  *  compile:
  *
- *      gcc -Ofast iq_dec.c -lm -o iq_dec
+ *      gcc -Ofast iq_dec.c dsp_core.o -lm -o iq_dec
  *
  *
  *  usage:
@@ -17,6 +17,12 @@
  *               --FM/decFM : FM demodulation
  *               --bo <b>   : output bits per sample b=8,16,32  (u8, s16, f32 (default))
  *
+ *      ./iq_dec [--bo <b>] [--IFbw <kHz>] --chan <fq1> <out1> [--chan <fq2> <out2> ...] - <sr> <bs> [iq_baseband.raw]
+ *               --chan <fq> <out> : filterbank, channel centered at fq=freq/sr, IF IQ written to <out>
+ *                                   (file or named pipe); all channels are decimated from one pass over the input.
+ *                                   A channel whose reader has gone (closed pipe) is dropped, the program ends
+ *                                   when no channel is left.
+ *
  *
  *  author: zilog80
  */
@@ -27,6 +33,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <signal.h>
 
 
 #define FM_GAIN (0.8)
@@ -34,31 +42,13 @@
 /* ------------------------------------------------------------------------------------ */
 
 
-#include <math.h>
-#include <complex.h>
-
-#ifndef M_PI
-    #define M_PI  (3.1415926535897932384626433832795)
-#endif
-#define _2PI  (6.2831853071795864769252867665590)
+#include "dsp_core.h"  // FIR lowpass (libsondedsp.a)
 
 #define LP_IQ    1
 #define LP_FM    2
 #define LP_IQFM  4
 
 
-#ifndef INTTYPES
-#define INTTYPES
-typedef unsigned char  ui8_t;
-typedef unsigned short ui16_t;
-typedef unsigned int   ui32_t;
-typedef unsigned long long ui64_t;
-typedef char  i8_t;
-typedef short i16_t;
-typedef int   i32_t;
-#endif
-
-
 typedef struct {
     FILE *fp;
     //
@@ -68,6 +58,7 @@ typedef struct {
     int ch;       // select channel
     //
     int bps_out;
+    int fd_out;
     //
     ui32_t sample_in;
     ui32_t sample_out;
@@ -384,151 +375,23 @@ static int f32read_cblock(dsp_t *dsp) {
 // decimate lowpass
 static float *ws_dec;
 
-static double sinc(double x) {
-    double y;
-    if (x == 0) y = 1;
-    else y = sin(M_PI*x)/(M_PI*x);
-    return y;
-}
-
-static int lowpass_init(float f, int taps, float **pws) {
-    double *h, *w;
-    double norm = 0;
-    int n;
-    float *ws = NULL;
-
-    if (taps % 2 == 0) taps++; // odd/symmetric
-
-    if ( taps < 1 ) taps = 1;
-
-    h = (double*)calloc( taps+1, sizeof(double)); if (h == NULL) return -1;
-    w = (double*)calloc( taps+1, sizeof(double)); if (w == NULL) return -1;
-    ws = (float*)calloc( 2*taps+1, sizeof(float)); if (ws == NULL) return -1;
-
-    for (n = 0; n < taps; n++) {
-        w[n] = 7938/18608.0 - 9240/18608.0*cos(_2PI*n/(taps-1)) + 1430/18608.0*cos(4*M_PI*n/(taps-1)); // Blackmann
-        h[n] = 2*f*sinc(2*f*(n-(taps-1)/2));
-        ws[n] = w[n]*h[n];
-        norm += ws[n]; // 1-norm
-    }
-    for (n = 0; n < taps; n++) {
-        ws[n] /= norm; // 1-norm
-    }
-
-    for (n = 0; n < taps; n++) ws[taps+n] = ws[n]; // duplicate/unwrap
-
-    *pws = ws;
-
-    free(h); h = NULL;
-    free(w); w = NULL;
-
-    return taps;
-}
-
-
-static int lowpass_update(float f, int taps, float *ws) {
-    double *h, *w;
-    double norm = 0;
-    int n;
-
-    if (taps % 2 == 0) taps++; // odd/symmetric
-
-    if ( taps < 1 ) taps = 1;
+// rotate a block of decM input samples (decimated sample _sample) and decimate
+static float complex dec_block(dsp_t *dsp, float complex *blk, ui32_t _sample) {
 
-    h = (double*)calloc( taps+1, sizeof(double)); if (h == NULL) return -1;
-    w = (double*)calloc( taps+1, sizeof(double)); if (w == NULL) return -1;
-
-    for (n = 0; n < taps; n++) {
-        w[n] = 7938/18608.0 - 9240/18608.0*cos(_2PI*n/(taps-1)) + 1430/18608.0*cos(4*M_PI*n/(taps-1)); // Blackmann
-        h[n] = 2*f*sinc(2*f*(n-(taps-1)/2));
-        ws[n] = w[n]*h[n];
-        norm += ws[n]; // 1-norm
-    }
-    for (n = 0; n < taps; n++) {
-        ws[n] /= norm; // 1-norm
-    }
-
-    for (n = 0; n < taps; n++) ws[taps+n] = ws[n];
-
-    free(h); h = NULL;
-    free(w); w = NULL;
-
-    return taps;
-}
-
-static float complex lowpass0(float complex buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    ui32_t n;
-    double complex w = 0;
-    for (n = 0; n < taps; n++) {
-        w += buffer[(sample+n)%taps]*ws[taps-1-n];
-    }
-    return (float complex)w;
-}
-//static __attribute__((optimize("-ffast-math"))) float complex lowpass()
-static float complex lowpass(float complex buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    float complex w = 0;
-    int n; // -Ofast
-    int S = taps - (sample % taps);
-    for (n = 0; n < taps; n++) {
-        w += buffer[n]*ws[S+n]; // ws[taps+s-n] = ws[(taps+sample-n)%taps]
-    }
-    return w;
-// symmetry: ws[n] == ws[taps-1-n]
-}
-static float complex lowpass2(float complex buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    float complex w = 0;
-    int n;
-    int s = sample % taps;
-    int S1 = s;
-    int S1N = S1-taps;
-    int n0 = taps-s;
-    for (n = 0; n < n0; n++) {
-        w += buffer[S1+n]*ws[n];
-    }
-    for (n = n0; n < taps; n++) {
-        w += buffer[S1N+n]*ws[n];
-    }
-    return w;
-// symmetry: ws[n] == ws[taps-1-n]
-}
-
-static float re_lowpass0(float buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    ui32_t n;
-    double w = 0;
-    for (n = 0; n < taps; n++) {
-        w += buffer[(sample+n)%taps]*ws[taps-1-n];
-    }
-    return (float)w;
-}
-static float re_lowpass(float buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    float w = 0;
-    int n;
-    int S = taps - (sample % taps);
-    for (n = 0; n < taps; n++) {
-        w += buffer[n]*ws[S+n]; // ws[taps+s-n] = ws[(taps+sample-n)%taps]
-    }
-    return w;
-}
-
-
-static int ifblock(dsp_t *dsp, float complex *z_out) {
-
-    float complex z;
+    float complex z = 0;
     int j;
 
-    if ( f32read_cblock(dsp) < dsp->decM ) return EOF;
-
     for (j = 0; j < dsp->decM; j++) {
         if (dsp->opt_nolut) {
-            double _s_base = (double)(dsp->sample_in*dsp->decM+j); // dsp->sample_dec
+            double _s_base = (double)(_sample*dsp->decM+j); // dsp->sample_dec
             double f0 = dsp->xlt_fq*_s_base;
-            z = dsp->decMbuf[j] * cexp(f0*_2PI*I);
+            z = blk[j] * cexp(f0*_2PI*I);
         }
         else if (dsp->exlut) {
-            z = dsp->decMbuf[j] * dsp->ex[dsp->sample_decM];
+            z = blk[j] * dsp->ex[dsp->sample_decM];
         }
         else {
-            z = dsp->decMbuf[j];
+            z = blk[j];
         }
         dsp->sample_decM += 1; if (dsp->sample_decM >= dsp->lut_len) dsp->sample_decM = 0;
 
@@ -540,7 +403,14 @@ static int ifblock(dsp_t *dsp, float complex *z_out) {
         z = lowpass(dsp->decXbuffer, dsp->sample_decX, dsp->dectaps, ws_dec);
     }
 
-    *z_out = z;
+    return z;
+}
+
+static int ifblock(dsp_t *dsp, float complex *z_out) {
+
+    if ( f32read_cblock(dsp) < dsp->decM ) return EOF;
+
+    *z_out = dec_block(dsp, dsp->decMbuf, dsp->sample_in);
 
     dsp->sample_in += 1;
 
@@ -555,34 +425,13 @@ static int if_fm(dsp_t *dsp, float complex *z_out, float *s) {
     float gain = FM_GAIN;
     ui32_t _sample = dsp->sample_in * dsp->decFM;
     int m;
-    int j;
 
     for (m = 0; m < dsp->decFM; m++)
     {
 
         if ( f32read_cblock(dsp) < dsp->decM ) return EOF;
 
-        for (j = 0; j < dsp->decM; j++) {
-            if (dsp->opt_nolut) {
-                double _s_base = (double)(_sample*dsp->decM+j); // dsp->sample_dec
-                double f0 = dsp->xlt_fq*_s_base;
-                z = dsp->decMbuf[j] * cexp(f0*_2PI*I);
-            }
-            else if (dsp->exlut) {
-                z = dsp->decMbuf[j] * dsp->ex[dsp->sample_decM];
-            }
-            else {
-                z = dsp->decMbuf[j];
-            }
-            dsp->sample_decM += 1; if (dsp->sample_decM >= dsp->lut_len) dsp->sample_decM = 0;
-
-            dsp->decXbuffer[dsp->sample_decX] = z;
-            dsp->sample_decX += 1; if (dsp->sample_decX >= dsp->dectaps) dsp->sample_decX = 0;
-        }
-        if (dsp->decM > 1)
-        {
-            z = lowpass(dsp->decXbuffer, dsp->sample_decX, dsp->dectaps, ws_dec);
-        }
+        z = dec_block(dsp, dsp->decMbuf, _sample);
 
         // IF-lowpass
         if (dsp->opt_lp & LP_IQ) {
@@ -629,10 +478,52 @@ static int IF_min = IF_SAMPLE_RATE;
 #define FM_TRANSITION_BW (2e3)  // 2kHz transition width
 
 
+static int init_exlut(dsp_t *dsp) {
+
+    int n, k;
+
+    if (dsp->exlut && !dsp->opt_nolut)
+    {
+        // look up table, exp-rotation
+        int W = 2*8; // 16 Hz window
+        int d = 1; // 1..W , groesster Teiler d <= W von sr_base
+        int freq = (int)( dsp->xlt_fq * (double)dsp->sr_base + 0.5);
+        int freq0 = freq; // init
+        double f0 = freq0 / (double)dsp->sr_base; // init
+
+        for (d = W; d > 0; d--) { // groesster Teiler d <= W von sr
+            if (dsp->sr_base % d == 0) break;
+        }
+        if (d == 0) d = 1; // d >= 1 ?
+
+        for (k = 0; k < W/2; k++) {
+            if ((freq+k) % d == 0) {
+                freq0 = freq + k;
+                break;
+            }
+            if ((freq-k) % d == 0) {
+                freq0 = freq - k;
+                break;
+            }
+        }
+
+        dsp->lut_len = dsp->sr_base / d;
+        f0 = freq0 / (double)dsp->sr_base;
+
+        dsp->ex = calloc(dsp->lut_len+1, sizeof(float complex));
+        if (dsp->ex == NULL) return -1;
+        for (n = 0; n < dsp->lut_len; n++) {
+            double t = f0*(double)n;
+            dsp->ex[n] = cexp(t*_2PI*I);
+        }
+    }
+
+    return 0;
+}
+
 static int init_buffers(dsp_t *dsp) {
 
     int K = 0;
-    int n, k;
 
 
     // decimate
@@ -671,41 +562,7 @@ static int init_buffers(dsp_t *dsp) {
     fprintf(stderr, "dec: %d\n", decM);
 
 
-    if (dsp->exlut && !dsp->opt_nolut)
-    {
-        // look up table, exp-rotation
-        int W = 2*8; // 16 Hz window
-        int d = 1; // 1..W , groesster Teiler d <= W von sr_base
-        int freq = (int)( dsp->xlt_fq * (double)dsp->sr_base + 0.5);
-        int freq0 = freq; // init
-        double f0 = freq0 / (double)dsp->sr_base; // init
-
-        for (d = W; d > 0; d--) { // groesster Teiler d <= W von sr
-            if (dsp->sr_base % d == 0) break;
-        }
-        if (d == 0) d = 1; // d >= 1 ?
-
-        for (k = 0; k < W/2; k++) {
-            if ((freq+k) % d == 0) {
-                freq0 = freq + k;
-                break;
-            }
-            if ((freq-k) % d == 0) {
-                freq0 = freq - k;
-                break;
-            }
-        }
-
-        dsp->lut_len = dsp->sr_base / d;
-        f0 = freq0 / (double)dsp->sr_base;
-
-        dsp->ex = calloc(dsp->lut_len+1, sizeof(float complex));
-        if (dsp->ex == NULL) return -1;
-        for (n = 0; n < dsp->lut_len; n++) {
-            double t = f0*(double)n;
-            dsp->ex[n] = cexp(t*_2PI*I);
-        }
-    }
+    if (init_exlut(dsp) < 0) return -1;
 
     dsp->decXbuffer = calloc( dsp->dectaps+1, sizeof(float complex));
     if (dsp->decXbuffer == NULL) return -1;
@@ -801,7 +658,7 @@ static int write_cpx_blk(dsp_t *dsp, float complex *z, int len) {
     ui8_t u[2*len];
     float xy[2*len];
     int bps = dsp->bps_out;
-    int fd = 1; // STDOUT_FILENO
+    int fd = dsp->fd_out; // STDOUT_FILENO or channel output
 
     for (j = 0; j < len; j++) {
         xy[2*j  ] = creal(z[j]);
@@ -934,6 +791,69 @@ static int fwrite_fm_blk(dsp_t *dsp, float *s, int len) {
 
 
 #define ZLEN 64
+#define MAX_CHAN 32
+
+// filterbank: one pass over the input, every channel rotated and decimated on its own (--chan)
+static int filterbank(dsp_t *dsp, int nchan, double *chan_fq, char **chan_out) {
+
+    dsp_t chn[MAX_CHAN];
+    float complex z_vec[MAX_CHAN][ZLEN];
+    int k, n = 0;
+    int open_ch = 0;
+
+    for (k = 0; k < nchan; k++) {
+        chn[k] = *dsp; // sample rates, decimation, shared decMbuf (input block)
+        chn[k].xlt_fq = -chan_fq[k];
+        chn[k].exlut = 1;
+        chn[k].ex = NULL;
+        chn[k].lut_len = 0;
+        chn[k].sample_decM = 0;
+        chn[k].sample_decX = 0;
+        if (init_exlut(&chn[k]) < 0) return -1;
+        chn[k].decXbuffer = calloc( chn[k].dectaps+1, sizeof(float complex));
+        if (chn[k].decXbuffer == NULL) return -1;
+    }
+
+    // named pipes: open() blocks until the reader is there
+    signal(SIGPIPE, SIG_IGN);
+    for (k = 0; k < nchan; k++) {
+        chn[k].fd_out = open(chan_out[k], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (chn[k].fd_out < 0) fprintf(stderr, "error: open %s\n", chan_out[k]);
+        else open_ch++;
+    }
+
+    while (open_ch > 0 && f32read_cblock(dsp) == dsp->decM)
+    {
+        for (k = 0; k < nchan; k++) {
+            if (chn[k].fd_out >= 0) z_vec[k][n] = dec_block(&chn[k], dsp->decMbuf, dsp->sample_in);
+        }
+        dsp->sample_in += 1;
+        n++;
+
+        if (n == ZLEN) {
+            for (k = 0; k < nchan; k++) {
+                if (chn[k].fd_out >= 0 && write_cpx_blk(&chn[k], z_vec[k], n) < n) {
+                    // reader gone (EPIPE)
+                    close(chn[k].fd_out);
+                    chn[k].fd_out = -1;
+                    open_ch--;
+                }
+            }
+            n = 0;
+        }
+    }
+
+    for (k = 0; k < nchan; k++) {
+        if (chn[k].fd_out >= 0) {
+            if (n > 0) write_cpx_blk(&chn[k], z_vec[k], n);
+            close(chn[k].fd_out);
+        }
+        if (chn[k].ex) free(chn[k].ex);
+        free(chn[k].decXbuffer);
+    }
+
+    return 0;
+}
 
 int main(int argc, char *argv[]) {
 
@@ -961,6 +881,10 @@ int main(int argc, char *argv[]) {
     int bps_out = 32;
     float lpIQ_bw = 10e3;
 
+    int nchan = 0;
+    double chan_fq[MAX_CHAN];
+    char *chan_out[MAX_CHAN];
+
 
     pcm_t pcm = {0};
     dsp_t dsp = {0};  //memset(&dsp, 0, sizeof(dsp));
@@ -990,6 +914,23 @@ int main(int argc, char *argv[]) {
             dsp.exlut = 1;
             //option_iq = 5;
         }
+        else if   (strcmp(*argv, "--chan") == 0) { // filterbank channel: --chan <fq> <out>
+            double fq = 0.0;                       // -0.5 < fq < 0.5
+            ++argv;
+            if (*argv) fq = atof(*argv);
+            else return -1;
+            ++argv;
+            if (*argv == NULL) return -1;
+            if (nchan == MAX_CHAN) {
+                fprintf(stderr, "error: max. %d channels\n", MAX_CHAN);
+                return -1;
+            }
+            if (fq < -0.5) fq = -0.5;
+            if (fq >  0.5) fq =  0.5;
+            chan_fq[nchan] = fq;
+            chan_out[nchan] = *argv;
+            nchan++;
+        }
         else if   (strcmp(*argv, "--IFbw") == 0) {  // min IF bandwidth / kHz
             int ifbw = 0;
             ++argv;
@@ -1093,6 +1034,12 @@ int main(int argc, char *argv[]) {
     dsp.lpFM_bw = 6e3; // FM audio lowpass
     dsp.opt_IFmin = option_min;
     dsp.bps_out = bps_out;
+    dsp.fd_out = 1;
+
+    if (nchan > 0 && (option_fm || option_wav || (option_lp & LP_IQ))) {
+        fprintf(stderr, "error: --chan: IQ output only\n");
+        return -1;
+    }
 
     if (option_fm) dsp.opt_fm = 1;
 
@@ -1123,6 +1070,13 @@ int main(int argc, char *argv[]) {
     }
     if (option_wav) write_wav_header( &pcm );
 
+    if (nchan > 0) {
+        k = filterbank(&dsp, nchan, chan_fq, chan_out);
+        free_buffers(&dsp);
+        fclose(fp);
+        return k;
+    }
+
 
     int len = ZLEN;
     int l, n = 0;
@@ -0,0 +1,275 @@
+
+/*
+ *  IQ ring buffer in POSIX shared memory
+ *  compile:
+ *      gcc -c iq_shm.c
+ *  (older glibc: link with -lrt)
+ *
+ *  layout: [iqshm_hdr_t | pad to 64] [ring: 1<<log2len bytes]
+ *
+ *  producer: read(fd) straight into the ring, publish whole sample frames
+ *            by advancing hdr->wseq (release store).
+ *  consumer: copy from ring[rseq & mask], then re-check wseq; if the producer
+ *            may have overwritten the copied bytes, drop them and resync.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "iq_shm.h"
+
+
+#define LOAD_ACQ(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE_REL(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+#define IQSHM_WAIT_NS    1000000  // 1ms poll, if ring is empty
+#define IQSHM_OPEN_TRY   40       // open: 40 x 50ms
+
+
+static void shm_sleep(long ns) {
+    struct timespec ts;
+    ts.tv_sec = 0;
+    ts.tv_nsec = ns;
+    nanosleep(&ts, NULL);
+}
+
+static int shm_name(char *dst, const char *name) {
+    int n;
+    if (name == NULL || *name == '\0') return -1;
+    if (name[0] == '/') n = snprintf(dst, 64, "%s", name);
+    else                n = snprintf(dst, 64, "/%s", name);
+    if (n < 0 || n >= 64) return -1;
+    return 0;
+}
+
+
+iqshm_t *iqshm_create(const char *name, int sr, int bps, int nch, int log2len) {
+    iqshm_t *q = NULL;
+    iqshm_hdr_t *hdr;
+    void *p;
+
+    if (bps != 8 && bps != 16 && bps != 32) return NULL;
+    if (nch < 1) return NULL;
+    if (log2len < IQSHM_LOG2LEN_MIN) log2len = IQSHM_LOG2LEN_MIN;
+    if (log2len > IQSHM_LOG2LEN_MAX) log2len = IQSHM_LOG2LEN_MAX;
+
+    q = calloc(1, sizeof(iqshm_t));
+    if (q == NULL) return NULL;
+    if (shm_name(q->name, name) < 0) goto fail;
+
+    q->len = (ui64_t)1 << log2len;
+    q->mask = q->len - 1;
+    q->maplen = IQSHM_HDRLEN + q->len;
+    q->frame = nch*bps/8;
+    q->writer = 1;
+
+    // stale segment from a previous writer: readers still attached keep their mapping
+    shm_unlink(q->name);
+    q->fd = shm_open(q->name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (q->fd < 0) goto fail;
+    if (ftruncate(q->fd, q->maplen) < 0) goto fail_unlink;
+
+    p = mmap(NULL, q->maplen, PROT_READ | PROT_WRITE, MAP_SHARED, q->fd, 0);
+    if (p == MAP_FAILED) goto fail_unlink;
+
+    hdr = (iqshm_hdr_t *)p;
+    q->hdr = hdr;
+    q->ring = (ui8_t *)p + IQSHM_HDRLEN;
+
+    hdr->version = IQSHM_VERSION;
+    hdr->sr = sr;
+    hdr->bps = bps;
+    hdr->nch = nch;
+    hdr->log2len = log2len;
+    // publish at most len/4 at once; readers treat len-blklen as the safe window
+    hdr->blklen = (q->len/4 / q->frame) * q->frame;
+    if (hdr->blklen > (1<<16)) hdr->blklen = (1<<16) - (1<<16) % q->frame;
+    hdr->eof = 0;
+    hdr->wseq = 0;
+    hdr->t0_ns = 0;
+    STORE_REL(&hdr->magic, IQSHM_MAGIC);
+
+    return q;
+
+fail_unlink:
+    close(q->fd);
+    shm_unlink(q->name);
+fail:
+    free(q);
+    return NULL;
+}
+
+iqshm_t *iqshm_open(const char *name) {
+    iqshm_t *q = NULL;
+    iqshm_hdr_t *hdr;
+    struct stat st;
+    void *p;
+    int n;
+
+    q = calloc(1, sizeof(iqshm_t));
+    if (q == NULL) return NULL;
+    if (shm_name(q->name, name) < 0) goto fail;
+
+    // the producer may not be up yet
+    for (n = 0; n < IQSHM_OPEN_TRY; n++) {
+        q->fd = shm_open(q->name, O_RDONLY, 0);
+        if (q->fd >= 0) {
+            if (fstat(q->fd, &st) == 0 && st.st_size > IQSHM_HDRLEN) break;
+            close(q->fd);
+            q->fd = -1;
+        }
+        shm_sleep(50000000);
+    }
+    if (q->fd < 0) goto fail;
+
+    q->maplen = st.st_size;
+    p = mmap(NULL, q->maplen, PROT_READ, MAP_SHARED, q->fd, 0);
+    if (p == MAP_FAILED) goto fail_close;
+    hdr = (iqshm_hdr_t *)p;
+
+    for (n = 0; n < IQSHM_OPEN_TRY; n++) {
+        if (LOAD_ACQ(&hdr->magic) == IQSHM_MAGIC) break;
+        shm_sleep(50000000);
+    }
+    if (hdr->magic != IQSHM_MAGIC || hdr->version != IQSHM_VERSION
+     || IQSHM_HDRLEN + ((ui64_t)1 << hdr->log2len) > q->maplen
+     || hdr->nch < 1 || (hdr->bps != 8 && hdr->bps != 16 && hdr->bps != 32)) {
+        munmap(p, q->maplen);
+        goto fail_close;
+    }
+
+    q->hdr = hdr;
+    q->ring = (ui8_t *)p + IQSHM_HDRLEN;
+    q->len = (ui64_t)1 << hdr->log2len;
+    q->mask = q->len - 1;
+    q->frame = hdr->nch*hdr->bps/8;
+    q->writer = 0;
+
+    // attach live: start at the current write position
+    q->rseq = LOAD_ACQ(&hdr->wseq);
+
+    return q;
+
+fail_close:
+    close(q->fd);
+fail:
+    free(q);
+    return NULL;
+}
+
+void iqshm_close(iqshm_t *q) {
+    if (q == NULL) return;
+    if (q->writer) iqshm_eof(q);
+    if (q->hdr) munmap(q->hdr, q->maplen);
+    if (q->fd >= 0) close(q->fd);
+    if (q->writer) shm_unlink(q->name);
+    free(q);
+}
+
+void iqshm_eof(iqshm_t *q) {
+    if (q && q->writer && q->hdr) STORE_REL(&q->hdr->eof, 1);
+}
+
+
+/*
+ * consumer: fread()-like, blocks until n items of size bytes are available
+ * or the producer has closed and the ring is drained.
+ * overruns: jump to about wseq - len/2, i.e. keep half a ring of history,
+ * at the same byte offset within the sample frame.
+ */
+size_t iqshm_read(iqshm_t *q, void *buf, size_t size, size_t n) {
+    ui8_t *dst = (ui8_t *)buf;
+    ui64_t want = (ui64_t)size*n;
+    ui64_t got = 0;
+    ui64_t safe = q->len - q->hdr->blklen;
+    ui64_t w, avail, chunk, pos;
+
+    while (got < want) {
+        w = LOAD_ACQ(&q->hdr->wseq);
+        if (w - q->rseq > safe) {
+            ui64_t rs = w - q->len/2;
+            // keep the position within the sample frame: the caller may be between
+            // the channels of a frame (I/Q read one at a time), len/2 need not be frames (nch=3)
+            rs -= rs % q->frame;
+            rs += q->rseq % q->frame;
+            q->lost += rs - q->rseq;
+            q->rseq = rs;
+            q->overruns += 1;
+            continue;
+        }
+        avail = w - q->rseq;
+        if (avail == 0) {
+            if (LOAD_ACQ(&q->hdr->eof)) break;
+            shm_sleep(IQSHM_WAIT_NS);
+            continue;
+        }
+
+        pos = q->rseq & q->mask;
+        chunk = want - got;
+        if (chunk > avail) chunk = avail;
+        if (chunk > q->len - pos) chunk = q->len - pos;
+        memcpy(dst + got, q->ring + pos, chunk);
+
+        // producer may have wrapped onto the copied bytes meanwhile.
+        // the fence keeps the ring loads above from moving after the wseq recheck (ARM)
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        w = LOAD_ACQ(&q->hdr->wseq);
+        if (w - q->rseq > safe) continue;
+
+        q->rseq += chunk;
+        got += chunk;
+    }
+
+    return got / size;
+}
+
+/*
+ * producer: one read() from fd directly into the ring.
+ * whole frames are published, a partial frame stays pending at rseq.
+ * returns bytes read, 0 on EOF (or error).
+ */
+size_t iqshm_write(iqshm_t *q, int fd) {
+    iqshm_hdr_t *hdr = q->hdr;
+    ui64_t w = hdr->wseq;  // only written by us
+    ui64_t pos, chunk, pend;
+    ssize_t len;
+
+    // the previous wseq publish must be visible before the ring writes below,
+    // else a reader can pass its overrun check on bytes that are being overwritten
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    pend = q->rseq;  // bytes of a partial frame already in the ring
+    pos = (w + pend) & q->mask;
+    chunk = hdr->blklen - pend;
+    if (chunk > q->len - pos) chunk = q->len - pos;
+
+    len = read(fd, q->ring + pos, chunk);
+    if (len <= 0) return 0;
+
+    pend += len;
+    q->rseq = pend % q->frame;
+    STORE_REL(&hdr->wseq, w + pend - q->rseq);
+
+    return len;
+}
+
+/*
+ * time base: wall clock (unix time, s) of sample frame 0,
+ * i.e. frame k = rseq/frame was received at t0 + k/sr.
+ * set by the producer, 0: unknown
+ */
+void iqshm_set_t0(iqshm_t *q, double t0) {
+    if (q && q->writer && q->hdr) STORE_REL(&q->hdr->t0_ns, (ui64_t)(t0*1e9));
+}
+
+double iqshm_t0(iqshm_t *q) {
+    return LOAD_ACQ(&q->hdr->t0_ns) * 1e-9;
+}
+
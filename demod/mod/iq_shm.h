@@ -0,0 +1,81 @@
+
+/*
+ *  IQ ring buffer in POSIX shared memory
+ *    single producer (iq_shmw), multiple consumers
+ *
+ *  the writer publishes a byte sequence number (wseq) after each block;
+ *  every reader keeps its own cursor (rseq) and never blocks the writer.
+ *  if the writer laps a reader, the reader skips ahead and counts an overrun.
+ *
+ */
+
+#ifndef IQ_SHM_H
+#define IQ_SHM_H
+
+#include <stddef.h>
+
+#ifndef INTTYPES
+#define INTTYPES
+typedef unsigned char  ui8_t;
+typedef unsigned short ui16_t;
+typedef unsigned int   ui32_t;
+typedef unsigned long long ui64_t;
+typedef char  i8_t;
+typedef short i16_t;
+typedef int   i32_t;
+#endif
+
+
+#define IQSHM_MAGIC    0x51534849  // "IHSQ"
+#define IQSHM_VERSION  1
+
+#define IQSHM_LOG2LEN_DEF  22  // 4 MiB ring (~10s u8 @ 192k, ~5s s16 @ 192k)
+#define IQSHM_LOG2LEN_MIN  16
+#define IQSHM_LOG2LEN_MAX  30
+
+#define IQSHM_HDRLEN   64      // ring data starts 64-byte aligned
+
+
+typedef struct {
+    ui32_t magic;      // written last by the producer
+    ui32_t version;
+    ui32_t sr;         // sample rate
+    ui32_t bps;        // bits/sample (8,16,32)
+    ui32_t nch;        // channels (IQ: 2)
+    ui32_t log2len;    // ring length: 1<<log2len bytes
+    ui32_t blklen;     // max bytes the producer writes before publishing
+    ui32_t eof;        // producer closed
+    ui64_t wseq;       // bytes written (sequence number)
+    ui64_t t0_ns;      // wall clock (unix ns) of sample frame 0 (wseq=0); 0: unknown (rx_time.h)
+} iqshm_hdr_t;
+
+
+typedef struct iqshm {
+    iqshm_hdr_t *hdr;
+    ui8_t *ring;
+    size_t maplen;
+    ui64_t len;        // ring length
+    ui64_t mask;
+    ui64_t rseq;       // reader cursor / writer pending position
+    ui64_t overruns;   // number of times the producer lapped this reader
+    ui64_t lost;       // bytes skipped due to overruns
+    ui32_t frame;      // bytes per sample frame (nch*bps/8)
+    int fd;
+    int writer;
+    char name[64];
+} iqshm_t;
+
+
+iqshm_t *iqshm_create(const char *name, int sr, int bps, int nch, int log2len);
+iqshm_t *iqshm_open(const char *name);
+void iqshm_close(iqshm_t *q);
+
+size_t iqshm_read(iqshm_t *q, void *buf, size_t size, size_t n);
+size_t iqshm_write(iqshm_t *q, int fd);
+void iqshm_eof(iqshm_t *q);
+
+void iqshm_set_t0(iqshm_t *q, double t0);
+double iqshm_t0(iqshm_t *q);
+
+#endif
+
@@ -0,0 +1,199 @@
+
+/*
+ *  compile:
+ *
+ *      gcc -O2 iq_shmw.c iq_shm.c -o iq_shmw
+ *
+ *
+ *  usage:
+ *
+ *      rtl_fm -M raw -s <sr> -f <freq> - | ./iq_shmw [--len <log2>] <name> - <sr> <bs>
+ *      ./iq_shmw [--len <log2>] <name> iq_baseband.wav
+ *      rtl_fm -M raw -s <sr> -f <freq> - | ./iq_shmw --tee <name> - <sr> <bs> | ./rs41mod --IQ 0.0 - <sr> <bs>
+ *
+ *               <name>      : shared memory segment (/dev/shm/<name>)
+ *               --len <l>   : ring length 2^l bytes (default: 22)
+ *               --tee       : also pass the samples through to stdout (tap of a decoder pipe)
+ *               --rxt0 <t>  : wall clock (unix time, s) of the first sample;
+ *                             default: estimated from the arrival of the samples on stdin (rx_time.h)
+ *
+ *  readers:
+ *
+ *      ./rs41mod --IQ <fq> --shm <name>
+ *      ./dft_detect --IQ <fq> --shm <name>
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "demod_mod.h"
+#include "iq_shm.h"
+#include "rx_time.h"
+
+
+static volatile sig_atomic_t sig_stop = 0;
+
+static void sig_handler(int sig) {
+    sig_stop = 1;
+}
+
+
+static int write_all(int fd, const ui8_t *buf, size_t len) {
+    ssize_t n;
+    while (len > 0) {
+        n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR && !sig_stop) continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+
+int main(int argc, char *argv[]) {
+
+    int option_pcmraw = 0;
+    int option_tee = 0;
+    int log2len = IQSHM_LOG2LEN_DEF;
+    int wavloaded = 0;
+    double rx_t0 = 0.0;
+
+    FILE *fp = NULL;
+    char *fpname = NULL;
+    char *shm_name = NULL;
+
+    pcm_t pcm = {0};
+    iqshm_t *q = NULL;
+    rxtime_t rxt;
+    struct sigaction sa;
+
+    size_t len, pos;
+
+
+    fpname = argv[0];
+    ++argv;
+    while ((*argv) && (!wavloaded)) {
+        if      ( (strcmp(*argv, "-h") == 0) || (strcmp(*argv, "--help") == 0) ) {
+            fprintf(stderr, "%s [options] <name> [- <sr> <bs>] [iq_baseband.wav]\n", fpname);
+            fprintf(stderr, "  options:\n");
+            fprintf(stderr, "       --len <l>   (ring length 2^l bytes; default=%d)\n", IQSHM_LOG2LEN_DEF);
+            fprintf(stderr, "       --rxt0 <t>  (wall clock of the first sample, unix time)\n");
+            fprintf(stderr, "       --tee       (pass samples through to stdout)\n");
+            return 0;
+        }
+        else if   (strcmp(*argv, "--tee") == 0) { option_tee = 1; }
+        else if   (strcmp(*argv, "--len") == 0) {
+            ++argv;
+            if (*argv) log2len = atoi(*argv); else return -1;
+        }
+        else if   (strcmp(*argv, "--rxt0") == 0) {
+            ++argv;
+            if (*argv) rx_t0 = atof(*argv); else return -1;
+        }
+        else if (strcmp(*argv, "-") == 0) {
+            int sample_rate = 0, bits_sample = 0, channels = 0;
+            ++argv;
+            if (*argv) sample_rate = atoi(*argv); else return -1;
+            ++argv;
+            if (*argv) bits_sample = atoi(*argv); else return -1;
+            channels = 2;
+            if (sample_rate < 1 || (bits_sample != 8 && bits_sample != 16 && bits_sample != 32)) {
+                fprintf(stderr, "- <sr> <bs>\n");
+                return -1;
+            }
+            pcm.sr  = sample_rate;
+            pcm.bps = bits_sample;
+            pcm.nch = channels;
+            option_pcmraw = 1;
+        }
+        else if (shm_name == NULL) {
+            shm_name = *argv;
+        }
+        else {
+            fp = fopen(*argv, "rb");
+            if (fp == NULL) {
+                fprintf(stderr, "error: open %s\n", *argv);
+                return -1;
+            }
+            wavloaded = 1;
+        }
+        ++argv;
+    }
+    if (!wavloaded) fp = stdin;
+
+    if (shm_name == NULL) {
+        fprintf(stderr, "error: no shm name\n");
+        return -1;
+    }
+
+    // samples are read() from the raw fd: stdio must not buffer ahead of the wav header
+    setvbuf(fp, NULL, _IONBF, 0);
+
+    if (option_pcmraw == 0) {
+        if (read_wav_header(&pcm, fp) < 0) {
+            fclose(fp);
+            fprintf(stderr, "error: wav header\n");
+            return -1;
+        }
+    }
+    if (pcm.nch < 2) {
+        fprintf(stderr, "error: data not IQ\n");
+        return -1;
+    }
+
+    if (option_tee && !option_pcmraw) {
+        fprintf(stderr, "error: --tee needs raw input (- <sr> <bs>)\n");
+        return -1;
+    }
+
+    q = iqshm_create(shm_name, pcm.sr, pcm.bps, pcm.nch, log2len);
+    if (q == NULL) {
+        fprintf(stderr, "error: create shm %s\n", shm_name);
+        if (!option_tee) return -1;
+        // --tee: the decoder downstream must not lose its input, pass the samples through only
+        {
+            ui8_t buf[4096];
+            ssize_t n;
+            while ((n = read(fileno(fp), buf, sizeof(buf))) > 0) {
+                if (write_all(STDOUT_FILENO, buf, n) < 0) break;
+            }
+        }
+        return 0;
+    }
+
+    // shm_unlink() on SIGINT/SIGTERM/SIGPIPE
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = sig_handler;
+    sigaction(SIGINT,  &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGPIPE, &sa, NULL);
+
+    // time base: given, or from the read() times of a real-time stream
+    rxt_init(&rxt, pcm.sr);
+    if (rx_t0 > 0) iqshm_set_t0(q, rx_t0);
+
+    while (!sig_stop) {
+        pos = (q->hdr->wseq + q->rseq) & q->mask;  // iqshm_write() reads into ring[pos..pos+len)
+        len = iqshm_write(q, fileno(fp));
+        if (len == 0) break;
+        if (option_tee && write_all(STDOUT_FILENO, q->ring + pos, len) < 0) break;  // stdout closed
+        if (rx_t0 <= 0 && fp == stdin) {
+            rxt_update(&rxt, q->hdr->wseq / q->frame, rxt_now());
+            iqshm_set_t0(q, rxt.t0);
+        }
+    }
+
+    iqshm_close(q);
+    if (fp != stdin) fclose(fp);
+
+    return 0;
+}
+
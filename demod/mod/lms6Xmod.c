@@ -51,6 +51,7 @@
 //typedef unsigned int   ui32_t;
 
 #include "demod_mod.h"
+#include "sonde_tlm.h"
 
 //#define  INCLUDESTATIC 1
 #ifdef INCLUDESTATIC
@@ -70,6 +71,7 @@ typedef struct {
     i8_t inv;
     i8_t vit;
     i8_t jsn;  // JSON output (auto_rx)
+    i8_t jsb;  // --jsnbin: JSON as binary record (sonde_tlm.h)
 } option_t;
 
 
@@ -166,6 +168,7 @@ typedef struct {
     option_t option;
     RS_t RS;
     VIT_t *vit;
+    tlm_t tlm;
 } gpx_t;
 
 
@@ -768,26 +771,33 @@ static void print_frame(gpx_t *gpx, int crc_err, int len) {
                     char subtyp[] = "LMS6-403\0\0";
                     if (gpx->typ == 10) { sntyp[3] = 'X'; subtyp[3] = 'X'; }
                     else if (gpx->typ == 0x0206) strcpy(subtyp, "LMS6-403-2");
-                    printf("{ \"type\": \"%s\"", "LMS");
-                    printf(", \"frame\": %d, \"id\": \"%s%d\", \"datetime\": \"", gpx->frnr, sntyp, gpx->sn );
-                    //if (gpx->week > 0) printf("%04d-%02d-%02dT", gpx->jahr, gpx->monat, gpx->tag );
-                    printf("%02d:%02d:%06.3fZ\", \"lat\": %.5f, \"lon\": %.5f, \"alt\": %.5f, \"vel_h\": %.5f, \"heading\": %.5f, \"vel_v\": %.5f",
-                           gpx->std, gpx->min, gpx->sek, gpx->lat, gpx->lon, gpx->alt, gpx->vH, gpx->vD, gpx->vV );
-                    printf(", \"gpstow\": %d", gpx->gpstow );
-                    printf(", \"subtype\": \"%s\"", subtyp); // "LMS6-403", "LMS6-403-2", "LMSX-403"; "MK2A":LMS6-1680/Mk2a
+                    tlm_t *t = &gpx->tlm;
+                    tlm_begin(t, "LMS");
+                    tlm_int(t, TLM_FRAME, gpx->frnr);
+                    tlm_strf(t, TLM_ID, "%s%d", sntyp, gpx->sn);
+                    //if (gpx->week > 0): gpx->jahr, gpx->monat, gpx->tag
+                    tlm_datetime(t, 0, 0, 0, gpx->std, gpx->min, gpx->sek, 3);
+                    tlm_flt(t, TLM_LAT, gpx->lat, 5);
+                    tlm_flt(t, TLM_LON, gpx->lon, 5);
+                    tlm_flt(t, TLM_ALT, gpx->alt, 5);
+                    tlm_flt(t, TLM_VEL_H, gpx->vH, 5);
+                    tlm_flt(t, TLM_HEADING, gpx->vD, 5);
+                    tlm_flt(t, TLM_VEL_V, gpx->vV, 5);
+                    tlm_int(t, TLM_GPSTOW, gpx->gpstow);
+                    tlm_str(t, TLM_SUBTYPE, subtyp); // "LMS6-403", "LMS6-403-2", "LMSX-403"; "MK2A":LMS6-1680/Mk2a
                     if (gpx->jsn_freq > 0) {
-                        printf(", \"freq\": %d", gpx->jsn_freq);
+                        tlm_int(t, TLM_FREQ, gpx->jsn_freq);
                     }
 
                     // Reference time/position
-                    printf(", \"ref_datetime\": \"%s\"", "GPS" ); // {"GPS", "UTC"} GPS-UTC=leap_sec
-                    printf(", \"ref_position\": \"%s\"", "GPS" ); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid
+                    tlm_str(t, TLM_REF_DATETIME, "GPS"); // {"GPS", "UTC"} GPS-UTC=leap_sec
+                    tlm_str(t, TLM_REF_POSITION, "GPS"); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid
 
                     #ifdef VER_JSN_STR
                         ver_jsn = VER_JSN_STR;
                     #endif
-                    if (ver_jsn && *ver_jsn != '\0') printf(", \"version\": \"%s\"", ver_jsn);
-                    printf(" }\n");
+                    if (ver_jsn && *ver_jsn != '\0') tlm_str(t, TLM_VERSION_STR, ver_jsn);
+                    tlm_out(t, stdout, gpx->option.jsb);
                     printf("\n");
                 }
             }
@@ -1009,6 +1019,7 @@ int main(int argc, char **argv) {
 
     FILE *fp = NULL;
     char *fpname = NULL;
+    char *shm_name = NULL;
 
     int k;
 
@@ -1155,6 +1166,7 @@ int main(int argc, char **argv) {
             gpx->option.ecc = 1;
             gpx->option.vit = 1;
         }
+        else if   (strcmp(*argv, "--jsnbin") == 0) { gpx->option.jsb = 1; }  // json as binary records
         else if   (strcmp(*argv, "--jsn_cfq") == 0) {
             int frq = -1;  // center frequency / Hz
             ++argv;
@@ -1162,6 +1174,16 @@ int main(int argc, char **argv) {
             if (frq < 300000000) frq = -1;
             cfreq = frq;
         }
+        else if   (strcmp(*argv, "--shm") == 0) {  // IQ from shared-memory ring (iq_shmw)
+            ++argv;
+            if (*argv) shm_name = *argv; else return -1;
+        }
+        else if   (strcmp(*argv, "--rxtime") == 0) { dsp.opt_rxtime = 1; }  // JSON: wall clock of the header
+        else if   (strcmp(*argv, "--rxt0") == 0) {  // wall clock of the first sample (unix time)
+            ++argv;
+            if (*argv) dsp.rx_t0 = atof(*argv); else return -1;
+            dsp.opt_rxtime = 1;
+        }
         else if (strcmp(*argv, "-") == 0) {
             int sample_rate = 0, bits_sample = 0, channels = 0;
             ++argv;
@@ -1190,6 +1212,14 @@ int main(int argc, char **argv) {
     }
     if (!wavloaded) fp = stdin;
 
+    if (shm_name) {
+        if (attach_shm(&dsp, &pcm, shm_name) < 0) {
+            fprintf(stderr, "error: open shm %s\n", shm_name);
+            return -1;
+        }
+        option_pcmraw = 1;
+    }
+
     if (option_iq == 5 && option_dc) option_lp |= LP_FM;
 
     // LUT faster for decM, however frequency correction after decimation
@@ -1353,10 +1383,12 @@ int main(int argc, char **argv) {
     {
         if (option_softin) {
             header_found = find_softbinhead(fp, &hdb, &_mv, option_softin == 2);
+            if (dsp.opt_rxtime) gpx->tlm.rx_time = softin_rx_time(dsp.rx_t0);
         }
         else {                                                               // FM-audio:
             header_found = find_header(&dsp, thres, 10, bitofs, dsp.opt_dc); // optional 2nd pass: dc=0
             _mv = dsp.mv;
+            gpx->tlm.rx_time = dsp.rx_time;
         }
 
         if (header_found == EOF) break;
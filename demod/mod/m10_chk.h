@@ -0,0 +1,158 @@
+
+/*
+ *  M10/M20 checksum
+ *    m10mod, m20mod
+ *
+ *  update_checkM10(c, b) is linear over GF(2):
+ *    update(c, b) = A(c) ^ B(b) ,  A(c) = A(c & 0x00FF) ^ A(c & 0xFF00)
+ *  byte-at-a-time with 3 tables:
+ *    c = chkM10_A0[c & 0xFF] ^ chkM10_A1[c >> 8] ^ chkM10_B[b]
+ *  and checkM10(msg ^ e, len) = checkM10(msg, len) ^ checkM10(e, len):
+ *    flipping bit k of msg[i] changes the checksum by chkM10_D[len-1-i][k].
+ *
+ *  repair: the frame bits are differentially decoded (bit_j = raw_j XNOR raw_j-1),
+ *    a wrong raw bit j flips frame bits j and j+1.
+ *    The weakest raw bits of a frame are collected while receiving (m10weak_t);
+ *    single and double raw bit flips are tested against the checksum
+ *    by xor-ing the precomputed checksum differences.
+ *
+ */
+
+#ifndef M10_CHK_H
+#define M10_CHK_H
+
+
+#define CHKM10_MAXLEN  256
+#define M10_WEAKBITS    12  // 12 + 12*11/2 = 78 candidates
+
+
+static ui16_t chkM10_A0[256];
+static ui16_t chkM10_A1[256];
+static ui16_t chkM10_B[256];
+static ui16_t chkM10_D[CHKM10_MAXLEN][8];
+
+
+static int update_checkM10(int c, ui8_t b) {
+    int c0, c1, t, t6, t7, s;
+
+    c1 = c & 0xFF;
+
+    // B
+    b  = (b >> 1) | ((b & 1) << 7);
+    b ^= (b >> 2) & 0xFF;
+
+    // A1
+    t6 = ( c     & 1) ^ ((c>>2) & 1) ^ ((c>>4) & 1);
+    t7 = ((c>>1) & 1) ^ ((c>>3) & 1) ^ ((c>>5) & 1);
+    t = (c & 0x3F) | (t6 << 6) | (t7 << 7);
+
+    // A2
+    s  = (c >> 7) & 0xFF;
+    s ^= (s >> 2) & 0xFF;
+
+
+    c0 = b ^ t ^ s;
+
+    return ((c1<<8) | c0) & 0xFFFF;
+}
+
+static void init_checkM10(void) {
+    int i, k;
+
+    for (i = 0; i < 256; i++) {
+        chkM10_A0[i] = update_checkM10(i,    0);
+        chkM10_A1[i] = update_checkM10(i<<8, 0);
+        chkM10_B[i]  = update_checkM10(0,    i);
+    }
+    for (k = 0; k < 8; k++) {
+        chkM10_D[0][k] = chkM10_B[1<<k];
+        for (i = 1; i < CHKM10_MAXLEN; i++) {
+            ui16_t c = chkM10_D[i-1][k];
+            chkM10_D[i][k] = chkM10_A0[c & 0xFF] ^ chkM10_A1[c >> 8];
+        }
+    }
+}
+
+static int checkM10(ui8_t *msg, int len) {
+    int i;
+    ui16_t cs = 0;
+
+    for (i = 0; i < len; i++) {
+        cs = chkM10_A0[cs & 0xFF] ^ chkM10_A1[cs >> 8] ^ chkM10_B[msg[i]];
+    }
+
+    return cs;
+}
+
+
+typedef struct {
+    int   n;
+    int   pos[M10_WEAKBITS];  // raw bit position in frame
+    float sb[M10_WEAKBITS];   // |soft bit|, ascending
+} m10weak_t;
+
+static void weak_add(m10weak_t *w, int pos, float sb) {
+    int i;
+    if (sb < 0) sb = -sb;
+    if (w->n == M10_WEAKBITS && sb >= w->sb[M10_WEAKBITS-1]) return;
+    i = (w->n < M10_WEAKBITS) ? w->n++ : M10_WEAKBITS-1;
+    while (i > 0 && w->sb[i-1] > sb) {
+        w->sb[i]  = w->sb[i-1];
+        w->pos[i] = w->pos[i-1];
+        i--;
+    }
+    w->sb[i]  = sb;
+    w->pos[i] = pos;
+}
+
+// checksum difference (cs1 ^ cs2) of frame bit q; frame[len..len+1]: cs1
+static ui16_t bit_checkM10(int q, int len) {
+    int i = q / BITS;
+    int k = 7 - q % BITS;  // big endian
+    if (i < len)   return chkM10_D[len-1-i][k];
+    if (i == len)   return (1<<k) << 8;
+    if (i == len+1) return  1<<k;
+    return 0;
+}
+
+// frame[0..len-1], checksum frame[len..len+1], nbits received
+// return: number of corrected raw bits (1, 2), 0: no correction found
+static int repair_checkM10(ui8_t *frame, int len, int nbits, m10weak_t *w) {
+    ui16_t syn, d[M10_WEAKBITS];
+    int i, j, q, ret = 0;
+    int fl[2] = {-1, -1};
+
+    if (len < 1 || len+2 > CHKM10_MAXLEN) return 0;
+
+    syn = ((frame[len] << 8) | frame[len+1]) ^ checkM10(frame, len);
+    if (syn == 0) return 0;
+
+    for (i = 0; i < w->n; i++) {
+        q = w->pos[i];
+        d[i] = 0;
+        // frame[0] = len, bit 0 not used
+        if (q < BITS || q >= nbits || q >= 8*(len+2)) continue;
+        d[i] = bit_checkM10(q, len);
+        if (q+1 < 8*(len+2)) d[i] ^= bit_checkM10(q+1, len);
+    }
+
+    for (i = 0; i < w->n && !ret; i++) {
+        if (d[i] == 0) continue;
+        if (d[i] == syn) { fl[0] = i; ret = 1; break; }
+        for (j = 0; j < i; j++) {
+            if (d[j] && (d[i] ^ d[j]) == syn) { fl[0] = i; fl[1] = j; ret = 2; break; }
+        }
+    }
+
+    for (i = 0; i < ret; i++) {
+        q = w->pos[fl[i]];
+        frame[q/BITS] ^= 1 << (7 - q%BITS);
+        q += 1;
+        if (q < 8*(len+2)) frame[q/BITS] ^= 1 << (7 - q%BITS);
+    }
+
+    return ret;
+}
+
+#endif
+
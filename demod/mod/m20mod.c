@@ -39,19 +39,21 @@
 
 
 #include "demod_mod.h"
+#include "sonde_tlm.h"
 
 
 typedef struct {
     i8_t vbs;  // verbose output
     i8_t raw;  // raw frames
     i8_t crc;  // CRC check output
-    i8_t ecc;  // M10/M20: no ECC
+    i8_t ecc;  // M10/M20: no ECC; --ecc: weak bit repair (m10_chk.h)
     i8_t sat;  // GPS sat data
     i8_t ptu;  // PTU: temperature
     i8_t inv;
     i8_t aut;
     i8_t col;  // colors
     i8_t jsn;  // JSON output (auto_rx)
+    i8_t jsb;  // --jsnbin: JSON as binary record (sonde_tlm.h)
     i8_t slt;  // silent (only raw/json)
 } option_t;
 
@@ -86,6 +88,7 @@ static char rawheader[] = "10011001100110010100110010011001";
 #define AUX_LEN          64
 #define BITAUX_LEN      (AUX_LEN*BITS)
 
+#include "m10_chk.h"
 
 #define t_M2K2     0x8F
 #define t_M10      0x9F
@@ -111,11 +114,12 @@ typedef struct {
     char SN[12+4];
     ui8_t SNraw[3];
     ui8_t frame_bytes[FRAME_LEN+AUX_LEN+4];
-    char frame_bits[BITFRAME_LEN+BITAUX_LEN+8];
+    m10weak_t weak;
     int auxlen; // ? 0 .. 0x57-0x45
     int jsn_freq;   // freq/kHz (SDR)
     option_t option;
     ui8_t type;
+    tlm_t tlm;
 } gpx_t;
 
 
@@ -147,37 +151,6 @@ static void Gps2Date(long GpsWeek, long GpsSeconds, int *Year, int *Month, int *
 }
 /* -------------------------------------------------------------------------- */
 
-static int bits2bytes(char *bitstr, ui8_t *bytes) {
-    int i, bit, d, byteval;
-    int bitpos, bytepos;
-
-    bitpos = 0;
-    bytepos = 0;
-
-    while (bytepos < FRAME_LEN+AUX_LEN) {
-
-        byteval = 0;
-        d = 1;
-        for (i = 0; i < BITS; i++) {
-            //bit=*(bitstr+bitpos+i); /* little endian */
-            bit=*(bitstr+bitpos+7-i);  /* big endian */
-            // bit == 'x' ?
-            if         (bit == '1')                     byteval += d;
-            else /*if ((bit == '0') || (bit == 'x'))*/  byteval += 0;
-            d <<= 1;
-        }
-        bitpos += BITS;
-        bytes[bytepos++] = byteval & 0xFF;
-
-    }
-
-    //while (bytepos < FRAME_LEN+AUX_LEN) bytes[bytepos++] = 0;
-
-    return 0;
-}
-
-/* -------------------------------------------------------------------------- */
-
 /*
 M20
 
@@ -510,50 +483,15 @@ f : F^16 x F^8 -> F^16 linear
 000000000000000100000000
 */
 
-static int update_checkM10(int c, ui8_t b) {
-    int c0, c1, t, t6, t7, s;
-
-    c1 = c & 0xFF;
-
-    // B
-    b  = (b >> 1) | ((b & 1) << 7);
-    b ^= (b >> 2) & 0xFF;
-
-    // A1
-    t6 = ( c     & 1) ^ ((c>>2) & 1) ^ ((c>>4) & 1);
-    t7 = ((c>>1) & 1) ^ ((c>>3) & 1) ^ ((c>>5) & 1);
-    t = (c & 0x3F) | (t6 << 6) | (t7 << 7);
-
-    // A2
-    s  = (c >> 7) & 0xFF;
-    s ^= (s >> 2) & 0xFF;
-
-
-    c0 = b ^ t ^ s;
-
-    return ((c1<<8) | c0) & 0xFFFF;
-}
-
-static int checkM10(ui8_t *msg, int len) {
-    int i, cs;  // msg[0] = len+1
-
-    cs = 0;
-    for (i = 0; i < len; i++) {
-        cs = update_checkM10(cs, msg[i]);
-    }
-
-    return cs & 0xFFFF;
-}
+// update_checkM10(), checkM10(): m10_chk.h
 // checkM10(frame, frame[0]-1) = blk_checkM10(frame[0], frame+1)
 static int blk_checkM10(int len, ui8_t *msg) {
     int i, cs;
     ui8_t pre = len & 0xFF; // len(block+chk16)
-    cs = 0;
-
-    cs = update_checkM10(cs, pre);
+    cs = chkM10_B[pre];
 
     for (i = 0; i < len-2; i++) {
-        cs = update_checkM10(cs, msg[i]);
+        cs = chkM10_A0[cs & 0xFF] ^ chkM10_A1[cs >> 8] ^ chkM10_B[msg[i]];
     }
 
     return cs & 0xFFFF;
@@ -827,37 +765,45 @@ static int print_pos(gpx_t *gpx, int bcOK, int csOK) {
             // Print out telemetry data as JSON
             if (csOK) {
                 char *ver_jsn = NULL;
+                tlm_t *t;
                 int j;
                 char sn_id[4+12+4] = "M20-";
 
                 strncpy(sn_id+4, gpx->SN, 12+4);
                 sn_id[15+4] = '\0';
 
-                fprintf(stdout, "{ \"type\": \"%s\"", "M20");
-                fprintf(stdout, ", \"frame\": %lu, ", (unsigned long)gpx->gps_cnt); // sec_gps0+0.5
-                fprintf(stdout, "\"id\": \"%s\", \"datetime\": \"%04d-%02d-%02dT%02d:%02d:%06.3fZ\", \"lat\": %.5f, \"lon\": %.5f, \"alt\": %.5f, \"vel_h\": %.5f, \"heading\": %.5f, \"vel_v\": %.5f",
-                               sn_id, gpx->jahr, gpx->monat, gpx->tag, gpx->std, gpx->min, gpx->sek, gpx->lat, gpx->lon, gpx->alt, gpx->vH, gpx->vD, gpx->vV);
+                t = &gpx->tlm;
+                tlm_begin(t, "M20");
+                tlm_int(t, TLM_FRAME, (unsigned long)gpx->gps_cnt); // sec_gps0+0.5
+                tlm_str(t, TLM_ID, sn_id);
+                tlm_datetime(t, gpx->jahr, gpx->monat, gpx->tag, gpx->std, gpx->min, gpx->sek, 3);
+                tlm_flt(t, TLM_LAT, gpx->lat, 5);
+                tlm_flt(t, TLM_LON, gpx->lon, 5);
+                tlm_flt(t, TLM_ALT, gpx->alt, 5);
+                tlm_flt(t, TLM_VEL_H, gpx->vH, 5);
+                tlm_flt(t, TLM_HEADING, gpx->vD, 5);
+                tlm_flt(t, TLM_VEL_V, gpx->vV, 5);
                 if (gpx->option.ptu) { // temperature
-                    if (gpx->T > -273.0f) fprintf(stdout, ", \"temp\": %.1f", gpx->T );
-                    if (gpx->RH > -0.5f)  fprintf(stdout, ", \"humidity\": %.1f", gpx->RH );
-                    if (gpx->P > 0.0f)    fprintf(stdout, ", \"pressure\": %.2f",  gpx->P );
+                    if (gpx->T > -273.0f) tlm_flt(t, TLM_TEMP, gpx->T, 1);
+                    if (gpx->RH > -0.5f)  tlm_flt(t, TLM_HUMIDITY, gpx->RH, 1);
+                    if (gpx->P > 0.0f)    tlm_flt(t, TLM_PRESSURE, gpx->P, 2);
                 }
-                fprintf(stdout, ", \"batt\": %.2f", gpx->batV);
-                fprintf(stdout, ", \"rawid\": \"M20_%02X%02X%02X\"", gpx->frame_bytes[pos_SN], gpx->frame_bytes[pos_SN+1], gpx->frame_bytes[pos_SN+2]); // gpx->type
-                fprintf(stdout, ", \"subtype\": \"0x%02X\"", gpx->type);
+                tlm_flt(t, TLM_BATT, gpx->batV, 2);
+                tlm_strf(t, TLM_RAWID, "M20_%02X%02X%02X", gpx->frame_bytes[pos_SN], gpx->frame_bytes[pos_SN+1], gpx->frame_bytes[pos_SN+2]); // gpx->type
+                tlm_strf(t, TLM_SUBTYPE, "0x%02X", gpx->type);
                 if (gpx->jsn_freq > 0) {
-                    fprintf(stdout, ", \"freq\": %d", gpx->jsn_freq);
+                    tlm_int(t, TLM_FREQ, gpx->jsn_freq);
                 }
 
                 // Reference time/position
-                fprintf(stdout, ", \"ref_datetime\": \"%s\"", "GPS" ); // {"GPS", "UTC"} GPS-UTC=leap_sec
-                fprintf(stdout, ", \"ref_position\": \"%s\"", "GPS" ); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid
+                tlm_str(t, TLM_REF_DATETIME, "GPS"); // {"GPS", "UTC"} GPS-UTC=leap_sec
+                tlm_str(t, TLM_REF_POSITION, "GPS"); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid
 
                 #ifdef VER_JSN_STR
                     ver_jsn = VER_JSN_STR;
                 #endif
-                if (ver_jsn && *ver_jsn != '\0') fprintf(stdout, ", \"version\": \"%s\"", ver_jsn);
-                fprintf(stdout, " }\n");
+                if (ver_jsn && *ver_jsn != '\0') tlm_str(t, TLM_VERSION_STR, ver_jsn);
+                tlm_out(t, stdout, gpx->option.jsb);
                 fprintf(stdout, "\n");
             }
         }
@@ -867,7 +813,7 @@ static int print_pos(gpx_t *gpx, int bcOK, int csOK) {
     return err;
 }
 
-static int print_frame(gpx_t *gpx, int pos, int b2B) {
+static int print_frame(gpx_t *gpx, int pos) {
     int i;
     ui8_t byte;
     int cs1, cs2;
@@ -876,9 +822,6 @@ static int print_frame(gpx_t *gpx, int pos, int b2B) {
     int pos_fw = pos_stdFW;
     int pos_check = pos_stdCheck;
 
-    if (b2B) {
-        bits2bytes(gpx->frame_bits, gpx->frame_bytes);
-    }
     flen = gpx->frame_bytes[0];
     if (flen == stdFLEN) gpx->auxlen = 0;
     else {
@@ -894,6 +837,9 @@ static int print_frame(gpx_t *gpx, int pos, int b2B) {
         }
     }
     pos_check = flen-1;
+    if (gpx->option.ecc) {
+        repair_checkM10(gpx->frame_bytes, pos_check, pos, &gpx->weak);
+    }
     gpx->fwVer = gpx->frame_bytes[pos_fw];
     if (gpx->fwVer > 0x20) gpx->fwVer = 0;
 
@@ -1018,6 +964,7 @@ int main(int argc, char **argv) {
 
     FILE *fp = NULL;
     char *fpname = NULL;
+    char *shm_name = NULL;
 
     int k;
 
@@ -1025,6 +972,8 @@ int main(int argc, char **argv) {
     int bitpos = 0;
     int bitQ;
     int pos;
+    ui8_t byte = 0;
+    float sb = 0.0;
     hsbit_t hsbit, hsbit1;
 
     //int headerlen = 0;
@@ -1053,6 +1002,8 @@ int main(int argc, char **argv) {
 #endif
     setbuf(stdout, NULL);
 
+    init_checkM10();
+
 
     fpname = argv[0];
     ++argv;
@@ -1094,6 +1045,7 @@ int main(int argc, char **argv) {
         else if ( (strcmp(*argv, "--spike") == 0) ) {
             spike = 1;
         }
+        else if   (strcmp(*argv, "--ecc") == 0) { gpx.option.ecc = 1; }  // weak bit repair
         else if   (strcmp(*argv, "--ch2") == 0) { sel_wavch = 1; }  // right channel (default: 0=left)
         else if   (strcmp(*argv, "--softin") == 0)  { option_softin = 1; }  // float32 soft input
         else if   (strcmp(*argv, "--softinv") == 0) { option_softin = 2; }  // float32 inverted soft input
@@ -1144,6 +1096,7 @@ int main(int argc, char **argv) {
             option_min = 1;
         }
         else if   (strcmp(*argv, "--json") == 0) { gpx.option.jsn = 1; }
+        else if   (strcmp(*argv, "--jsnbin") == 0) { gpx.option.jsb = 1; }  // json as binary records
         else if   (strcmp(*argv, "--jsn_cfq") == 0) {
             int frq = -1;  // center frequency / Hz
             ++argv;
@@ -1152,6 +1105,16 @@ int main(int argc, char **argv) {
             cfreq = frq;
         }
         else if (strcmp(*argv, "--rawhex") == 0) { rawhex = 2; }  // raw hex input
+        else if   (strcmp(*argv, "--shm") == 0) {  // IQ from shared-memory ring (iq_shmw)
+            ++argv;
+            if (*argv) shm_name = *argv; else return -1;
+        }
+        else if   (strcmp(*argv, "--rxtime") == 0) { dsp.opt_rxtime = 1; }  // JSON: wall clock of the header
+        else if   (strcmp(*argv, "--rxt0") == 0) {  // wall clock of the first sample (unix time)
+            ++argv;
+            if (*argv) dsp.rx_t0 = atof(*argv); else return -1;
+            dsp.opt_rxtime = 1;
+        }
         else if (strcmp(*argv, "-") == 0) {
             int sample_rate = 0, bits_sample = 0, channels = 0;
             ++argv;
@@ -1180,6 +1143,14 @@ int main(int argc, char **argv) {
     }
     if (!wavloaded) fp = stdin;
 
+    if (shm_name) {
+        if (attach_shm(&dsp, &pcm, shm_name) < 0) {
+            fprintf(stderr, "error: open shm %s\n", shm_name);
+            return -1;
+        }
+        option_pcmraw = 1;
+    }
+
     if (option_iq == 5 && option_dc) option_lp |= LP_FM;
 
     // LUT faster for decM, however frequency correction after decimation
@@ -1300,10 +1271,12 @@ int main(int argc, char **argv) {
         {
             if (option_softin) {
                 header_found = find_softbinhead(fp, &hdb, &_mv, option_softin == 2);
+                if (dsp.opt_rxtime) gpx.tlm.rx_time = softin_rx_time(dsp.rx_t0);
             }
             else {                                                              // FM-audio:
                 header_found = find_header(&dsp, thres, 2, bitofs, dsp.opt_dc); // optional 2nd pass: dc=0
                 _mv = dsp.mv;
+                gpx.tlm.rx_time = dsp.rx_time;
             }
 
             if (header_found == EOF) break;
@@ -1318,7 +1291,9 @@ int main(int argc, char **argv) {
                 bitpos = 0;
                 pos = 0;
                 pos /= 2;
-                bit0 = '0'; // oder: _mv[j] > 0
+                bit0 = 0; // oder: _mv[j] > 0
+                byte = 0;
+                gpx.weak.n = 0;
 
                 while ( pos < BITFRAME_LEN+BITAUX_LEN ) {
 
@@ -1334,6 +1309,7 @@ int main(int argc, char **argv) {
                                 bit = (s>=0.0); // no soft decoding
                             }
                         }
+                        sb = s;
                     }
                     else {
                         float bl = -1;
@@ -1342,16 +1318,20 @@ int main(int argc, char **argv) {
                         //bitQ = read_slbit(&dsp, &bit, 0, bitofs, bitpos, bl, spike); // symlen=2
                         bitQ = read_softbit2p(&dsp, &hsbit, 0, bitofs, bitpos, bl, spike, &hsbit1); // symlen=2
                         bit = hsbit.hb;
+                        sb = hsbit.sb;
                     }
                     if ( bitQ == EOF ) { break; }
 
-                    gpx.frame_bits[pos] = 0x31 ^ (bit0 ^ bit);
+                    // differential bits, big endian; 1st bit: 0
+                    byte = (byte << 1) | (pos > 0 && bit == bit0);
+                    if ((pos & 7) == 7) gpx.frame_bytes[pos >> 3] = byte;
+                    if (gpx.option.ecc) weak_add(&gpx.weak, pos, sb);
                     pos++;
                     bit0 = bit;
                     bitpos += 1;
                 }
-                gpx.frame_bits[pos] = '\0';
-                print_frame(&gpx, pos, 1);
+                if (pos & 7) gpx.frame_bytes[pos >> 3] = byte << (8 - (pos & 7));
+                print_frame(&gpx, pos);
                 if (pos < BITFRAME_LEN) break;
 
                 header_found = 0;
@@ -1406,7 +1386,7 @@ int main(int argc, char **argv) {
                     // wenn ohne %hhx: sscanf(buffer_rawhex+rawhex*i, "%2x", &byte); frame[frameofs+i] = (ui8_t)byte;
                     gpx.frame_bytes[frameofs+i] = frmbyte;
                 }
-                print_frame(&gpx, len*8, 0);
+                print_frame(&gpx, len*8);
             }
         }
     }
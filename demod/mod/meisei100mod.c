@@ -122,6 +122,7 @@ e.g. -b --br 2398
 //typedef short i16_t;
 
 #include "demod_mod.h"
+#include "sonde_tlm.h"
 
 //#define  INCLUDESTATIC 1
 #ifdef INCLUDESTATIC
@@ -156,6 +157,7 @@ typedef struct {
     int frm1_count; int frm1_valid;
     int vV_valid;
     RS_t RS;
+    tlm_t tlm;
 } gpx_t;
 
 /* -------------------------------------------------------------------------- */
@@ -351,6 +353,7 @@ int main(int argc, char **argv) {
         option_inv = 0,
         option_ecc = 0,    // BCH(63,51)
         option_jsn = 0;    // JSON output (auto_rx)
+    int option_jsnbin = 0; // --jsnbin: JSON as binary record (sonde_tlm.h)
     int option_ptu = 0;
     int option_min = 0;
     int option_iq = 0;
@@ -371,6 +374,7 @@ int main(int argc, char **argv) {
 
     FILE *fp;
     char *fpname;
+    char *shm_name = NULL;
 
     int subframe = 0;
     int err_frm = 0;
@@ -519,6 +523,7 @@ int main(int argc, char **argv) {
             option_jsn = 1;
             option_ecc = 1;
         }
+        else if   (strcmp(*argv, "--jsnbin") == 0) { option_jsnbin = 1; }  // json as binary records
         else if   (strcmp(*argv, "--jsn_cfq") == 0) {
             int frq = -1;  // center frequency / Hz
             ++argv;
@@ -532,6 +537,16 @@ int main(int argc, char **argv) {
             if (*argv) _yr = atoi(*argv); else return -1;
             if (_yr > 2003 && _yr < 2100) gpx.ref_yr = _yr;
         }
+        else if   (strcmp(*argv, "--shm") == 0) {  // IQ from shared-memory ring (iq_shmw)
+            ++argv;
+            if (*argv) shm_name = *argv; else return -1;
+        }
+        else if   (strcmp(*argv, "--rxtime") == 0) { dsp.opt_rxtime = 1; }  // JSON: wall clock of the header
+        else if   (strcmp(*argv, "--rxt0") == 0) {  // wall clock of the first sample (unix time)
+            ++argv;
+            if (*argv) dsp.rx_t0 = atof(*argv); else return -1;
+            dsp.opt_rxtime = 1;
+        }
         else if (strcmp(*argv, "-") == 0) {
             int sample_rate = 0, bits_sample = 0, channels = 0;
             ++argv;
@@ -562,6 +577,14 @@ int main(int argc, char **argv) {
     }
     if (!wavloaded) fp = stdin;
 
+    if (shm_name) {
+        if (attach_shm(&dsp, &pcm, shm_name) < 0) {
+            fprintf(stderr, "error: open shm %s\n", shm_name);
+            return -1;
+        }
+        option_pcmraw = 1;
+    }
+
     if (option_iq == 5 && option_dc) option_lp |= LP_FM;
 
     // LUT faster for decM, however frequency correction after decimation
@@ -686,10 +709,12 @@ int main(int argc, char **argv) {
     {
         if (option_softin) {
             header_found = find_softbinhead(fp, &hdb, &_mv, option_softin == 2);
+            if (dsp.opt_rxtime) gpx.tlm.rx_time = softin_rx_time(dsp.rx_t0);
         }
         else {                                                              // FM-audio:
             header_found = find_header(&dsp, thres, 1, bitofs, dsp.opt_dc); // optional 2nd pass: dc=0
             _mv = dsp.mv;
+            gpx.tlm.rx_time = dsp.rx_time;
         }
 
         if (header_found == EOF) break;
@@ -734,35 +759,29 @@ int main(int argc, char **argv) {
 
                     if (option_ecc) {
                         int   errors;
-                        ui8_t cw[63+1],  // BCH(63,51), t=2
-                              err_pos[4],
-                              err_val[4];
+                        ui64_t cw;  // BCH(63,51), t=2; bit k = cw[k]
+                        ui8_t err_pos[4];
                         int check_err;
 
                         for (block = 0; block < 6; block++) {
 
                             // prepare block-codeword
-                            for (j =  0; j < 46; j++) cw[45-j] = subframe_bits[HEADLEN + block*46+j];
-                            for (j = 46; j < 63; j++) cw[j] = 0;
+                            cw = 0;
+                            for (j = 0; j < 46; j++) cw = (cw << 1) | subframe_bits[HEADLEN + block*46+j];
 
-                            errors = rs_decode_bch_gf2t2(&gpx.RS, cw, err_pos, err_val);
+                            errors = rs_decode_bch63(&cw, err_pos);
 
                             // check parity,padding
                             if (errors >= 0) {
-                                int par = 0;
                                 check_err = 0;
-                                for (j = 46; j < 63; j++) { if (cw[j] != 0) check_err = 0x1; }
-                                par = 1;
-                                for (j = 13; j < 13+16; j++) par ^= cw[j];
-                                if (cw[12] != par) check_err |= 0x100;
-                                par = 1;
-                                for (j = 30; j < 30+16; j++) par ^= cw[j];
-                                if (cw[29] != par) check_err |= 0x10;
+                                if (cw >> 46) check_err = 0x1;
+                                if (__builtin_parityll(cw & 0x00001FFFF000ULL) != 1) check_err |= 0x100; // cw[12] = 1^cw[13..28]
+                                if (__builtin_parityll(cw & 0x3FFFE0000000ULL) != 1) check_err |= 0x10;  // cw[29] = 1^cw[30..45]
                                 if (check_err) errors = -3;
                             }
-                            if (errors >= 0) // errors > 0
+                            if (errors > 0)
                             {
-                                for (j = 0; j < 46; j++) subframe_bits[HEADLEN + block*46+j] = cw[45-j];
+                                for (j = 0; j < 46; j++) subframe_bits[HEADLEN + block*46+j] = (cw >> (45-j)) & 1;
                             }
 
                             if (errors < 0) {
@@ -910,34 +929,42 @@ int main(int argc, char **argv) {
                                         if (gpx.sn > 0 && gpx.sn < 1e9) {
                                             sprintf(id_str, "%.0f", gpx.sn);
                                         }
-                                        printf("{ \"type\": \"%s\"", "MEISEI");
-                                        printf(", \"frame\": %d, \"id\": \"RS11G-%s\", \"datetime\": \"%04d-%02d-%02dT%02d:%02d:%06.3fZ\", \"lat\": %.5f, \"lon\": %.5f, \"alt\": %.5f, \"vel_h\": %.5f, \"heading\": %.5f, \"vel_v\": %.5f",
-                                               gpx.frnr, id_str, gpx.jahr, gpx.monat, gpx.tag, gpx.std, gpx.min, gpx.sek, gpx.lat, gpx.lon, gpx.alt, gpx.vH, gpx.vD, gpx.vV );
+                                        tlm_t *t = &gpx.tlm;
+                                        tlm_begin(t, "MEISEI");
+                                        tlm_int(t, TLM_FRAME, gpx.frnr);
+                                        tlm_strf(t, TLM_ID, "RS11G-%s", id_str);
+                                        tlm_datetime(t, gpx.jahr, gpx.monat, gpx.tag, gpx.std, gpx.min, gpx.sek, 3);
+                                        tlm_flt(t, TLM_LAT, gpx.lat, 5);
+                                        tlm_flt(t, TLM_LON, gpx.lon, 5);
+                                        tlm_flt(t, TLM_ALT, gpx.alt, 5);
+                                        tlm_flt(t, TLM_VEL_H, gpx.vH, 5);
+                                        tlm_flt(t, TLM_HEADING, gpx.vD, 5);
+                                        tlm_flt(t, TLM_VEL_V, gpx.vV, 5);
                                         if (option_ptu) {
                                             if (!isnan(gpx.T)) { // better don't use -ffast-math here
-                                                fprintf(stdout, ", \"temp\": %.1f",  gpx.T );
+                                                tlm_flt(t, TLM_TEMP, gpx.T, 1);
                                             }
                                             if (!isnan(gpx.RH)) { // better don't use -ffast-math here
-                                                fprintf(stdout, ", \"humidity\": %.1f",  gpx.RH );
+                                                tlm_flt(t, TLM_HUMIDITY, gpx.RH, 1);
                                             }
                                         }
-                                        printf(", \"subtype\": \"RS11G\"");
+                                        tlm_str(t, TLM_SUBTYPE, "RS11G");
                                         if (gpx.jsn_freq > 0) {
-                                            printf(", \"freq\": %d", gpx.jsn_freq);
+                                            tlm_int(t, TLM_FREQ, gpx.jsn_freq);
                                         }
                                         if (gpx.fq > 0) { // include frequency derived from subframe information if available
-                                            fprintf(stdout, ", \"tx_frequency\": %.0f", gpx.fq );
+                                            tlm_flt(t, TLM_TX_FREQUENCY, gpx.fq, 0);
                                         }
 
                                         // Reference time/position
-                                        printf(", \"ref_datetime\": \"%s\"", "UTC" ); // {"GPS", "UTC"} GPS-UTC=leap_sec
-                                        printf(", \"ref_position\": \"%s\"", "MSL" ); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid
+                                        tlm_str(t, TLM_REF_DATETIME, "UTC"); // {"GPS", "UTC"} GPS-UTC=leap_sec
+                                        tlm_str(t, TLM_REF_POSITION, "MSL"); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid
 
                                         #ifdef VER_JSN_STR
                                             ver_jsn = VER_JSN_STR;
                                         #endif
-                                        if (ver_jsn && *ver_jsn != '\0') printf(", \"version\": \"%s\"", ver_jsn);
-                                        printf(" }\n");
+                                        if (ver_jsn && *ver_jsn != '\0') tlm_str(t, TLM_VERSION_STR, ver_jsn);
+                                        tlm_out(t, stdout, option_jsnbin);
                                         printf("\n");
                                     }
 
@@ -1241,37 +1268,44 @@ int main(int argc, char **argv) {
                                     if (gpx.sn > 0 && gpx.sn < 1e9) {
                                         sprintf(id_str, "%.0f", gpx.sn);
                                     }
-                                    printf("{ \"type\": \"%s\"", "MEISEI"); // alt: "IMS100"
-                                    printf(", \"frame\": %d, \"id\": \"IMS100-%s\", \"datetime\": \"%04d-%02d-%02dT%02d:%02d:%06.3fZ\", \"lat\": %.5f, \"lon\": %.5f, \"alt\": %.5f, \"vel_h\": %.5f, \"heading\": %.5f",
-                                           gpx.frnr, id_str, gpx.jahr, gpx.monat, gpx.tag, gpx.std, gpx.min, gpx.sek, gpx.lat, gpx.lon, gpx.alt, gpx.vH, gpx.vD );
+                                    tlm_t *t = &gpx.tlm;
+                                    tlm_begin(t, "MEISEI"); // alt: "IMS100"
+                                    tlm_int(t, TLM_FRAME, gpx.frnr);
+                                    tlm_strf(t, TLM_ID, "IMS100-%s", id_str);
+                                    tlm_datetime(t, gpx.jahr, gpx.monat, gpx.tag, gpx.std, gpx.min, gpx.sek, 3);
+                                    tlm_flt(t, TLM_LAT, gpx.lat, 5);
+                                    tlm_flt(t, TLM_LON, gpx.lon, 5);
+                                    tlm_flt(t, TLM_ALT, gpx.alt, 5);
+                                    tlm_flt(t, TLM_VEL_H, gpx.vH, 5);
+                                    tlm_flt(t, TLM_HEADING, gpx.vD, 5);
                                     if (gpx.frm1_valid && (gpx.frm1_count == gpx.frm0_count + 1)) {
-                                        if (gpx.vV_valid) printf(", \"vel_v\": %.5f", gpx.vV );
+                                        if (gpx.vV_valid) tlm_flt(t, TLM_VEL_V, gpx.vV, 5);
                                     }
                                     if (option_ptu) {
                                         if (!isnan(gpx.T)) { // don't use -ffast-math here
-                                            fprintf(stdout, ", \"temp\": %.1f",  gpx.T );
+                                            tlm_flt(t, TLM_TEMP, gpx.T, 1);
                                         }
                                         if (!isnan(gpx.RH)) { // don't use -ffast-math here
-                                            fprintf(stdout, ", \"humidity\": %.1f",  gpx.RH );
+                                            tlm_flt(t, TLM_HUMIDITY, gpx.RH, 1);
                                         }
                                     }
-                                    printf(", \"subtype\": \"IMS100\"");
+                                    tlm_str(t, TLM_SUBTYPE, "IMS100");
                                     if (gpx.jsn_freq > 0) { // not gpx.fq, because gpx.sn not in every frame
-                                        printf(", \"freq\": %d", gpx.jsn_freq);
+                                        tlm_int(t, TLM_FREQ, gpx.jsn_freq);
                                     }
                                     if (gpx.fq > 0) { // include frequency derived from subframe information if available
-                                        fprintf(stdout, ", \"tx_frequency\": %.0f", gpx.fq );
+                                        tlm_flt(t, TLM_TX_FREQUENCY, gpx.fq, 0);
                                     }
 
                                     // Reference time/position
-                                    printf(", \"ref_datetime\": \"%s\"", "UTC" ); // {"GPS", "UTC"} GPS-UTC=leap_sec
-                                    printf(", \"ref_position\": \"%s\"", "MSL" ); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid
+                                    tlm_str(t, TLM_REF_DATETIME, "UTC"); // {"GPS", "UTC"} GPS-UTC=leap_sec
+                                    tlm_str(t, TLM_REF_POSITION, "MSL"); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid
 
                                     #ifdef VER_JSN_STR
                                         ver_jsn = VER_JSN_STR;
                                     #endif
-                                    if (ver_jsn && *ver_jsn != '\0') printf(", \"version\": \"%s\"", ver_jsn);
-                                    printf(" }\n");
+                                    if (ver_jsn && *ver_jsn != '\0') tlm_str(t, TLM_VERSION_STR, ver_jsn);
+                                    tlm_out(t, stdout, option_jsnbin);
                                     printf("\n");
 
                                     gpx.frm0_valid = 0;
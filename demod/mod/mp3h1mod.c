@@ -44,6 +44,7 @@
 //typedef int i32_t;
 
 #include "demod_mod.h"
+#include "sonde_tlm.h"
 
 
 typedef struct {
@@ -57,6 +58,7 @@ typedef struct {
     i8_t aut;
     i8_t col;  // colors
     i8_t jsn;  // JSON output (auto_rx)
+    i8_t jsb;  // --jsnbin: JSON as binary record (sonde_tlm.h)
     i8_t slt;  // silent
     i8_t dbg;
     i8_t unq;
@@ -107,6 +109,7 @@ typedef struct {
     int week;
     int jsn_freq;   // freq/kHz (SDR)
     option_t option;
+    tlm_t tlm;
 } gpx_t;
 
 
@@ -744,37 +747,42 @@ static void print_gpx(gpx_t *gpx, int crcOK) {
             }
             else {
                 char *ver_jsn = NULL;
-                printf("{ \"type\": \"%s\"", "MRZ");
-                printf(", \"frame\": %lu, ", (unsigned long)gpx->gps_cnt); // sec_gps0+0.5
-                printf("\"id\": \"MRZ-%d-%d\", \"datetime\": \"%04d-%02d-%02dT%02d:%02d:%02dZ\", \"lat\": %.5f, \"lon\": %.5f, \"alt\": %.5f",
-                        gpx->snC, gpx->snD, gpx->yr, gpx->mth, gpx->day, gpx->hrs, gpx->min, gpx->sec, gpx->lat, gpx->lon, gpx->alt);
-                printf(", \"vel_h\": %.5f, \"heading\": %.5f", gpx->vH, gpx->vD);
+                tlm_t *t = &gpx->tlm;
+                tlm_begin(t, "MRZ");
+                tlm_int(t, TLM_FRAME, (unsigned long)gpx->gps_cnt); // sec_gps0+0.5
+                tlm_strf(t, TLM_ID, "MRZ-%d-%d", gpx->snC, gpx->snD);
+                tlm_datetime(t, gpx->yr, gpx->mth, gpx->day, gpx->hrs, gpx->min, gpx->sec, 0);
+                tlm_flt(t, TLM_LAT, gpx->lat, 5);
+                tlm_flt(t, TLM_LON, gpx->lon, 5);
+                tlm_flt(t, TLM_ALT, gpx->alt, 5);
+                tlm_flt(t, TLM_VEL_H, gpx->vH, 5);
+                tlm_flt(t, TLM_HEADING, gpx->vD, 5);
                 if ( !ofs_ptucfg ) {
-                    printf(", \"vel_v\": %.5f", gpx->vV);
+                    tlm_flt(t, TLM_VEL_V, gpx->vV, 5);
                 }
-                printf(", \"sats\": %d", gpx->numSats);
+                tlm_int(t, TLM_SATS, gpx->numSats);
 
                 if (gpx->option.ptu) {
                     if (gpx->T > -273.0f) {
-                        fprintf(stdout, ", \"temp\": %.1f",  gpx->T );
+                        tlm_flt(t, TLM_TEMP, gpx->T, 1);
                     }
                     if (gpx->RH > -0.5f) {
-                        fprintf(stdout, ", \"humidity\": %.1f",  gpx->RH );
+                        tlm_flt(t, TLM_HUMIDITY, gpx->RH, 1);
                     }
                 }
                 if (gpx->jsn_freq > 0) {
-                    printf(", \"freq\": %d", gpx->jsn_freq);
+                    tlm_int(t, TLM_FREQ, gpx->jsn_freq);
                 }
 
                 // Reference time/position
-                printf(", \"ref_datetime\": \"%s\"", "UTC" ); // {"GPS", "UTC"} GPS-UTC=leap_sec
-                printf(", \"ref_position\": \"%s\"", !ofs_ptucfg ? "GPS" : "MSL" ); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid
+                tlm_str(t, TLM_REF_DATETIME, "UTC"); // {"GPS", "UTC"} GPS-UTC=leap_sec
+                tlm_str(t, TLM_REF_POSITION, !ofs_ptucfg ? "GPS" : "MSL"); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid
 
                 #ifdef VER_JSN_STR
                     ver_jsn = VER_JSN_STR;
                 #endif
-                if (ver_jsn && *ver_jsn != '\0') printf(", \"version\": \"%s\"", ver_jsn);
-                printf(" }\n");
+                if (ver_jsn && *ver_jsn != '\0') tlm_str(t, TLM_VERSION_STR, ver_jsn);
+                tlm_out(t, stdout, gpx->option.jsb);
             }
         }
     }
@@ -869,6 +877,7 @@ int main(int argc, char **argv) {
 
     FILE *fp;
     char *fpname;
+    char *shm_name = NULL;
     int pos, bit;
     int cfreq = -1;
 
@@ -1010,6 +1019,7 @@ int main(int argc, char **argv) {
         else if (strcmp(*argv, "--json") == 0) {
             gpx.option.jsn = 1;
         }
+        else if (strcmp(*argv, "--jsnbin") == 0) { gpx.option.jsb = 1; }  // json as binary records
         else if ( (strcmp(*argv, "--jsn_cfq") == 0) ) {
             int frq = -1;  // center frequency / Hz
             ++argv;
@@ -1018,6 +1028,16 @@ int main(int argc, char **argv) {
             cfreq = frq;
         }
         else if   (strcmp(*argv, "--rawhex") == 0) { rawhex = 3; }  // raw hex input
+        else if   (strcmp(*argv, "--shm") == 0) {  // IQ from shared-memory ring (iq_shmw)
+            ++argv;
+            if (*argv) shm_name = *argv; else return -1;
+        }
+        else if   (strcmp(*argv, "--rxtime") == 0) { dsp.opt_rxtime = 1; }  // JSON: wall clock of the header
+        else if   (strcmp(*argv, "--rxt0") == 0) {  // wall clock of the first sample (unix time)
+            ++argv;
+            if (*argv) dsp.rx_t0 = atof(*argv); else return -1;
+            dsp.opt_rxtime = 1;
+        }
         else if (strcmp(*argv, "-") == 0) {
             int sample_rate = 0, bits_sample = 0, channels = 0;
             ++argv;
@@ -1046,6 +1066,14 @@ int main(int argc, char **argv) {
     }
     if (!wavloaded) fp = stdin;
 
+    if (shm_name) {
+        if (attach_shm(&dsp, &pcm, shm_name) < 0) {
+            fprintf(stderr, "error: open shm %s\n", shm_name);
+            return -1;
+        }
+        option_pcmraw = 1;
+    }
+
     if (option_iq == 5 && option_dc) option_lp |= LP_FM;
 
     // LUT faster for decM, however frequency correction after decimation
@@ -1176,10 +1204,12 @@ int main(int argc, char **argv) {
         {
             if (option_softin) {
                 header_found = find_softbinhead(fp, &hdb, &_mv, option_softin == 2);
+                if (dsp.opt_rxtime) gpx.tlm.rx_time = softin_rx_time(dsp.rx_t0);
             }
             else {                                                              // FM-audio:
                 header_found = find_header(&dsp, thres, 2, bitofs, dsp.opt_dc); // optional 2nd pass: dc=0
                 _mv = dsp.mv;
+                gpx.tlm.rx_time = dsp.rx_time;
             }
 
             if (header_found == EOF) break;
@@ -28,6 +28,7 @@
 
 
 #include "demod_mod.h"
+#include "sonde_tlm.h"
 
 
 typedef struct {
@@ -35,6 +36,7 @@ typedef struct {
     i8_t raw;  // raw frames
     i8_t inv;
     i8_t jsn;  // JSON output (auto_rx)
+    i8_t jsb;  // --jsnbin: JSON as binary record (sonde_tlm.h)
     i8_t aut;
 } option_t;
 
@@ -70,6 +72,7 @@ typedef struct {
     char frm_str[FRAMELEN+4];
     int jsn_freq;   // freq/kHz (SDR)
     option_t option;
+    tlm_t tlm;
 } gpx_t;
 
 
@@ -251,24 +254,31 @@ static int print_frame(gpx_t *gpx, int pos) {
             if (crc_ok) {
                 // UTC oder GPS?
                 char *ver_jsn = NULL;
-                printf("{ \"type\": \"%s\"", "MTS01");
-                printf(", \"frame\": %d, \"id\": \"MTS01-%s\", \"datetime\": \"%04d-%02d-%02dT%02d:%02d:%06.3fZ\", \"lat\": %.5f, \"lon\": %.5f, \"alt\": %.5f, \"vel_h\": %.5f, \"heading\": %.5f",
-                       gpx->frnr, gpx->ID, gpx->year, gpx->month, gpx->day, gpx->hrs, gpx->min, (float)gpx->sec, gpx->lat, gpx->lon, gpx->alt, gpx->vH, gpx->vD );
-                printf(", \"batt\": %.2f", gpx->batt/1000.0);
-                if (gpx->T > -270.0f) printf(", \"temp\": %.1f", gpx->T);
+                tlm_t *t = &gpx->tlm;
+                tlm_begin(t, "MTS01");
+                tlm_int(t, TLM_FRAME, gpx->frnr);
+                tlm_strf(t, TLM_ID, "MTS01-%s", gpx->ID);
+                tlm_datetime(t, gpx->year, gpx->month, gpx->day, gpx->hrs, gpx->min, (float)gpx->sec, 3);
+                tlm_flt(t, TLM_LAT, gpx->lat, 5);
+                tlm_flt(t, TLM_LON, gpx->lon, 5);
+                tlm_flt(t, TLM_ALT, gpx->alt, 5);
+                tlm_flt(t, TLM_VEL_H, gpx->vH, 5);
+                tlm_flt(t, TLM_HEADING, gpx->vD, 5);
+                tlm_flt(t, TLM_BATT, gpx->batt/1000.0, 2);
+                if (gpx->T > -270.0f) tlm_flt(t, TLM_TEMP, gpx->T, 1);
                 if (gpx->jsn_freq > 0) {
-                    printf(", \"freq\": %d", gpx->jsn_freq);
+                    tlm_int(t, TLM_FREQ, gpx->jsn_freq);
                 }
 
                 // Reference time/position
-                printf(", \"ref_datetime\": \"%s\"", "UTC" ); // {"GPS", "UTC"} GPS-UTC=leap_sec ?
-                printf(", \"ref_position\": \"%s\"", "MSL" ); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid ?
+                tlm_str(t, TLM_REF_DATETIME, "UTC"); // {"GPS", "UTC"} GPS-UTC=leap_sec ?
+                tlm_str(t, TLM_REF_POSITION, "MSL"); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid ?
 
                 #ifdef VER_JSN_STR
                     ver_jsn = VER_JSN_STR;
                 #endif
-                if (ver_jsn && *ver_jsn != '\0') printf(", \"version\": \"%s\"", ver_jsn);
-                printf(" }\n");
+                if (ver_jsn && *ver_jsn != '\0') tlm_str(t, TLM_VERSION_STR, ver_jsn);
+                tlm_out(t, stdout, gpx->option.jsb);
             }
         }
 
@@ -302,6 +312,7 @@ int main(int argc, char **argv) {
 
     FILE *fp = NULL;
     char *fpname = NULL;
+    char *shm_name = NULL;
 
     int k;
 
@@ -421,6 +432,7 @@ int main(int argc, char **argv) {
         else if   (strcmp(*argv, "--json") == 0) {
             gpx.option.jsn = 1;
         }
+        else if   (strcmp(*argv, "--jsnbin") == 0) { gpx.option.jsb = 1; }  // json as binary records
         else if   (strcmp(*argv, "--jsn_cfq") == 0) {
             int frq = -1;  // center frequency / Hz
             ++argv;
@@ -428,6 +440,16 @@ int main(int argc, char **argv) {
             if (frq < 300000000) frq = -1;
             cfreq = frq;
         }
+        else if   (strcmp(*argv, "--shm") == 0) {  // IQ from shared-memory ring (iq_shmw)
+            ++argv;
+            if (*argv) shm_name = *argv; else return -1;
+        }
+        else if   (strcmp(*argv, "--rxtime") == 0) { dsp.opt_rxtime = 1; }  // JSON: wall clock of the header
+        else if   (strcmp(*argv, "--rxt0") == 0) {  // wall clock of the first sample (unix time)
+            ++argv;
+            if (*argv) dsp.rx_t0 = atof(*argv); else return -1;
+            dsp.opt_rxtime = 1;
+        }
         else if (strcmp(*argv, "-") == 0) {
             int sample_rate = 0, bits_sample = 0, channels = 0;
             ++argv;
@@ -456,6 +478,14 @@ int main(int argc, char **argv) {
     }
     if (!wavloaded) fp = stdin;
 
+    if (shm_name) {
+        if (attach_shm(&dsp, &pcm, shm_name) < 0) {
+            fprintf(stderr, "error: open shm %s\n", shm_name);
+            return -1;
+        }
+        option_pcmraw = 1;
+    }
+
     if (option_iq == 5 && option_dc) option_lp |= LP_FM;
 
     // LUT faster for decM, however frequency correction after decimation
@@ -567,10 +597,12 @@ int main(int argc, char **argv) {
     {
         if (option_softin) {
             header_found = find_softbinhead(fp, &hdb, &_mv, option_softin == 2);
+            if (dsp.opt_rxtime) gpx.tlm.rx_time = softin_rx_time(dsp.rx_t0);
         }
         else {                                                              // FM-audio:
             header_found = find_header(&dsp, thres, 2, bitofs, dsp.opt_dc); // optional 2nd pass: dc=0
             _mv = dsp.mv;
+            gpx.tlm.rx_time = dsp.rx_time;
         }
 
         if (header_found == EOF) break;
@@ -435,6 +435,107 @@ EPHEM_t *read_RNXpephs(FILE *fp) {
     return te;
 }
 
+/* ---------------------------------------------------------------------------------------------------- */
+// RINEX ephemerides indexed by PRN:
+//   read_RNXpephs() array regrouped by PRN (file order kept within a PRN),
+//   unhealthy records dropped; first[prn], count[prn] index the records of a PRN
+
+typedef struct {
+    EPHEM_t *ephs;
+    int first[33];
+    int count[33];
+} EPHIDX_t;
+
+int index_RNXpephs(EPHEM_t *ephs, EPHIDX_t *idx) {
+    int i, n, k, prn;
+    EPHEM_t *tmp;
+
+    memset(idx, 0, sizeof(*idx));
+    if (ephs == NULL) return -1;
+
+    n = 0;
+    while (ephs[n].prn > 0) n++;
+
+    tmp = calloc(n+1, sizeof(EPHEM_t));
+    if (tmp == NULL) return -1;
+
+    k = 0;
+    for (prn = 1; prn < 33; prn++) {
+        idx->first[prn] = k;
+        for (i = 0; i < n; i++) {
+            if (ephs[i].prn == prn && ephs[i].health == 0) tmp[k++] = ephs[i];
+        }
+        idx->count[prn] = k - idx->first[prn];
+    }
+    tmp[k].prn = 0;
+
+    memcpy(ephs, tmp, (k+1)*sizeof(EPHEM_t));
+    free(tmp);
+    idx->ephs = ephs;
+
+    return k;
+}
+
+// record with toe closest to t (first one on ties, as in the file); NULL if none
+EPHEM_t *best_RNXeph(EPHIDX_t *idx, int prn, double t, int *rollover) {
+    int i, ro;
+    double td, tdiff = SECONDS_IN_WEEK;
+    EPHEM_t *e, *best = NULL;
+
+    if (prn < 1 || prn > 32 || idx->ephs == NULL) return NULL;
+
+    for (i = 0; i < idx->count[prn]; i++) {
+        e = idx->ephs + idx->first[prn] + i;
+        if      (t - e->toe >  SECONDS_IN_WEEK/2) ro = +1;
+        else if (t - e->toe < -SECONDS_IN_WEEK/2) ro = -1;
+        else ro = 0;
+        td = fabs( t - e->toe - ro*SECONDS_IN_WEEK);
+        if ( td < tdiff ) {
+            tdiff = td;
+            best = e;
+            *rollover = ro;
+        }
+    }
+
+    return best;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+// satellite state at epoch t (memoized per PRN by the caller)
+
+typedef struct {
+    double t;         // GPS time of week of the state
+    EPHEM_t *rec;     // almanac/ephemeris record used
+    int week;
+    int vel;          // vX,vY,vZ, clock_drift valid
+    double X, Y, Z;
+    double vX, vY, vZ;
+    double clock_corr;
+    double clock_drift;
+} SATSTATE_t;
+
+// state at t+dt (|dt| <= ~1s) from a state with velocity, 2nd order Taylor with ECEF acceleration
+// (gravity, Coriolis, centrifugal); the neglected 3rd order term is below 1mm for |dt| = 1s
+void SAT_extrapolate(SATSTATE_t *st, double dt, SAT_t *sat) {
+    double r, g, w = EARTH_ROTATION_RATE;
+    double aX, aY, aZ;
+
+    r = sqrt(st->X*st->X + st->Y*st->Y + st->Z*st->Z);
+    g = -GRAVITY_CONSTANT/(r*r*r);
+    aX = g*st->X + 2*w*st->vY + w*w*st->X;
+    aY = g*st->Y - 2*w*st->vX + w*w*st->Y;
+    aZ = g*st->Z;
+
+    sat->X = st->X + st->vX*dt + 0.5*aX*dt*dt;
+    sat->Y = st->Y + st->vY*dt + 0.5*aY*dt*dt;
+    sat->Z = st->Z + st->vZ*dt + 0.5*aZ*dt*dt;
+    sat->vX = st->vX + aX*dt;
+    sat->vY = st->vY + aY*dt;
+    sat->vZ = st->vZ + aZ*dt;
+    sat->clock_corr = st->clock_corr + st->clock_drift*dt;
+    sat->clock_drift = st->clock_drift;
+}
+
 
 /* ---------------------------------------------------------------------------------------------------- */
 //
@@ -1890,3 +1991,137 @@ int NAV_LinV(int N, SAT_t satv[], double pos_ecef[3],
     return 0;
 }
 
+
+/* ---------------------------------------------------------------------------------------------------- */
+// iterative weighted least squares over all sats, with fault detection and exclusion (RAIM)
+//
+//   model (cf. NAV_LinP):  pseudorange + clock_corr = |rotZ(sat) - pos| - dt
+//   weights: sin^2(elevation), floor WLS_WMIN
+//   fault detection: normalized residual sqrt(w_i)|r_i|/sqrt(1-h_ii) > thres [m],
+//                    i.e. the residual over its standard deviation, in units of the zenith pseudorange sigma;
+//                    exclude the worst sat and solve again (while N > 5)
+
+#define WLS_ITER   10
+#define WLS_CONV   1e-3   // [m]
+#define WLS_WMIN   0.05
+#define WLS_RAIM_THRES  30.0  // [m] exclusion threshold, ~3-6 sigma of a healthy pseudorange
+
+static int wls_iter(int N, SAT_t satv[], int used[], double pos_ecef[3], double *cc,
+                    double res[], double nres[], double *rms) {
+    int i, j, k, it;
+    double A[12][4], w[12], a[12];
+    double AtWA[4][4], Ninv[4][4], rhs[4], dx[4];
+    double S[3], norm, range, up[3], rpos, sinel;
+    double dt = *cc, sw, swr, h, d;
+
+    for (it = 0; it <= WLS_ITER; it++) {
+
+        rpos = sqrt(pos_ecef[0]*pos_ecef[0] + pos_ecef[1]*pos_ecef[1] + pos_ecef[2]*pos_ecef[2]);
+        for (j = 0; j < 3; j++) up[j] = rpos > 1e6 ? pos_ecef[j]/rpos : 0.0;
+
+        for (i = 0; i < N; i++) {
+            if (!used[i]) continue;
+            range = dist( pos_ecef[0], pos_ecef[1], pos_ecef[2], satv[i].X, satv[i].Y, satv[i].Z );
+            range /= LIGHTSPEED;
+            if (range < 0.06  ||  range > 0.1) range = RANGE_ESTIMATE;
+            rotZ(satv[i].X, satv[i].Y, satv[i].Z, EARTH_ROTATION_RATE*range, S, S+1, S+2);
+            for (j = 0; j < 3; j++) S[j] -= pos_ecef[j];
+            norm = sqrt(S[0]*S[0]+S[1]*S[1]+S[2]*S[2]);
+            for (j = 0; j < 3; j++) A[i][j] = S[j]/norm;
+            A[i][3] = 1;
+
+            sinel = rpos > 1e6 ? A[i][0]*up[0] + A[i][1]*up[1] + A[i][2]*up[2] : 1.0;
+            w[i] = sinel*sinel;
+            if (sinel < 0 || w[i] < WLS_WMIN) w[i] = WLS_WMIN;
+
+            a[i] = norm - (satv[i].pseudorange + satv[i].clock_corr);  // + dt
+        }
+
+        if (it == 0) {  // clock bias from the seed position
+            sw = swr = 0.0;
+            for (i = 0; i < N; i++) {
+                if (!used[i]) continue;
+                sw += w[i];
+                swr += w[i]*a[i];
+            }
+            dt = swr/sw;
+        }
+        for (i = 0; i < N; i++) a[i] -= dt;
+
+        for (j = 0; j < 4; j++) {
+            rhs[j] = 0.0;
+            for (k = 0; k < 4; k++) {
+                AtWA[j][k] = 0.0;
+                for (i = 0; i < N; i++) {
+                    if (used[i]) AtWA[j][k] += w[i]*A[i][j]*A[i][k];
+                }
+            }
+            for (i = 0; i < N; i++) {
+                if (used[i]) rhs[j] += w[i]*A[i][j]*a[i];
+            }
+        }
+        if (matrix_invert(AtWA, Ninv) != 0) return -1;
+
+        if (it == WLS_ITER) return -1;  // no convergence
+
+        for (j = 0; j < 4; j++) {
+            dx[j] = 0.0;
+            for (k = 0; k < 4; k++) dx[j] += Ninv[j][k]*rhs[k];
+        }
+        for (j = 0; j < 3; j++) pos_ecef[j] += dx[j];
+        dt += dx[3];
+
+        if (dist(0, 0, 0, dx[0], dx[1], dx[2]) < WLS_CONV) break;
+    }
+
+    // post-fit residuals (linearized at the previous iterate; the last step is < WLS_CONV)
+    sw = swr = 0.0;
+    for (i = 0; i < N; i++) {
+        if (!used[i]) continue;
+        d = 0.0;
+        for (j = 0; j < 4; j++) d += A[i][j]*dx[j];
+        res[i] = d - a[i];
+        h = 0.0;
+        for (j = 0; j < 4; j++) {
+            for (k = 0; k < 4; k++) h += A[i][j]*Ninv[j][k]*A[i][k];
+        }
+        h *= w[i];
+        nres[i] = h < 1.0-1e-6 ? sqrt(w[i])*fabs(res[i])/sqrt(1.0-h) : 0.0;
+        sw += w[i];
+        swr += w[i]*res[i]*res[i];
+    }
+    *rms = sqrt(swr/sw);
+    *cc = dt;
+
+    return 0;
+}
+
+int NAV_WLS(int N, SAT_t satv[], double pos_ecef[3], double *cc, int used[], double thres, double *rms) {
+    int i, n, kmax;
+    double res[12], nres[12];
+    double pos0[3];
+
+    if (N < 4 || N > 12) return -1;
+
+    for (i = 0; i < N; i++) used[i] = 1;
+    n = N;
+
+    for (;;) {
+        for (i = 0; i < 3; i++) pos0[i] = pos_ecef[i];
+        if (wls_iter(N, satv, used, pos_ecef, cc, res, nres, rms) < 0) return -1;
+
+        if (n <= 5) break;  // N=5: a fault can be detected, but not identified
+
+        kmax = -1;
+        for (i = 0; i < N; i++) {
+            if (used[i] && (kmax < 0 || nres[i] > nres[kmax])) kmax = i;
+        }
+        if (nres[kmax] <= thres) break;
+
+        used[kmax] = 0;
+        n -= 1;
+        for (i = 0; i < 3; i++) pos_ecef[i] = pos0[i];  // seed again, not from the faulty fix
+    }
+
+    return n;
+}
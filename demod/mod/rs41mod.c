@@ -19,6 +19,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
 
 #ifdef CYGWIN
   #include <fcntl.h>  // cygwin: _setmode()
@@ -43,6 +50,8 @@
 //typedef int   i32_t;
 
 #include "demod_mod.h"
+#include "sonde_tlm.h"
+#include "frm_queue.h"
 
 //#define  INCLUDESTATIC 1
 #ifdef INCLUDESTATIC
@@ -57,6 +66,7 @@ typedef struct {
     i8_t raw;  // raw frames
     i8_t crc;  // CRC check output
     i8_t ecc;  // Reed-Solomon ECC
+    i8_t emt;  // --ecc_mt: cw1/cw2 erasure search in 2 threads
     i8_t sat;  // GPS sat data
     i8_t ptu;  // PTU: temperature humidity (pressure)
     i8_t dwp;  // PTU derived: dew point
@@ -64,6 +74,7 @@ typedef struct {
     i8_t inv;
     i8_t aut;
     i8_t jsn;  // JSON output (auto_rx)
+    i8_t jsb;  // --jsnbin: JSON as binary record (sonde_tlm.h)
     i8_t slt;  // silent (only raw/json)
     i8_t cal;  // json cal/conf
 } option_t;
@@ -104,6 +115,28 @@ typedef struct {
     ui8_t status;
 } gnss_t;
 
+// calibration cache (--calcache <file>): one slot per sonde, file mapped shared
+#define CALCACHE_MAGIC    0x43434C52  // "RLCC"
+#define CALCACHE_VERSION  1
+#define CALCACHE_SLOTS    64
+#define CALCACHE_PRELOAD  (4*3600)    // sec: max age of a slot for --jsn_cfq preload
+
+typedef struct {
+    char   id[8];
+    ui32_t t_used;         // unix time of last update
+    ui8_t  calfrchk[51];   // 0x00..0x31 (0x32 not constant, not cached)
+    ui8_t  res[5];
+    ui8_t  calibytes[51*16];
+} calslot_t;  // 884 bytes
+
+typedef struct {
+    ui32_t magic;
+    ui32_t version;
+    ui32_t nslots;
+    ui32_t slotlen;
+    calslot_t slot[CALCACHE_SLOTS];
+} calcache_t;
+
 typedef struct {
     int out;
     int frnr;
@@ -159,6 +192,10 @@ typedef struct {
     option_t option;
     RS_t RS;
     ecdat_t ecdat;
+    tlm_t tlm;
+    int calcache_fd;
+    calcache_t *calcache;
+    calslot_t *calslot;   // slot of gpx->id
 } gpx_t;
 
 
@@ -454,6 +491,158 @@ static int get_BattVolts(gpx_t *gpx, int ofs) {
     return 0;
 }
 
+/* ------------------------------------------------------------------------------------ */
+/*
+ *  calibration cache
+ *    the cal/conf subframes 0x00..0x31 are constant for a sonde; the cache file keeps
+ *    them across decoder restarts (PTU and --ecc4 known bytes from the first frame).
+ *    subframes are written to the mapped file as they arrive; several decoders
+ *    can share the file (slot allocation under flock()).
+ */
+
+static calcache_t *calcache_open(gpx_t *gpx, const char *fname) {
+    calcache_t *cc = NULL;
+    struct stat st;
+    int fd;
+
+    fd = open(fname, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return NULL;
+
+    flock(fd, LOCK_EX);
+    if (fstat(fd, &st) < 0 || (st.st_size != sizeof(calcache_t) && ftruncate(fd, sizeof(calcache_t)) < 0)) {
+        flock(fd, LOCK_UN);
+        close(fd);
+        return NULL;
+    }
+    cc = mmap(NULL, sizeof(calcache_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (cc == MAP_FAILED) {
+        flock(fd, LOCK_UN);
+        close(fd);
+        return NULL;
+    }
+    if (cc->magic != CALCACHE_MAGIC || cc->version != CALCACHE_VERSION
+     || cc->nslots != CALCACHE_SLOTS || cc->slotlen != sizeof(calslot_t))
+    {   // new file or other layout
+        memset(cc, 0, sizeof(calcache_t));
+        cc->version = CALCACHE_VERSION;
+        cc->nslots = CALCACHE_SLOTS;
+        cc->slotlen = sizeof(calslot_t);
+        cc->magic = CALCACHE_MAGIC;
+    }
+    flock(fd, LOCK_UN);
+
+    gpx->calcache_fd = fd;
+    gpx->calcache = cc;
+    gpx->calslot = NULL;
+
+    return cc;
+}
+
+static void calcache_close(gpx_t *gpx) {
+    if (gpx->calcache) {
+        munmap(gpx->calcache, sizeof(calcache_t));
+        close(gpx->calcache_fd);
+        gpx->calcache = NULL;
+        gpx->calslot = NULL;
+    }
+}
+
+// copy cached subframes of gpx->calslot, and the conf data of get_Calconf()
+static void calcache_restore(gpx_t *gpx) {
+    calslot_t *sl = gpx->calslot;
+    ui8_t *cb = gpx->calibytes;
+    int i;
+
+    for (i = 0; i < 0x32; i++) {
+        if (sl->calfrchk[i] && !gpx->calfrchk[i]) {
+            memcpy(cb+16*i, sl->calibytes+16*i, 16);
+            gpx->calfrchk[i] = 1;
+        }
+    }
+
+    // subframe byte j: frame[pos_CalData+1+j]
+    if (gpx->calfrchk[0x00]) gpx->freq = 400000 + 40*cb[0x00*16+3] + ((cb[0x00*16+2] & 0xC0)*10)/64;  // pos_Calfreq
+    if (gpx->calfrchk[0x01]) gpx->conf_fw = cb[0x01*16+5] | (cb[0x01*16+6]<<8);
+    if (gpx->calfrchk[0x02]) {
+        gpx->conf_bk = cb[0x02*16+11];  // pos_Calburst
+        gpx->conf_kt = cb[0x02*16+7] | (cb[0x02*16+8]<<8);
+    }
+    if (gpx->calfrchk[0x31]) gpx->conf_bt = cb[0x31*16+6] | (cb[0x31*16+7]<<8);
+    if (gpx->calfrchk[0x21] && gpx->calfrchk[0x22]) {
+        memset(gpx->rstyp, 0, 10);
+        for (i = 0; i < 9; i++) {  // pos_CalRSTyp, pos_CalRSTyp2
+            ui8_t byte = (i < 8) ? cb[0x21*16+8+i] : cb[0x22*16+0];
+            if ((byte >= 0x20) && (byte < 0x7F)) gpx->rstyp[i] = byte;
+        }
+        memset(gpx->rsm, 0, 10);
+        for (i = 0; i < 8; i++) {  // pos_CalRSM
+            ui8_t byte = cb[0x22*16+2+i];
+            if ((byte >= 0x20) && (byte < 0x7F)) gpx->rsm[i] = byte;
+        }
+    }
+}
+
+// slot of new gpx->id (least recently used slot if not cached)
+static void calcache_load(gpx_t *gpx) {
+    calcache_t *cc = gpx->calcache;
+    calslot_t *sl = NULL;
+    int i;
+
+    flock(gpx->calcache_fd, LOCK_EX);
+    for (i = 0; i < CALCACHE_SLOTS; i++) {
+        if (strncmp(cc->slot[i].id, gpx->id, 8) == 0) { sl = cc->slot+i; break; }
+    }
+    if (sl == NULL) {
+        sl = cc->slot;
+        for (i = 1; i < CALCACHE_SLOTS; i++) {
+            if (cc->slot[i].t_used < sl->t_used) sl = cc->slot+i;
+        }
+        memset(sl, 0, sizeof(calslot_t));
+        memcpy(sl->id, gpx->id, 8);
+    }
+    sl->t_used = time(NULL);
+    flock(gpx->calcache_fd, LOCK_UN);
+
+    gpx->calslot = sl;
+    calcache_restore(gpx);
+}
+
+static void calcache_store(gpx_t *gpx, ui8_t calfr) {
+    calslot_t *sl = gpx->calslot;
+
+    if (sl == NULL || calfr >= 0x32) return;
+    if (sl->calfrchk[calfr] == 0) {
+        memcpy(sl->calibytes+16*calfr, gpx->calibytes+16*calfr, 16);
+        sl->calfrchk[calfr] = 1;  // after the data
+    }
+    sl->t_used = time(NULL);
+}
+
+// --jsn_cfq: most recent sonde on this frequency (cal subframe 0x00), probably the same after a restart;
+// a frame with a different ID resets gpx (get_SondeID())
+static int calcache_preload(gpx_t *gpx, int freq_khz) {
+    calcache_t *cc = gpx->calcache;
+    calslot_t *sl = NULL;
+    ui32_t now = time(NULL);
+    int i, f;
+
+    for (i = 0; i < CALCACHE_SLOTS; i++) {
+        calslot_t *s = cc->slot+i;
+        if (s->id[0] == 0 || s->calfrchk[0] == 0 || now - s->t_used > CALCACHE_PRELOAD) continue;
+        f = 400000 + 40*s->calibytes[3] + ((s->calibytes[2] & 0xC0)*10)/64;  // pos_Calfreq
+        if (abs(f - freq_khz) > 5) continue;
+        if (sl == NULL || s->t_used > sl->t_used) sl = s;
+    }
+    if (sl == NULL) return -1;
+
+    memcpy(gpx->id, sl->id, 8);
+    gpx->id[8] = '\0';
+    gpx->calslot = sl;
+    calcache_restore(gpx);
+
+    return 0;
+}
+
 static int get_SondeID(gpx_t *gpx, int crc, int ofs) {
     int i;
     unsigned byte;
@@ -501,6 +690,8 @@ static int get_SondeID(gpx_t *gpx, int crc, int ofs) {
             gpx->id[8] = '\0';
 
             gpx->ecdat.last_frnb = 0;
+
+            if (gpx->calcache) calcache_load(gpx);
         }
     }
 
@@ -528,6 +719,7 @@ static int get_FrameConf(gpx_t *gpx, int ofs) {
                 gpx->calibytes[calfr*16 + i] = gpx->frame[pos_CalData+ofs+1+i];
             }
             gpx->calfrchk[calfr] = 1;
+            calcache_store(gpx, calfr);
         }
 
         gpx->ecdat.last_calfrm = calfr;
@@ -1700,16 +1892,83 @@ static int inFixed(gpx_t *gpx, int idx, int *frmset, int setcnt) {
 #define rs_R 24
 #define rs_K (rs_N-rs_R)
 
+// 3rd pass, one codeword (only reads gpx)
+typedef struct {
+    gpx_t *gpx;
+    int   *sort_idx;  // ecdat.sort_idx1/2
+    int    parofs;    // parity in frame: cw1: parpos+0, cw2: parpos+rs_R
+    int   *frmset;
+    int    setcnt;
+    ui8_t *cw;
+    ui8_t *err_pos;
+    ui8_t *err_val;
+    int    errors;
+} erasrch_t;
+
+static int frm2cw(int pos_frm, int parofs) {
+    if (pos_frm < cfg_rs41.msgpos) return pos_frm - cfg_rs41.parpos - parofs;
+    else                           return rs_R + (pos_frm - cfg_rs41.msgpos)/2;
+}
+
+static void *rs41_erasrch(void *arg) {
+    erasrch_t *es = (erasrch_t *)arg;
+    gpx_t *gpx = es->gpx;
+    int i, j, k;
+    int pos_cw = 0;
+    int pos_frm = 0;
+    ui8_t era_pos[rs_R];
+    ui8_t Era_max = 12; // iteration depth 2..255 (2 erasures for 1 error)
+
+    if (es->errors >= 0) return NULL;
+
+    for (i = 1; i < Era_max; i++) {
+        pos_frm = es->sort_idx[i];
+        if (inFixed(gpx, pos_frm, es->frmset, es->setcnt)) continue;
+        pos_cw = frm2cw(pos_frm, es->parofs);
+        if (pos_cw < 0 || pos_cw > 254) continue;
+        era_pos[0] = pos_cw;
+        for (j = 0; j < i; j++) {
+            pos_frm = es->sort_idx[j];
+            if (inFixed(gpx, pos_frm, es->frmset, es->setcnt)) continue;
+            pos_cw = frm2cw(pos_frm, es->parofs);
+            if (pos_cw < 0 || pos_cw > 254) continue;
+            era_pos[1] = pos_cw;
+
+            //k = -1;
+            for (k = -1; k < j; k++)  // toggle low-score bits
+            {
+                if (k >= 0) {
+                    pos_frm = es->sort_idx[k];
+                    if (inFixed(gpx, pos_frm, es->frmset, es->setcnt)) continue;
+                    else {
+                        pos_cw = frm2cw(pos_frm, es->parofs);
+                        if (pos_cw < 0 || pos_cw > 254) continue;
+                        es->cw[pos_cw] ^= gpx->dfrm_bitscore[pos_frm];
+                    }
+                }
+
+                es->errors = rs_decode_ErrEra(&gpx->RS, es->cw, 2, era_pos, es->err_pos, es->err_val);
+                if (es->errors >= 0) { j = 256; i = 256; k = 256; } //break;
+                //else if (k >= 0) { es->cw[pos_cw] ^= gpx->dfrm_bitscore[pos_frm]; }
+            }
+        }
+    }
+
+    return NULL;
+}
+
 static int rs41_ecc(gpx_t *gpx, int frmlen) {
 // richtige framelen wichtig fuer 0-padding
 
-    int i, j, k, leak, ret = 0;
+    int i, leak, ret = 0;
     int errors1, errors2;
     ui8_t cw1[rs_N], cw2[rs_N];
     ui8_t err_pos1[rs_R], err_pos2[rs_R],
           err_val1[rs_R], err_val2[rs_R];
-    ui8_t era_pos[rs_R];
-    ui8_t Era_max = 12; // iteration depth 2..255 (2 erasures for 1 error)
+    ui8_t *cws[2] = { cw1, cw2 };
+    ui8_t *err_pos[2] = { err_pos1, err_pos2 },
+          *err_val[2] = { err_val1, err_val2 };
+    int errs[2];
 
     int frmset[FRAME_LEN];
     int setcnt = 0;
@@ -1731,8 +1990,9 @@ static int rs41_ecc(gpx_t *gpx, int frmlen) {
     for (i = 0; i < rs_K; i++) cw1[rs_R+i] = gpx->frame[cfg_rs41.msgpos+2*i  ];
     for (i = 0; i < rs_K; i++) cw2[rs_R+i] = gpx->frame[cfg_rs41.msgpos+2*i+1];
 
-    errors1 = rs_decode(&gpx->RS, cw1, err_pos1, err_val1);
-    errors2 = rs_decode(&gpx->RS, cw2, err_pos2, err_val2);
+    rs_decode_batch(&gpx->RS, 2, cws, errs, err_pos, err_val);
+    errors1 = errs[0];
+    errors2 = errs[1];
 
 
     if (gpx->option.ecc >= 2 && (errors1 < 0 || errors2 < 0))
@@ -1757,8 +2017,9 @@ static int rs41_ecc(gpx_t *gpx, int frmlen) {
         }
         for (i = 0; i < rs_K; i++) cw1[rs_R+i] = gpx->frame[cfg_rs41.msgpos+2*i  ];
         for (i = 0; i < rs_K; i++) cw2[rs_R+i] = gpx->frame[cfg_rs41.msgpos+2*i+1];
-        errors1 = rs_decode(&gpx->RS, cw1, err_pos1, err_val1);
-        errors2 = rs_decode(&gpx->RS, cw2, err_pos2, err_val2);
+        rs_decode_batch(&gpx->RS, 2, cws, errs, err_pos, err_val);
+        errors1 = errs[0];
+        errors2 = errs[1];
     }
 
     if (gpx->option.ecc == 4)  // set (probably) known bytes (if same rs41)
@@ -1857,86 +2118,21 @@ static int rs41_ecc(gpx_t *gpx, int frmlen) {
 
     if (gpx->option.ecc > 2)
     {
-        int pos_cw = 0;
-        int pos_frm = 0;
-
-        if (errors1 < 0)
-        {
-            for (i = 1; i < Era_max; i++) {
-                pos_frm = gpx->ecdat.sort_idx1[i];
-                if (inFixed(gpx, pos_frm, frmset, setcnt)) continue;
-                if (pos_frm < cfg_rs41.msgpos) pos_cw = pos_frm - cfg_rs41.parpos;
-                else                           pos_cw = rs_R + (pos_frm - cfg_rs41.msgpos)/2;
-                if (pos_cw < 0 || pos_cw > 254) continue;
-                era_pos[0] = pos_cw;
-                for (j = 0; j < i; j++) {
-                    pos_frm = gpx->ecdat.sort_idx1[j];
-                    if (inFixed(gpx, pos_frm, frmset, setcnt)) continue;
-                    if (pos_frm < cfg_rs41.msgpos) pos_cw = pos_frm - cfg_rs41.parpos;
-                    else                           pos_cw = rs_R + (pos_frm - cfg_rs41.msgpos)/2;
-                    if (pos_cw < 0 || pos_cw > 254) continue;
-                    era_pos[1] = pos_cw;
-
-                    //k = -1;
-                    for (k = -1; k < j; k++)  // toggle low-score bits
-                    {
-                        if (k >= 0) {
-                            pos_frm = gpx->ecdat.sort_idx1[k];
-                            if (inFixed(gpx, pos_frm, frmset, setcnt)) continue;
-                            else {
-                                if (pos_frm < cfg_rs41.msgpos) pos_cw = pos_frm - cfg_rs41.parpos;
-                                else                           pos_cw = rs_R + (pos_frm - cfg_rs41.msgpos)/2;
-                                if (pos_cw < 0 || pos_cw > 254) continue;
-                                cw1[pos_cw] ^= gpx->dfrm_bitscore[pos_frm];
-                            }
-                        }
+        erasrch_t es1 = { gpx, gpx->ecdat.sort_idx1, 0,    frmset, setcnt, cw1, err_pos1, err_val1, errors1 };
+        erasrch_t es2 = { gpx, gpx->ecdat.sort_idx2, rs_R, frmset, setcnt, cw2, err_pos2, err_val2, errors2 };
+        pthread_t thr2;
+        int thr = 0;
 
-                        errors1 = rs_decode_ErrEra(&gpx->RS, cw1, 2, era_pos, err_pos1, err_val1);
-                        if (errors1 >= 0) { j = 256; i = 256; k = 256; } //break;
-                        //else if (k >= 0) { cw1[pos_cw] ^= gpx->dfrm_bitscore[pos_frm]; }
-                    }
-                }
-            }
+        // cw1 and cw2 are independent: search cw2 in a 2nd thread
+        if (gpx->option.emt && errors1 < 0 && errors2 < 0) {
+            thr = (pthread_create(&thr2, NULL, rs41_erasrch, &es2) == 0);
         }
+        rs41_erasrch(&es1);
+        if (thr) pthread_join(thr2, NULL);
+        else     rs41_erasrch(&es2);
 
-        if (errors2 < 0)
-        {
-            for (i = 1; i < Era_max; i++) {
-                pos_frm = gpx->ecdat.sort_idx2[i];
-                if (inFixed(gpx, pos_frm, frmset, setcnt)) continue;
-                if (pos_frm < cfg_rs41.msgpos) pos_cw = pos_frm - cfg_rs41.parpos - rs_R;
-                else                           pos_cw = rs_R + (pos_frm - cfg_rs41.msgpos)/2;
-                if (pos_cw < 0 || pos_cw > 254) continue;
-                era_pos[0] = pos_cw;
-                for (j = 0; j < i; j++) {
-                    pos_frm = gpx->ecdat.sort_idx2[j];
-                    if (inFixed(gpx, pos_frm, frmset, setcnt)) continue;
-                    if (pos_frm < cfg_rs41.msgpos) pos_cw = pos_frm - cfg_rs41.parpos - rs_R;
-                    else                           pos_cw = rs_R + (pos_frm - cfg_rs41.msgpos)/2;
-                    if (pos_cw < 0 || pos_cw > 254) continue;
-                    era_pos[1] = pos_cw;
-
-                    //k = -1;
-                    for (k = -1; k < j; k++)  // toggle low-score bits
-                    {
-                        if (k >= 0) {
-                            pos_frm = gpx->ecdat.sort_idx2[k];
-                            if (inFixed(gpx, pos_frm, frmset, setcnt)) continue;
-                            else {
-                                if (pos_frm < cfg_rs41.msgpos) pos_cw = pos_frm - cfg_rs41.parpos - rs_R;
-                                else                           pos_cw = rs_R + (pos_frm - cfg_rs41.msgpos)/2;
-                                if (pos_cw < 0 || pos_cw > 254) continue;
-                                cw2[pos_cw] ^= gpx->dfrm_bitscore[pos_frm];
-                            }
-                        }
-
-                        errors2 = rs_decode_ErrEra(&gpx->RS, cw2, 2, era_pos, err_pos2, err_val2);
-                        if (errors2 >= 0) { j = 256; i = 256; k = 256; } //break;
-                        //else if (k >= 0) { cw2[pos_cw] ^= gpx->dfrm_bitscore[pos_frm]; }
-                    }
-                }
-            }
-        }
+        errors1 = es1.errors;
+        errors2 = es2.errors;
     }
 
 
@@ -2304,92 +2500,91 @@ static int print_position(gpx_t *gpx, int ec) {
                     if ( !err && ((!err1 && !err3) || !err13 || encrypted) ) { // frame-nb/id && gps-time && gps-position  (crc-)ok; 3 CRCs, RS not needed
                         // eigentlich GPS, d.h. UTC = GPS - 18sec (ab 1.1.2017)
                         char *ver_jsn = NULL;
-                        fprintf(stdout, "{ \"type\": \"%s\"", "RS41");
-                        fprintf(stdout, ", \"frame\": %d, \"id\": \"%s\", \"datetime\": \"%04d-%02d-%02dT%02d:%02d:%06.3fZ\", \"lat\": %.5f, \"lon\": %.5f, \"alt\": %.5f, \"vel_h\": %.5f, \"heading\": %.5f, \"vel_v\": %.5f, \"sats\": %d, \"bt\": %d, \"batt\": %.2f",
-                                       gpx->frnr, gpx->id, gpx->jahr, gpx->monat, gpx->tag, gpx->std, gpx->min, gpx->sek, gpx->lat, gpx->lon, gpx->alt, gpx->vH, gpx->vD, gpx->vV, gpx->numSV, gpx->conf_cd, gpx->batt );
+                        tlm_t *t = &gpx->tlm;
+                        tlm_begin(t, "RS41");
+                        tlm_int(t, TLM_FRAME, gpx->frnr);
+                        tlm_str(t, TLM_ID, gpx->id);
+                        tlm_datetime(t, gpx->jahr, gpx->monat, gpx->tag, gpx->std, gpx->min, gpx->sek, 3);
+                        tlm_flt(t, TLM_LAT, gpx->lat, 5);
+                        tlm_flt(t, TLM_LON, gpx->lon, 5);
+                        tlm_flt(t, TLM_ALT, gpx->alt, 5);
+                        tlm_flt(t, TLM_VEL_H, gpx->vH, 5);
+                        tlm_flt(t, TLM_HEADING, gpx->vD, 5);
+                        tlm_flt(t, TLM_VEL_V, gpx->vV, 5);
+                        tlm_int(t, TLM_SATS, gpx->numSV);
+                        tlm_int(t, TLM_BT, gpx->conf_cd);
+                        tlm_flt(t, TLM_BATT, gpx->batt, 2);
                         if (gpx->option.ptu && !err0) {
                             float _RH = gpx->RH;
                             if (gpx->option.ptu == 2) _RH = gpx->RH2;
                             if (gpx->T > -273.0) {
-                                fprintf(stdout, ", \"temp\": %.1f",  gpx->T );
+                                tlm_flt(t, TLM_TEMP, gpx->T, 1);
                             }
                             if (_RH > -0.5) {
-                                fprintf(stdout, ", \"humidity\": %.1f",  _RH );
+                                tlm_flt(t, TLM_HUMIDITY, _RH, 1);
                             }
                             if (gpx->P > 0.0) {
-                                fprintf(stdout, ", \"pressure\": %.2f",  gpx->P );
+                                tlm_flt(t, TLM_PRESSURE, gpx->P, 2);
                             }
                         }
                         if (gpx->aux) { // <=> gpx->xdata[0]!='\0'
-                            fprintf(stdout, ", \"aux\": \"%s\"",  gpx->xdata );
+                            tlm_str(t, TLM_AUX, gpx->xdata);
                         }
                         if (encrypted) {
-                            fprintf(stdout, ", \"subtype\": \"RS41-SGM\", \"encrypted\": true");
+                            tlm_str(t, TLM_SUBTYPE, "RS41-SGM");
+                            tlm_bool(t, TLM_ENCRYPTED, 1);
                         } else {
-                            fprintf(stdout, ", \"subtype\": \"%s\"",  *gpx->rstyp ? gpx->rstyp : "RS41" );  // RS41-SG(P/M)
+                            tlm_str(t, TLM_SUBTYPE, *gpx->rstyp ? gpx->rstyp : "RS41");  // RS41-SG(P/M)
                             if (strncmp(gpx->rstyp, "RS41-SGM", 8) == 0) {
-                                fprintf(stdout, ", \"encrypted\": false");
+                                tlm_bool(t, TLM_ENCRYPTED, 0);
                             }
                         }
                         if (gpx->jsn_freq > 0) {  // rs41-frequency: gpx->freq
                             int fq_kHz = gpx->jsn_freq;
                             if (gpx->freq > 0) fq_kHz = gpx->freq;
-                            fprintf(stdout, ", \"freq\": %d", fq_kHz);
+                            tlm_int(t, TLM_FREQ, fq_kHz);
                         }
                         if (*gpx->rsm) {  // RSM type
-                            fprintf(stdout, ", \"rs41_mainboard\": \"%s\"", gpx->rsm);
+                            tlm_str(t, TLM_RS41_MAINBOARD, gpx->rsm);
                         }
                         if (gpx->conf_fw) {  // firmware
-                            fprintf(stdout, ", \"rs41_mainboard_fw\": %d", gpx->conf_fw);
+                            tlm_int(t, TLM_RS41_MAINBOARD_FW, gpx->conf_fw);
                         }
 
                         if (gpx->option.cal == 1) {  // cal/conf
-                            int _j;
                             if ( !gpx->calconf_sent && gpx->calconf_complete ) {
-                                /*
-                                fprintf(stdout, ", \"rs41_calconf320h\": \""); // only constant/crc part
-                                for (int _j = 0; _j < 50*16; _j++) {
-                                    fprintf(stdout, "%02X", gpx->calibytes[_j]);
-                                }
-                                */
-                                fprintf(stdout, ", \"rs41_calconf51x16\": \"");
-                                for (_j = 0; _j < 51*16; _j++) {
-                                    fprintf(stdout, "%02X", gpx->calibytes[_j]);
-                                }
-                                fprintf(stdout, "\"");
+                                // rs41_calconf320h: only constant/crc part, 50*16 bytes
+                                tlm_hex(t, TLM_RS41_CALCONF51X16, gpx->calibytes, 51*16);
                                 gpx->calconf_sent = 1;
                             }
                             if (gpx->calconf_subfrm[0] == 0x32) {
-                                fprintf(stdout, ", \"rs41_conf0x32\": \"");
-                                for (_j = 0; _j < 16; _j++) {
-                                    fprintf(stdout, "%02X", gpx->calconf_subfrm[1+_j]);
-                                }
-                                fprintf(stdout, "\"");
+                                tlm_hex(t, TLM_RS41_CONF0X32, gpx->calconf_subfrm+1, 16);
                             }
                         }
                         if (gpx->option.cal == 2) {  // cal/conf
+                            char subfrm[8+2*16];
                             int _j;
-                            fprintf(stdout, ", \"rs41_subfrm\": \"0x%02X:", gpx->calconf_subfrm[0]);
+                            sprintf(subfrm, "0x%02X:", gpx->calconf_subfrm[0]);
                             for (_j = 0; _j < 16; _j++) {
-                                fprintf(stdout, "%02X", gpx->calconf_subfrm[1+_j]);
+                                sprintf(subfrm+5+2*_j, "%02X", gpx->calconf_subfrm[1+_j]);
                             }
-                            fprintf(stdout, "\"");
+                            tlm_str(t, TLM_RS41_SUBFRM, subfrm);
                         }
 
                         // Include frequency derived from subframe information if available.
                         if (gpx->freq > 0) {
-                            fprintf(stdout, ", \"tx_frequency\": %d", gpx->freq );
+                            tlm_int(t, TLM_TX_FREQUENCY, gpx->freq);
                         }
 
                         // Reference time/position      (fw 0x50dd: datetime UTC)
-                        fprintf(stdout, ", \"ref_datetime\": \"%s\"", gpx->isUTC ? "UTC" : "GPS" ); // {"GPS", "UTC"} GPS-UTC=leap_sec
-                        fprintf(stdout, ", \"ref_position\": \"%s\"", "GPS" ); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid
+                        tlm_str(t, TLM_REF_DATETIME, gpx->isUTC ? "UTC" : "GPS"); // {"GPS", "UTC"} GPS-UTC=leap_sec
+                        tlm_str(t, TLM_REF_POSITION, "GPS"); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid
 
                         #ifdef VER_JSN_STR
                             ver_jsn = VER_JSN_STR;
                         #endif
-                        if (ver_jsn && *ver_jsn != '\0') fprintf(stdout, ", \"version\": \"%s\"", ver_jsn);
-                        fprintf(stdout, " }\n");
+                        if (ver_jsn && *ver_jsn != '\0') tlm_str(t, TLM_VERSION_STR, ver_jsn);
+                        tlm_out(t, stdout, gpx->option.jsb);
                         fprintf(stdout, "\n");
                     }
                 }
@@ -2555,6 +2750,53 @@ static void print_frame(gpx_t *gpx, int len) {
 /* -------------------------------------------------------------------------- */
 
 
+/* -------------------------------------------------------------------------- */
+
+// --mt: the demodulator (main thread) queues the received frames,
+//       ECC/parsing/output run in the frame thread
+
+typedef struct {
+    int   len;    // bytes received
+    float ts;
+    double rx_time;  // wall clock of the header (--rxtime)
+    float bytescore[FRAME_LEN];
+    ui8_t bitscore[FRAME_LEN];
+    ui8_t frame[FRAME_LEN];
+} rs41frm_t;
+
+typedef struct {
+    gpx_t  *gpx;
+    frmq_t *q;
+} frmthr_t;
+
+static void proc_frame(gpx_t *gpx, rs41frm_t *f) {
+    int n = f->len - FRAMESTART;
+
+    // frame[len..]: previous frame (EOF)
+    if (n > 0) {
+        memcpy(gpx->frame+FRAMESTART, f->frame+FRAMESTART, n);
+        memcpy(gpx->ecdat.frm_bytescore+FRAMESTART, f->bytescore+FRAMESTART, n*sizeof(float));
+        memcpy(gpx->dfrm_bitscore+FRAMESTART, f->bitscore+FRAMESTART, n);
+    }
+    gpx->ecdat.ts = f->ts;
+    gpx->tlm.rx_time = f->rx_time;
+
+    print_frame(gpx, f->len);
+}
+
+static void *rs41_frmthr(void *arg) {
+    frmthr_t *ft = (frmthr_t *)arg;
+    rs41frm_t *f;
+
+    while ( (f = frmq_rslot(ft->q)) != NULL ) {
+        proc_frame(ft->gpx, f);
+        frmq_pop(ft->q);
+    }
+
+    return NULL;
+}
+
+
 int main(int argc, char *argv[]) {
 
     //int option_inv = 0;    // invertiert Signal
@@ -2571,9 +2813,12 @@ int main(int argc, char *argv[]) {
     int sel_wavch = 0;     // audio channel: left
     int rawhex = 0, xorhex = 0;
     int cfreq = -1;
+    int option_mt = 0;
 
     FILE *fp;
     char *fpname = NULL;
+    char *shm_name = NULL;
+    char *calcache_name = NULL;
 
     int k;
 
@@ -2605,6 +2850,12 @@ int main(int argc, char *argv[]) {
     hdb_t hdb = {0};
     float softbits[BITS];
 
+    rs41frm_t frm1;
+    rs41frm_t *frm = &frm1;
+    frmq_t frmq = {0};
+    frmthr_t frmthr = {0};
+    pthread_t thr_frm;
+
 
 #ifdef CYGWIN
     _setmode(fileno(stdin), _O_BINARY);  // _fileno(stdin)
@@ -2645,6 +2896,8 @@ int main(int argc, char *argv[]) {
         else if   (strcmp(*argv, "--ecc2") == 0) { gpx.option.ecc = 2; }
         else if   (strcmp(*argv, "--ecc3") == 0) { gpx.option.ecc = 3; }
         else if   (strcmp(*argv, "--ecc4") == 0) { gpx.option.ecc = 4; }
+        else if   (strcmp(*argv, "--ecc_mt") == 0) { gpx.option.emt = 1; }
+        else if   (strcmp(*argv, "--mt") == 0) { option_mt = 1; }  // demod / ECC+output threads
         else if   (strcmp(*argv, "--sat") == 0) { gpx.option.sat = 1; }
         else if   (strcmp(*argv, "--ptu" ) == 0) { gpx.option.ptu = 1; }
         else if   (strcmp(*argv, "--ptu2") == 0) { gpx.option.ptu = 2; }
@@ -2705,6 +2958,7 @@ int main(int argc, char *argv[]) {
             gpx.option.ecc = 2;
             gpx.option.crc = 1;
         }
+        else if   (strcmp(*argv, "--jsnbin") == 0) { gpx.option.jsb = 1; }  // json as binary records
         else if   (strcmp(*argv, "--jsn_cfq") == 0) {
             int frq = -1;  // center frequency / Hz
             ++argv;
@@ -2712,10 +2966,24 @@ int main(int argc, char *argv[]) {
             if (frq < 300000000) frq = -1;
             cfreq = frq;
         }
+        else if   (strcmp(*argv, "--calcache") == 0) {  // cal/conf subframes cache file
+            ++argv;
+            if (*argv) calcache_name = *argv; else return -1;
+        }
         else if   (strcmp(*argv, "--jsnsubfrm1") == 0) { gpx.option.cal = 1; }  // json cal/conf
         else if   (strcmp(*argv, "--jsnsubfrm2") == 0) { gpx.option.cal = 2; }  // json cal/conf
         else if   (strcmp(*argv, "--rawhex") == 0) { rawhex = 2; }  // raw hex input
         else if   (strcmp(*argv, "--xorhex") == 0) { rawhex = 2; xorhex = 1; }  // raw xor input
+        else if   (strcmp(*argv, "--shm") == 0) {  // IQ from shared-memory ring (iq_shmw)
+            ++argv;
+            if (*argv) shm_name = *argv; else return -1;
+        }
+        else if   (strcmp(*argv, "--rxtime") == 0) { dsp.opt_rxtime = 1; }  // JSON: wall clock of the header
+        else if   (strcmp(*argv, "--rxt0") == 0) {  // wall clock of the first sample (unix time)
+            ++argv;
+            if (*argv) dsp.rx_t0 = atof(*argv); else return -1;
+            dsp.opt_rxtime = 1;
+        }
         else if (strcmp(*argv, "-") == 0) {
             int sample_rate = 0, bits_sample = 0, channels = 0;
             ++argv;
@@ -2744,6 +3012,14 @@ int main(int argc, char *argv[]) {
     }
     if (!wavloaded) fp = stdin;
 
+    if (shm_name) {
+        if (attach_shm(&dsp, &pcm, shm_name) < 0) {
+            fprintf(stderr, "error: open shm %s\n", shm_name);
+            return -1;
+        }
+        option_pcmraw = 1;
+    }
+
     if (option_iq == 5 && option_dc) option_lp |= LP_FM;
 
     // LUT faster for decM, however frequency correction after decimation
@@ -2774,6 +3050,15 @@ int main(int argc, char *argv[]) {
 
     if (cfreq > 0) gpx.jsn_freq = (cfreq+500)/1000;
 
+    if (calcache_name) {
+        if (calcache_open(&gpx, calcache_name) == NULL) {
+            fprintf(stderr, "warning: calcache %s\n", calcache_name);
+        }
+        else if (gpx.jsn_freq > 0) {
+            calcache_preload(&gpx, gpx.jsn_freq);
+        }
+    }
+
 
     #ifdef EXT_FSK
     if (!option_bin && !option_softin) {
@@ -2869,6 +3154,18 @@ int main(int argc, char *argv[]) {
             }
         }
 
+        if (option_mt) {
+            frmthr.gpx = &gpx;
+            frmthr.q = &frmq;
+            if (frmq_init(&frmq, FRMQ_LOG2N_DEF, sizeof(rs41frm_t)) < 0
+               || pthread_create(&thr_frm, NULL, rs41_frmthr, &frmthr) != 0)
+            {
+                fprintf(stderr, "warning: frame thread\n");
+                frmq_free(&frmq);
+                option_mt = 0;
+            }
+        }
+
 
         while ( 1 )
         {
@@ -2877,6 +3174,7 @@ int main(int argc, char *argv[]) {
             }
             else if (option_softin) {
                 header_found = find_softbinhead(fp, &hdb, &_mv, option_softin == 2);
+                if (dsp.opt_rxtime) dsp.rx_time = softin_rx_time(dsp.rx_t0);
             }
             else {                                                              // FM-audio:
                 header_found = find_header(&dsp, thres, 4, bitofs, dsp.opt_dc); // optional 2nd pass: dc=0
@@ -2892,6 +3190,8 @@ int main(int argc, char *argv[]) {
 
             if (header_found)
             {
+                if (option_mt) frm = frmq_wslot(&frmq);
+
                 byte_count = FRAMESTART;
                 bitpos = 0; // byte_count*8-HEADLEN
                 b8pos = 0;
@@ -2950,24 +3250,36 @@ int main(int argc, char *argv[]) {
                                 j0 = j;
                             }
                         }
-                        gpx.ecdat.frm_bytescore[byte_count] = min_score_byte;
+                        frm->bytescore[byte_count] = min_score_byte;
                         b8pos = 0;
                         byte = bits2byte(bitbuf);
-                        gpx.frame[byte_count] = byte ^ mask[byte_count % MASK_LEN];
+                        frm->frame[byte_count] = byte ^ mask[byte_count % MASK_LEN];
                         //gpx.dfrm_shiftsgn[byte_count] = difbyte;
-                        gpx.dfrm_bitscore[byte_count] = (1<<j0);
+                        frm->bitscore[byte_count] = (1<<j0);
                         difbyte = 0;
                         byte_count++;
                     }
                 }
-                gpx.ecdat.ts = dsp.mv_pos/(float)dsp.sr;
+                frm->len = byte_count;
+                frm->ts = dsp.mv_pos/(float)dsp.sr;
+                frm->rx_time = dsp.rx_time;
 
-                print_frame(&gpx, byte_count);
+                if (option_mt) frmq_push(&frmq);
+                else           proc_frame(&gpx, frm);
                 byte_count = FRAMESTART;
                 header_found = 0;
             }
         }
 
+        if (option_mt) {
+            frmq_close(&frmq);
+            pthread_join(thr_frm, NULL);
+            if (frmq.full && gpx.option.vbs) {
+                fprintf(stderr, "frame queue full: %u\n", frmq.full);
+            }
+            frmq_free(&frmq);
+        }
+
         if (!option_bin && !option_softin) free_buffers(&dsp);
         else {
             if (hdb.buf) { free(hdb.buf); hdb.buf = NULL; }
@@ -3002,6 +3314,7 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    calcache_close(&gpx);
 
     fclose(fp);
 
@@ -41,6 +41,7 @@
 //typedef unsigned int   ui32_t;
 
 #include "demod_mod.h"
+#include "sonde_tlm.h"
 
 //#define  INCLUDESTATIC 1
 #ifdef INCLUDESTATIC
@@ -61,6 +62,7 @@ typedef struct {
     i8_t aut;
     i8_t aux;  // aux/ozone
     i8_t jsn;  // JSON output (auto_rx)
+    i8_t jsb;  // --jsnbin: JSON as binary record (sonde_tlm.h)
     i8_t ngp;
     i8_t dbg;
 } option_t;
@@ -102,6 +104,7 @@ typedef struct {
     i8_t opt_vel;
     float dop_limit; // 9.9
     float d_err; // 10000
+    float raim_thres; // WLS_RAIM_THRES
     int almanac;
     int ephem;
     int exSat; // -1
@@ -110,8 +113,12 @@ typedef struct {
     ui8_t prn[12];  // valide PRN 0,..,k-1
     ui8_t prn32toggle; // 0x1
     ui8_t prn32next;
+    int wls_fix;           // -g3: previous fix valid
+    double wls_pos[3];     // -g3: previous fix (seed)
     EPHEM_t alm[33];
     EPHEM_t *ephs;
+    EPHIDX_t ephidx;         // ephs by PRN
+    SATSTATE_t sstate[33][2]; // per PRN: last two evaluated epochs
     SAT_t sat[33];
     SAT_t sat1s[33];
 } GPS_t;
@@ -151,6 +158,7 @@ typedef struct {
     option_t option;
     RS_t RS;
     GPS_t gps;
+    tlm_t tlm;
 } gpx_t;
 
 /* --- RS92-SGP ------------------- */
@@ -842,123 +850,130 @@ static void prn12(GPS_t *gps, ui8_t *prn_le, ui8_t prns[12]) {
     }
 }
 
-static int calc_satpos_alm(gpx_t *gpx, double t, SAT_t *satp) {
-    double X, Y, Z, vX, vY, vZ;
-    int j;
-    int week;
-    double cl_corr, cl_drift;
+// almanac/ephemeris record for PRN j at t; sets week (for the orbit) and gpsweek (full GPS week)
+static EPHEM_t *sat_record(gpx_t *gpx, int j, double t, int *week, int *gpsweek) {
     int rollover = 0;
-    EPHEM_t *alm = gpx->gps.alm;
-
-    for (j = 1; j < 33; j++) {
-        if (alm[j].prn > 0 && alm[j].health == 0) {  // prn==j
-
-            // Woche hat 604800 sec
-            if      (t-alm[j].toa >  WEEKSEC/2) rollover = +1;
-            else if (t-alm[j].toa < -WEEKSEC/2) rollover = -1;
-            else rollover = 0;
-            week = alm[j].week - rollover;
-            /*if (j == 1)*/ gpx->week = week + gpx->gps.WEEK1024epoch*1024;
-
-            if (gpx->gps.opt_vel >= 2) {
-                GPS_SatellitePositionVelocity_Ephem(
-                    week, t, alm[j],
-                    &cl_corr, &cl_drift, &X, &Y, &Z, &vX, &vY, &vZ
-                );
-                satp[alm[j].prn].clock_drift = cl_drift;
-                satp[alm[j].prn].vX = vX;
-                satp[alm[j].prn].vY = vY;
-                satp[alm[j].prn].vZ = vZ;
-            }
-            else {
-                GPS_SatellitePosition_Ephem(
-                    week, t, alm[j],
-                    &cl_corr, &X, &Y, &Z
-                );
-            }
+    EPHEM_t *rec = NULL;
 
-            satp[alm[j].prn].X = X;
-            satp[alm[j].prn].Y = Y;
-            satp[alm[j].prn].Z = Z;
-            satp[alm[j].prn].clock_corr = cl_corr;
-
-        }
+    if (gpx->gps.almanac) {
+        rec = gpx->gps.alm + j;
+        if (rec->prn == 0 || rec->health != 0) return NULL;  // prn==j
+        // Woche hat 604800 sec
+        if      (t-rec->toa >  WEEKSEC/2) rollover = +1;
+        else if (t-rec->toa < -WEEKSEC/2) rollover = -1;
+        else rollover = 0;
+        *week = rec->week - rollover;
+        *gpsweek = *week + gpx->gps.WEEK1024epoch*1024;
+    }
+    else if (gpx->gps.ephem) {
+        rec = best_RNXeph(&gpx->gps.ephidx, j, t, &rollover);
+        if (rec == NULL) return NULL;
+        *week = rec->week - rollover;
+        *gpsweek = rec->gpsweek - rollover;
     }
 
-    return 0;
+    return rec;
 }
 
-static int calc_satpos_rnx2(gpx_t *gpx, double t, SAT_t *satp) {
-    double X, Y, Z, vX, vY, vZ;
-    int j;
-    int week;
-    double cl_corr, cl_drift;
-    double tdiff, td;
-    int count, count0, satfound;
-    int rollover = 0;
-    EPHEM_t *eph = gpx->gps.ephs;
+// GPS week as before: set by the highest PRN with a valid record
+static void sat_week(gpx_t *gpx, double t) {
+    int j, week, gpsweek;
 
-    for (j = 1; j < 33; j++) {
+    for (j = 32; j > 0; j--) {
+        if (sat_record(gpx, j, t, &week, &gpsweek)) {
+            gpx->week = gpsweek;
+            break;
+        }
+    }
+}
 
-        count = count0 = 0;
-        satfound = 0;
+// satellite state of PRN j at t, memoized per (PRN, t, record);
+// vel: velocity/clock drift needed
+static SATSTATE_t *find_satstate(gpx_t *gpx, int j, EPHEM_t *rec, double t, int vel) {
+    int k;
+    SATSTATE_t *st = gpx->gps.sstate[j];
 
-        // Woche hat 604800 sec
-        tdiff = WEEKSEC;
+    for (k = 0; k < 2; k++) {
+        if (st[k].rec == rec && st[k].t == t && st[k].vel >= vel) return st+k;
+    }
+    return NULL;
+}
+
+static SATSTATE_t *calc_satstate(gpx_t *gpx, int j, double t, int vel) {
+    int week, gpsweek, k;
+    EPHEM_t *rec;
+    SATSTATE_t *st = gpx->gps.sstate[j];
+
+    rec = sat_record(gpx, j, t, &week, &gpsweek);
+    if (rec == NULL) return NULL;
+
+    if ( (st = find_satstate(gpx, j, rec, t, vel)) ) return st;
+    st = gpx->gps.sstate[j];
+
+    k = (st[0].t <= st[1].t) ? 0 : 1;  // replace older epoch
+    st += k;
+    st->t = t;
+    st->rec = rec;
+    st->week = week;
+    st->vel = vel;
+    if (vel) {
+        GPS_SatellitePositionVelocity_Ephem(
+            week, t, *rec,
+            &st->clock_corr, &st->clock_drift, &st->X, &st->Y, &st->Z, &st->vX, &st->vY, &st->vZ
+        );
+    }
+    else {
+        GPS_SatellitePosition_Ephem(
+            week, t, *rec,
+            &st->clock_corr, &st->X, &st->Y, &st->Z
+        );
+    }
 
-        while (eph[count].prn > 0) {
+    return st;
+}
 
-            if (eph[count].prn == j && eph[count].health == 0) {
+static void set_satpos(gpx_t *gpx, SATSTATE_t *st, SAT_t *sat) {
+    sat->X = st->X;
+    sat->Y = st->Y;
+    sat->Z = st->Z;
+    sat->clock_corr = st->clock_corr;
+    if (st->vel) {
+        sat->vX = st->vX;
+        sat->vY = st->vY;
+        sat->vZ = st->vZ;
+        sat->clock_drift = st->clock_drift;
+    }
+    if (gpx->gps.ephem) sat->ephtime = st->rec->toe;
+}
 
-                satfound += 1;
+// sat[] at t, and sat1s[] at t-1 (--vel1), only for the PRNs in the frame;
+// t-1 is the previous frame's epoch (cache hit), else Taylor extrapolation from t
+static int calc_satpos(gpx_t *gpx, double t, ui8_t prns[12]) {
+    int i, j;
+    int vel = (gpx->gps.opt_vel >= 1);
+    SATSTATE_t *st, *st1;
 
-                if      (t - eph[count].toe >  WEEKSEC/2) rollover = +1;
-                else if (t - eph[count].toe < -WEEKSEC/2) rollover = -1;
-                else rollover = 0;
-                td = fabs( t - eph[count].toe - rollover*WEEKSEC);
+    if (!gpx->gps.almanac && !gpx->gps.ephem) return -1;
 
-                if ( td < tdiff ) {
-                    tdiff = td;
-                    week = eph[count].week - rollover;
-                    gpx->week = eph[count].gpsweek - rollover;
-                    count0 = count;
-                }
-            }
-            count += 1;
-        }
+    for (i = 0; i < 12; i++) {
+        j = prns[i];
+        if (j < 1 || j > 32) continue;
 
-        if ( satfound )
-        {
-            if (gpx->gps.opt_vel >= 2) {
-                GPS_SatellitePositionVelocity_Ephem(
-                    week, t, eph[count0],
-                    &cl_corr, &cl_drift, &X, &Y, &Z, &vX, &vY, &vZ
-                );
-                satp[j].clock_drift = cl_drift;
-                satp[j].vX = vX;
-                satp[j].vY = vY;
-                satp[j].vZ = vZ;
-            }
-            else {
-                GPS_SatellitePosition_Ephem(
-                    week, t, eph[count0],
-                    &cl_corr, &X, &Y, &Z
-                );
-            }
+        st = calc_satstate(gpx, j, t, vel);
+        if (st == NULL) continue;
+        set_satpos(gpx, st, gpx->gps.sat+j);
 
-            satp[j].X = X;
-            satp[j].Y = Y;
-            satp[j].Z = Z;
-            satp[j].clock_corr = cl_corr;
-            satp[j].ephtime = eph[count0].toe;
+        if (gpx->gps.opt_vel == 1) {
+            st1 = find_satstate(gpx, j, st->rec, t-1, 0);
+            if (st1) set_satpos(gpx, st1, gpx->gps.sat1s+j);
+            else     SAT_extrapolate(st, -1.0, gpx->gps.sat1s+j);
         }
-
     }
+    sat_week(gpx, gpx->gps.opt_vel == 1 ? t-1 : t);
 
     return 0;
 }
 
-
 typedef struct {
     ui32_t tow;
     ui8_t status;
@@ -1011,15 +1026,8 @@ static int get_pseudorange(gpx_t *gpx) {
     prn12(&gpx->gps, prn_le, prns);
 
 
-    // GPS Sat Pos (& Vel)
-    if (gpx->gps.almanac) calc_satpos_alm( gpx, gpstime/1000.0, gpx->gps.sat);
-    if (gpx->gps.ephem)   calc_satpos_rnx2(gpx, gpstime/1000.0, gpx->gps.sat);
-
-    // GPS Sat Pos t -= 1s
-    if (gpx->gps.opt_vel == 1) {
-        if (gpx->gps.almanac) calc_satpos_alm( gpx, gpstime/1000.0-1, gpx->gps.sat1s);
-        if (gpx->gps.ephem)   calc_satpos_rnx2(gpx, gpstime/1000.0-1, gpx->gps.sat1s);
-    }
+    // GPS Sat Pos (& Vel), t -= 1s (--vel1)
+    calc_satpos(gpx, gpstime/1000.0, prns);
 
     k = 0;
     for (j = 0; j < 12; j++) {
@@ -1121,6 +1129,77 @@ static int get_GPSvel(double lat, double lon, double vel_ecef[3],
     return 0;
 }
 
+// -g3: one weighted least-squares fix over all sats, seeded from the previous fix;
+//      bad pseudoranges are excluded by their residuals (nav_gps_vel.c: NAV_WLS)
+static int get_GPSkoord_wls(gpx_t *gpx, int N) {
+    double lat, lon, alt, rx_cl_bias;
+    double vH, vD, vU;
+    double pos_ecef[3], vel_ecef[3], dvel_ecef[3];
+    double gdop = -1, rms = 0;
+    double DOP[4];
+    SAT_t Sat_B[12]; // N <= 12
+    int used[12];
+    int j, k, n = -1;
+
+    gpx->lat = gpx->lon = gpx->alt = 0;
+    if (N > 12) N = 12;
+
+    for (j = 0; j < N; j++) Sat_B[j] = gpx->gps.sat[gpx->gps.prn[j]];
+
+    if (gpx->gps.wls_fix) {
+        for (j = 0; j < 3; j++) pos_ecef[j] = gpx->gps.wls_pos[j];
+        n = NAV_WLS(N, Sat_B, pos_ecef, &rx_cl_bias, used, gpx->gps.raim_thres, &rms);
+    }
+    if (n < 0) {
+        if (NAV_bancroft1(N, Sat_B, pos_ecef, &rx_cl_bias) == 0) {
+            n = NAV_WLS(N, Sat_B, pos_ecef, &rx_cl_bias, used, gpx->gps.raim_thres, &rms);
+        }
+    }
+    if (n >= 0) {
+        ecef2elli(pos_ecef[0], pos_ecef[1], pos_ecef[2], &lat, &lon, &alt);
+        if (alt < -1000.0 || alt > 80000.0) n = -1;
+    }
+    gpx->gps.wls_fix = (n >= 0);
+    if (n < 0) return 0;
+
+    for (j = 0; j < 3; j++) gpx->gps.wls_pos[j] = pos_ecef[j];
+
+    k = 0;
+    for (j = 0; j < N; j++) {
+        if (used[j]) {
+            Sat_B[k] = Sat_B[j];
+            gpx->gps.prn[k] = gpx->gps.prn[j];
+            k++;
+        }
+        else if (gpx->gps.prn[j] == gpx->gps.prn32next) gpx->gps.prn32toggle ^= 0x1;
+    }
+    N = k;
+
+    if (calc_DOPn(N, Sat_B, pos_ecef, DOP) == 0) {
+        gdop = sqrt(DOP[0]+DOP[1]+DOP[2]+DOP[3]);
+    }
+
+    if (gpx->gps.opt_vel) {
+        vel_ecef[0] = vel_ecef[1] = vel_ecef[2] = 0;
+        NAV_LinV(N, Sat_B, pos_ecef, vel_ecef, 0.0, dvel_ecef, &rx_cl_bias);
+        for (j=0; j<3; j++) vel_ecef[j] += dvel_ecef[j];
+        NAV_LinV(N, Sat_B, pos_ecef, vel_ecef, rx_cl_bias, dvel_ecef, &rx_cl_bias);
+        for (j=0; j<3; j++) vel_ecef[j] += dvel_ecef[j];
+        get_GPSvel(lat, lon, vel_ecef, &vH, &vD, &vU);
+        gpx->vH = vH;
+        gpx->vD = vD;
+        gpx->vU = vU;
+    }
+
+    gpx->lat = lat;
+    gpx->lon = lon;
+    gpx->alt = alt;
+    gpx->dop = gdop;
+    gpx->diter = rms;  // weighted residual rms
+
+    return N;
+}
+
 static int get_GPSkoord(gpx_t *gpx, int N) {
     double lat, lon, alt, rx_cl_bias;
     double vH, vD, vU;
@@ -1141,6 +1220,8 @@ static int get_GPSkoord(gpx_t *gpx, int N) {
     double diter;
     int exN = -1;
 
+    if (gpx->gps.opt_vergps == 3) return get_GPSkoord_wls(gpx, N);
+
     if (gpx->gps.opt_vergps == 8) {
         fprintf(stdout, "  sats: ");
         for (j = 0; j < N; j++) fprintf(stdout, "%02d ", gpx->gps.prn[j]);
@@ -1434,11 +1515,11 @@ static int print_position(gpx_t *gpx, int ec) {  // GPS-Hoehe ueber Ellipsoid
                     fprintf(stdout,"  vH: %4.1f  D: %5.1f  vV: %3.1f ", gpx->vH, gpx->vD, gpx->vU);
                 }
                 if (gpx->option.vbs) {
-                    if (gpx->gps.opt_vergps != 2) {
+                    if (gpx->gps.opt_vergps != 2 && gpx->gps.opt_vergps != 3) {
                         fprintf(stdout, " DOP[%02d,%02d,%02d,%02d] %.1f",
                                        gpx->sats[0], gpx->sats[1], gpx->sats[2], gpx->sats[3], gpx->dop);
                     }
-                    else {  // wenn gpx->gps.opt_vergps=2, dann n=N=k(-1)
+                    else {  // wenn gpx->gps.opt_vergps=2,3, dann n=N=k(-RAIM)
                         fprintf(stdout, " DOP[");
                         for (j = 0; j < n; j++) {
                             fprintf(stdout, "%d", gpx->gps.prn[j]);
@@ -1495,44 +1576,52 @@ static int print_position(gpx_t *gpx, int ec) {  // GPS-Hoehe ueber Ellipsoid
             {   // eigentlich GPS, d.h. UTC = GPS - UTC_OFS (UTC_OFS=18sec ab 1.1.2017)
                 char *ver_jsn = NULL;
                 fprintf(stdout, "\n");
-                fprintf(stdout, "{ \"type\": \"%s\"", "RS92");
-                fprintf(stdout, ", \"frame\": %d, \"id\": \"%s\", \"datetime\": \"%04d-%02d-%02dT%02d:%02d:%06.3fZ\", \"lat\": %.5f, \"lon\": %.5f, \"alt\": %.5f, \"vel_h\": %.5f, \"heading\": %.5f, \"vel_v\": %.5f",
-                               gpx->frnr, gpx->id, gpx->jahr, gpx->monat, gpx->tag, gpx->std, gpx->min, gpx->sek, gpx->lat, gpx->lon, gpx->alt, gpx->vH, gpx->vD, gpx->vU);
+                tlm_t *t = &gpx->tlm;
+                tlm_begin(t, "RS92");
+                tlm_int(t, TLM_FRAME, gpx->frnr);
+                tlm_str(t, TLM_ID, gpx->id);
+                tlm_datetime(t, gpx->jahr, gpx->monat, gpx->tag, gpx->std, gpx->min, gpx->sek, 3);
+                tlm_flt(t, TLM_LAT, gpx->lat, 5);
+                tlm_flt(t, TLM_LON, gpx->lon, 5);
+                tlm_flt(t, TLM_ALT, gpx->alt, 5);
+                tlm_flt(t, TLM_VEL_H, gpx->vH, 5);
+                tlm_flt(t, TLM_HEADING, gpx->vD, 5);
+                tlm_flt(t, TLM_VEL_V, gpx->vU, 5);
                 if (gpx->option.ptu && !err2) {
                     if (gpx->T > -273.0f) {
-                        fprintf(stdout, ", \"temp\": %.1f",  gpx->T );
+                        tlm_flt(t, TLM_TEMP, gpx->T, 1);
                     }
                     if (gpx->_RH > -0.5f) {
-                        fprintf(stdout, ", \"humidity\": %.1f",  gpx->_RH );
+                        tlm_flt(t, TLM_HUMIDITY, gpx->_RH, 1);
                     }
                     if (gpx->_P > 0.0f) {
-                        fprintf(stdout, ", \"pressure\": %.2f",  gpx->_P );
+                        tlm_flt(t, TLM_PRESSURE, gpx->_P, 2);
                     }
                 }
                 if ((gpx->crc & crc_AUX)==0 && (gpx->aux[0] != 0 || gpx->aux[1] != 0 || gpx->aux[2] != 0 || gpx->aux[3] != 0)) {
-                    fprintf(stdout, ", \"aux\": \"%04x%04x%04x%04x\"", gpx->aux[0], gpx->aux[1], gpx->aux[2], gpx->aux[3]);
+                    tlm_strf(t, TLM_AUX, "%04x%04x%04x%04x", gpx->aux[0], gpx->aux[1], gpx->aux[2], gpx->aux[3]);
                 }
-                fprintf(stdout, ", \"subtype\": \"RS92-%s\"",  gpx->rs_type == RS92SGP ? "SGP" : "NGP" );
+                tlm_str(t, TLM_SUBTYPE, gpx->rs_type == RS92SGP ? "RS92-SGP" : "RS92-NGP");
                 if (gpx->jsn_freq > 0) {  // rs92-frequency: gpx->freq
                     int fq_kHz = gpx->jsn_freq;
                     //if (gpx->freq > 0) fq_kHz = gpx->freq; // L-band: option.ngp ?
-                    fprintf(stdout, ", \"freq\": %d", fq_kHz );
+                    tlm_int(t, TLM_FREQ, fq_kHz);
                 }
 
                 // Include frequency derived from subframe information if available.
                 if (gpx->freq > 0) {
-                    fprintf(stdout, ", \"tx_frequency\": %d", gpx->freq );
+                    tlm_int(t, TLM_TX_FREQUENCY, gpx->freq);
                 }
 
                 // Reference time/position
-                fprintf(stdout, ", \"ref_datetime\": \"%s\"", "GPS" ); // {"GPS", "UTC"} GPS-UTC=leap_sec
-                fprintf(stdout, ", \"ref_position\": \"%s\"", "GPS" ); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid
+                tlm_str(t, TLM_REF_DATETIME, "GPS"); // {"GPS", "UTC"} GPS-UTC=leap_sec
+                tlm_str(t, TLM_REF_POSITION, "GPS"); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid
 
                 #ifdef VER_JSN_STR
                     ver_jsn = VER_JSN_STR;
                 #endif
-                if (ver_jsn && *ver_jsn != '\0') fprintf(stdout, ", \"version\": \"%s\"", ver_jsn);
-                fprintf(stdout, " }\n");
+                if (ver_jsn && *ver_jsn != '\0') tlm_str(t, TLM_VERSION_STR, ver_jsn);
+                tlm_out(t, stdout, gpx->option.jsb);
             }
         }
 
@@ -1581,6 +1670,7 @@ int main(int argc, char *argv[]) {
 
     FILE *fp, *fp_alm = NULL, *fp_eph = NULL;
     char *fpname = NULL;
+    char *shm_name = NULL;
 
     int option_der = 0;    // linErr
     int option_min = 0;
@@ -1629,6 +1719,7 @@ int main(int argc, char *argv[]) {
     gpx.gps.prn32toggle = 0x1;
     gpx.gps.dop_limit = 9.9;
     gpx.gps.d_err = 10000;
+    gpx.gps.raim_thres = WLS_RAIM_THRES;
     gpx.gps.exSat = -1;
     gpx.gps.WEEK1024epoch = 1; // SEM almanac, GPS epoch (1: 1999-2019)
 
@@ -1655,6 +1746,8 @@ int main(int argc, char *argv[]) {
             fprintf(stderr, "           --gpsepoch <n> (2019-04-07: n=2)\n");
             fprintf(stderr, "       -g1          (verbose GPS:   4 sats)\n");
             fprintf(stderr, "       -g2          (verbose GPS: all sats)\n");
+            fprintf(stderr, "       -g3, --wls   (GPS: weighted least squares, all sats, RAIM)\n");
+            fprintf(stderr, "       --raim <m>   (-g3: exclusion threshold of the normalized residual, default %.0fm)\n", WLS_RAIM_THRES);
             fprintf(stderr, "       -gg          (vverbose GPS)\n");
             fprintf(stderr, "       --crc        (CRC check GPS)\n");
             fprintf(stderr, "       --ecc        (Reed-Solomon)\n");
@@ -1727,6 +1820,14 @@ int main(int argc, char *argv[]) {
             }
             else return -1;
         }
+        else if ( (strcmp(*argv, "--raim") == 0) ) {
+            ++argv;
+            if (*argv) {
+                gpx.gps.raim_thres = atof(*argv);
+                if (gpx.gps.raim_thres <= 0  || gpx.gps.raim_thres >= 100000)  gpx.gps.raim_thres = WLS_RAIM_THRES;
+            }
+            else return -1;
+        }
         else if ( (strcmp(*argv, "--exsat") == 0) ) {
             ++argv;
             if (*argv) {
@@ -1737,6 +1838,9 @@ int main(int argc, char *argv[]) {
         }
         else if   (strcmp(*argv, "-g1") == 0) { gpx.gps.opt_vergps = 1; }  //  verbose1 GPS
         else if   (strcmp(*argv, "-g2") == 0) { gpx.gps.opt_vergps = 2; }  //  verbose2 GPS (bancroft)
+        else if ( (strcmp(*argv, "-g3") == 0) || (strcmp(*argv, "--wls") == 0) ) {
+            gpx.gps.opt_vergps = 3;  // WLS/RAIM, all sats
+        }
         else if   (strcmp(*argv, "-gg") == 0) { gpx.gps.opt_vergps = 8; }  // vverbose GPS
         else if   (strcmp(*argv, "--json") == 0) {
             gpx.option.jsn = 1;
@@ -1744,6 +1848,7 @@ int main(int argc, char *argv[]) {
             gpx.option.crc = 1;
             gpx.gps.opt_vel = 4;
         }
+        else if   (strcmp(*argv, "--jsnbin") == 0) { gpx.option.jsb = 1; }  // json as binary records
         else if   (strcmp(*argv, "--jsn_cfq") == 0) {
             int frq = -1;  // center frequency / Hz
             ++argv;
@@ -1803,6 +1908,16 @@ int main(int argc, char *argv[]) {
         else if   (strcmp(*argv, "--ngp") == 0) { gpx.option.ngp = 1; }  // RS92-NGP, RS92-D: 1680 MHz
         else if   (strcmp(*argv, "--dbg" ) == 0) { gpx.option.dbg = 1; }
         else if (strcmp(*argv, "--rawhex") == 0) { rawhex = 2; }  // raw hex input
+        else if   (strcmp(*argv, "--shm") == 0) {  // IQ from shared-memory ring (iq_shmw)
+            ++argv;
+            if (*argv) shm_name = *argv; else return -1;
+        }
+        else if   (strcmp(*argv, "--rxtime") == 0) { dsp.opt_rxtime = 1; }  // JSON: wall clock of the header
+        else if   (strcmp(*argv, "--rxt0") == 0) {  // wall clock of the first sample (unix time)
+            ++argv;
+            if (*argv) dsp.rx_t0 = atof(*argv); else return -1;
+            dsp.opt_rxtime = 1;
+        }
         else if (strcmp(*argv, "-") == 0) {
             int sample_rate = 0, bits_sample = 0, channels = 0;
             ++argv;
@@ -1831,6 +1946,14 @@ int main(int argc, char *argv[]) {
     }
     if (!fileloaded) fp = stdin;
 
+    if (shm_name) {
+        if (attach_shm(&dsp, &pcm, shm_name) < 0) {
+            fprintf(stderr, "error: open shm %s\n", shm_name);
+            return -1;
+        }
+        option_pcmraw = 1;
+    }
+
     if (fp_alm) {
         if (read_SEMalmanac(fp_alm, gpx.gps.alm) == 0) {
             gpx.gps.almanac = 1;
@@ -1847,6 +1970,7 @@ int main(int argc, char *argv[]) {
            fclose(fp_eph); */
         gpx.gps.ephs = read_RNXpephs(fp_eph);
         if (gpx.gps.ephs) {
+            index_RNXpephs(gpx.gps.ephs, &gpx.gps.ephidx);
             gpx.gps.ephem = 1;
             gpx.gps.almanac = 0;
         }
@@ -1987,10 +2111,12 @@ int main(int argc, char *argv[]) {
             if (option_softin) {
                 for (k = 0; k < hdb.len; k++) hdb.sbuf[k] = 0.0;
                 header_found = find_softbinhead(fp, &hdb, &_mv, option_softin == 2);
+                if (dsp.opt_rxtime) gpx.tlm.rx_time = softin_rx_time(dsp.rx_t0);
             }
             else {
                 header_found = find_header(&dsp, thres, 3, bitofs, dsp.opt_dc);
                 _mv = dsp.mv;
+                gpx.tlm.rx_time = dsp.rx_time;
             }
 
             if (header_found == EOF) break;
@@ -0,0 +1,74 @@
+
+/*
+ *  sample time base
+ *    iq_shmw (shm header), demod_mod (--rxtime)
+ *
+ *  input sample k (sample rate sr) was received at t0 + k/sr (wall clock, unix time).
+ *  t0 is estimated from the arrival of the samples: if the samples 0..n-1 have
+ *  been read at time t, then t - n/sr >= t0 + latency (a sample can't be read
+ *  before it is captured and passed on). the smallest value, i.e. the read with
+ *  the least queueing, is the estimate of t0 (+ minimum latency of the SDR reader).
+ *  the minimum runs over the current and the previous window of RXT_WIN seconds,
+ *  so that t0 follows a drift of the sample clock against the system clock.
+ *  only meaningful for real-time input (SDR pipe), not for a file.
+ *
+ */
+
+#ifndef RX_TIME_H
+#define RX_TIME_H
+
+#include <time.h>
+
+#ifndef INTTYPES
+#define INTTYPES
+typedef unsigned char  ui8_t;
+typedef unsigned short ui16_t;
+typedef unsigned int   ui32_t;
+typedef unsigned long long ui64_t;
+typedef char  i8_t;
+typedef short i16_t;
+typedef int   i32_t;
+#endif
+
+
+#define RXT_WIN  10.0  // s
+
+
+typedef struct {
+    double sr;
+    double t0;      // wall clock of sample 0; 0: no estimate yet
+    double win;     // start of the current window
+    double min[2];  // min(t - n/sr): previous, current window
+} rxtime_t;
+
+
+static inline double rxt_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+static inline void rxt_init(rxtime_t *r, double sr) {
+    r->sr = sr;
+    r->t0 = 0.0;
+    r->win = 0.0;
+    r->min[0] = r->min[1] = 0.0;
+}
+
+// samples 0..n-1 read at time t
+static inline void rxt_update(rxtime_t *r, ui64_t n, double t) {
+    double ofs = t - n/r->sr;
+
+    if (r->win == 0.0 || t - r->win > RXT_WIN) {
+        r->min[0] = r->min[1];
+        r->min[1] = ofs;
+        r->win = t;
+    }
+    if (ofs < r->min[1]) r->min[1] = ofs;
+
+    r->t0 = r->min[1];
+    if (r->min[0] != 0.0 && r->min[0] < r->t0) r->t0 = r->min[0];
+}
+
+#endif
+
@@ -0,0 +1,46 @@
+
+/*
+ *  framed float32 soft symbols
+ *    fsk_demod --softblk  ->  <decoder> --softin
+ *
+ *  stream: [softblk_hdr_t | len x float32] [softblk_hdr_t | len x float32] ...
+ *  little endian, one block per demodulator call.
+ *  the first 4 bytes of the stream identify the format: SOFTBLK_MAGIC as a
+ *  float32 is ~1.3e7, not a plausible soft symbol of a raw float32 stream.
+ *
+ */
+
+#ifndef SOFT_BLK_H
+#define SOFT_BLK_H
+
+#ifndef INTTYPES
+#define INTTYPES
+typedef unsigned char  ui8_t;
+typedef unsigned short ui16_t;
+typedef unsigned int   ui32_t;
+typedef unsigned long long ui64_t;
+typedef char  i8_t;
+typedef short i16_t;
+typedef int   i32_t;
+#endif
+
+
+#define SOFTBLK_MAGIC    0x4B4C4253  // "SBLK"
+#define SOFTBLK_VERSION  1
+
+#define SOFTBLK_MAXLEN   (1<<16)     // max symbols per block
+
+
+typedef struct {
+    ui32_t magic;
+    ui16_t version;
+    ui16_t chan;       // channel id (fsk_demod --channels)
+    ui32_t sym_rate;   // symbols/s
+    ui32_t sr;         // time base: samples/s of the demodulator input
+    ui64_t t0;         // time base: first input sample of this block
+    ui32_t len;        // number of float32 soft symbols following
+    ui32_t flags;      // reserved
+} softblk_hdr_t;       // 32 bytes
+
+#endif
+
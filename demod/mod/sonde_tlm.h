@@ -0,0 +1,430 @@
+
+/*
+ *  telemetry record common to the decoders
+ *    <decoder> --json           : JSON line (auto_rx)
+ *    <decoder> --json --jsnbin  : length-prefixed binary record
+ *
+ *  the decoder fills one record (tlm_begin(), tlm_int(), tlm_flt(), ...);
+ *  the fields keep their order, so tlm_json() gives the same JSON line as
+ *  the former printf code of the decoder.
+ *  tlm_out() writes a record with a single write() (stdio of fp is flushed first);
+ *  the JSON line is formatted into tlm_t.jsn without printf/locale.
+ *
+ *  binary record (little endian):
+ *    [tlmhdr_t]  magic, len (whole record), version, nfld
+ *    nfld x [ui8 key | ui8 typ | value]
+ *      typ & 0xF: TLM_INT  i64
+ *                 TLM_FLT  f64           (typ>>4: decimals in JSON)
+ *                 TLM_STR  ui16 n, n bytes
+ *                 TLM_HEX  ui16 n, n bytes  (JSON: uppercase hex string)
+ *                 TLM_BOOL ui8
+ *                 TLM_DT   i16 year, month, day, hour, min, f64 sec
+ *                          (year<=0: time only; typ>>4: decimals of sec)
+ *  the first byte of the magic is 0xFF, i.e. never part of the text output;
+ *  a reader can skip text lines between records.
+ *  reader: auto_rx/autorx/sonde_tlm.py (same key table)
+ *
+ */
+
+#ifndef SONDE_TLM_H
+#define SONDE_TLM_H
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#ifndef INTTYPES
+#define INTTYPES
+typedef unsigned char  ui8_t;
+typedef unsigned short ui16_t;
+typedef unsigned int   ui32_t;
+typedef unsigned long long ui64_t;
+typedef char  i8_t;
+typedef short i16_t;
+typedef int   i32_t;
+#endif
+
+
+#define TLM_MAGIC    0x4D4C54FF  // "\xFFTLM"
+#define TLM_VERSION  1
+
+#define TLM_MAXLEN   4096        // record incl. header
+#define TLM_JSNLEN   16384       // JSON output buffer
+
+
+// key ids: append only (reader tables)
+enum {
+    TLM_TYPE = 0,
+    TLM_FRAME,
+    TLM_ID,
+    TLM_DATETIME,
+    TLM_LAT,
+    TLM_LON,
+    TLM_ALT,
+    TLM_VEL_H,
+    TLM_HEADING,
+    TLM_VEL_V,
+    TLM_SATS,
+    TLM_BT,
+    TLM_BATT,
+    TLM_TEMP,
+    TLM_HUMIDITY,
+    TLM_PRESSURE,
+    TLM_AUX,
+    TLM_SUBTYPE,
+    TLM_ENCRYPTED,
+    TLM_FREQ,
+    TLM_TX_FREQUENCY,
+    TLM_REF_DATETIME,
+    TLM_REF_POSITION,
+    TLM_DIFF_GPS_MSL,
+    TLM_GPSUTC_LEAPSEC,
+    TLM_GPSTOW,
+    TLM_APRSID,
+    TLM_RAWID,
+    TLM_RS41_MAINBOARD,
+    TLM_RS41_MAINBOARD_FW,
+    TLM_RS41_CALCONF51X16,
+    TLM_RS41_CONF0X32,
+    TLM_RS41_SUBFRM,
+    TLM_VERSION_STR,
+    TLM_RX_TIME,
+    TLM_NKEYS
+};
+
+static const char *tlm_key[TLM_NKEYS] = {
+    "type", "frame", "id", "datetime", "lat", "lon", "alt", "vel_h", "heading", "vel_v",
+    "sats", "bt", "batt", "temp", "humidity", "pressure", "aux", "subtype", "encrypted", "freq",
+    "tx_frequency", "ref_datetime", "ref_position", "diff_GPS_MSL", "gpsutc_leapsec", "gpstow",
+    "aprsid", "rawid", "rs41_mainboard", "rs41_mainboard_fw", "rs41_calconf51x16", "rs41_conf0x32",
+    "rs41_subfrm", "version", "rx_time"
+};
+
+enum { TLM_INT = 1, TLM_FLT, TLM_STR, TLM_HEX, TLM_BOOL, TLM_DT };
+
+
+typedef struct {
+    ui32_t magic;
+    ui16_t len;
+    ui8_t  version;
+    ui8_t  nfld;
+} tlmhdr_t;  // 8 bytes
+
+typedef struct {
+    int len;
+    int nfld;
+    double rx_time;  // wall clock of the frame header (--rxtime), appended by tlm_out(); 0: none
+    ui8_t buf[TLM_MAXLEN];
+    char jsn[TLM_JSNLEN];
+} tlm_t;
+
+
+/* ---------------------------------------------------------------------------------------------------- */
+// fill
+
+// field header; 0 if the record is full (field dropped)
+static inline int tlm_fld(tlm_t *t, int key, int typ, int n) {
+    if (t->nfld >= 255 || t->len + 2 + n > TLM_MAXLEN) return 0;
+    t->buf[t->len++] = key;
+    t->buf[t->len++] = typ;
+    t->nfld += 1;
+    return 1;
+}
+
+static inline void tlm_put(tlm_t *t, const void *p, int n) {
+    memcpy(t->buf + t->len, p, n);
+    t->len += n;
+}
+
+static inline void tlm_int(tlm_t *t, int key, long long v) {
+    if (tlm_fld(t, key, TLM_INT, 8)) tlm_put(t, &v, 8);
+}
+
+static inline void tlm_flt(tlm_t *t, int key, double v, int prec) {
+    if (tlm_fld(t, key, TLM_FLT | (prec<<4), 8)) tlm_put(t, &v, 8);
+}
+
+static inline void tlm_bool(tlm_t *t, int key, int v) {
+    ui8_t b = (v != 0);
+    if (tlm_fld(t, key, TLM_BOOL, 1)) tlm_put(t, &b, 1);
+}
+
+static inline void tlm_bytes(tlm_t *t, int key, int typ, const void *p, int n) {
+    ui16_t n16 = n;
+    if (tlm_fld(t, key, typ, 2+n)) {
+        tlm_put(t, &n16, 2);
+        tlm_put(t, p, n);
+    }
+}
+
+static inline void tlm_str(tlm_t *t, int key, const char *s) {
+    tlm_bytes(t, key, TLM_STR, s, strlen(s));
+}
+
+static inline void tlm_strf(tlm_t *t, int key, const char *fmt, ...) {
+    char s[256];
+    int n;
+    va_list ap;
+    va_start(ap, fmt);
+    n = vsnprintf(s, sizeof(s), fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    if (n >= (int)sizeof(s)) n = sizeof(s)-1;
+    tlm_bytes(t, key, TLM_STR, s, n);
+}
+
+static inline void tlm_hex(tlm_t *t, int key, const ui8_t *p, int n) {
+    tlm_bytes(t, key, TLM_HEX, p, n);
+}
+
+// datetime: yr<=0 time only; prec: decimals of sec (0: integer seconds)
+static inline void tlm_datetime(tlm_t *t, int yr, int mon, int day, int hr, int min, double sec, int prec) {
+    i16_t d[5];
+    d[0] = yr; d[1] = mon; d[2] = day; d[3] = hr; d[4] = min;
+    if (tlm_fld(t, TLM_DATETIME, TLM_DT | (prec<<4), 18)) {
+        tlm_put(t, d, 10);
+        tlm_put(t, &sec, 8);
+    }
+}
+
+static inline void tlm_begin(tlm_t *t, const char *type) {
+    t->len = sizeof(tlmhdr_t);
+    t->nfld = 0;
+    tlm_str(t, TLM_TYPE, type);
+}
+
+
+/* ---------------------------------------------------------------------------------------------------- */
+// JSON formatting
+//   same text as printf("%lld"), printf("%0*.*f"), ... (C locale, round-half-even),
+//   without stdio on the hot path
+
+static const ui32_t tlm_pow10[10] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+// digits of v, at least width (zero padded)
+static inline char *tlm_fmt_uint(char *p, ui64_t v, int width) {
+    char d[24];
+    int n = 0;
+    do { d[n++] = '0' + v % 10; v /= 10; } while (v);
+    while (width-- > n) *p++ = '0';
+    while (n > 0) *p++ = d[--n];
+    return p;
+}
+
+// "%0*lld"
+static inline char *tlm_fmt_int(char *p, long long v, int width) {
+    if (v < 0) {
+        *p++ = '-';
+        return tlm_fmt_uint(p, -(ui64_t)v, width-1);
+    }
+    return tlm_fmt_uint(p, v, width);
+}
+
+// q = round(m * 10^prec / 2^s), ties to even; -1 if q does not fit
+static inline int tlm_fix_round(ui64_t m, int s, int prec, ui64_t *q) {
+    ui64_t P = tlm_pow10[prec];
+    ui64_t t = (m & 0xFFFFFFFF) * P;  // m < 2^53, P < 2^30
+    ui64_t u = (m >> 32) * P;
+    ui64_t lo = t + (u << 32);
+    ui64_t hi = (u >> 32) + (lo < t); // m*P = hi:lo
+    ui64_t qq, rh, rl, hh, hl;
+    int c;
+
+    if (s == 0) {
+        if (hi) return -1;
+        *q = lo;
+        return 0;
+    }
+    if (s >= 128) {  // m*P < 2^83
+        *q = 0;
+        return 0;
+    }
+    if (s < 64) {
+        if (hi >> s) return -1;
+        qq = (lo >> s) | (hi << (64-s));
+        rh = 0; rl = lo & ((1ULL<<s)-1);
+        hh = 0; hl = 1ULL << (s-1);
+    }
+    else if (s == 64) {
+        qq = hi;
+        rh = 0; rl = lo;
+        hh = 0; hl = 1ULL << 63;
+    }
+    else {
+        qq = hi >> (s-64);
+        rh = hi & ((1ULL<<(s-64))-1); rl = lo;
+        hh = 1ULL << (s-65); hl = 0;
+    }
+    c = (rh != hh) ? (rh > hh ? 1 : -1) : (rl != hl ? (rl > hl ? 1 : -1) : 0);
+    if (c > 0 || (c == 0 && (qq & 1))) qq += 1;
+    *q = qq;
+    return 0;
+}
+
+// "%0*.*f"; p needs TLM_FLTLEN+width bytes
+#define TLM_FLTLEN  352
+static inline char *tlm_fmt_fix(char *p, double x, int prec, int width) {
+    ui64_t bits, m, q = 0;
+    int ex, neg, n;
+    char d[40];
+    char *s = d;
+
+    memcpy(&bits, &x, 8);  // IEEE-754 binary64 (no fpclassify(): -ffast-math)
+    neg = bits >> 63;
+    ex  = (bits >> 52) & 0x7FF;
+    m   = bits & ((1ULL<<52)-1);
+    if (ex) m |= 1ULL<<52; else ex = 1;
+
+    if (ex == 0x7FF || ex > 1075 || prec > 9 || tlm_fix_round(m, 1075-ex, prec, &q) < 0) {
+        n = snprintf(p, TLM_FLTLEN+width, "%0*.*f", width, prec, x);
+        return p + (n < 0 ? 0 : n);
+    }
+
+    if (neg) *s++ = '-';
+    s = tlm_fmt_uint(s, q / tlm_pow10[prec], 1);
+    if (prec > 0) {
+        *s++ = '.';
+        s = tlm_fmt_uint(s, q % tlm_pow10[prec], prec);
+    }
+    n = s - d;
+    s = d;
+    if (neg) { *p++ = *s++; n--; width--; }
+    while (width-- > n) *p++ = '0';
+    memcpy(p, s, n);
+    return p + n;
+}
+
+
+/* ---------------------------------------------------------------------------------------------------- */
+// output
+
+static inline int tlm_write(int fd, const void *buf, size_t n) {
+    const char *p = buf;
+    ssize_t k;
+    while (n > 0) {
+        k = write(fd, p, n);
+        if (k < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += k;
+        n -= k;
+    }
+    return 0;
+}
+
+// one write() per record; stdio output of fp goes first
+static inline int tlm_write_bin(tlm_t *t, FILE *fp) {
+    tlmhdr_t hdr;
+    hdr.magic = TLM_MAGIC;
+    hdr.len = t->len;
+    hdr.version = TLM_VERSION;
+    hdr.nfld = t->nfld;
+    memcpy(t->buf, &hdr, sizeof(hdr));
+    fflush(fp);
+    return tlm_write(fileno(fp), t->buf, t->len);
+}
+
+// { "type": "...", "key": value, ... }\n
+//   serialized into t->jsn, written with one write() (records > TLM_JSNLEN in pieces)
+static inline int tlm_json(tlm_t *t, FILE *fp) {
+    static const char hex[] = "0123456789ABCDEF";
+    int pos = sizeof(tlmhdr_t);
+    int fd = fileno(fp);
+    int k, key, typ, prec, n;
+    long long v;
+    double x;
+    ui16_t n16;
+    i16_t dt[5];
+    ui8_t *b;
+    const char *kn;
+    char *p = t->jsn;
+
+    // flush t->jsn if less than m bytes are left
+    #define TLM_ROOM(m)  if (t->jsn + TLM_JSNLEN - p < (m)) { \
+                             if (tlm_write(fd, t->jsn, p - t->jsn) < 0) return -1; \
+                             p = t->jsn; }
+
+    fflush(fp);
+
+    for (k = 0; k < t->nfld; k++) {
+        key = t->buf[pos++];
+        typ = t->buf[pos] & 0xF;
+        prec = t->buf[pos] >> 4;
+        pos++;
+        b = t->buf + pos;
+
+        kn = key < TLM_NKEYS ? tlm_key[key] : "";
+        n = strlen(kn);
+        TLM_ROOM(n+8);
+        if (k == 0) { memcpy(p, "{ \"", 3); p += 3; }
+        else        { memcpy(p, ", \"", 3); p += 3; }
+        memcpy(p, kn, n); p += n;
+        memcpy(p, "\": ", 3); p += 3;
+
+        switch (typ) {
+            case TLM_INT:  memcpy(&v, b, 8); pos += 8;
+                           TLM_ROOM(24);
+                           p = tlm_fmt_int(p, v, 1);
+                           break;
+            case TLM_FLT:  memcpy(&x, b, 8); pos += 8;
+                           TLM_ROOM(TLM_FLTLEN);
+                           p = tlm_fmt_fix(p, x, prec, 0);
+                           break;
+            case TLM_BOOL: pos += 1;
+                           TLM_ROOM(8);
+                           if (*b) { memcpy(p, "true", 4); p += 4; }
+                           else    { memcpy(p, "false", 5); p += 5; }
+                           break;
+            case TLM_STR:  memcpy(&n16, b, 2); n = n16; pos += 2+n;
+                           TLM_ROOM(n+2);
+                           *p++ = '"';
+                           memcpy(p, b+2, n); p += n;
+                           *p++ = '"';
+                           break;
+            case TLM_HEX:  memcpy(&n16, b, 2); n = n16; pos += 2+n;
+                           TLM_ROOM(2*n+2);
+                           *p++ = '"';
+                           for (b += 2; n > 0; n--, b++) {
+                               *p++ = hex[*b >> 4];
+                               *p++ = hex[*b & 0xF];
+                           }
+                           *p++ = '"';
+                           break;
+            case TLM_DT:   memcpy(dt, b, 10); memcpy(&x, b+10, 8); pos += 18;
+                           TLM_ROOM(TLM_FLTLEN+64);
+                           *p++ = '"';
+                           if (dt[0] > 0) {
+                               p = tlm_fmt_int(p, dt[0], 4); *p++ = '-';
+                               p = tlm_fmt_int(p, dt[1], 2); *p++ = '-';
+                               p = tlm_fmt_int(p, dt[2], 2); *p++ = 'T';
+                           }
+                           p = tlm_fmt_int(p, dt[3], 2); *p++ = ':';
+                           p = tlm_fmt_int(p, dt[4], 2); *p++ = ':';
+                           p = tlm_fmt_fix(p, x, prec, prec ? prec+3 : 2);
+                           *p++ = 'Z';
+                           *p++ = '"';
+                           break;
+            default:       return -1;
+        }
+    }
+    TLM_ROOM(3);
+    memcpy(p, " }\n", 3); p += 3;
+
+    #undef TLM_ROOM
+
+    return tlm_write(fd, t->jsn, p - t->jsn);
+}
+
+static inline int tlm_out(tlm_t *t, FILE *fp, int bin) {
+    if (t->rx_time > 0) tlm_flt(t, TLM_RX_TIME, t->rx_time, 6);
+    if (bin) return tlm_write_bin(t, fp);
+    return tlm_json(t, fp);
+}
+
+#endif
+
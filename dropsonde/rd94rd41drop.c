@@ -26,10 +26,18 @@
 //      gcc -DVER_JSN_STR=\"0.0.2\" ...
 
 
+#ifndef INTTYPES
+#define INTTYPES
 typedef unsigned char  ui8_t;
 typedef unsigned short ui16_t;
 typedef unsigned int   ui32_t;
-typedef signed   char  i8_t;
+typedef unsigned long long ui64_t;
+typedef char  i8_t;
+typedef short i16_t;
+typedef int   i32_t;
+#endif
+
+#include "../demod/mod/demod_mod.h"
 
 typedef struct {
     i8_t vbs;  // verbose output
@@ -104,194 +112,6 @@ static int bufpos = -1;
 
 #define BAUD_RATE 4800  //(4798.8) //4800
 
-static int sample_rate = 0, bits_sample = 0, channels = 0;
-static float samples_per_bit = 0;
-
-static int findstr(char *buf, char *str, int pos) {
-    int i;
-    for (i = 0; i < 4; i++) {
-        if (buf[(pos+i)%4] != str[i]) break;
-    }
-    return i;
-}
-
-static int read_wav_header(FILE *fp) {
-    char txt[4+1] = "\0\0\0\0";
-    unsigned char dat[4];
-    int byte, p=0;
-
-    if (fread(txt, 1, 4, fp) < 4) return -1;
-    if (strncmp(txt, "RIFF", 4)) return -1;
-    if (fread(txt, 1, 4, fp) < 4) return -1;
-    // pos_WAVE = 8L
-    if (fread(txt, 1, 4, fp) < 4) return -1;
-    if (strncmp(txt, "WAVE", 4)) return -1;
-    // pos_fmt = 12L
-    for ( ; ; ) {
-        if ( (byte=fgetc(fp)) == EOF ) return -1;
-        txt[p % 4] = byte;
-        p++; if (p==4) p=0;
-        if (findstr(txt, "fmt ", p) == 4) break;
-    }
-    if (fread(dat, 1, 4, fp) < 4) return -1;
-    if (fread(dat, 1, 2, fp) < 2) return -1;
-
-    if (fread(dat, 1, 2, fp) < 2) return -1;
-    channels = dat[0] + (dat[1] << 8);
-
-    if (fread(dat, 1, 4, fp) < 4) return -1;
-    memcpy(&sample_rate, dat, 4); //sample_rate = dat[0]|(dat[1]<<8)|(dat[2]<<16)|(dat[3]<<24);
-
-    if (fread(dat, 1, 4, fp) < 4) return -1;
-    if (fread(dat, 1, 2, fp) < 2) return -1;
-    //byte = dat[0] + (dat[1] << 8);
-
-    if (fread(dat, 1, 2, fp) < 2) return -1;
-    bits_sample = dat[0] + (dat[1] << 8);
-
-    // pos_dat = 36L + info
-    for ( ; ; ) {
-        if ( (byte=fgetc(fp)) == EOF ) return -1;
-        txt[p % 4] = byte;
-        p++; if (p==4) p=0;
-        if (findstr(txt, "data", p) == 4) break;
-    }
-    if (fread(dat, 1, 4, fp) < 4) return -1;
-
-
-    fprintf(stderr, "sample_rate: %d\n", sample_rate);
-    fprintf(stderr, "bits       : %d\n", bits_sample);
-    fprintf(stderr, "channels   : %d\n", channels);
-
-    if ((bits_sample != 8) && (bits_sample != 16)) return -1;
-
-    samples_per_bit = sample_rate/(float)BAUD_RATE;
-
-    fprintf(stderr, "samples/bit: %.2f\n", samples_per_bit);
-
-    return 0;
-}
-
-#define EOF_INT  0x1000000
-
-static unsigned long sample_count = 0;
-
-static int read_signed_sample(FILE *fp) {  // int = i32_t
-    int byte, i, sample, s=0;              //  EOF -> 0x1000000
-
-    for (i = 0; i < channels; i++) {
-                           // i = 0: links bzw. mono
-        byte = fgetc(fp);
-        if (byte == EOF) return EOF_INT;
-        if (i == 0) sample = byte;
-
-        if (bits_sample == 16) {
-            byte = fgetc(fp);
-            if (byte == EOF) return EOF_INT;
-            if (i == 0) sample +=  byte << 8;
-        }
-
-    }
-
-    if (bits_sample ==  8) s = sample-128;   // 8bit: 00..FF, centerpoint 0x80=128
-    if (bits_sample == 16) s = (short)sample;
-
-    sample_count++;
-
-    return s;
-}
-
-static int option_res = 0;
-static int par=1, par_alt=1;
-
-static int read_bits_fsk(gpx_t *gpx, FILE *fp, int *bit, int *len) {
-    static int sample;
-    int n, y0;
-    float l, x1;
-    static float x0;
-
-    n = 0;
-    do {
-        y0 = sample;
-        sample = read_signed_sample(fp);
-        if (sample == EOF_INT) return EOF;
-        //sample_count++; // in read_signed_sample()
-        par_alt = par;
-        par =  (sample >= 0) ? 1 : -1;    // 8bit: 0..127,128..255 (-128..-1,0..127)
-        n++;
-    } while (par*par_alt > 0);
-
-    if (!option_res) l = (float)n / samples_per_bit;
-    else {                                 // genauere Bitlaengen-Messung
-        x1 = sample/(float)(sample-y0);    // hilft bei niedriger sample rate
-        l = (n+x0-x1) / samples_per_bit;   // meist mehr frames (nicht immer)
-        x0 = x1;
-    }
-
-    *len = (int)(l+0.5);
-
-    if (!gpx->option.inv) *bit = (1+par_alt)/2;  // oben 1, unten -1
-    else                  *bit = (1-par_alt)/2;  // sdr#<rev1381?, invers: unten 1, oben -1
-// *bit = (1+inv*par_alt)/2; // ausser inv=0
-
-    return 0;
-}
-
-static double bitgrenze = 0;
-static int bitstart = 0;
-static int read_rawbit(gpx_t *gpx, FILE *fp, int *bit) {
-    int sample;
-    int n, sum;
-
-    sum = 0;
-    n = 0;
-
-    if (bitstart) {
-        n = 1;    // d.h. bitgrenze = sample_count-1 (?)
-        bitgrenze = sample_count-1;
-        bitstart = 0;
-    }
-    bitgrenze += samples_per_bit;
-
-    do {
-        sample = read_signed_sample(fp);
-        if (sample == EOF_INT) return EOF;
-        //sample_count++; // in read_signed_sample()
-        //par =  (sample >= 0) ? 1 : -1;    // 8bit: 0..127,128..255 (-128..-1,0..127)
-        sum += sample;
-        n++;
-    } while (sample_count < bitgrenze);  // n < samples_per_bit
-
-    if (sum >= 0) *bit = 1;
-    else          *bit = 0;
-
-    if (gpx->option.inv) *bit ^= 1;
-
-    return 0;
-}
-
-static int f32soft_read(FILE *fp, float *s, int inv) {
-    unsigned int word = 0;
-    short *b = (short*)&word;
-    float *f = (float*)&word;
-    int bps = 32;
-
-    if (fread( &word, bps/8, 1, fp) != 1) return EOF;
-
-    if (bps == 32) {
-        *s = *f;
-    }
-    else {
-        if (bps ==  8) { *b -= 128; }
-        *s = *b/128.0;
-        if (bps == 16) { *s /= 256.0; }
-    }
-
-    if (inv) *s = -*s;
-
-    return 0;
-}
-
 /* ------------------------------------------------------------------------------------ */
 
 static void inc_bufpos() {
@@ -1264,17 +1084,47 @@ int main(int argc, char **argv) {
     FILE *fp = NULL;
     char *fpname;
     char *pbuf = NULL;
+    char *shm_name = NULL;
     int header_found = 0;
     int i, pos, bit, len;
     int fileloaded = 0,
         rawin = 0,
-        option_b = 0,
         option_softin = 0;
+    int option_min = 0;
+    int option_iq = 0;
+    int option_iqdc = 0;
+    int option_lp = 0;
+    int option_dc = 0;
+    int option_noLUT = 0;
+    int option_pcmraw = 0;
+    int sel_wavch = 0;     // audio channel: left
     int cfreq = -1;
     float baudrate = -1;
 
+    int k;
+    int bitpos, bitQ;
+    hsbit_t hsbit, hsbit1;
+
+    float thres = 0.7;
+    float _mv = 0.0;
+
+    float lpIQ_bw = 8e3;
+
+    int bitofs = 0;
+    int shift = 0;
+
+    pcm_t pcm = {0};
+    dsp_t dsp = {0};
+
     gpx_t gpx = {0};
 
+
+#ifdef CYGWIN
+    _setmode(fileno(stdin), _O_BINARY);  // _setmode(_fileno(stdin), _O_BINARY);
+#endif
+    setbuf(stdout, NULL);
+
+
     fpname = argv[0];
     ++argv;
     while ((*argv) && (!fileloaded)) {
@@ -1287,6 +1137,7 @@ int main(int argc, char **argv) {
             fprintf(stderr, "       -R,        (output: raw_bytes)\n");
             fprintf(stderr, "       -i         (invert polarity)\n");
             fprintf(stderr, "       --rawhex   (input: bytes)\n");
+            fprintf(stderr, "       --IQ <fq>  (IQ baseband)\n");
             return 0;
         }
         else if (strcmp(*argv, "-v") == 0) {
@@ -1315,8 +1166,7 @@ int main(int argc, char **argv) {
             if (frq < 300000000) frq = -1;
             cfreq = frq;
         }
-        else if (strcmp(*argv, "-b" ) == 0) { option_b = 1; }
-        //else if (strcmp(*argv, "-b2") == 0) { option_b = 2; }
+        else if (strcmp(*argv, "-b" ) == 0) { }  // bit sync: always (demod_mod)
         else if (strcmp(*argv, "--br") == 0) {
             ++argv;
             if (*argv) {
@@ -1327,6 +1177,70 @@ int main(int argc, char **argv) {
         }
         else if   (strcmp(*argv, "--softin") == 0)  { option_softin = 1; }  // float32 soft input
         else if   (strcmp(*argv, "--softinv") == 0) { option_softin = 2; }  // float32 inverted soft input
+        else if   (strcmp(*argv, "--ch2") == 0) { sel_wavch = 1; }  // right channel (default: 0=left)
+        else if   (strcmp(*argv, "--ths") == 0) {
+            ++argv;
+            if (*argv) {
+                thres = atof(*argv);
+            }
+            else return -1;
+        }
+        else if ( (strcmp(*argv, "-d") == 0) ) {
+            ++argv;
+            if (*argv) {
+                shift = atoi(*argv);
+                if (shift >  4) shift =  4;
+                if (shift < -4) shift = -4;
+            }
+            else return -1;
+        }
+        else if   (strcmp(*argv, "--iq0") == 0) { option_iq = 1; }  // differential/FM-demod
+        else if   (strcmp(*argv, "--iq2") == 0) { option_iq = 2; }
+        else if   (strcmp(*argv, "--iq3") == 0) { option_iq = 3; }  // iq2==iq3
+        else if   (strcmp(*argv, "--iqdc") == 0) { option_iqdc = 1; }  // iq-dc removal (iq0,2,3)
+        else if   (strcmp(*argv, "--IQ") == 0) { // fq baseband -> IF (rotate from and decimate)
+            double fq = 0.0;                     // --IQ <fq> , -0.5 < fq < 0.5
+            ++argv;
+            if (*argv) fq = atof(*argv);
+            else return -1;
+            if (fq < -0.5) fq = -0.5;
+            if (fq >  0.5) fq =  0.5;
+            dsp.xlt_fq = -fq; // S(t) -> S(t)*exp(-f*2pi*I*t)
+            option_iq = 5;
+        }
+        else if   (strcmp(*argv, "--lpIQ") == 0) { option_lp |= LP_IQ; }  // IQ/IF lowpass
+        else if   (strcmp(*argv, "--lpbw") == 0) {  // IQ lowpass BW / kHz
+            double bw = 0.0;
+            ++argv;
+            if (*argv) bw = atof(*argv);
+            else return -1;
+            if (bw > 4.6 && bw < 48.0) lpIQ_bw = bw*1e3;
+            option_lp |= LP_IQ;
+        }
+        else if   (strcmp(*argv, "--lpFM") == 0) { option_lp |= LP_FM; }  // FM lowpass
+        else if   (strcmp(*argv, "--dc") == 0) { option_dc = 1; }
+        else if   (strcmp(*argv, "--noLUT") == 0) { option_noLUT = 1; }
+        else if   (strcmp(*argv, "--min") == 0) { option_min = 1; }
+        else if   (strcmp(*argv, "--shm") == 0) {  // IQ from shared-memory ring (iq_shmw)
+            ++argv;
+            if (*argv) shm_name = *argv; else return -1;
+        }
+        else if (strcmp(*argv, "-") == 0) {
+            int sample_rate = 0, bits_sample = 0, channels = 0;
+            ++argv;
+            if (*argv) sample_rate = atoi(*argv); else return -1;
+            ++argv;
+            if (*argv) bits_sample = atoi(*argv); else return -1;
+            channels = 2;
+            if (sample_rate < 1 || (bits_sample != 8 && bits_sample != 16 && bits_sample != 32)) {
+                fprintf(stderr, "- <sr> <bs>\n");
+                return -1;
+            }
+            pcm.sr  = sample_rate;
+            pcm.bps = bits_sample;
+            pcm.nch = channels;
+            option_pcmraw = 1;
+        }
         else {
             if (!rawin) fp = fopen(*argv, "rb");
             else        fp = fopen(*argv, "r");
@@ -1340,6 +1254,18 @@ int main(int argc, char **argv) {
     }
     if (!fileloaded) fp = stdin;
 
+    if (shm_name) {
+        if (attach_shm(&dsp, &pcm, shm_name) < 0) {
+            fprintf(stderr, "error: open shm %s\n", shm_name);
+            return -1;
+        }
+        option_pcmraw = 1;
+    }
+
+    if (option_iq == 5 && option_dc) option_lp |= LP_FM;
+
+    if (option_noLUT && option_iq == 5) dsp.opt_nolut = 1; else dsp.opt_nolut = 0;
+
     if (gpx.type) gpx.auto_type = 0;
     else {
         gpx.type = RD41;
@@ -1386,64 +1312,100 @@ int main(int argc, char **argv) {
         }
         else {
 
-            i = read_wav_header(fp);
-            if (i) {
+            if (option_iq == 0 && option_pcmraw) {
                 fclose(fp);
+                fprintf(stderr, "error: raw data not IQ\n");
                 return -1;
             }
-            if (baudrate > 0) {
-                samples_per_bit = sample_rate/baudrate;
-                fprintf(stderr, "corr: %.4f\n", samples_per_bit);
+            if (option_iq) sel_wavch = 0;
+
+            pcm.sel_ch = sel_wavch;
+            if (option_pcmraw == 0) {
+                k = read_wav_header(&pcm, fp);
+                if ( k < 0 ) {
+                    fclose(fp);
+                    fprintf(stderr, "error: wav header\n");
+                    return -1;
+                }
             }
 
-            while (!read_bits_fsk(&gpx, fp, &bit, &len)) {
+            if (cfreq > 0) {
+                int fq_kHz = (cfreq - dsp.xlt_fq*pcm.sr + 500)/1e3;
+                gpx.jsn_freq = fq_kHz;
+            }
 
-                if (len == 0) { // reset_frame();
-                /*  if (pos > 2*BITS*pos_GPSV) {
-                        print_bitframe(&gpx, pos);
-                        pos = HEADLEN;
-                        header_found = 0;
-                    } */
-                    continue;   // ...
-                }
+            // init dsp
+            //
+            dsp.fp = fp;
+            dsp.sr = pcm.sr;
+            dsp.bps = pcm.bps;
+            dsp.nch = pcm.nch;
+            dsp.ch = pcm.sel_ch;
+            dsp.br = (float)BAUD_RATE;
+            if (baudrate > 0) dsp.br = baudrate;
+            dsp.sps = (float)dsp.sr/dsp.br;
+            dsp.symlen = 1;  // raw (manchester) symbols
+            dsp.symhd = 1;
+            dsp._spb = dsp.sps;
+            dsp.hdr = header+HEADOFS;
+            dsp.hdrlen = HEADLEN;
+            dsp.BT = 1.0; // bw/time (ISI)
+            dsp.h = 0.8;  // 1.0 modulation index abzgl. BT, as rs92mod (same 4800 Bd manchester FSK)
+            dsp.opt_iq = option_iq;
+            dsp.opt_iqdc = option_iqdc;
+            dsp.opt_lp = option_lp;
+            dsp.lpIQ_bw = lpIQ_bw;  // 8e3; // IF lowpass bandwidth
+            dsp.lpFM_bw = 6e3; // FM audio lowpass
+            dsp.opt_dc = option_dc;
+            dsp.opt_IFmin = option_min;
+
+            if ( dsp.sps < 8 ) {
+                fprintf(stderr, "note: sample rate low (%.1f sps)\n", dsp.sps);
+            }
 
-                for (i = 0; i < len; i++) {
+            k = init_buffers(&dsp);
+            if ( k < 0 ) {
+                fprintf(stderr, "error: init buffers\n");
+                return -1;
+            }
 
-                    inc_bufpos();
-                    buf[bufpos] = 0x30+bit;
+            bitofs += shift;
 
-                    if (!header_found) {
-                        header_found = compare();
-                    }
-                    else {
-                        gpx.frame_rawbits[pos] = 0x30+bit;
-                        //printf("%d", bit);
-                        pos++;
-                        if (pos == RAWBITFRAME_LEN) {
-                            //frames++;
-                            print_bitframe(&gpx, pos);
-                            header_found = 0;
-                            pos = HEADLEN;
-                        }
-                    }
+            while ( 1 )
+            {
+                header_found = find_header(&dsp, thres, 2, bitofs, dsp.opt_dc); // optional 2nd pass: dc=0
+                _mv = dsp.mv;
+
+                if (header_found == EOF) break;
+
+                // mv == correlation score
+                if (_mv*(0.5-gpx.option.inv) < 0) {
+                    gpx.option.inv ^= 0x1;
                 }
-                if (header_found && option_b) {
-                    bitstart = 1;
+
+                if (header_found) {
+
+                    bitpos = 0;
+                    pos = HEADLEN;
+
                     while ( pos < RAWBITFRAME_LEN ) {
-                        if (read_rawbit(&gpx, fp, &bit) == EOF) break;
-                        gpx.frame_rawbits[pos] = 0x30+bit;
-                        //printf("%d", bit);
+                        bitQ = read_softbit2p(&dsp, &hsbit, 0, bitofs, bitpos, -1, 0, &hsbit1);
+                        if ( bitQ == EOF ) break;
+                        bit = hsbit.hb;
+                        if (gpx.option.inv) bit ^= 1;
+                        gpx.frame_rawbits[pos] = 0x30 + bit;
                         pos++;
-
-                        inc_bufpos();
-                        buf[bufpos] = 0x30+bit;
+                        bitpos += 1;
                     }
-                    //frames++;
+
                     print_bitframe(&gpx, pos);
+                    if (pos < RAWBITFRAME_LEN) break;
+
                     header_found = 0;
-                    pos = HEADLEN;
                 }
             }
+
+            free_buffers(&dsp);
         }
     }
     else {  // input: hexraw bytes
@@ -1466,4 +1428,3 @@ int main(int argc, char **argv) {
 
     return 0;
 }
-
@@ -10,6 +10,9 @@
 #include "M10TrimbleParser.h"
 
 char M10Decoder::header[] = "10011001100110010100110010011001";
+unsigned short M10Decoder::chkA0[256];
+unsigned short M10Decoder::chkA1[256];
+unsigned short M10Decoder::chkB[256];
 
 M10Decoder::M10Decoder() {
     m10Gtop = new M10GtopParser();
@@ -18,6 +21,8 @@ M10Decoder::M10Decoder() {
     
     frameSamples = NULL;
     audioFile = NULL;
+
+    initCheckM10();
 }
 
 M10Decoder::~M10Decoder() {
@@ -238,6 +243,7 @@ int M10Decoder::decodeMessage(double initialPos) {
 
 int M10Decoder::decodeMethodCompare(double initialPos) {
     char bit0 = 2;
+    unsigned char byte = 0;
 
     double j = initialPos;
     double sum = 0;
@@ -283,26 +289,19 @@ int M10Decoder::decodeMethodCompare(double initialPos) {
         j += samplesPerBit;
 
         // Determination of a combination of raw bits or 10 or 01.
-        if (moy1 > moy2) {
-            if (bit0 == 0)
-                frame_bits[k] = '1';
-            else
-                frame_bits[k] = '0';
-            bit0 = 0;
-        } else {
-            if (bit0 == 1)
-                frame_bits[k] = '1';
-            else
-                frame_bits[k] = '0';
-            bit0 = 1;
-        }
+        // The bits are shifted into the frame bytes (big endian) as they come.
+        char bit = moy1 > moy2 ? 0 : 1;
+        byte = (byte << 1) | (bit == bit0);
+        if ((k & 7) == 7)
+            frame_bytes[k >> 3] = byte;
+        bit0 = bit;
     }
-    bits2bytes();
     return !checkCRC();
 }
 
 int M10Decoder::decodeMethodSign(double initialPos) {
     char bit0 = 2;
+    unsigned char byte = 0;
 
     double j = initialPos;
     double sum = 0;
@@ -350,21 +349,13 @@ int M10Decoder::decodeMethodSign(double initialPos) {
         j += samplesPerBit;
 
         // Determination of a combination of raw bits or 10 or 01.
-        if (moy1 > moy2) {
-            if (bit0 == 0)
-                frame_bits[k] = '1';
-            else
-                frame_bits[k] = '0';
-            bit0 = 0;
-        } else {
-            if (bit0 == 1)
-                frame_bits[k] = '1';
-            else
-                frame_bits[k] = '0';
-            bit0 = 1;
-        }
+        // The bits are shifted into the frame bytes (big endian) as they come.
+        char bit = moy1 > moy2 ? 0 : 1;
+        byte = (byte << 1) | (bit == bit0);
+        if ((k & 7) == 7)
+            frame_bytes[k >> 3] = byte;
+        bit0 = bit;
     }
-    bits2bytes();
     return !checkCRC();
 }
 
@@ -384,14 +375,24 @@ int M10Decoder::getNextBufferValue() {
 }
 
 bool M10Decoder::checkCRC() {
-    int i, cs;
+    int i;
+    unsigned short cs;
 
+    // Byte at a time: the checksum update is linear, update(c, b) = A(c & 0xFF) ^ A(c & 0xFF00) ^ B(b)
     cs = 0;
     for (i = 0; i < frameLength-1; i++) {
-        cs = update_checkM10(cs, frame_bytes[i]);
+        cs = chkA0[cs & 0xFF] ^ chkA1[cs >> 8] ^ chkB[frame_bytes[i]];
     }
 
-    return ((cs & 0xFFFF) != 0) && ((cs & 0xFFFF) == ((frame_bytes[frameLength-1] << 8) | frame_bytes[frameLength]));
+    return (cs != 0) && (cs == ((frame_bytes[frameLength-1] << 8) | frame_bytes[frameLength]));
+}
+
+void M10Decoder::initCheckM10() {
+    for (int i = 0; i < 256; i++) {
+        chkA0[i] = update_checkM10(i, 0);
+        chkA1[i] = update_checkM10(i << 8, 0);
+        chkB[i] = update_checkM10(0, i);
+    }
 }
 
 int M10Decoder::update_checkM10(int c, unsigned short b) {
@@ -417,29 +418,3 @@ int M10Decoder::update_checkM10(int c, unsigned short b) {
 
     return ((c1 << 8) | c0) & 0xFFFF;
 }
-
-void M10Decoder::bits2bytes() {
-    int i, bit, d, byteval;
-    int bitpos, bytepos;
-
-    bitpos = 0;
-    bytepos = 0;
-
-    while (bytepos < FRAME_LEN + AUX_LEN) {
-
-        byteval = 0;
-        d = 1;
-        for (i = 0; i < 8; i++) {
-            //bit=*(bitstr+bitpos+i); /* little endian */
-            bit = frame_bits[bitpos + 7 - i]; /* big endian */
-            if (bit == '1')
-                byteval += d;
-            else
-                byteval += 0;
-            d <<= 1;
-        }
-        bitpos += 8;
-        frame_bytes[bytepos++] = byteval & 0xFF;
-
-    }
-}
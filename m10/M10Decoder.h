@@ -45,8 +45,8 @@ protected:
     int decodeMethodSign(double initialPos);
     int getNextBufferValue();
     bool checkCRC();
-    int update_checkM10(int c, unsigned short b);
-    void bits2bytes();
+    static int update_checkM10(int c, unsigned short b);
+    static void initCheckM10();
 
     M10GeneralParser *m10Parser;
     M10GeneralParser *m10Gtop;
@@ -64,6 +64,7 @@ protected:
     double samplesPerBit = 0;
     double baudRate = 9615;
     static char header[];
+    static unsigned short chkA0[256], chkA1[256], chkB[256];
     std::string filename;
     
     std::vector<int> *frameSamples;
@@ -74,7 +75,6 @@ protected:
     int frameLength = 0;
     
     std::array<unsigned char, DATA_LENGTH> frame_bytes;
-    std::array<unsigned char, (DATA_LENGTH)*8> frame_bits;
     std::array<unsigned char, DATA_LENGTH> lastGoodFrame;
 };
 
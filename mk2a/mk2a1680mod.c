@@ -3,7 +3,7 @@
    Sippican MkIIa
    LMS-6 (1680 MHz)
         (modulation index h = 10..10.5 (deviation +/- 50kHz))
-        gcc -Ofast mk2a1680mod.c -lm -o mk2mod
+        gcc -Ofast mk2a1680mod.c ../demod/mod/dsp_core.o -lm -o mk2mod
         ./mk2mod -v --iq <fq> --lpIQ --lpFM --crc iq_base.wav
         # default IQ lowpass 180k
         # sr=375k: lpbw=145k..165k
@@ -41,39 +41,13 @@
 // -------------------------------------------------------------------------------------------------
 //#include "demod_mod_Lband.h"
 
-#ifndef M_PI
-    #define M_PI  (3.1415926535897932384626433832795)
-#endif
-#define _2PI  (6.2831853071795864769252867665590)
+#include "../demod/mod/dsp_core.h"  // DFT, FIR lowpass, soft input (libsondedsp.a)
 
 #define LP_IQ    1
 #define LP_FM    2
 #define LP_IQFM  4
 
 
-typedef unsigned char  ui8_t;
-typedef unsigned short ui16_t;
-typedef unsigned int   ui32_t;
-typedef char  i8_t;
-typedef short i16_t;
-typedef int   i32_t;
-
-
-typedef struct {
-    int sr;       // sample_rate
-    int LOG2N;
-    int N;
-    int N2;
-    float *xn;
-    float complex  *ew;
-    float complex  *Fm;
-    float complex  *X;
-    float complex  *Z;
-    float complex  *cx;
-    float complex  *win; // float real
-} dft_t;
-
-
 typedef struct {
     FILE *fp;
     //
@@ -187,154 +161,18 @@ typedef struct {
 } pcm_t;
 
 
-typedef struct {
-    ui8_t hb;
-    float sb;
-} hsbit_t;
-
-
-typedef struct {
-    char *hdr;
-    char *buf;
-    float *sbuf;
-    int len;
-    int bufpos;
-    float thb;
-    float ths;
-} hdb_t;
-
 // -------------------------------------------------------------------------------------------------
 // demod_mod_Lband.c
 
 #define FM_DEC  4     // 2, 4
 #define FM_GAIN (0.8)
 
-static void raw_dft(dft_t *dft, float complex *Z) {
-    int s, l, l2, i, j, k;
-    float complex  w1, w2, T;
-
-    j = 1;
-    for (i = 1; i < dft->N; i++) {
-        if (i < j) {
-            T = Z[j-1];
-            Z[j-1] = Z[i-1];
-            Z[i-1] = T;
-        }
-        k = dft->N/2;
-        while (k < j) {
-            j = j - k;
-            k = k/2;
-        }
-        j = j + k;
-    }
-
-    for (s = 0; s < dft->LOG2N; s++) {
-        l2 = 1 << s;
-        l  = l2 << 1;
-        w1 = (float complex)1.0;
-        w2 = dft->ew[s]; // cexp(-I*M_PI/(float)l2)
-        for (j = 1; j <= l2; j++) {
-            for (i = j; i <= dft->N; i += l) {
-                k = i + l2;
-                T = Z[k-1] * w1;
-                Z[k-1] = Z[i-1] - T;
-                Z[i-1] = Z[i-1] + T;
-            }
-            w1 = w1 * w2;
-        }
-    }
-}
-
-static void cdft(dft_t *dft, float complex *z, float complex *Z) {
-    int i;
-    for (i = 0; i < dft->N; i++)  Z[i] = z[i];
-    raw_dft(dft, Z);
-}
-
-static void rdft(dft_t *dft, float *x, float complex *Z) {
-    int i;
-    for (i = 0; i < dft->N; i++)  Z[i] = (float complex)x[i];
-    raw_dft(dft, Z);
-}
-
-static void Nidft(dft_t *dft, float complex *Z, float complex *z) {
-    int i;
-    for (i = 0; i < dft->N; i++)  z[i] = conj(Z[i]);
-    raw_dft(dft, z);
-    // idft():
-    // for (i = 0; i < dft->N; i++)  z[i] = conj(z[i])/(float)dft->N; // hier: z reell
-}
-
-static float bin2freq0(dft_t *dft, int k) {
-    float fq = dft->sr * k / /*(float)*/dft->N;
-    if (fq >= dft->sr/2.0) fq -= dft->sr;
-    return fq;
-}
-static float bin2freq(dft_t *dft, int k) {
-    float fq = k / (float)dft->N;
-    if ( fq >= 0.5) fq -= 1.0;
-    return fq*dft->sr;
-}
-static float bin2fq(dft_t *dft, int k) {
-    float fq = k / (float)dft->N;
-    if ( fq >= 0.5) fq -= 1.0;
-    return fq;
-}
-
-static int max_bin(dft_t *dft, float complex *Z) {
-    int k, kmax;
-    double max;
-
-    max = 0; kmax = 0;
-    for (k = 0; k < dft->N; k++) {
-        if (cabs(Z[k]) > max) {
-            max = cabs(Z[k]);
-            kmax = k;
-        }
-    }
-
-    return kmax;
-}
-
-static int dft_window(dft_t *dft, int w) {
-    int n;
-
-    if (w < 0 || w > 3) return -1;
-
-    for (n = 0; n < dft->N2; n++) {
-        switch (w)
-        {
-            case 0: // (boxcar)
-                    dft->win[n] = 1.0;
-                    break;
-            case 1: // Hann
-                    dft->win[n] = 0.5 * ( 1.0 - cos(_2PI*n/(float)(dft->N2-1)) );
-                    break ;
-            case 2: // Hamming
-                    dft->win[n] = 25/46.0 - (1.0 - 25/46.0)*cos(_2PI*n / (float)(dft->N2-1));
-                    break ;
-            case 3: // Blackmann
-                    dft->win[n] =  7938/18608.0
-                                 - 9240/18608.0*cos(_2PI*n / (float)(dft->N2-1))
-                                 + 1430/18608.0*cos(4*M_PI*n / (float)(dft->N2-1));
-                    break ;
-        }
-    }
-    while (n < dft->N) dft->win[n++] = 0.0;
-
-    return 0;
-}
-
-
 /* ------------------------------------------------------------------------------------ */
 
 static int getCorrDFT(dsp_t *dsp) {
     int i;
     int mp = -1;
     float mx = 0.0;
-    float mx2 = 0.0;
-    float re_cx = 0.0;
-    float xnorm = 1;
     ui32_t mpos = 0;
     ui32_t pos = dsp->sample_out;
 
@@ -347,61 +185,8 @@ static int getCorrDFT(dsp_t *dsp) {
     if (dsp->K + dsp->L > dsp->DFT.N) return -1;
     if (dsp->sample_out < dsp->L) return -2;
 
-
-    for (i = 0; i < dsp->K + dsp->L; i++) dsp->DFT.xn[i] = sbuf[(pos+dsp->M -(dsp->K + dsp->L-1) + i) % dsp->M];
-    while (i < dsp->DFT.N) dsp->DFT.xn[i++] = 0.0;
-
-
-    rdft(&dsp->DFT, dsp->DFT.xn, dsp->DFT.X);
-
-
-    if (dsp->opt_dc) {
-        /*
-        //X[0] = 0; // nicht ueber gesamte Laenge ... M10
-        //
-        // L < K ?  // only last 2L samples (avoid M10 carrier offset)
-        //dc = 0.0;
-        //for (i = dsp->K - dsp->L; i < dsp->K + dsp->L; i++) dc += dsp->DFT.xn[i];
-        //dc /= 2.0*(float)dsp->L;
-        dc = 0.0;
-        for (i = dsp->K; i < dsp->K + dsp->L; i++) dc += dsp->DFT.xn[i];
-        dc /= 1.0*(float)dsp->L;
-        dsp->DFT.X[0] -= dsp->DFT.N * dc  * 0.95;  // dc * dsp->L
-        */
-        dsp->DFT.X[0] = 0;
-        Nidft(&dsp->DFT, dsp->DFT.X, dsp->DFT.cx);
-        for (i = 0; i < dsp->DFT.N; i++) (dsp->DFT).xn[i] = creal(dsp->DFT.cx[i])/(float)dsp->DFT.N;
-    }
-
-    for (i = 0; i < dsp->DFT.N; i++) dsp->DFT.Z[i] = dsp->DFT.X[i]*dsp->DFT.Fm[i];
-
-    Nidft(&dsp->DFT, dsp->DFT.Z, dsp->DFT.cx);
-
-
-    // relativ Peak - Normierung erst zum Schluss;
-    // dann jedoch nicht zwingend corr-Max wenn FM-Amplitude bzw. norm(x) nicht konstant
-    // (z.B. rs41 Signal-Pausen). Moeglicherweise wird dann wahres corr-Max in dem
-    //  K-Fenster nicht erkannt, deshalb K nicht zu gross waehlen.
-    //
-    mx2 = 0.0;                                      // t = L-1
-    for (i = dsp->L-1; i < dsp->K + dsp->L; i++) {  // i=t .. i=t+K < t+1+K
-        re_cx = creal(dsp->DFT.cx[i]);  // imag(cx)=0
-        if (re_cx*re_cx > mx2) {
-            mx = re_cx;
-            mx2 = mx*mx;
-            mp = i;
-        }
-    }
-    if (mp == dsp->L-1 || mp == dsp->K + dsp->L-1) return -4; // Randwert
-    //  mp == t           mp == K+t
-
-    mpos = pos - (dsp->K + dsp->L-1) + mp; // t = L-1
-
-    xnorm = 0.0;
-    for (i = 0; i < dsp->L; i++) xnorm += dsp->DFT.xn[mp-i]*dsp->DFT.xn[mp-i];
-    xnorm = sqrt(xnorm);
-
-    mx /= xnorm*dsp->DFT.N;
+    mp = dft_corr(&dsp->DFT, sbuf, dsp->M, pos, dsp->K, dsp->L, dsp->opt_dc, &mx, &mpos);
+    if (mp < 0) return mp;
 
     dsp->mv = mx;
     dsp->mv_pos = mpos;
@@ -409,6 +194,8 @@ static int getCorrDFT(dsp_t *dsp) {
     if (pos == dsp->sample_out) dsp->buffered = dsp->sample_out - mpos;
 
 
+    // L-band: second correlation on the FM buffer (IQ modes) while not locked,
+    // header accepted on either score (find_header)
     dsp->mv2 = 0.0f;
     dsp->mv2_pos = 0;
     if (dsp->opt_dc) {
@@ -416,38 +203,8 @@ static int getCorrDFT(dsp_t *dsp) {
             mx = 0.0f;
             mpos = 0;
 
-            for (i = 0; i < dsp->K + dsp->L; i++) dsp->DFT.xn[i] = dcbuf[(pos+dsp->M -(dsp->K + dsp->L-1) + i) % dsp->M];
-            while (i < dsp->DFT.N) dsp->DFT.xn[i++] = 0.0;
-            rdft(&dsp->DFT, dsp->DFT.xn, dsp->DFT.X);
-
-            dsp->DFT.X[0] = 0;
-            Nidft(&dsp->DFT, dsp->DFT.X, dsp->DFT.cx);
-            for (i = 0; i < dsp->DFT.N; i++) dsp->DFT.xn[i] = creal(dsp->DFT.cx[i])/(float)dsp->DFT.N;
-
-            for (i = 0; i < dsp->DFT.N; i++) dsp->DFT.Z[i] = dsp->DFT.X[i]*dsp->DFT.Fm[i];
-
-            Nidft(&dsp->DFT, dsp->DFT.Z, dsp->DFT.cx);
-
-            mx2 = 0.0;                                      // t = L-1
-            for (i = dsp->L-1; i < dsp->K + dsp->L; i++) {  // i=t .. i=t+K < t+1+K
-                re_cx = creal(dsp->DFT.cx[i]);  // imag(cx)=0
-                if (re_cx*re_cx > mx2) {
-                    mx = re_cx;
-                    mx2 = mx*mx;
-                    mp = i;
-                }
-            }
-            if (mp == dsp->L-1 || mp == dsp->K + dsp->L-1) return -4; // Randwert
-            //  mp == t           mp == K+t
-
-            mpos = pos - (dsp->K + dsp->L-1) + mp; // t = L-1
-
-            xnorm = 0.0;
-            for (i = 0; i < dsp->L; i++) xnorm += dsp->DFT.xn[mp-i]*dsp->DFT.xn[mp-i];
-            xnorm = sqrt(xnorm);
-
-            mx /= xnorm*(dsp->DFT).N;
-
+            mp = dft_corr(&dsp->DFT, dcbuf, dsp->M, pos, dsp->K, dsp->L, 1, &mx, &mpos);
+            if (mp < 0) return mp;
 
             dsp->mv2 = mx;
             dsp->mv2_pos = mpos;
@@ -691,96 +448,6 @@ static int f32read_cblock(dsp_t *dsp) {
 // decimate lowpass
 static float *ws_dec;
 
-static double sinc(double x) {
-    double y;
-    if (x == 0) y = 1;
-    else y = sin(M_PI*x)/(M_PI*x);
-    return y;
-}
-
-static int lowpass_init(float f, int taps, float **pws) {
-    double *h, *w;
-    double norm = 0;
-    int n;
-    float *ws = NULL;
-
-    if (taps % 2 == 0) taps++; // odd/symmetric
-
-    if ( taps < 1 ) taps = 1;
-
-    h = (double*)calloc( taps+1, sizeof(double)); if (h == NULL) return -1;
-    w = (double*)calloc( taps+1, sizeof(double)); if (w == NULL) return -1;
-    ws = (float*)calloc( 2*taps+1, sizeof(float)); if (ws == NULL) return -1;
-
-    for (n = 0; n < taps; n++) {
-        w[n] = 7938/18608.0 - 9240/18608.0*cos(_2PI*n/(taps-1)) + 1430/18608.0*cos(4*M_PI*n/(taps-1)); // Blackmann
-        h[n] = 2*f*sinc(2*f*(n-(taps-1)/2));
-        ws[n] = w[n]*h[n];
-        norm += ws[n]; // 1-norm
-    }
-    for (n = 0; n < taps; n++) {
-        ws[n] /= norm; // 1-norm
-    }
-
-    for (n = 0; n < taps; n++) ws[taps+n] = ws[n]; // duplicate/unwrap
-
-    *pws = ws;
-
-    free(h); h = NULL;
-    free(w); w = NULL;
-
-    return taps;
-}
-
-static float complex lowpass1a(float complex buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    double complex w = 0;
-    ui32_t n;
-    ui32_t S = taps-1 + (sample % taps);
-    for (n = 0; n < taps; n++) {
-        w += buffer[n]*ws[S-n]; // ws[taps+s-n] = ws[(taps+sample-n)%taps]
-    }
-    return (float complex)w;
-// symmetry: ws[n] == ws[taps-1-n]
-}
-//static __attribute__((optimize("-ffast-math"))) float complex lowpass()
-static float complex lowpass(float complex buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    float complex w = 0;
-    int n; // -Ofast
-    int S = taps - (sample % taps);
-    for (n = 0; n < taps; n++) {
-        w += buffer[n]*ws[S+n]; // ws[taps+s-n] = ws[(taps+sample-n)%taps]
-    }
-    return w;
-// symmetry: ws[n] == ws[taps-1-n]
-}
-static float complex lowpass2(float complex buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    float complex w = 0;
-    int n;
-    int s = sample % taps;
-    int S1 = s;
-    int S1N = S1-taps;
-    int n0 = taps-s;
-    for (n = 0; n < n0; n++) {
-        w += buffer[S1+n]*ws[n];
-    }
-    for (n = n0; n < taps; n++) {
-        w += buffer[S1N+n]*ws[n];
-    }
-    return w;
-// symmetry: ws[n] == ws[taps-1-n]
-}
-
-static float re_lowpass(float buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    float w = 0;
-    int n;
-    int S = taps - (sample % taps);
-    for (n = 0; n < taps; n++) {
-        w += buffer[n]*ws[S+n]; // ws[taps+s-n] = ws[(taps+sample-n)%taps]
-    }
-    return w;
-}
-
-
 static
 int f32buf_sample(dsp_t *dsp, int inv) {
     float s = 0.0;
@@ -1562,106 +1229,6 @@ int find_header(dsp_t *dsp, float thres, int hdmax, int bitofs, int opt_dc) {
 /* ------------------------------------------------------------------------------------ */
 
 
-static float cmp_hdb(hdb_t *hdb) { // bit-errors?
-    int i, j;
-    int headlen = hdb->len;
-    int berrs1 = 0, berrs2 = 0;
-
-    i = 0;
-    j = hdb->bufpos;
-    while (i < headlen) {
-        if (j < 0) j = headlen-1;
-        if (hdb->buf[j] != hdb->hdr[headlen-1-i]) berrs1 += 1;
-        j--;
-        i++;
-    }
-
-    i = 0;
-    j = hdb->bufpos;
-    while (i < headlen) {
-        if (j < 0) j = headlen-1;
-        if ((hdb->buf[j]^0x01) != hdb->hdr[headlen-1-i]) berrs2 += 1;
-        j--;
-        i++;
-    }
-
-    if (berrs2 < berrs1) return (-headlen+berrs2)/(float)headlen;
-    else                 return ( headlen-berrs1)/(float)headlen;
-
-    return 0;
-}
-
-static float corr_softhdb(hdb_t *hdb) { // max score in window probably not needed
-    int i, j;
-    int headlen = hdb->len;
-    double sum = 0.0;
-    double normx = 0.0,
-           normy = 0.0;
-    float x, y;
-
-    i = 0;
-    j = hdb->bufpos + 1;
-
-    while (i < headlen) {
-        if (j >= headlen) j = 0;
-        x = hdb->sbuf[j];
-        y = 2.0*(hdb->hdr[i]&0x1) - 1.0;
-        sum += y * hdb->sbuf[j];
-        normx += x*x;
-        normy += y*y;
-        j++;
-        i++;
-    }
-    sum /= sqrt(normx*normy);
-
-    return sum;
-}
-
-static
-int f32soft_read(FILE *fp, float *s) {
-    unsigned int word = 0;
-    short *b = (short*)&word;
-    float *f = (float*)&word;
-    int bps = 32;
-
-    if (fread( &word, bps/8, 1, fp) != 1) return EOF;
-
-    if (bps == 32) {
-        *s = *f;
-    }
-    else {
-        if (bps ==  8) { *b -= 128; }
-        *s = *b/128.0;
-        if (bps == 16) { *s /= 256.0; }
-    }
-
-    return 0;
-}
-
-static
-int find_softbinhead(FILE *fp, hdb_t *hdb, float *score) {
-    int headlen = hdb->len;
-    float sbit;
-    float mv;
-
-    //*score = 0.0;
-
-    while ( f32soft_read(fp, &sbit) != EOF )
-    {
-        hdb->bufpos = (hdb->bufpos+1) % headlen;
-        hdb->sbuf[hdb->bufpos] = sbit;
-
-        mv = corr_softhdb(hdb);
-
-        if ( fabs(mv) > hdb->ths ) {
-            *score = mv;
-            return 1;
-        }
-    }
-
-    return EOF;
-}
-
 // -------------------------------------------------------------------------------------------------
 /* ------------------------------------------------------------------------------------------------- */
 
@@ -2370,7 +1937,7 @@ int main(int argc, char **argv) {
     while ( 1 )
     {
         if (option_softin) {
-            header_found = find_softbinhead(fp, &hdb, &_mv);
+            header_found = find_softbinhead(fp, &hdb, &_mv, 0);
         }
         else {                                                              // FM-audio:
             header_found = find_header(&dsp, thres, 1, bitofs, dsp.opt_dc); // optional 2nd pass: dc=0
@@ -2395,7 +1962,7 @@ int main(int argc, char **argv) {
             {
                 if (option_softin) {
                         float s = 0.0;
-                        bitQ = f32soft_read(fp, &s);
+                        bitQ = f32soft_read(fp, &s, 0);
                         if (bitQ != EOF) {
                             bit = (s>=0.0);
                         }
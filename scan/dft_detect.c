@@ -1,9 +1,10 @@
 
 /*
  *  compile:
- *      gcc dft_detect.c -lm -o dft_detect
+ *      (cd ../demod/mod; make libsondedsp.a)
+ *      gcc dft_detect.c ../demod/mod/libsondedsp.a -lm -o dft_detect
  *  speedup:
- *      gcc -Ofast dft_detect.c -lm -o dft_detect
+ *      gcc -Ofast dft_detect.c ../demod/mod/libsondedsp.a -lm -o dft_detect
  *
  *  author: zilog80
  */
@@ -14,15 +15,8 @@
 #include <math.h>
 #include <complex.h>
 
-#ifndef M_PI
-    #define M_PI  (3.1415926535897932384626433832795)
-#endif
-
-typedef unsigned char  ui8_t;
-typedef unsigned short ui16_t;
-typedef unsigned int   ui32_t;
-typedef short i16_t;
-typedef int   i32_t;
+#include "../demod/mod/dsp_core.h"  // DFT, FIR lowpass (libsondedsp.a)
+#include "../demod/mod/iq_shm.h"
 
 
 static int option_verbose = 0,  // ausfuehrliche Anzeige
@@ -273,9 +267,8 @@ static float *ws_dec;
 static double dsp__xlt_fq = 0.0;
 
 
-static int LOG2N, N_DFT;
-
-static float complex  *ew;
+static dft_t DFT;  // N, LOG2N, ew
+static int N_DFT;
 
 static float complex  *X, *Z, *cx;
 static float *xn;
@@ -292,66 +285,10 @@ static int dsp__lpIQtaps; // ui32_t
 static float complex *lpIQ_buf;
 
 
-static void dft_raw(float complex *Z) {
-    int s, l, l2, i, j, k;
-    float complex  w1, w2, T;
-
-    j = 1;
-    for (i = 1; i < N_DFT; i++) {
-        if (i < j) {
-            T = Z[j-1];
-            Z[j-1] = Z[i-1];
-            Z[i-1] = T;
-        }
-        k = N_DFT/2;
-        while (k < j) {
-            j = j - k;
-            k = k/2;
-        }
-        j = j + k;
-    }
-
-    for (s = 0; s < LOG2N; s++) {
-        l2 = 1 << s;
-        l  = l2 << 1;
-        w1 = (float complex)1.0;
-        w2 = ew[s]; // cexp(-I*M_PI/(float)l2)
-        for (j = 1; j <= l2; j++) {
-            for (i = j; i <= N_DFT; i += l) {
-                k = i + l2;
-                T = Z[k-1] * w1;
-                Z[k-1] = Z[i-1] - T;
-                Z[i-1] = Z[i-1] + T;
-            }
-            w1 = w1 * w2;
-        }
-    }
-}
-
-static void dft(float *x, float complex *Z) {
-    int i;
-    for (i = 0; i < N_DFT; i++)  Z[i] = (float complex)x[i];
-    dft_raw(Z);
-}
-
-static void Nidft(float complex *Z, float complex *z) {
-    int i;
-    for (i = 0; i < N_DFT; i++)  z[i] = conj(Z[i]);
-    dft_raw(z);
-    // idft():
-    // for (i = 0; i < N_DFT; i++)  z[i] = conj(z[i])/(float)N_DFT; // hier: z reell
-}
-
 static float freq2bin(int f) {
     return  f * N_DFT / (float)sample_rate;
 }
 
-static float bin2freq(int k) {
-    float fq = k / (float)N_DFT;
-    if ( fq >= 0.5) fq -= 1.0;
-    return fq*sample_rate;
-}
-
 /* ------------------------------------------------------------------------------------ */
 
 static int getCorrDFT(int K, unsigned int pos, float *maxv, unsigned int *maxvpos, rsheader_t *rshd) {
@@ -376,7 +313,7 @@ static int getCorrDFT(int K, unsigned int pos, float *maxv, unsigned int *maxvpo
     for (i = 0; i < K+rshd->L; i++) xn[i] = bufs[(pos+M -(K+rshd->L-1) + i) % M];
     while (i < N_DFT) xn[i++] = 0.0;
 
-    dft(xn, X);
+    rdft(&DFT, xn, X);
 
 
     //dc = get_bufmu(pos-sample_out); //oder: dc = creal(X[0])/(K+rshd->L) = avg(xn) // zu lang (M10)
@@ -397,11 +334,11 @@ static int getCorrDFT(int K, unsigned int pos, float *maxv, unsigned int *maxvpo
     }
 
     if (option_dc || option_iq) { // mx = mx(xn[]), xn(lowpass, dc)
-        Nidft(X, cx);
+        Nidft(&DFT, X, cx);
         for (i = 0; i < N_DFT; i++) xn[i] = creal(cx[i])/(float)N_DFT;
     }
     for (i = 0; i < N_DFT; i++) Z[i] = X[i] * rshd->Fm[i];
-    Nidft(Z, cx);
+    Nidft(&DFT, Z, cx);
 
 
     // relativ Peak - Normierung erst zum Schluss;
@@ -513,6 +450,14 @@ static int read_wav_header(FILE *fp, int wav_channel) {
     return 0;
 }
 
+// IQ input from shared-memory ring (iq_shmw) instead of fp
+static iqshm_t *shm = NULL;
+
+static size_t iq_fread(void *ptr, size_t size, size_t n, FILE *fp) {
+    if (shm) return iqshm_read(shm, ptr, size, n);
+    return fread(ptr, size, n, fp);
+}
+
 static int f32read_sample(FILE *fp, float *s) {
     int i;
     unsigned int word = 0;
@@ -521,7 +466,7 @@ static int f32read_sample(FILE *fp, float *s) {
 
     for (i = 0; i < channels; i++) {
 
-        if (fread( &word, bits_sample/8, 1, fp) != 1) return EOF;
+        if (iq_fread( &word, bits_sample/8, 1, fp) != 1) return EOF;
 
         if (i == wav_ch) {  // i = 0: links bzw. mono
             //if (bits_sample ==  8)  sint = b-128;   // 8bit: 00..FF, centerpoint 0x80=128
@@ -559,19 +504,19 @@ static int f32read_csample(FILE *fp, float complex *z) {
 
     if (bits_sample == 32) { //float32
         float f[2];
-        if (fread( f, bits_sample/8, 2, fp) != 2) return EOF;
+        if (iq_fread( f, bits_sample/8, 2, fp) != 2) return EOF;
         x = f[0];
         y = f[1];
     }
     else if (bits_sample == 16) { //int16
         short b[2];
-        if (fread( b, bits_sample/8, 2, fp) != 2) return EOF;
+        if (iq_fread( b, bits_sample/8, 2, fp) != 2) return EOF;
         x = b[0]/32768.0;
         y = b[1]/32768.0;
     }
     else {  // bits_sample == 8   //uint8
         ui8_t u[2];
-        if (fread( u, bits_sample/8, 2, fp) != 2) return EOF;
+        if (iq_fread( u, bits_sample/8, 2, fp) != 2) return EOF;
         x = (u[0]-128)/128.0;
         y = (u[1]-128)/128.0;
     }
@@ -600,7 +545,7 @@ static int f32read_cblock(FILE *fp) {
 
     if (bits_sample == 8) { //uint8
         ui8_t u[2*dsp__decM];
-        len = fread( u, bits_sample/8, 2*dsp__decM, fp) / 2;
+        len = iq_fread( u, bits_sample/8, 2*dsp__decM, fp) / 2;
         //for (n = 0; n < len; n++) dsp__decMbuf[n] = (u[2*n]-128)/128.0 + I*(u[2*n+1]-128)/128.0;
         // u8: 0..255, 128 -> 0V
         for (n = 0; n < len; n++) {
@@ -619,7 +564,7 @@ static int f32read_cblock(FILE *fp) {
     }
     else if (bits_sample == 16) { //int16
         short b[2*dsp__decM];
-        len = fread( b, bits_sample/8, 2*dsp__decM, fp) / 2;
+        len = iq_fread( b, bits_sample/8, 2*dsp__decM, fp) / 2;
         for (n = 0; n < len; n++) {
             x = b[2*n  ]/32768.0;
             y = b[2*n+1]/32768.0;
@@ -636,7 +581,7 @@ static int f32read_cblock(FILE *fp) {
     }
     else { // bits_sample == 32   //float32
         float f[2*dsp__decM];
-        len = fread( f, bits_sample/8, 2*dsp__decM, fp) / 2;
+        len = iq_fread( f, bits_sample/8, 2*dsp__decM, fp) / 2;
         for (n = 0; n < len; n++) {
             x = f[2*n];
             y = f[2*n+1];
@@ -655,85 +600,6 @@ static int f32read_cblock(FILE *fp) {
     return len;
 }
 
-static double sinc(double x) {
-    double y;
-    if (x == 0) y = 1;
-    else y = sin(M_PI*x)/(M_PI*x);
-    return y;
-}
-
-static int lowpass_init(float f, int taps, float **pws) {
-    double *h, *w;
-    double norm = 0;
-    int n;
-    float *ws = NULL;
-
-    if (taps % 2 == 0) taps++; // odd/symmetric
-
-    if ( taps < 1 ) taps = 1;
-
-    h = (double*)calloc( taps+1, sizeof(double)); if (h == NULL) return -1;
-    w = (double*)calloc( taps+1, sizeof(double)); if (w == NULL) return -1;
-    ws = (float*)calloc( 2*taps+1, sizeof(float)); if (ws == NULL) return -1;
-
-    for (n = 0; n < taps; n++) {
-        w[n] = 7938/18608.0 - 9240/18608.0*cos(2*M_PI*n/(taps-1)) + 1430/18608.0*cos(4*M_PI*n/(taps-1)); // Blackmann
-        h[n] = 2*f*sinc(2*f*(n-(taps-1)/2));
-        ws[n] = w[n]*h[n];
-        norm += ws[n]; // 1-norm
-    }
-    for (n = 0; n < taps; n++) {
-        ws[n] /= norm; // 1-norm
-    }
-
-    for (n = 0; n < taps; n++) ws[taps+n] = ws[n]; // duplicate/unwrap
-
-    *pws = ws;
-
-    free(h); h = NULL;
-    free(w); w = NULL;
-
-    return taps;
-}
-
-// struct { int taps; double *ws}
-static float complex lowpass0(float complex buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    ui32_t n;
-    double complex w = 0;
-    for (n = 0; n < taps; n++) {
-        w += buffer[(sample+n)%taps]*ws[taps-1-n];
-    }
-    return (float complex)w;
-}
-//static __attribute__((optimize("-ffast-math"))) float complex lowpass()
-static float complex lowpass(float complex buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    float complex w = 0;
-    int n; // -Ofast
-    int S = taps - (sample % taps);
-    for (n = 0; n < taps; n++) {
-        w += buffer[n]*ws[S+n]; // ws[taps+s-n] = ws[(taps+sample-n)%taps]
-    }
-    return w;
-// symmetry: ws[n] == ws[taps-1-n]
-}
-static float complex lowpass2(float complex buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    float complex w = 0;
-    int n;
-    int s = sample % taps;
-    int S1 = s;
-    int S1N = S1-taps;
-    int n0 = taps-s;
-    for (n = 0; n < n0; n++) {
-        w += buffer[S1+n]*ws[n];
-    }
-    for (n = n0; n < taps; n++) {
-        w += buffer[S1N+n]*ws[n];
-    }
-    return w;
-// symmetry: ws[n] == ws[taps-1-n]
-}
-
-
 static int f32buf_sample(FILE *fp, int inv) {
     float _s = 0.0;
     float s[N_bwIQ];
@@ -1195,8 +1061,10 @@ static int init_buffers() {
     while (p2 < 0x2000) p2 <<= 1;  // or 0x4000, if sample not too short
     N_DFT = p2;
     K = N_DFT - L;
-    LOG2N = log(N_DFT)/log(2)+0.1; // 32bit cpu ... intermediate floating-point precision
-    //while ((1 << LOG2N) < N_DFT) LOG2N++;  // better N_DFT = (1 << LOG2N) ...
+    DFT.N = N_DFT;
+    DFT.sr = sample_rate;
+    DFT.LOG2N = log(N_DFT)/log(2)+0.1; // 32bit cpu ... intermediate floating-point precision
+    //while ((1 << DFT.LOG2N) < N_DFT) DFT.LOG2N++;  // better N_DFT = (1 << LOG2N) ...
 
     delay = L/16;
     M = N_DFT + delay + 8; // L+K < M
@@ -1212,14 +1080,14 @@ static int init_buffers() {
     xn = calloc(N_DFT+1, sizeof(float));  if (xn == NULL) return -1;
     db = calloc(N_DFT+1, sizeof(float));  if (db == NULL) return -1;
 
-    ew = calloc(LOG2N+1, sizeof(float complex));  if (ew == NULL) return -1;
+    DFT.ew = calloc(DFT.LOG2N+1, sizeof(float complex));  if (DFT.ew == NULL) return -1;
     X  = calloc(N_DFT+1, sizeof(float complex));  if (X  == NULL) return -1;
     Z  = calloc(N_DFT+1, sizeof(float complex));  if (Z  == NULL) return -1;
     cx = calloc(N_DFT+1, sizeof(float complex));  if (cx == NULL) return -1;
 
-    for (n = 0; n < LOG2N; n++) {
+    for (n = 0; n < DFT.LOG2N; n++) {
         k = 1 << n;
-        ew[n] = cexp(-I*M_PI/(float)k);
+        DFT.ew[n] = cexp(-I*M_PI/(float)k);
     }
 
     match = (float *)calloc( L+1, sizeof(float)); if (match == NULL) return -1;
@@ -1261,7 +1129,7 @@ static int init_buffers() {
 
         for (i = 0; i < rs_hdr[j].L; i++) m[rs_hdr[j].L-1 - i] = match[i]; // t = L-1
         while (i < N_DFT) m[i++] = 0.0;
-        dft(m, rs_hdr[j].Fm);
+        rdft(&DFT, m, rs_hdr[j].Fm);
 
     }
 
@@ -1272,7 +1140,7 @@ static int init_buffers() {
             WS[j] = (float complex *)calloc(N_DFT+1, sizeof(float complex));  if (WS[j] == NULL) return -1;
             for (i = 0; i < dsp__lpFMtaps; i++) m[i] = ws_lpFM[j][i];
             while (i < N_DFT) m[i++] = 0.0;
-            dft(m, WS[j]);
+            rdft(&DFT, m, WS[j]);
         }
         Y = (float complex *)calloc(N_DFT+1, sizeof(float complex));  if (Y == NULL) return -1;
     }
@@ -1295,7 +1163,7 @@ static int free_buffers() {
 
     if (xn) { free(xn); xn = NULL; }
     if (db) { free(xn); xn = NULL; }
-    if (ew) { free(ew); ew = NULL; }
+    if (DFT.ew) { free(DFT.ew); DFT.ew = NULL; }
     if (X)  { free(X);  X  = NULL; }
     if (Z)  { free(Z);  Z  = NULL; }
     if (cx) { free(cx); cx = NULL; }
@@ -1339,6 +1207,7 @@ int main(int argc, char **argv) {
 
     FILE *fp = NULL;
     char *fpname = NULL;
+    char *shm_name = NULL;
 
     int j;
     int k, K;
@@ -1374,6 +1243,7 @@ int main(int argc, char **argv) {
             fprintf(stderr, "       --iq        (IF iq-data)\n");
             fprintf(stderr, "       --IQ <fq>   (baseband IQ at fq)\n");
             fprintf(stderr, "       --bw <kHz>  (set IQ filter bw/kHz)\n");
+            fprintf(stderr, "       --shm <name> (IQ from shared memory ring)\n");
             return 0;
         }
         else if ( (strcmp(*argv, "-v") == 0) || (strcmp(*argv, "--verbose") == 0) ) {
@@ -1431,6 +1301,10 @@ int main(int argc, char **argv) {
             }
             else return -50;
         }
+        else if   (strcmp(*argv, "--shm") == 0) {  // IQ from shared-memory ring (iq_shmw)
+            ++argv;
+            if (*argv) shm_name = *argv; else return -1;
+        }
         else if (strcmp(*argv, "-") == 0) {
             ++argv;
             if (*argv) sample_rate = atoi(*argv); else return -1;
@@ -1455,6 +1329,18 @@ int main(int argc, char **argv) {
     }
     if (!wavloaded) fp = stdin;
 
+    if (shm_name) {
+        shm = iqshm_open(shm_name);
+        if (shm == NULL) {
+            fprintf(stderr, "error: open shm %s\n", shm_name);
+            return -50;
+        }
+        sample_rate = shm->hdr->sr;
+        bits_sample = shm->hdr->bps;
+        channels = shm->hdr->nch;
+        option_pcmraw = 1;
+    }
+
     if (option_d2) {
         option_cont = 0;
     }
@@ -1561,12 +1447,12 @@ int main(int argc, char **argv) {
                                 n++;
 
                                 if (n % D == 0) {
-                                    dft(xn, X);
+                                    rdft(&DFT, xn, X);
                                     for (m = 0; m < N_DFT; m++) db[m] += cabs(X[m]);
                                 }
                             }
 
-                            df = bin2freq(1);
+                            df = bin2freq(&DFT, 1);
                             m = 50.0/df;
                             if (m < 1) m = 1;
                             if (freq2bin(2500) > N_DFT/2) goto ende;
@@ -1632,6 +1518,7 @@ int main(int argc, char **argv) {
                                         }
                                     }
                                     fprintf(stdout, "\n");
+                                    if (option_cont) fflush(stdout);  // -c: report each header as it is found
                                 }
                             }
                             // if ((j < 3) && mv[j] < 0) header_found = -1;
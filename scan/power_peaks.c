@@ -0,0 +1,399 @@
+/*
+ *  power_peaks: spectrum peak search for the auto_rx scanner
+ *
+ *  reads a rtl_power/ss_power log (csv) or a ka9q-radio 'powers' log,
+ *  estimates the noise floor (median), detects the peaks above
+ *  noise floor + snr (local maxima, rising edge; weaker peaks within
+ *  min. distance of a stronger peak are dropped), sorts them by power,
+ *  quantizes, removes duplicates, peaks outside fmin..fmax and near
+ *  never-scan frequencies, and limits the number of peaks.
+ *  the always-scan frequencies go first; every frequency gets the peak level
+ *  (max. power within +-quant/2 around it).
+ *
+ *  output (text):
+ *      nf <noise floor> step <step> bins <n>
+ *      <freq> <level>
+ *      ...
+ *  output (--bin): little endian, see power_peaks_hdr_t
+ *      header, double freq[bins], double power[bins], double peak_freq[n], double peak_lvl[n]
+ *
+ *  compile:
+ *      gcc -O2 power_peaks.c -lm -o power_peaks
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+
+#define MAX_FQLIST  256
+
+#define PP_MAGIC    0x50505350  // "PSPP"
+
+typedef struct {
+    unsigned int magic;
+    unsigned int bins;      // spectrum bins
+    unsigned int peaks;     // peak frequencies
+    unsigned int reserved;
+    double step;            // frequency step (log file), Hz
+    double nf;              // noise floor estimate
+} power_peaks_hdr_t;
+
+
+typedef struct {
+    double *freq;
+    double *power;
+    int     n;
+    int     size;
+    double  step;
+} spectrum_t;
+
+typedef struct {
+    int idx;
+    double pwr;
+} peak_t;
+
+
+static int spec_add(spectrum_t *s, double f, double p) {
+    if (s->n == s->size) {
+        int size = s->size ? 2*s->size : 1<<16;
+        double *freq = realloc(s->freq, size*sizeof(double));
+        double *power = realloc(s->power, size*sizeof(double));
+        if (freq) s->freq = freq;
+        if (power) s->power = power;
+        if (freq == NULL || power == NULL) return -1;
+        s->size = size;
+    }
+    s->freq[s->n] = f;
+    s->power[s->n] = p;
+    s->n += 1;
+    return 0;
+}
+
+// field i of a csv line (0-based), NULL if there are fewer fields
+static char *csv_field(char *line, int i) {
+    char *p = line;
+    while (i > 0) {
+        p = strchr(p, ',');
+        if (p == NULL) return NULL;
+        p++;
+        i--;
+    }
+    return p;
+}
+
+/*
+ * rtl_power: date, time, f_start, f_stop, step, samples, p_0, p_1, ...
+ * ka9q powers: datetime, f_start, f_stop, step, bins, p_0, p_1, ...  (1st line: burn-in scan)
+ * the frequencies of a line run linearly from f_start to f_stop
+ */
+static int read_log(FILE *fp, int ka9q, spectrum_t *s) {
+    char *line = NULL;
+    size_t len = 0;
+    int nf = ka9q ? 5 : 6;  // header fields
+    int first = 1;
+    int ret = 0;
+
+    while (getline(&line, &len, fp) > 0) {
+        char *p, *q;
+        double f0, f1;
+        int n0, m, i;
+
+        if (ka9q && first) { first = 0; continue; }
+
+        p = csv_field(line, nf-4);
+        if (p == NULL || csv_field(line, nf-1) == NULL) { ret = -1; break; }
+        f0 = strtod(p, NULL);
+        f1 = strtod(csv_field(line, nf-3), NULL);
+        s->step = strtod(csv_field(line, nf-2), NULL);
+
+        n0 = s->n;
+        p = csv_field(line, nf);
+        while (p) {
+            double x = strtod(p, &q);
+            if (q == p) break;
+            // numpy.nan_to_num()
+            if (isnan(x)) x = 0.0;
+            else if (x >  DBL_MAX) x =  DBL_MAX;
+            else if (x < -DBL_MAX) x = -DBL_MAX;
+            if (spec_add(s, 0.0, x) < 0) { ret = -1; break; }
+            p = strchr(q, ',');
+            if (p) p++;
+        }
+        // numpy.linspace(f0, f1, m)
+        m = s->n - n0;
+        for (i = 0; i < m; i++) {
+            s->freq[n0+i] = (m > 1) ? f0 + i*(f1-f0)/(m-1) : f0;
+        }
+        if (m > 1) s->freq[n0+m-1] = f1;
+        if (ret) break;
+    }
+
+    free(line);
+    return ret;
+}
+
+// k-th smallest (Hoare's find): afterwards a[0..k-1] <= a[k] <= a[k+1..n-1]
+static double select_k(double *a, int n, int k) {
+    int l = 0, r = n-1;
+    while (l < r) {
+        double x = a[k];
+        int i = l, j = r;
+        while (i <= j) {
+            while (a[i] < x) i++;
+            while (a[j] > x) j--;
+            if (i <= j) { double t = a[i]; a[i] = a[j]; a[j] = t; i++; j--; }
+        }
+        if (j < k) l = i;
+        if (k < i) r = j;
+    }
+    return a[k];
+}
+
+// numpy.median()
+static double median(double *x, int n) {
+    double m, m1;
+    int i;
+    double *a = malloc(n*sizeof(double));
+    if (a == NULL) return 0.0;
+    memcpy(a, x, n*sizeof(double));
+    m = select_k(a, n, n/2);
+    if (n % 2 == 0) {
+        m1 = a[0];
+        for (i = 1; i < n/2; i++) if (a[i] > m1) m1 = a[i];
+        m = 0.5*(m + m1);
+    }
+    free(a);
+    return m;
+}
+
+// descending power; equal power: higher index first
+static int cmp_peak(const void *a, const void *b) {
+    const peak_t *pa = a, *pb = b;
+    if (pa->pwr > pb->pwr) return -1;
+    if (pa->pwr < pb->pwr) return  1;
+    return pb->idx - pa->idx;
+}
+
+/*
+ * local maxima x[i-1] < x[i] >= x[i+1] (rising edge of a flat peak) with x[i] >= mph;
+ * in order of decreasing height, a peak removes the weaker peaks within +-mpd bins.
+ * return: number of peaks, sorted by power (descending)
+ */
+static int detect_peaks(spectrum_t *s, double mph, double mpd, peak_t *pk) {
+    double *x = s->power;
+    unsigned char *del;
+    int n = 0, m = 0;
+    int i;
+
+    for (i = 1; i < s->n-1; i++) {
+        if (x[i]-x[i-1] > 0 && x[i+1]-x[i] <= 0 && x[i] >= mph) {
+            pk[n].idx = i;
+            pk[n].pwr = x[i];
+            n++;
+        }
+    }
+    qsort(pk, n, sizeof(peak_t), cmp_peak);
+
+    if (mpd <= 1) return n;
+
+    del = calloc(s->n, 1);
+    if (del == NULL) return n;
+    for (i = 0; i < n; i++) {
+        int j, j0, j1;
+        if (del[pk[i].idx]) continue;
+        pk[m++] = pk[i];
+        j0 = (int)ceil(pk[i].idx - mpd);
+        j1 = (int)floor(pk[i].idx + mpd);
+        if (j0 < 0) j0 = 0;
+        if (j1 > s->n-1) j1 = s->n-1;
+        for (j = j0; j <= j1; j++) del[j] = 1;
+    }
+    free(del);
+
+    return m;
+}
+
+// max. power within +-r bins around the bin closest to f
+static double peak_level(spectrum_t *s, double f, int r, int ascending) {
+    int i, k = 0, i0, i1;
+    double d = fabs(s->freq[0] - f);
+    double lvl;
+
+    if (ascending) {  // 1st bin >= f, or the one before
+        int l = 0, h = s->n;
+        while (l < h) {
+            int c = (l+h)/2;
+            if (s->freq[c] < f) l = c+1; else h = c;
+        }
+        k = (l < s->n) ? l : s->n-1;
+        if (k > 0 && fabs(s->freq[k-1] - f) <= fabs(s->freq[k] - f)) k -= 1;
+    }
+    else {
+        for (i = 1; i < s->n; i++) {
+            if (fabs(s->freq[i] - f) < d) { d = fabs(s->freq[i] - f); k = i; }
+        }
+    }
+    i0 = k - r; if (i0 < 0) i0 = 0;
+    i1 = k + r; if (i1 > s->n-1) i1 = s->n-1;
+    lvl = s->power[i0];
+    for (i = i0+1; i <= i1; i++) if (s->power[i] > lvl) lvl = s->power[i];
+    return lvl;
+}
+
+static int parse_list(char *arg, double *list, int n) {
+    char *p = arg;
+    while (p && *p && n < MAX_FQLIST) {
+        list[n++] = atof(p);
+        p = strchr(p, ',');
+        if (p) p++;
+    }
+    return n;
+}
+
+
+int main(int argc, char **argv) {
+
+    FILE *fp = NULL;
+    char *fpname = NULL;
+    spectrum_t spec = {0};
+    peak_t *pk = NULL;
+    double *pf = NULL;
+    double *pl = NULL;
+    double never[MAX_FQLIST], always[MAX_FQLIST];
+    int n_never = 0, n_always = 0;
+    int option_ka9q = 0,
+        option_bin = 0;
+    double snr = 10.0, min_dist = 1000.0, quant = 10000.0;
+    double fmin = -1.0, fmax = -1.0, search_step = 0.0;
+    int max_peaks = 10;
+    double nf;
+    int n, m, i, j, r, asc;
+
+    fpname = argv[0];
+    ++argv;
+    while (*argv) {
+        if      ( (strcmp(*argv, "-h") == 0) || (strcmp(*argv, "--help") == 0) ) {
+            fprintf(stderr, "%s [options] <power log>\n", fpname);
+            fprintf(stderr, "  options:\n");
+            fprintf(stderr, "       --ka9q              (ka9q-radio powers log)\n");
+            fprintf(stderr, "       --bin               (binary output)\n");
+            fprintf(stderr, "       --snr <dB>          (threshold above noise floor)\n");
+            fprintf(stderr, "       --dist <Hz>         (min. distance between peaks)\n");
+            fprintf(stderr, "       --quant <Hz>        (quantization)\n");
+            fprintf(stderr, "       --fmin <Hz>, --fmax <Hz>\n");
+            fprintf(stderr, "       --step <Hz>         (search step, level search radius)\n");
+            fprintf(stderr, "       --max <n>           (max. number of peaks)\n");
+            fprintf(stderr, "       --never <f1,f2,..>  (Hz)\n");
+            fprintf(stderr, "       --always <f1,f2,..> (Hz)\n");
+            return 0;
+        }
+        else if (strcmp(*argv, "--ka9q") == 0) { option_ka9q = 1; }
+        else if (strcmp(*argv, "--bin") == 0) { option_bin = 1; }
+        else if (strcmp(*argv, "--snr") == 0) {
+            ++argv; if (*argv) snr = atof(*argv); else return -1;
+        }
+        else if (strcmp(*argv, "--dist") == 0) {
+            ++argv; if (*argv) min_dist = atof(*argv); else return -1;
+        }
+        else if (strcmp(*argv, "--quant") == 0) {
+            ++argv; if (*argv) quant = atof(*argv); else return -1;
+        }
+        else if (strcmp(*argv, "--fmin") == 0) {
+            ++argv; if (*argv) fmin = atof(*argv); else return -1;
+        }
+        else if (strcmp(*argv, "--fmax") == 0) {
+            ++argv; if (*argv) fmax = atof(*argv); else return -1;
+        }
+        else if (strcmp(*argv, "--step") == 0) {
+            ++argv; if (*argv) search_step = atof(*argv); else return -1;
+        }
+        else if (strcmp(*argv, "--max") == 0) {
+            ++argv; if (*argv) max_peaks = atoi(*argv); else return -1;
+        }
+        else if (strcmp(*argv, "--never") == 0) {
+            ++argv; if (*argv) n_never = parse_list(*argv, never, n_never); else return -1;
+        }
+        else if (strcmp(*argv, "--always") == 0) {
+            ++argv; if (*argv) n_always = parse_list(*argv, always, n_always); else return -1;
+        }
+        else {
+            fp = fopen(*argv, "r");
+            if (fp == NULL) {
+                fprintf(stderr, "error: open %s\n", *argv);
+                return -1;
+            }
+        }
+        ++argv;
+    }
+    if (fp == NULL) {
+        fprintf(stderr, "error: no power log\n");
+        return -1;
+    }
+
+    if (read_log(fp, option_ka9q, &spec) < 0 || spec.n == 0) {
+        fprintf(stderr, "error: invalid power log\n");
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    pk = malloc(spec.n * sizeof(peak_t));
+    pf = malloc((spec.n + n_always) * sizeof(double));
+    pl = malloc((spec.n + n_always) * sizeof(double));
+    if (pk == NULL || pf == NULL || pl == NULL) return -1;
+
+    nf = median(spec.power, spec.n);
+
+    n = detect_peaks(&spec, nf + snr, spec.step > 0 ? min_dist / spec.step : 0, pk);
+
+    // always-scan frequencies first
+    m = 0;
+    for (i = 0; i < n_always; i++) pf[m++] = always[i];
+
+    for (i = 0; i < n && m - n_always < max_peaks; i++) {
+        double f = nearbyint(spec.freq[pk[i].idx] / quant) * quant;
+        // duplicates (after quantization)
+        for (j = n_always; j < m; j++) if (pf[j] == f) break;
+        if (j < m) continue;
+        // fmin..fmax
+        if (fmin >= 0 && f < fmin - quant/2.0) continue;
+        if (fmax >= 0 && f > fmax + quant/2.0) continue;
+        // never-scan
+        for (j = 0; j < n_never; j++) if (fabs(f - never[j]) < quant/2.0) break;
+        if (j < n_never) continue;
+        pf[m++] = f;
+    }
+
+    if (search_step <= 0) search_step = spec.step;
+    r = (search_step > 0) ? (int)ceil((quant/2.0) / search_step) : 0;
+    asc = 1;  // log lines in frequency order, not overlapping
+    for (i = 1; i < spec.n; i++) if (spec.freq[i] <= spec.freq[i-1]) { asc = 0; break; }
+    for (i = 0; i < m; i++) pl[i] = peak_level(&spec, pf[i], r, asc);
+
+    if (option_bin) {
+        power_peaks_hdr_t hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.magic = PP_MAGIC;
+        hdr.bins = spec.n;
+        hdr.peaks = m;
+        hdr.step = spec.step;
+        hdr.nf = nf;
+        fwrite(&hdr, sizeof(hdr), 1, stdout);
+        fwrite(spec.freq, sizeof(double), spec.n, stdout);
+        fwrite(spec.power, sizeof(double), spec.n, stdout);
+        fwrite(pf, sizeof(double), m, stdout);
+        fwrite(pl, sizeof(double), m, stdout);
+    }
+    else {
+        printf("nf %.2f step %.2f bins %d\n", nf, spec.step, spec.n);
+        for (i = 0; i < m; i++) printf("%.0f %.2f\n", pf[i], pl[i]);
+    }
+
+    free(pk); free(pf); free(pl);
+    free(spec.freq); free(spec.power);
+
+    return 0;
+}
@@ -54,6 +54,12 @@
 */
 #define GENERATE_HANN_TABLE_RUNTIME
 
+/* Use the optimised demod core by default: ring buffer integrator memory,
+   precomputed per-tone mixers with a vectorisable complex multiply, and
+   prefix-sum (boxcar) symbol integration. The reference core can still be
+   selected at run time with fsk_set_fast_core(). */
+#define FSK_FAST_CORE
+
 /* Turn off table generation if on cortex M4 to save memory */
 #ifdef CORTEX_M4
 #undef USE_HANN_TABLE
@@ -165,6 +171,18 @@ struct FSK * fsk_create_core(int Fs, int Rs, int M, int P, int Nsym, int tx_f1,
     fsk->f_dc = (COMP*)malloc(M*fsk->Nmem*sizeof(COMP)); assert(fsk->f_dc != NULL);
     for(i=0; i<M*fsk->Nmem; i++)
         fsk->f_dc[i] = comp0();
+
+    #ifdef FSK_FAST_CORE
+    fsk->fast_core = 1;
+    #else
+    fsk->fast_core = 0;
+    #endif
+    fsk->dc_pos = 0;
+    fsk->dc_re = (float*)calloc(M*2*fsk->Nmem, sizeof(float)); assert(fsk->dc_re != NULL);
+    fsk->dc_im = (float*)calloc(M*2*fsk->Nmem, sizeof(float)); assert(fsk->dc_im != NULL);
+    fsk->mix_re = (float*)malloc(fsk->Nmem*sizeof(float)); assert(fsk->mix_re != NULL);
+    fsk->mix_im = (float*)malloc(fsk->Nmem*sizeof(float)); assert(fsk->mix_im != NULL);
+    fsk->dc_cs = (double*)malloc(2*(fsk->Nmem+1)*sizeof(double)); assert(fsk->dc_cs != NULL);
         
     fsk->fft_cfg = kiss_fft_alloc(Ndft,0,NULL,NULL); assert(fsk->fft_cfg != NULL);    
     fsk->Sf = (float*)malloc(sizeof(float)*fsk->Ndft); assert(fsk->Sf != NULL);
@@ -248,6 +266,11 @@ struct FSK * fsk_create_hbr(int Fs, int Rs, int M, int P, int Nsym, int tx_f1, i
 
 void fsk_destroy(struct FSK *fsk){
     free(fsk->f_dc);
+    free(fsk->dc_re);
+    free(fsk->dc_im);
+    free(fsk->mix_re);
+    free(fsk->mix_im);
+    free(fsk->dc_cs);
     free(fsk->fft_cfg);
     free(fsk->stats);
     free(fsk->hann_table);
@@ -589,50 +612,36 @@ void fsk_demod_freq_est(struct FSK *fsk, COMP fsk_in[], float *freqs, int M) {
     #endif
 }
 
-/* core demodulator function */
-void fsk_demod_core(struct FSK *fsk, uint8_t rx_bits[], float rx_sd[], COMP fsk_in[]){
-    int N = fsk->N;
-    int Ts = fsk->Ts;
-    int Rs = fsk->Rs;
+/*---------------------------------------------------------------------------*\
+
+  FUNCTION....: fsk_demod_integrate
+
+  Reference down conversion and symbol integration, as ported from
+  fsk_horus.m. Shifts nin new samples into the f_dc memory, then sums
+  Ts samples for each of the (nsym+1)*P timing offsets.
+
+\*---------------------------------------------------------------------------*/
+
+static void fsk_demod_integrate(struct FSK *fsk, COMP fsk_in[], float *f_est, COMP *f_int){
     int Fs = fsk->Fs;
+    int Ts = fsk->Ts;
     int nsym = fsk->Nsym;
     int nin = fsk->nin;
     int P = fsk->P;
     int Nmem = fsk->Nmem;
     int M = fsk->mode;
+    int nint = (nsym+1)*P;
     size_t i,j,m;
-    float ft1;
-    
-    COMP t[M];          /* complex number temps */
-    COMP t_c;           /* another complex temp */
-    COMP *phi_c = fsk->phi_c;  
-    COMP *f_dc = fsk->f_dc;  
-    COMP phi_ft;        
+
+    COMP *phi_c = fsk->phi_c;
+    COMP *f_dc = fsk->f_dc;
     int nold = Nmem-nin;
-    
-    COMP dphift;
-    float rx_timing,norm_rx_timing,old_norm_rx_timing,d_norm_rx_timing,appm;
 
-    float fc_avg,fc_tx;
-    float meanebno,stdebno,eye_max;
-    int neyesamp,neyeoffset;
-    
     #ifdef MODEMPROBE_ENABLE
     #define NMP_NAME 26
     char mp_name_tmp[NMP_NAME+1]; /* Temporary string for modem probe trace names */
     #endif
 
-    /* Estimate tone frequencies */
-    fsk_demod_freq_est(fsk,fsk_in,fsk->f_est,M);
-    #ifdef MODEMPROBE_ENABLE
-    modem_probe_samp_f("t_f_est",fsk->f_est,M);
-    #endif
-    float *f_est;
-    if (fsk->freq_est_type)
-        f_est = fsk->f2_est;
-    else
-        f_est = fsk->f_est;
-      
     /* update filter (integrator) memory by shifting in nin samples */
     for(m=0; m<M; m++) {
         for(i=0,j=Nmem-nold; i<nold; i++,j++)
@@ -656,16 +665,164 @@ void fsk_demod_core(struct FSK *fsk, uint8_t rx_bits[], float rx_sd[], COMP fsk_
     }
 
     /* integrate over symbol period at a variety of offsets */
-    COMP f_int[M][(nsym+1)*P];
-    for(i=0; i<(nsym+1)*P; i++) {
+    for(i=0; i<nint; i++) {
         int st = i*Ts/P;
         int en = st+Ts-1;
         for(m=0; m<M; m++) {
-            f_int[m][i] = comp0();
+            f_int[m*nint+i] = comp0();
             for(j=st; j<=en; j++)
-                f_int[m][i] = cadd(f_int[m][i], f_dc[m*Nmem+j]);
+                f_int[m*nint+i] = cadd(f_int[m*nint+i], f_dc[m*Nmem+j]);
         }
     }
+}
+
+/*---------------------------------------------------------------------------*\
+
+  FUNCTION....: fsk_demod_integrate_fast
+
+  Optimised version of fsk_demod_integrate(), same results within float
+  tolerance:
+
+  - the per-tone mixer for this cycle is generated once with the same
+    phase recursion, then applied with a split real/imag complex multiply
+    that the compiler can vectorise
+  - the down converted samples live in mirrored ring buffers (each sample
+    is stored at k and k+Nmem), so the last Nmem samples are always
+    contiguous from dc_pos and nothing is shifted
+  - symbol integration uses (double) prefix sums, so each of the
+    (nsym+1)*P offsets costs O(1) instead of O(Ts)
+
+\*---------------------------------------------------------------------------*/
+
+static void fsk_demod_integrate_fast(struct FSK *fsk, COMP fsk_in[], float *f_est, COMP *f_int){
+    int Fs = fsk->Fs;
+    int Ts = fsk->Ts;
+    int nsym = fsk->Nsym;
+    int nin = fsk->nin;
+    int P = fsk->P;
+    int Nmem = fsk->Nmem;
+    int M = fsk->mode;
+    int nint = (nsym+1)*P;
+    int i,m,k,n;
+
+    COMP *phi_c = fsk->phi_c;
+    float *mr = fsk->mix_re;
+    float *mi = fsk->mix_im;
+    double *cs_re = fsk->dc_cs;
+    double *cs_im = fsk->dc_cs + Nmem+1;
+    COMP dphi_m;
+
+    int pos0 = fsk->dc_pos;
+    int pos1 = (pos0 + nin) % Nmem;
+
+    for(m=0; m<M; m++) {
+        float *dre = fsk->dc_re + m*2*Nmem;
+        float *dim = fsk->dc_im + m*2*Nmem;
+
+        /* mixer for this cycle, identical recursion to the reference core */
+        dphi_m = comp_exp_j(2*M_PI*((f_est[m])/(float)(Fs)));
+        for(i=0; i<nin; i++) {
+            phi_c[m] = cmult(phi_c[m],dphi_m);
+            mr[i] = phi_c[m].real;
+            mi[i] = phi_c[m].imag;
+        }
+        phi_c[m] = comp_normalize(phi_c[m]);
+
+        /* fsk_in * conj(mixer), written to the ring and its mirror */
+        k = pos0;
+        for(i=0; i<nin; ) {
+            n = Nmem - k;
+            if (n > nin-i) n = nin-i;
+            float *r0 = dre + k, *r1 = dre + k + Nmem;
+            float *q0 = dim + k, *q1 = dim + k + Nmem;
+            for(int j=0; j<n; j++) {
+                float xr = fsk_in[i+j].real, xi = fsk_in[i+j].imag;
+                float yr = xr*mr[i+j] + xi*mi[i+j];
+                float yi = xi*mr[i+j] - xr*mi[i+j];
+                r0[j] = yr; r1[j] = yr;
+                q0[j] = yi; q1[j] = yi;
+            }
+            i += n;
+            k = 0;
+        }
+
+        /* last Nmem samples, oldest first: dre[pos1 .. pos1+Nmem-1] */
+        dre += pos1;
+        dim += pos1;
+        cs_re[0] = 0;
+        cs_im[0] = 0;
+        for(i=0; i<Nmem; i++) {
+            cs_re[i+1] = cs_re[i] + dre[i];
+            cs_im[i+1] = cs_im[i] + dim[i];
+        }
+
+        for(i=0; i<nint; i++) {
+            int st = i*Ts/P;
+            int en = st+Ts;
+            f_int[m*nint+i].real = (float)(cs_re[en] - cs_re[st]);
+            f_int[m*nint+i].imag = (float)(cs_im[en] - cs_im[st]);
+        }
+    }
+
+    fsk->dc_pos = pos1;
+}
+
+/*---------------------------------------------------------------------------*\
+
+  FUNCTION....: fsk_set_fast_core
+
+  Select the optimised (enable=1) or reference (enable=0) demod core.
+
+\*---------------------------------------------------------------------------*/
+
+void fsk_set_fast_core(struct FSK *fsk, int enable){
+    fsk->fast_core = enable != 0;
+}
+
+/* core demodulator function */
+void fsk_demod_core(struct FSK *fsk, uint8_t rx_bits[], float rx_sd[], COMP fsk_in[]){
+    int N = fsk->N;
+    int Ts = fsk->Ts;
+    int Rs = fsk->Rs;
+    int nsym = fsk->Nsym;
+    int P = fsk->P;
+    int M = fsk->mode;
+    size_t i,j,m;
+    float ft1;
+    
+    COMP t[M];          /* complex number temps */
+    COMP t_c;           /* another complex temp */
+    COMP phi_ft;        
+    
+    COMP dphift;
+    float rx_timing,norm_rx_timing,old_norm_rx_timing,d_norm_rx_timing,appm;
+
+    float fc_avg,fc_tx;
+    float meanebno,stdebno,eye_max;
+    int neyesamp,neyeoffset;
+    
+    #ifdef MODEMPROBE_ENABLE
+    #define NMP_NAME 26
+    char mp_name_tmp[NMP_NAME+1]; /* Temporary string for modem probe trace names */
+    #endif
+
+    /* Estimate tone frequencies */
+    fsk_demod_freq_est(fsk,fsk_in,fsk->f_est,M);
+    #ifdef MODEMPROBE_ENABLE
+    modem_probe_samp_f("t_f_est",fsk->f_est,M);
+    #endif
+    float *f_est;
+    if (fsk->freq_est_type)
+        f_est = fsk->f2_est;
+    else
+        f_est = fsk->f_est;
+      
+    /* down convert the new samples and integrate over symbol period at a variety of offsets */
+    COMP f_int[M][(nsym+1)*P];
+    if (fsk->fast_core)
+        fsk_demod_integrate_fast(fsk, fsk_in, f_est, &f_int[0][0]);
+    else
+        fsk_demod_integrate(fsk, fsk_in, f_est, &f_int[0][0]);
 
     #ifdef MODEMPROBE_ENABLE
     for(m=0; m<M; m++) {
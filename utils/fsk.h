@@ -92,6 +92,15 @@ struct FSK {
     /*  modem statistic struct */
     struct MODEM_STATS *stats;
     int normalise_eye;      /* enables/disables normalisation of eye diagram */
+
+    /*  Optimised demod core state */
+    int fast_core;          /* use the optimised demod core */
+    int dc_pos;             /* oldest sample in the down converted ring buffers */
+    float *dc_re;           /* down converted samples, M mirrored rings of 2*Nmem */
+    float *dc_im;
+    float *mix_re;          /* per-tone mixer for the current demod cycle */
+    float *mix_im;
+    double *dc_cs;          /* prefix sums of the down converted samples */
 };
 
 /*
@@ -197,6 +206,10 @@ void fsk_demod_sd(struct FSK *fsk, float rx_bits[],COMP fsk_in[]);
   
 void fsk_stats_normalise_eye(struct FSK *fsk, int normalise_enable);
 
+/* Select the optimised (default) or the reference demod core.
+   Call before the first fsk_demod(), the cores keep separate memories. */
+void fsk_set_fast_core(struct FSK *fsk, int enable);
+
 /* Set the FSK modem into burst demod mode */
 
 void fsk_enable_burst_mode(struct FSK *fsk);
@@ -36,10 +36,13 @@
 #include <time.h>
 #include <signal.h>
 #include <unistd.h>
+#include <string.h>
+#include <pthread.h>
 
 #include "fsk.h"
 #include "codec2_fdmdv.h"
 #include "modem_stats.h"
+#include "../demod/mod/soft_blk.h"
 
 /* cleanly exit when we get a SIGTERM */
 
@@ -50,6 +53,359 @@ void sig_handler(int signo)
     }
 }
 
+/* print one line of modem statistics as JSON, tagged with the channel number if channel >= 0 */
+
+static void print_stats(FILE *f, struct FSK *fsk, struct MODEM_STATS *stats, long sample_count, int channel,
+                        int testframe_mode, int testframecnt, int bitcnt, int biterr)
+{
+    int i,j;
+
+    /* Print standard 2FSK stats */
+
+    fprintf(f,"{");
+
+    if (channel >= 0) {
+        fprintf(f,"\"channel\": %d, ",channel);
+    }
+
+    // Cast some values to avoid problems if time is long long
+    fprintf(f,"\"samples\": %ld, \"EbNodB\": %5.1f, \"ppm\": %4d,", sample_count, stats->snr_est, (int)fsk->ppm);                
+    float *f_est;
+    if (fsk->freq_est_type)
+        f_est = fsk->f2_est;
+    else
+        f_est = fsk->f_est;
+    fprintf(f," \"f1_est\":%.1f, \"f2_est\":%.1f",f_est[0],f_est[1]);
+
+    /* Print 4FSK stats if in 4FSK mode */
+
+    if(fsk->mode == 4){
+        fprintf(f,", \"f3_est\":%.1f, \"f4_est\":%.1f",f_est[2],f_est[3]);
+    }
+
+    if (testframe_mode == 0) {
+        /* Print the eye diagram */
+
+        fprintf(f,",\t\"eye_diagram\":[");
+        for(i=0;i<stats->neyetr;i++){
+            fprintf(f,"[");
+            for(j=0;j<stats->neyesamp;j++){
+                fprintf(f,"%f ",stats->rx_eye[i][j]);
+                if(j<stats->neyesamp-1) fprintf(f,",");
+            }
+            fprintf(f,"]");
+            if(i<stats->neyetr-1) fprintf(f,",");
+        }
+        fprintf(f,"],");
+
+        /* Print a sample of the FFT from the freq estimator */
+        fprintf(f,"\"samp_fft\":[");
+        int Ndft = fsk->Ndft/2;
+        for(i=0; i<Ndft; i++){
+            fprintf(f,"%f ",(fsk->Sf)[i]);
+            if(i<Ndft-1) fprintf(f,",");
+        }
+        fprintf(f,"]");
+    }
+
+    if (testframe_mode) {
+        fprintf(f,", \"frames\":%d, \"bits\":%d, \"errs\":%d",testframecnt,bitcnt,biterr);
+    }
+
+    fprintf(f,"}\n");
+}
+
+/* --softblk: the soft decisions are demodulated straight behind the block
+   header (demod/mod/soft_blk.h), so each block goes out in one fwrite() */
+
+static softblk_hdr_t *softblk_create(int Nbits, int chan, int Rs, int Fs)
+{
+    softblk_hdr_t *blk = (softblk_hdr_t*)calloc(1, sizeof(softblk_hdr_t)+sizeof(float)*Nbits);
+    assert(blk != NULL);
+    blk->magic = SOFTBLK_MAGIC;
+    blk->version = SOFTBLK_VERSION;
+    blk->chan = chan;
+    blk->sym_rate = Rs;
+    blk->sr = Fs;
+    blk->len = Nbits;
+    return blk;
+}
+
+/*---------------------------------------------------------------------------*\
+
+  Multichannel mode (--channels K)
+
+  The input holds K interleaved channels in the same sample format, e.g.
+  from a channeliser. Each channel has its own struct FSK and its own
+  output file (OutputFile is a printf pattern with %d for the channel
+  number). Input is read in blocks of N sample frames; the channels of a
+  block are demodulated on a small pool of worker threads, channel k on
+  worker k % T. Each channel buffers its samples, since fsk_nin() differs
+  between channels. --stats lines get a "channel" tag.
+
+\*---------------------------------------------------------------------------*/
+
+struct CHAN {
+    int ch;
+    struct FSK *fsk;
+    struct MODEM_STATS stats;
+    COMP *inbuf;            /* deinterleaved samples, not yet demodulated */
+    int ninbuf;
+    float *sdbuf;
+    softblk_hdr_t *blk;     /* --softblk: header in front of sdbuf */
+    uint8_t *bitbuf;
+    FILE *fout;
+    long sample_count;
+    int stats_ctr;
+};
+
+static struct {
+    int nchan;
+    int soft_dec_mode;
+    int softinv;
+    int softblk;
+    int complex_input;
+    int bytes_per_sample;
+    int enable_stats;
+    int stats_loop;
+
+    struct CHAN *chan;
+
+    /* current input block, read-only while the workers run */
+    void *rawbuf;
+    int nframes;
+
+    /* worker pool */
+    int nthreads;
+    pthread_t *threads;
+    pthread_mutex_t mtx;
+    pthread_cond_t go;
+    pthread_cond_t done;
+    int gen;
+    int pending;
+    int quit;
+    pthread_mutex_t stats_mtx;
+} mc;
+
+static void chan_process(struct CHAN *c)
+{
+    struct FSK *fsk = c->fsk;
+    int K = mc.nchan;
+    int i, j, nin;
+
+    /* deinterleave and convert this channel's samples of the block */
+    COMP *in = c->inbuf + c->ninbuf;
+    if (mc.complex_input == 1) {
+        int16_t *raw = (int16_t*)mc.rawbuf;
+        for(i=0; i<mc.nframes; i++){
+            in[i].real = ((float)raw[i*K + c->ch])/FDMDV_SCALE;
+            in[i].imag = 0.0;
+        }
+    }
+    else if (mc.bytes_per_sample == 1) {
+        uint8_t *raw = (uint8_t*)mc.rawbuf;
+        for(i=0; i<mc.nframes; i++){
+            in[i].real = ((float)raw[2*(i*K + c->ch)  ]-127.0)/128.0;
+            in[i].imag = ((float)raw[2*(i*K + c->ch)+1]-127.0)/128.0;
+        }
+    }
+    else {
+        int16_t *raw = (int16_t*)mc.rawbuf;
+        for(i=0; i<mc.nframes; i++){
+            in[i].real = ((float)raw[2*(i*K + c->ch)  ])/FDMDV_SCALE;
+            in[i].imag = ((float)raw[2*(i*K + c->ch)+1])/FDMDV_SCALE;
+        }
+    }
+    c->ninbuf += mc.nframes;
+
+    while (c->ninbuf >= (nin = fsk_nin(fsk))) {
+        if (c->blk) c->blk->t0 = c->sample_count;
+        if(mc.soft_dec_mode){
+            fsk_demod_sd(fsk,c->sdbuf,c->inbuf);
+        }else{
+            fsk_demod(fsk,c->bitbuf,c->inbuf);
+        }
+        c->sample_count += nin;
+        c->ninbuf -= nin;
+        memmove(c->inbuf, c->inbuf+nin, sizeof(COMP)*c->ninbuf);
+
+        if (mc.enable_stats) {
+            if (c->stats_ctr < 0) {
+                char *line = NULL;
+                size_t len = 0;
+                FILE *f = open_memstream(&line, &len);
+                if (f != NULL) {
+                    fsk_get_demod_stats(fsk,&c->stats);
+                    print_stats(f, fsk, &c->stats, c->sample_count, c->ch, 0, 0, 0, 0);
+                    fclose(f);
+                    /* one complete line per write */
+                    pthread_mutex_lock(&mc.stats_mtx);
+                    fputs(line, stderr);
+                    pthread_mutex_unlock(&mc.stats_mtx);
+                    free(line);
+                }
+                c->stats_ctr = mc.stats_loop;
+            }
+            c->stats_ctr--;
+        }
+
+        if(mc.soft_dec_mode){
+            if(mc.softinv){
+                for(j=0; j<fsk->Nbits; j++) {
+                    c->sdbuf[j] = c->sdbuf[j]*-1.0;
+                }
+            }
+            if (c->blk) {
+                fwrite(c->blk,sizeof(softblk_hdr_t)+sizeof(float)*fsk->Nbits,1,c->fout);
+            } else {
+                fwrite(c->sdbuf,sizeof(float),fsk->Nbits,c->fout);
+            }
+        }else{
+            fwrite(c->bitbuf,sizeof(uint8_t),fsk->Nbits,c->fout);
+        }
+        fflush(c->fout);
+    }
+}
+
+static void *chan_worker(void *arg)
+{
+    int w = (int)(intptr_t)arg;
+    int gen = 0;
+    int k;
+
+    for(;;) {
+        pthread_mutex_lock(&mc.mtx);
+        while (mc.gen == gen && !mc.quit)
+            pthread_cond_wait(&mc.go, &mc.mtx);
+        if (mc.quit) {
+            pthread_mutex_unlock(&mc.mtx);
+            break;
+        }
+        gen = mc.gen;
+        pthread_mutex_unlock(&mc.mtx);
+
+        for(k=w; k<mc.nchan; k+=mc.nthreads)
+            chan_process(&mc.chan[k]);
+
+        pthread_mutex_lock(&mc.mtx);
+        if (--mc.pending == 0)
+            pthread_cond_signal(&mc.done);
+        pthread_mutex_unlock(&mc.mtx);
+    }
+    return NULL;
+}
+
+static int demod_multichannel(int nchan, int nthreads, int M, int Fs, int Rs, int P, int nsym, int tx_tone_separation,
+                              int fsk_lower, int fsk_upper, int mask, int fast_core, int stats_rate,
+                              FILE *fin, char *fout_pattern)
+{
+    int i, k;
+    size_t frame_bytes;
+    char fname[512];
+
+    if (strstr(fout_pattern, "%d") == NULL) {
+        fprintf(stderr,"--channels: OutputFile must contain %%d for the channel number\n");
+        return 1;
+    }
+
+    mc.nchan = nchan;
+    mc.nthreads = nthreads;
+    if (mc.nthreads < 1) mc.nthreads = 1;
+    if (mc.nthreads > nchan) mc.nthreads = nchan;
+
+    mc.chan = (struct CHAN*)calloc(nchan, sizeof(struct CHAN)); assert(mc.chan != NULL);
+
+    #define UNUSED 1000
+    for(k=0; k<nchan; k++) {
+        struct CHAN *c = &mc.chan[k];
+        c->ch = k;
+        c->fsk = fsk_create_hbr(Fs,Rs,M,P,nsym,UNUSED,tx_tone_separation);
+        if (c->fsk == NULL) return 1;
+        fsk_set_freq_est_limits(c->fsk,fsk_lower,fsk_upper);
+        fsk_set_freq_est_alg(c->fsk, mask);
+        fsk_set_fast_core(c->fsk, fast_core);
+
+        snprintf(fname, sizeof(fname), fout_pattern, k);
+        c->fout = strcmp(fname,"-")==0 ? stdout : fopen(fname,"w");
+        if (c->fout == NULL) {
+            fprintf(stderr,"Couldn't open %s\n", fname);
+            return 1;
+        }
+
+        /* fsk_nin() <= N+Ts/2, plus one input block of N */
+        c->inbuf = (COMP*)malloc(sizeof(COMP)*(2*c->fsk->N+c->fsk->Ts*2)); assert(c->inbuf != NULL);
+        if(mc.soft_dec_mode && mc.softblk){
+            c->blk = softblk_create(c->fsk->Nbits, k, Rs, Fs);
+            c->sdbuf = (float*)(c->blk + 1);
+        }else if(mc.soft_dec_mode){
+            c->sdbuf = (float*)malloc(sizeof(float)*c->fsk->Nbits); assert(c->sdbuf != NULL);
+        }else{
+            c->bitbuf = (uint8_t*)malloc(sizeof(uint8_t)*c->fsk->Nbits); assert(c->bitbuf != NULL);
+        }
+        c->stats_ctr = 0;
+    }
+
+    if (mc.enable_stats) {
+        float loop_time = ((float)fsk_nin(mc.chan[0].fsk))/((float)Fs);
+        mc.stats_loop = (int)(1/(stats_rate*loop_time));
+    }
+
+    int N = mc.chan[0].fsk->N;
+    frame_bytes = (size_t)mc.bytes_per_sample*mc.complex_input*nchan;
+    mc.rawbuf = malloc(frame_bytes*N); assert(mc.rawbuf != NULL);
+
+    pthread_mutex_init(&mc.stats_mtx, NULL);
+    if (mc.nthreads > 1) {
+        pthread_mutex_init(&mc.mtx, NULL);
+        pthread_cond_init(&mc.go, NULL);
+        pthread_cond_init(&mc.done, NULL);
+        mc.threads = (pthread_t*)malloc(sizeof(pthread_t)*mc.nthreads); assert(mc.threads != NULL);
+        for(i=0; i<mc.nthreads; i++)
+            pthread_create(&mc.threads[i], NULL, chan_worker, (void*)(intptr_t)i);
+    }
+    fprintf(stderr,"Demodulating %d channels on %d threads.\n", nchan, mc.nthreads);
+
+    while( (mc.nframes = fread(mc.rawbuf,frame_bytes,N,fin)) > 0 ){
+        if (mc.nthreads > 1) {
+            pthread_mutex_lock(&mc.mtx);
+            mc.pending = mc.nthreads;
+            mc.gen++;
+            pthread_cond_broadcast(&mc.go);
+            while (mc.pending > 0)
+                pthread_cond_wait(&mc.done, &mc.mtx);
+            pthread_mutex_unlock(&mc.mtx);
+        }
+        else {
+            for(k=0; k<nchan; k++)
+                chan_process(&mc.chan[k]);
+        }
+    }
+
+    if (mc.nthreads > 1) {
+        pthread_mutex_lock(&mc.mtx);
+        mc.quit = 1;
+        pthread_cond_broadcast(&mc.go);
+        pthread_mutex_unlock(&mc.mtx);
+        for(i=0; i<mc.nthreads; i++)
+            pthread_join(mc.threads[i], NULL);
+        free(mc.threads);
+    }
+
+    for(k=0; k<nchan; k++) {
+        struct CHAN *c = &mc.chan[k];
+        fclose(c->fout);
+        free(c->inbuf);
+        if (c->blk) free(c->blk); else free(c->sdbuf);
+        free(c->bitbuf);
+        fsk_destroy(c->fsk);
+    }
+    free(mc.chan);
+    free(mc.rawbuf);
+    fclose(fin);
+
+    return 0;
+}
+
 int main(int argc,char *argv[]){
     struct FSK *fsk;
     struct MODEM_STATS stats;
@@ -62,7 +418,7 @@ int main(int argc,char *argv[]){
     int16_t *rawbuf;
     COMP *modbuf;
     float *sdbuf = NULL;
-    int i,j,Ndft;
+    int i,j;
     int soft_dec_mode = 0;
     stats_loop = 0;
     int complex_input = 1, bytes_per_sample = 2;
@@ -78,6 +434,11 @@ int main(int argc,char *argv[]){
     int mask = 0;
     int tx_tone_separation = 100;
     int softinv = 0;
+    int softblk = 0;
+    softblk_hdr_t *blk = NULL;
+    int fast_core = 1;
+    int nchan = 1;
+    int nthreads = 0;
 
     int o = 0;
     int opt_idx = 0;
@@ -95,6 +456,10 @@ int main(int argc,char *argv[]){
             {"testframes",no_argument,        0, 'f'},
             {"nsym",      required_argument,  0, 'n'},
             {"mask",      required_argument,  0, 'm'},
+            {"refcore",   no_argument,        0, 'r'},
+            {"channels",  required_argument,  0, 'k'},
+            {"threads",   required_argument,  0, 'T'},
+            {"softblk",   no_argument,        0, 'S'},
             {0, 0, 0, 0}
         };
 
@@ -151,6 +516,19 @@ int main(int argc,char *argv[]){
             mask = 1;
             tx_tone_separation = atoi(optarg);
             break;
+        case 'r':
+            fast_core = 0;
+            break;
+        case 'k':
+            nchan = atoi(optarg);
+            if (nchan < 1) nchan = 1;
+            break;
+        case 'T':
+            nthreads = atoi(optarg);
+            break;
+        case 'S':
+            softblk = 1;
+            break;
         case 'h':
         case '?':
             goto helpmsg;
@@ -184,6 +562,13 @@ int main(int argc,char *argv[]){
         fprintf(stderr," --fsk_upper freq   upper limit of freq estimator (default Fs/2)\n");
         fprintf(stderr," --nsym Nsym        number of symbols used for estimators. Default %d\n", FSK_DEFAULT_NSYM);
         fprintf(stderr," --mask TxFreqSpace Use \"mask\" freq estimator (default is \"peak\" estimator)\n");
+        fprintf(stderr," --refcore          Use the reference demod core instead of the optimised one\n");
+        fprintf(stderr," --channels K       Input holds K interleaved channels, each demodulated separately.\n");
+        fprintf(stderr,"                    OutputFile must contain %%d, replaced by the channel number 0..K-1.\n");
+        fprintf(stderr,"                    --stats lines are tagged with \"channel\". No testframe mode.\n");
+        fprintf(stderr," --threads T        Worker threads for --channels, default: number of CPUs\n");
+        fprintf(stderr," --softblk          With -s: write the soft decisions in framed blocks (demod/mod/soft_blk.h)\n");
+        fprintf(stderr,"                    carrying symbol rate, sample time base and channel number.\n");
         exit(1);
     }
 
@@ -204,6 +589,34 @@ int main(int argc,char *argv[]){
         fin = fopen(argv[dx + 3],"r");
     }
 
+    if (nchan > 1) {
+        /* set freq estimator limits, as below */
+        if (!user_fsk_lower) fsk_lower = (complex_input == 1) ? 0 : -Fs/2;
+        if (!user_fsk_upper) fsk_upper = Fs/2;
+        if (nthreads <= 0) nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+        if (fin == NULL) {
+            fprintf(stderr,"Couldn't open files\n");
+            exit(1);
+        }
+        if (testframe_mode) {
+            fprintf(stderr,"Testframe mode not supported with --channels\n");
+            exit(1);
+        }
+        signal(SIGTERM, sig_handler);
+
+        mc.soft_dec_mode = soft_dec_mode;
+        mc.softinv = softinv;
+        mc.softblk = softblk;
+        mc.complex_input = complex_input;
+        mc.bytes_per_sample = bytes_per_sample;
+        mc.enable_stats = enable_stats;
+        fprintf(stderr,"Setting estimator limits to %d to %d Hz.\n", fsk_lower, fsk_upper);
+
+        return demod_multichannel(nchan, nthreads, M, Fs, Rs, P, nsym, tx_tone_separation,
+                                  fsk_lower, fsk_upper, mask, fast_core, stats_rate,
+                                  fin, argv[dx + 4]);
+    }
+
     if(strcmp(argv[dx + 4],"-")==0){
         fout = stdout;
     }else{
@@ -229,6 +642,8 @@ int main(int argc,char *argv[]){
 
     fsk_set_freq_est_alg(fsk, mask);
 
+    fsk_set_fast_core(fsk, fast_core);
+
     if(fin==NULL || fout==NULL || fsk==NULL){
         fprintf(stderr,"Couldn't open files\n");
         exit(1);
@@ -262,7 +677,10 @@ int main(int argc,char *argv[]){
     }
 
     /* allocate buffers for processing */
-    if(soft_dec_mode){
+    if(soft_dec_mode && softblk){
+        blk = softblk_create(fsk->Nbits, 0, Rs, Fs);
+        sdbuf = (float*)(blk + 1);
+    }else if(soft_dec_mode){
         sdbuf = (float*)malloc(sizeof(float)*fsk->Nbits); assert(sdbuf != NULL);
     }else{
         bitbuf = (uint8_t*)malloc(sizeof(uint8_t)*fsk->Nbits); assert(bitbuf != NULL);
@@ -309,6 +727,7 @@ int main(int argc,char *argv[]){
             }
         }
 
+        if (blk) blk->t0 = sample_count - fsk_nin(fsk);
         if(soft_dec_mode){
             fsk_demod_sd(fsk,sdbuf,modbuf);
         }else{
@@ -359,56 +778,7 @@ int main(int argc,char *argv[]){
         if (enable_stats) {
             if ((stats_ctr < 0) || testframe_detected) {
                 fsk_get_demod_stats(fsk,&stats);
-
-                /* Print standard 2FSK stats */
-
-                fprintf(stderr,"{");
-
-                // Cast some values to avoid problems if time is long long
-                fprintf(stderr,"\"samples\": %ld, \"EbNodB\": %5.1f, \"ppm\": %4d,", sample_count, stats.snr_est, (int)fsk->ppm);                
-                float *f_est;
-                if (fsk->freq_est_type)
-                    f_est = fsk->f2_est;
-                else
-                    f_est = fsk->f_est;
-                fprintf(stderr," \"f1_est\":%.1f, \"f2_est\":%.1f",f_est[0],f_est[1]);
-
-                /* Print 4FSK stats if in 4FSK mode */
-
-                if(fsk->mode == 4){
-                    fprintf(stderr,", \"f3_est\":%.1f, \"f4_est\":%.1f",f_est[2],f_est[3]);
-                }
-
-                if (testframe_mode == 0) {
-                    /* Print the eye diagram */
-
-                    fprintf(stderr,",\t\"eye_diagram\":[");
-                    for(i=0;i<stats.neyetr;i++){
-                        fprintf(stderr,"[");
-                        for(j=0;j<stats.neyesamp;j++){
-                            fprintf(stderr,"%f ",stats.rx_eye[i][j]);
-                            if(j<stats.neyesamp-1) fprintf(stderr,",");
-                        }
-                        fprintf(stderr,"]");
-                        if(i<stats.neyetr-1) fprintf(stderr,",");
-                    }
-                    fprintf(stderr,"],");
-
-                    /* Print a sample of the FFT from the freq estimator */
-                    fprintf(stderr,"\"samp_fft\":[");
-                    Ndft = fsk->Ndft/2;
-                    for(i=0; i<Ndft; i++){
-                        fprintf(stderr,"%f ",(fsk->Sf)[i]);
-                        if(i<Ndft-1) fprintf(stderr,",");
-                    }
-                    fprintf(stderr,"]");
-                }
-
-                if (testframe_mode) {
-                    fprintf(stderr,", \"frames\":%d, \"bits\":%d, \"errs\":%d",testframecnt,bitcnt,biterr);
-                }
-
-                fprintf(stderr,"}\n");
+                print_stats(stderr, fsk, &stats, sample_count, -1, testframe_mode, testframecnt, bitcnt, biterr);
 
                 if (stats_ctr < 0) {
                     stats_ctr = stats_loop;
@@ -427,7 +797,11 @@ int main(int argc,char *argv[]){
                 }
             }
 
-            fwrite(sdbuf,sizeof(float),fsk->Nbits,fout);
+            if (blk) {
+                fwrite(blk,sizeof(softblk_hdr_t)+sizeof(float)*fsk->Nbits,1,fout);
+            } else {
+                fwrite(sdbuf,sizeof(float),fsk->Nbits,fout);
+            }
         }else{
             fwrite(bitbuf,sizeof(uint8_t),fsk->Nbits,fout);
         }
@@ -440,7 +814,9 @@ int main(int argc,char *argv[]){
         free(bitbuf_rx);
     }
 
-    if(soft_dec_mode){
+    if(blk){
+        free(blk);
+    }else if(soft_dec_mode){
         free(sdbuf);
     }else{
         free(bitbuf);
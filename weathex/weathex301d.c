@@ -9,6 +9,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef CYGWIN
+  #include <fcntl.h>  // cygwin: _setmode()
+  #include <io.h>
+#endif
+
 
 // optional JSON "version"
 //  (a) set global
@@ -21,20 +26,29 @@
 //      gcc -DVER_JSN_STR=\"0.0.2\" ...
 
 
-typedef unsigned char ui8_t;
+#ifndef INTTYPES
+#define INTTYPES
+typedef unsigned char  ui8_t;
+typedef unsigned short ui16_t;
+typedef unsigned int   ui32_t;
+typedef unsigned long long ui64_t;
+typedef char  i8_t;
 typedef short i16_t;
-typedef unsigned int ui32_t;
+typedef int   i32_t;
+#endif
+
+#include "../demod/mod/demod_mod.h"
+#include "../demod/mod/sonde_tlm.h"
 
 
 int option_verbose = 0,
     option_raw = 0,
     option_inv = 0,
-    option_b = 0,
     option_json = 0,
+    option_jsnbin = 0,  // --jsnbin: JSON as binary record (sonde_tlm.h)
     option_timestamp = 0,
     option_softin = 0,
     wavloaded = 0;
-int wav_channel = 0;     // audio channel: left
 
 int option_pn9 = 0;
 
@@ -63,190 +77,6 @@ float baudrate = BAUD_RATE;
 
 /* ------------------------------------------------------------------------------------ */
 
-int sample_rate = 0, bits_sample = 0, channels = 0;
-float samples_per_bit = 0;
-
-int findstr(char *buff, char *str, int pos) {
-    int i;
-    for (i = 0; i < 4; i++) {
-        if (buff[(pos+i)%4] != str[i]) break;
-    }
-    return i;
-}
-
-int read_wav_header(FILE *fp) {
-    char txt[4+1] = "\0\0\0\0";
-    unsigned char dat[4];
-    int byte, p=0;
-
-    if (fread(txt, 1, 4, fp) < 4) return -1;
-    if (strncmp(txt, "RIFF", 4) && strncmp(txt, "RF64", 4)) return -1;
-    if (fread(txt, 1, 4, fp) < 4) return -1;
-    // pos_WAVE = 8L
-    if (fread(txt, 1, 4, fp) < 4) return -1;
-    if (strncmp(txt, "WAVE", 4)) return -1;
-    // pos_fmt = 12L
-    for ( ; ; ) {
-        if ( (byte=fgetc(fp)) == EOF ) return -1;
-        txt[p % 4] = byte;
-        p++; if (p==4) p=0;
-        if (findstr(txt, "fmt ", p) == 4) break;
-    }
-    if (fread(dat, 1, 4, fp) < 4) return -1;
-    if (fread(dat, 1, 2, fp) < 2) return -1;
-
-    if (fread(dat, 1, 2, fp) < 2) return -1;
-    channels = dat[0] + (dat[1] << 8);
-
-    if (fread(dat, 1, 4, fp) < 4) return -1;
-    memcpy(&sample_rate, dat, 4); //sample_rate = dat[0]|(dat[1]<<8)|(dat[2]<<16)|(dat[3]<<24);
-
-    if (fread(dat, 1, 4, fp) < 4) return -1;
-    if (fread(dat, 1, 2, fp) < 2) return -1;
-    //byte = dat[0] + (dat[1] << 8);
-
-    if (fread(dat, 1, 2, fp) < 2) return -1;
-    bits_sample = dat[0] + (dat[1] << 8);
-
-    // pos_dat = 36L + info
-    for ( ; ; ) {
-        if ( (byte=fgetc(fp)) == EOF ) return -1;
-        txt[p % 4] = byte;
-        p++; if (p==4) p=0;
-        if (findstr(txt, "data", p) == 4) break;
-    }
-    if (fread(dat, 1, 4, fp) < 4) return -1;
-
-
-    fprintf(stderr, "sample_rate: %d\n", sample_rate);
-    fprintf(stderr, "bits       : %d\n", bits_sample);
-    fprintf(stderr, "channels   : %d\n", channels);
-
-    if (bits_sample != 8 && bits_sample != 16 && bits_sample != 32) return -1;
-
-    if (sample_rate == 900001) sample_rate -= 1;
-
-    samples_per_bit = sample_rate/(float)baudrate;
-
-    fprintf(stderr, "samples/bit: %.2f\n", samples_per_bit);
-
-    return 0;
-}
-
-unsigned long sample_count = 0;
-double bitgrenze = 0;
-
-int f32read_signed_sample(FILE *fp, float *s) {
-    int i;
-    unsigned int word = 0;
-    short *b = (short*)&word;
-    float *f = (float*)&word;
-
-    for (i = 0; i < channels; i++) {
-
-        if (fread( &word, bits_sample/8, 1, fp) != 1) return EOF;
-
-        if (i == wav_channel) {  // i = 0: links bzw. mono
-            //if (bits_sample ==  8)  sint = b-128;   // 8bit: 00..FF, centerpoint 0x80=128
-            //if (bits_sample == 16)  sint = (short)b;
-
-            if (bits_sample == 32) {
-                *s = *f;
-            }
-            else {
-                if (bits_sample ==  8) { *b -= 128; }
-                *s = *b/128.0;
-                if (bits_sample == 16) { *s /= 256.0; }
-            }
-        }
-    }
-
-    sample_count++;
-
-    return 0;
-}
-
-int par=1, par_alt=1;
-
-int read_bits_fsk(FILE *fp, int *bit, int *len) {
-    int n;
-    float s;
-    float l;
-
-    n = 0;
-    do {
-        if (f32read_signed_sample(fp, &s) == EOF) return EOF;
-        //sample_count++; // in f32read_signed_sample()
-        par_alt = par;
-        par =  (s >= 0) ? 1 : -1;
-        n++;
-    } while (par*par_alt > 0);
-
-    l = (float)n / samples_per_bit;
-
-    *len = (int)(l+0.5);
-
-    if (!option_inv) *bit = (1+par_alt)/2;  // oben 1, unten -1
-    else             *bit = (1-par_alt)/2;  // sdr#<rev1381?, invers: unten 1, oben -1
-// *bit = (1+inv*par_alt)/2; // ausser inv=0
-
-    /* Y-offset ? */
-
-    return 0;
-}
-
-int bitstart = 0;
-unsigned long scount = 0;
-int read_rawbit(FILE *fp, int *bit) {
-    float s;
-    float sum;
-
-    sum = 0;
-
-    if (bitstart) {
-        scount = 0;    // eigentlich scount = 1
-        bitgrenze = 0; //   oder bitgrenze = -1
-        bitstart = 0;
-    }
-    bitgrenze += samples_per_bit;
-
-    do {
-        if (f32read_signed_sample(fp, &s) == EOF) return EOF;
-        //sample_count++; // in f32read_signed_sample()
-        sum += s;
-        scount++;
-    } while (scount < bitgrenze);  // n < samples_per_bit
-
-    if (sum >= 0) *bit = 1;
-    else          *bit = 0;
-
-    if (option_inv) *bit ^= 1;
-
-    return 0;
-}
-
-
-int f32soft_read(FILE *fp, float *s) {
-    unsigned int word = 0;
-    short *b = (short*)&word;
-    float *f = (float*)&word;
-    int bps = 32;
-
-    if (fread( &word, bps/8, 1, fp) != 1) return EOF;
-
-    if (bps == 32) {
-        *s = *f;
-    }
-    else {
-        if (bps ==  8) { *b -= 128; }
-        *s = *b/128.0;
-        if (bps == 16) { *s /= 256.0; }
-    }
-
-    return 0;
-}
-
-
 int compare(char *hdr) {
     int i=0;
     while ((i < HEADLEN) && (buf[(bufpos+i) % HEADLEN] == hdr[HEADLEN+HEADOFS-1-i])) {
@@ -346,6 +176,7 @@ typedef struct {
     float alt;
     //
     int jsn_freq;   // freq/kHz (SDR)
+    tlm_t tlm;
 } gpx_t;
 
 gpx_t gpx;
@@ -489,33 +320,36 @@ int print_frame() {
                 if (gpx.chk1ok && gpx.sn2 == gpx.sn1 && gpx.cnt2 == gpx.cnt1) // double check, unreliable checksums
                 {
                     char *ver_jsn = NULL;
-                    fprintf(stdout, "{ \"type\": \"%s\"", "WXR301");
-                    fprintf(stdout, ", \"frame\": %u", gpx.cnt2);
-                    fprintf(stdout, ", \"id\": \"WXR-%u\"", gpx.sn2);
-                    fprintf(stdout, ", \"datetime\": \"%02d:%02d:%02dZ\", \"lat\": %.5f, \"lon\": %.5f, \"alt\": %.2f",
-                                    gpx.hrs, gpx.min, gpx.sec, gpx.lat, gpx.lon, gpx.alt);
+                    tlm_t *t = &gpx.tlm;
+                    tlm_begin(t, "WXR301");
+                    tlm_int(t, TLM_FRAME, gpx.cnt2);
+                    tlm_strf(t, TLM_ID, "WXR-%u", gpx.sn2);
+                    tlm_datetime(t, 0, 0, 0, gpx.hrs, gpx.min, gpx.sec, 0);
+                    tlm_flt(t, TLM_LAT, gpx.lat, 5);
+                    tlm_flt(t, TLM_LON, gpx.lon, 5);
+                    tlm_flt(t, TLM_ALT, gpx.alt, 2);
 
                     // if data from subframe1,
                     // check  gpx.chk1ok && gpx.sn1==gpx.sn2 && gpx.cnt1==gpx.cnt2
 
                     if (option_pn9) {
-                        fprintf(stdout, ", \"subtype\": \"WXR_PN9\"");
+                        tlm_str(t, TLM_SUBTYPE, "WXR_PN9");
                     }
 
                     if (gpx.jsn_freq > 0) {
-                        fprintf(stdout, ", \"freq\": %d", gpx.jsn_freq );
+                        tlm_int(t, TLM_FREQ, gpx.jsn_freq);
                     }
 
                     // Reference time/position
                     // (WxR-301D PN9)
-                    fprintf(stdout, ", \"ref_datetime\": \"%s\"", "UTC" ); // {"GPS", "UTC"} GPS-UTC=leap_sec
-                    fprintf(stdout, ", \"ref_position\": \"%s\"", "MSL" ); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid
+                    tlm_str(t, TLM_REF_DATETIME, "UTC"); // {"GPS", "UTC"} GPS-UTC=leap_sec
+                    tlm_str(t, TLM_REF_POSITION, "MSL"); // {"GPS", "MSL"} GPS=ellipsoid , MSL=geoid
 
                     #ifdef VER_JSN_STR
                         ver_jsn = VER_JSN_STR;
                     #endif
-                    if (ver_jsn && *ver_jsn != '\0') fprintf(stdout, ", \"version\": \"%s\"", ver_jsn);
-                    fprintf(stdout, " }\n");
+                    if (ver_jsn && *ver_jsn != '\0') tlm_str(t, TLM_VERSION_STR, ver_jsn);
+                    tlm_out(t, stdout, option_jsnbin);
                     fprintf(stdout, "\n");
                 }
             }
@@ -528,16 +362,46 @@ int print_frame() {
 
 int main(int argc, char **argv) {
 
-    FILE *fp;
-    char *fpname;
+    FILE *fp = NULL;
+    char *fpname = NULL;
+    char *shm_name = NULL;
+
+    int option_min = 0;
+    int option_iq = 0;
+    int option_iqdc = 0;
+    int option_lp = 0;
+    int option_dc = 0;
+    int option_noLUT = 0;
+    int option_pcmraw = 0;
+    int sel_wavch = 0;     // audio channel: left
 
-    int i, j, h, bit, len;
+    int k, h, bit;
     int bit_count, frames;
+    int bitpos, bitQ;
     int header_found = 0;
     int cfreq = -1;
 
+    float thres = 0.65;
+    float _mv = 0.0;
+
+    float lpIQ_bw = 64e3;
+
+    int bitofs = 0;
+    int shift = 0;
+
+    pcm_t pcm = {0};
+    dsp_t dsp = {0};
+    hsbit_t hsbit, hsbit1;
+
     char *hdr = header;
 
+
+#ifdef CYGWIN
+    _setmode(fileno(stdin), _O_BINARY);  // _setmode(_fileno(stdin), _O_BINARY);
+#endif
+    setbuf(stdout, NULL);
+
+
     fpname = argv[0];
     ++argv;
     while ((*argv) && (!wavloaded)) {
@@ -545,7 +409,8 @@ int main(int argc, char **argv) {
             fprintf(stderr, "%s [options] audio.wav\n", fpname);
             fprintf(stderr, "  options:\n");
             fprintf(stderr, "       -i\n");
-            fprintf(stderr, "       -b\n");
+            fprintf(stderr, "       --pn9\n");
+            fprintf(stderr, "       --IQ <fq> (IQ baseband, FM-demod)\n");
             return 0;
         }
         else if   (strcmp(*argv, "--pn9") == 0) { option_pn9 = 1; }
@@ -556,7 +421,7 @@ int main(int argc, char **argv) {
             option_verbose = 1;
         }
         else if   (strcmp(*argv, "--softin") == 0) { option_softin = 1; }  // float32 soft input
-        else if   (strcmp(*argv, "-b" ) == 0) { option_b = 1; }
+        else if   (strcmp(*argv, "-b" ) == 0) { }  // bit sync: always (demod_mod)
         else if   (strcmp(*argv, "-t" ) == 0) { option_timestamp = 1; }
         else if ( (strcmp(*argv, "-r") == 0) || (strcmp(*argv, "--raw") == 0) ) {
             option_raw = 1;
@@ -564,9 +429,52 @@ int main(int argc, char **argv) {
         else if ( (strcmp(*argv, "-R") == 0) || (strcmp(*argv, "--RAW") == 0) ) {
             option_raw = 2;
         }
+        else if   (strcmp(*argv, "--ch2") == 0) { sel_wavch = 1; }  // right channel (default: 0=left)
+        else if   (strcmp(*argv, "--ths") == 0) {
+            ++argv;
+            if (*argv) {
+                thres = atof(*argv);
+            }
+            else return -1;
+        }
+        else if ( (strcmp(*argv, "-d") == 0) ) {
+            ++argv;
+            if (*argv) {
+                shift = atoi(*argv);
+                if (shift >  4) shift =  4;
+                if (shift < -4) shift = -4;
+            }
+            else return -1;
+        }
+        else if   (strcmp(*argv, "--iq0") == 0) { option_iq = 1; }  // differential/FM-demod
+        else if   (strcmp(*argv, "--iqdc") == 0) { option_iqdc = 1; }  // iq-dc removal (iq0)
+        else if   (strcmp(*argv, "--IQ") == 0) { // fq baseband -> IF (rotate from and decimate)
+            double fq = 0.0;                     // --IQ <fq> , -0.5 < fq < 0.5
+            ++argv;
+            if (*argv) fq = atof(*argv);
+            else return -1;
+            if (fq < -0.5) fq = -0.5;
+            if (fq >  0.5) fq =  0.5;
+            dsp.xlt_fq = -fq; // S(t) -> S(t)*exp(-f*2pi*I*t)
+            option_iq = 5;
+        }
+        else if   (strcmp(*argv, "--lpIQ") == 0) { option_lp |= LP_IQ; }  // IQ/IF lowpass
+        else if   (strcmp(*argv, "--lpbw") == 0) {  // IQ lowpass BW / kHz
+            double bw = 0.0;
+            ++argv;
+            if (*argv) bw = atof(*argv);
+            else return -1;
+            if (bw > 16.0 && bw < 96.0) lpIQ_bw = bw*1e3;
+            option_lp |= LP_IQ;
+        }
+        else if   (strcmp(*argv, "--lpFM") == 0) { option_lp |= LP_FM; }  // FM lowpass
+        else if   (strcmp(*argv, "--dc") == 0) { option_dc = 1; }
+        else if   (strcmp(*argv, "--noLUT") == 0) { option_noLUT = 1; }
+        else if   (strcmp(*argv, "--min") == 0) { option_min = 1; }
         else if ( (strcmp(*argv, "--json") == 0) ) {
             option_json = 1;
         }
+        else if ( (strcmp(*argv, "--jsnbin") == 0) ) { option_jsnbin = 1; }  // json as binary records
         else if ( (strcmp(*argv, "--jsn_cfq") == 0) ) {
             int frq = -1;  // center frequency / Hz
             ++argv;
@@ -574,6 +482,32 @@ int main(int argc, char **argv) {
             if (frq < 300000000) frq = -1;
             cfreq = frq;
         }
+        else if   (strcmp(*argv, "--shm") == 0) {  // IQ from shared-memory ring (iq_shmw)
+            ++argv;
+            if (*argv) shm_name = *argv; else return -1;
+        }
+        else if   (strcmp(*argv, "--rxtime") == 0) { dsp.opt_rxtime = 1; }  // JSON: wall clock of the header
+        else if   (strcmp(*argv, "--rxt0") == 0) {  // wall clock of the first sample (unix time)
+            ++argv;
+            if (*argv) dsp.rx_t0 = atof(*argv); else return -1;
+            dsp.opt_rxtime = 1;
+        }
+        else if (strcmp(*argv, "-") == 0) {
+            int sample_rate = 0, bits_sample = 0, channels = 0;
+            ++argv;
+            if (*argv) sample_rate = atoi(*argv); else return -1;
+            ++argv;
+            if (*argv) bits_sample = atoi(*argv); else return -1;
+            channels = 2;
+            if (sample_rate < 1 || (bits_sample != 8 && bits_sample != 16 && bits_sample != 32)) {
+                fprintf(stderr, "- <sr> <bs>\n");
+                return -1;
+            }
+            pcm.sr  = sample_rate;
+            pcm.bps = bits_sample;
+            pcm.nch = channels;
+            option_pcmraw = 1;
+        }
         else {
             fp = fopen(*argv, "rb");
             if (fp == NULL) {
@@ -586,17 +520,23 @@ int main(int argc, char **argv) {
     }
     if (!wavloaded) fp = stdin;
 
+    if (shm_name) {
+        if (attach_shm(&dsp, &pcm, shm_name) < 0) {
+            fprintf(stderr, "error: open shm %s\n", shm_name);
+            return -1;
+        }
+        option_pcmraw = 1;
+    }
+
     if (option_pn9) {
         baudrate = BAUD_RATE_PN9;
         hdr = header_pn9;
         ofs = OFS_PN9;
     }
 
-    if ( !option_softin ) {
-        i = read_wav_header(fp);
-        if (i) return -1;
-    }
+    if (option_iq == 5 && option_dc) option_lp |= LP_FM;
 
+    if (option_noLUT && option_iq == 5) dsp.opt_nolut = 1; else dsp.opt_nolut = 0;
 
     if (cfreq > 0) gpx.jsn_freq = (cfreq+500)/1000;
 
@@ -608,10 +548,9 @@ int main(int argc, char **argv) {
     {
         float s = 0.0f;
         int bit = 0;
-        sample_rate = baudrate;
-        sample_count = 0;
+        unsigned long sample_count = 0;
 
-        while (!f32soft_read(fp, &s)) {
+        while (!f32soft_read(fp, &s, 0)) {
 
             bit = option_inv ? (s<=0.0f) : (s>=0.0f);  // softbit s: bit=0 <=> s<0 , bit=1 <=> s>=0
 
@@ -625,7 +564,7 @@ int main(int argc, char **argv) {
                 if ((h >= HEADLEN)) {
                     header_found = 1;
                     fflush(stdout);
-                    if (option_timestamp) printf("<%8.3f> ", sample_count/(double)sample_rate);
+                    if (option_timestamp) printf("<%8.3f> ", sample_count/(double)baudrate);
                     strncpy(frame_bits, hdr, HEADLEN);
                     bit_count += HEADLEN;
                     frames++;
@@ -648,62 +587,107 @@ int main(int argc, char **argv) {
     }
     else
     {
-        while (!read_bits_fsk(fp, &bit, &len)) {
-
-            if (len == 0) {
-                bufpos--;
-                if (bufpos < 0) bufpos = HEADLEN-1;
-                buf[bufpos] = 'x';
-                continue;
+        // FM-audio or IQ (demod_mod): header correlation, bit sync
+        if (option_iq == 0 && option_pcmraw) {
+            fclose(fp);
+            fprintf(stderr, "error: raw data not IQ\n");
+            return -1;
+        }
+        if (option_iq) sel_wavch = 0;
+
+        pcm.sel_ch = sel_wavch;
+        if (option_pcmraw == 0) {
+            k = read_wav_header(&pcm, fp);
+            if ( k < 0 ) {
+                fclose(fp);
+                fprintf(stderr, "error: wav header\n");
+                return -1;
             }
+        }
 
+        if (cfreq > 0) {
+            int fq_kHz = (cfreq - dsp.xlt_fq*pcm.sr + 500)/1e3;
+            gpx.jsn_freq = fq_kHz;
+        }
 
-            for (j = 0; j < len; j++) {
-                bufpos--;
-                if (bufpos < 0) bufpos = HEADLEN-1;
-                buf[bufpos] = 0x30 + bit;
+        // init dsp
+        //
+        dsp.fp = fp;
+        dsp.sr = pcm.sr;
+        dsp.bps = pcm.bps;
+        dsp.nch = pcm.nch;
+        dsp.ch = pcm.sel_ch;
+        dsp.br = baudrate;
+        dsp.sps = (float)dsp.sr/dsp.br;
+        dsp.symlen = 1;
+        dsp.symhd = 1;
+        dsp._spb = dsp.sps;
+        dsp.hdr = hdr;
+        dsp.hdrlen = HEADLEN;
+        dsp.BT = 1.0; // bw/time (ISI)
+        dsp.h = 8.0;  // wide FSK (64kHz); IQ: FM-demod, no f1/f2 tone filters
+        dsp.opt_fm = 1;
+        dsp.IF_sr = 96000;  // IF bandwidth > 48kHz
+        dsp.opt_iq = option_iq;
+        dsp.opt_iqdc = option_iqdc;
+        dsp.opt_lp = option_lp;
+        dsp.lpIQ_bw = lpIQ_bw;  // 64e3; // IF lowpass bandwidth
+        dsp.lpFM_bw = 8e3; // FM audio lowpass
+        dsp.opt_dc = option_dc;
+        dsp.opt_IFmin = option_min;
+
+        if ( dsp.sps < 8 ) {
+            fprintf(stderr, "note: sample rate low (%.1f sps)\n", dsp.sps);
+        }
 
-                if (!header_found)
-                {
-                    h = compare(hdr); //h2 = compare2(hdr);
-                    if ((h >= HEADLEN)) {
-                        header_found = 1;
-                        fflush(stdout);
-                        if (option_timestamp) printf("<%8.3f> ", sample_count/(double)sample_rate);
-                        strncpy(frame_bits, hdr, HEADLEN);
-                        bit_count += HEADLEN;
-                        frames++;
-                    }
-                }
-                else
-                {
-                    frame_bits[bit_count] = 0x30 + bit;
-                    bit_count += 1;
-                }
+        k = init_buffers(&dsp);
+        if ( k < 0 ) {
+            fprintf(stderr, "error: init buffers\n");
+            return -1;
+        }
 
-                if (bit_count >= BITFRAMELEN) {
-                    bit_count = 0;
-                    header_found = 0;
+        bitofs += shift;
 
-                    print_frame();
-                }
+        while ( 1 )
+        {
+            header_found = find_header(&dsp, thres, 2, bitofs, dsp.opt_dc); // optional 2nd pass: dc=0
+            _mv = dsp.mv;
+            gpx.tlm.rx_time = dsp.rx_time;
+
+            if (header_found == EOF) break;
 
+            // mv == correlation score
+            if (_mv*(0.5-option_inv) < 0) {
+                option_inv ^= 0x1;
             }
-            if (header_found && option_b) {
-                bitstart = 1;
+
+            if (header_found) {
+
+                if (option_timestamp) printf("<%8.3f> ", dsp.mv_pos/(double)dsp.sr);
+                strncpy(frame_bits, hdr, HEADLEN);
+                bit_count = HEADLEN;
+                bitpos = 0;
+                frames++;
 
                 while ( bit_count < BITFRAMELEN ) {
-                    if (read_rawbit(fp, &bit) == EOF) break;
+                    bitQ = read_softbit2p(&dsp, &hsbit, 0, bitofs, bitpos, -1, 0, &hsbit1);
+                    if ( bitQ == EOF ) break;
+                    bit = hsbit.hb;
+                    if (option_inv) bit ^= 1;
                     frame_bits[bit_count] = 0x30 + bit;
                     bit_count += 1;
+                    bitpos += 1;
                 }
 
-                bit_count = 0;
-                header_found = 0;
+                if (bit_count < BITFRAMELEN) break;
 
                 print_frame();
+                bit_count = 0;
+                header_found = 0;
             }
         }
+
+        free_buffers(&dsp);
     }
 
     printf("\n");
@@ -712,4 +696,3 @@ int main(int argc, char **argv) {
 
     return 0;
 }
-